@@ -2,7 +2,6 @@
 // "LICENSE" for information on usage and redistribution of this file.
 
 #include <verilated.h>
-#include <verilated_vcd_c.h>
 
 #include <algorithm>
 #include <array>
@@ -10,21 +9,29 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "../../../common/verilator/elf_loader.h"
+#include "../../../common/verilator/heartbeat.h"
+#include "../../../common/verilator/sim_stats.h"
+#include "../../../common/verilator/watchpoints.h"
+#include "../../../common/verilator/wave_tracer.h"
 #include "VTop.h"
 
-constexpr int TRACE_DEPTH = 99;
 constexpr int RESET_CYCLES = 2;
 
 // Represents the main memory of the simulated CPU.
 class Memory
 {
-    std::vector<uint32_t> memory;
+    GuestRAM memory;
 
 public:
-    Memory(size_t size) : memory(size, 0) {}
+    // Halt address and -watch ranges, checked only when write() stores
+    WriteWatchpoints watches;
+
+    Memory(size_t size) : memory(size) {}
 
     // Reads a 32-bit word from the specified byte address.
     uint32_t read(size_t address)
@@ -61,11 +68,18 @@ public:
 
         memory[address] =
             (memory[address] & ~write_mask) | (value & write_mask);
+        watches.on_write(address * 4, memory[address]);
     }
 
-    // Loads a binary file into memory at a specified address.
+    // Loads a program into memory: ELF files go where their program headers
+    // say, anything else is a flat binary placed at the specified address.
     void load_binary(const std::string &filename, size_t load_address = 0x1000)
     {
+        if (ElfImage::is_elf(filename)) {
+            ElfImage(filename).load(memory);
+            return;
+        }
+
         std::ifstream file(filename, std::ios::binary);
         if (!file) {
             throw std::runtime_error("Could not open file: " + filename);
@@ -80,50 +94,7 @@ public:
                                      " is too large for memory.");
         }
 
-        // Read the file word by word (4 bytes at a time).
-        for (size_t i = 0; i < size / 4; ++i) {
-            file.read(reinterpret_cast<char *>(&memory[i + load_address / 4]),
-                      sizeof(uint32_t));
-        }
-    }
-};
-
-// Manages VCD (Value Change Dump) tracing for Verilator simulations.
-class VCDTracer
-{
-    std::unique_ptr<VerilatedVcdC> tfp;
-
-public:
-    VCDTracer() : tfp(nullptr) {}
-
-    // Enables VCD tracing and opens the specified trace file.
-    void enable(const std::string &filename, VTop &top)
-    {
-        Verilated::traceEverOn(true);
-        tfp.reset(new VerilatedVcdC());
-        top.trace(tfp.get(), TRACE_DEPTH);
-        tfp->open(filename.c_str());
-        if (!tfp->isOpen()) {
-            throw std::runtime_error("Failed to open VCD dump file: " +
-                                     filename);
-        }
-    }
-
-    // Dumps the current signal values to the VCD file at the given simulation
-    // time.
-    void dump(vluint64_t time)
-    {
-        if (tfp) {
-            tfp->dump(time);
-        }
-    }
-
-    // Closes the VCD file upon destruction.
-    ~VCDTracer()
-    {
-        if (tfp) {
-            tfp->close();
-        }
+        file.read(reinterpret_cast<char *>(memory.data() + load_address), size);
     }
 };
 
@@ -141,21 +112,24 @@ uint32_t parse_number(const std::string &str)
 class Simulator
 {
     std::unique_ptr<VTop> top;
-    std::unique_ptr<VCDTracer> vcd_tracer;
+    std::unique_ptr<WaveTracer> vcd_tracer;
     std::unique_ptr<Memory> memory;
 
     vluint64_t main_time = 0;
     vluint64_t max_sim_time = 10000;
     uint32_t halt_address = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> watch_ranges;
     size_t memory_words = 1024 * 1024;  // 4MB
     std::string instruction_filename;
     bool dump_signature = false;
     unsigned long signature_begin, signature_end;
     std::string signature_filename;
+    SimStats stats;
+    bool print_stats = false;
 
 public:
     Simulator(const std::vector<std::string> &args)
-        : top(new VTop()), vcd_tracer(new VCDTracer())
+        : top(new VTop()), vcd_tracer(new WaveTracer())
     {
         parse_args(args);
         memory.reset(new Memory(memory_words));
@@ -182,8 +156,22 @@ public:
                 signature_begin = parse_number(*++it);
                 signature_end = parse_number(*++it);
                 signature_filename = *++it;
+            } else if (*it == "-stats") {
+                print_stats = true;
             } else if (*it == "-instruction" && std::next(it) != args.end()) {
                 instruction_filename = *++it;
+            } else if (*it == "-watch" && std::next(it) != args.end()) {
+                // -watch ADDR or -watch BEGIN:END (end exclusive)
+                std::string spec = *++it;
+                auto colon = spec.find(':');
+                uint32_t begin = parse_number(spec.substr(0, colon));
+                uint32_t end = colon == std::string::npos
+                                   ? begin + 4
+                                   : parse_number(spec.substr(colon + 1));
+                watch_ranges.emplace_back(begin, end);
+            } else if (std::next(it) != args.end() &&
+                       vcd_tracer->parse_option(*it, *std::next(it))) {
+                ++it;
             }
         }
     }
@@ -195,13 +183,21 @@ public:
         top->reset = 1;
         top->clock = 0;
         top->io_instruction_valid = 1;
-        top->eval();
+        stats.eval(*top);
         vcd_tracer->dump(main_time);
 
         uint32_t data_memory_read_word = 0;
         uint32_t inst_memory_read_word = 0;
         std::array<bool, 4> memory_write_strobe = {{false}};
 
+        // Halt and -watch fire from Memory::write() instead of being polled
+        std::optional<unsigned> halt_watch;
+        if (halt_address)
+            halt_watch = memory->watches.add_word(halt_address, 0xBABECAFE);
+        for (auto const &range : watch_ranges)
+            memory->watches.add(range.first, range.second);
+        Heartbeat heartbeat(0.5);  // one clock edge per step
+
         // Main simulation loop.
         while (main_time < max_sim_time && !Verilated::gotFinish()) {
             main_time++;
@@ -213,7 +209,7 @@ public:
 
             top->io_memory_bundle_read_data = data_memory_read_word;
             top->io_instruction = inst_memory_read_word;
-            top->eval();
+            stats.eval(*top);
 
             data_memory_read_word = memory->read(top->io_memory_bundle_address);
             inst_memory_read_word = memory->read(top->io_instruction_address);
@@ -228,25 +224,41 @@ public:
                               memory_write_strobe);
             }
 
+            vcd_tracer->check_pc(top->io_instruction_address);
+            if (top->io_memory_bundle_write_enable)
+                vcd_tracer->check_store(top->io_memory_bundle_address);
             vcd_tracer->dump(main_time);
 
-            if (halt_address && memory->read(halt_address) == 0xBABECAFE) {
+            if (memory->watches.pending() && report_watch_hits(halt_watch)) {
                 std::cout << "Halt condition met at address 0x" << std::hex
                           << halt_address << std::dec << std::endl;
                 break;
             }
 
-            if (main_time > 0 && max_sim_time > 10 &&
-                main_time % (max_sim_time / 10) == 0) {
-                std::cerr << "Simulation progress: "
-                          << (main_time * 100 / max_sim_time) << "%"
-                          << std::endl;
-            }
+            heartbeat.tick(main_time, max_sim_time);
         }
 
         if (dump_signature) {
             generate_signature();
         }
+        if (print_stats)
+            stats.report();
+    }
+
+    // Prints -watch hits; returns true when the halt watch fired.
+    bool report_watch_hits(std::optional<unsigned> halt_watch)
+    {
+        bool halt = false;
+        for (auto const &hit : memory->watches.take()) {
+            if (hit.id == halt_watch) {
+                halt = true;
+                continue;
+            }
+            std::cerr << "[watch] time " << main_time << ": 0x" << std::hex
+                      << hit.address << " = 0x" << hit.value << std::dec
+                      << std::endl;
+        }
+        return halt;
     }
 
     // Generates a signature file from a specified memory range.
@@ -1,22 +1,41 @@
 #include <verilated.h>
-#include <verilated_vcd_c.h>
 
 #include <algorithm>
+#include <cctype>
+#include <atomic>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "../../../common/verilator/elf_loader.h"
+#include "../../../common/verilator/fork_server.h"
+#include "../../../common/verilator/heartbeat.h"
+#include "../../../common/verilator/sim_stats.h"
+#include "../../../common/verilator/watchpoints.h"
+#include "../../../common/verilator/wave_tracer.h"
 #include "VTop.h"  // From Verilating "top.v"
 
 
 class Memory
 {
-    std::vector<uint32_t> memory;
+    GuestRAM memory;
+    std::unordered_map<std::string, uint32_t> symbol_table;
 
 public:
-    Memory(size_t size) : memory(size, 0) {}
+    // Halt address and -watch ranges, checked only when write() stores
+    WriteWatchpoints watches;
+
+    Memory(size_t size) : memory(size) {}
+
+    void clear() { memory.clear(); }
     uint32_t read(size_t address)
     {
         address = address / 4;
@@ -58,10 +77,20 @@ public:
         }
         memory[address] =
             (memory[address] & ~write_mask) | (value & write_mask);
+        watches.on_write(address * 4, memory[address]);
     }
 
+    // ELF files are placed by their program headers and keep their symbol
+    // table; anything else is a flat image copied to load_address.
     void load_binary(std::string const &filename, size_t load_address = 0x1000)
     {
+        if (ElfImage::is_elf(filename)) {
+            ElfImage elf(filename);
+            elf.load(memory);
+            symbol_table = elf.symbols();
+            return;
+        }
+        symbol_table.clear();
         std::ifstream file(filename, std::ios::binary);
         if (!file) {
             throw std::runtime_error("Could not open file " + filename);
@@ -75,45 +104,15 @@ public:
                 std::to_string(memory.size() * 4 - load_address) + " bytes.)");
         }
         file.seekg(0, std::ios::beg);
-        for (int i = 0; i < size / 4; ++i) {
-            file.read(reinterpret_cast<char *>(&memory[i + load_address / 4]),
-                      sizeof(uint32_t));
-        }
+        file.read(reinterpret_cast<char *>(memory.data() + load_address), size);
     }
-};
 
-class VCDTracer
-{
-    VerilatedVcdC *tfp = nullptr;
-
-public:
-    void enable(std::string const &filename, VTop &top)
+    std::optional<uint32_t> symbol(std::string const &name) const
     {
-        Verilated::traceEverOn(true);
-        tfp = new VerilatedVcdC;
-        top.trace(tfp, 99);
-        tfp->open(filename.c_str());
-        tfp->set_time_resolution("1ps");
-        tfp->set_time_unit("1ns");
-        if (!tfp->isOpen()) {
-            throw std::runtime_error("Failed to open VCD dump file " +
-                                     filename);
-        }
-    }
-
-    void dump(vluint64_t time)
-    {
-        if (tfp) {
-            tfp->dump(time);
-        }
-    }
-
-    ~VCDTracer()
-    {
-        if (tfp) {
-            tfp->close();
-            delete tfp;
-        }
+        auto it = symbol_table.find(name);
+        if (it == symbol_table.end())
+            return std::nullopt;
+        return it->second;
     }
 };
 
@@ -128,27 +127,80 @@ uint32_t parse_number(std::string const &str)
     return std::stoul(str);
 }
 
+// One entry of a -batch manifest: program image, signature output range and
+// the address whose write ends the test (RISCOF's tohost symbol). Addresses
+// are numbers or symbol names resolved against the loaded ELF.
+struct BatchTest {
+    std::string instruction_filename;
+    std::string signature_filename;
+    std::string signature_begin;
+    std::string signature_end;
+    std::string halt_address;
+};
+
+// Manifest format: one test per line, '#' starts a comment
+//   <program> <signature file> [<begin_signature> <end_signature> <tohost>]
+// The three addresses default to the RISCOF symbol names, so an ELF program
+// needs only the first two fields.
+std::vector<BatchTest> load_manifest(std::string const &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+        throw std::runtime_error("Could not open batch manifest " + filename);
+    std::vector<BatchTest> tests;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string program, signature, begin;
+        std::string end = "end_signature", tohost = "tohost";
+        if (!(fields >> program))
+            continue;
+        if (!(fields >> signature) ||
+            ((fields >> begin) && !(fields >> end >> tohost)))
+            throw std::runtime_error("Malformed batch manifest line: " + line);
+        if (begin.empty())
+            begin = "begin_signature";
+        tests.push_back({program, signature, begin, end, tohost});
+    }
+    return tests;
+}
+
 class Simulator
 {
     vluint64_t main_time = 0;
     vluint64_t max_sim_time = 10000;
     uint32_t halt_address = 0;
+    uint32_t halt_value = 0xBABECAFE;
+    bool report_progress = true;
+    Heartbeat heartbeat{0.75};  // 3 rising clock edges every 4 steps
     size_t memory_words = 1024 * 1024;  // 4MB
     bool dump_vcd = false;
     std::unique_ptr<VTop> top;
-    std::unique_ptr<VCDTracer> vcd_tracer;
+    std::unique_ptr<WaveTracer> vcd_tracer;
     std::unique_ptr<Memory> memory;
     bool dump_signature = false;
     unsigned long signature_begin, signature_end;
+    std::string halt_spec, signature_begin_spec, signature_end_spec;
+    std::vector<std::string> watch_specs;
+    std::vector<std::pair<uint32_t, uint32_t>> watch_ranges;
     std::string signature_filename;
     std::string instruction_filename;
+    SimStats stats;
+    bool print_stats = false;
 
 public:
+    // -batch -fork: called once, at the last reset cycle of run(). It
+    // returns true in each forked child after the child loaded its test, so
+    // the run goes on with the test program, and false in the parent.
+    std::function<bool()> on_reset;
+
     void parse_args(std::vector<std::string> const &args)
     {
+        print_stats =
+            std::find(args.begin(), args.end(), "-stats") != args.end();
         auto it = std::find(args.begin(), args.end(), "-halt");
         if (it != args.end()) {
-            halt_address = parse_number(*(it + 1));
+            halt_spec = *(it + 1);
         }
 
         it = std::find(args.begin(), args.end(), "-memory");
@@ -166,11 +218,18 @@ public:
             vcd_tracer->enable(*(it + 1), *top);
         }
 
+        for (auto it = args.begin(); it != args.end() && it + 1 != args.end();
+             ++it) {
+            vcd_tracer->parse_option(*it, *(it + 1));
+            if (*it == "-watch")
+                watch_specs.push_back(*(it + 1));
+        }
+
         it = std::find(args.begin(), args.end(), "-signature");
         if (it != args.end()) {
             dump_signature = true;
-            signature_begin = parse_number(*(it + 1));
-            signature_end = parse_number(*(it + 2));
+            signature_begin_spec = *(it + 1);
+            signature_end_spec = *(it + 2);
             signature_filename = *(it + 3);
         }
 
@@ -180,23 +239,123 @@ public:
         }
     }
 
-    Simulator(std::vector<std::string> const &args)
-        : top(std::make_unique<VTop>()),
-          vcd_tracer(std::make_unique<VCDTracer>())
+    // A null context uses Verilator's default one; -batch workers pass their
+    // own so that models in different threads never share a context.
+    Simulator(std::vector<std::string> const &args,
+              VerilatedContext *contextp = nullptr)
+        : top(contextp ? std::make_unique<VTop>(contextp)
+                       : std::make_unique<VTop>()),
+          vcd_tracer(std::make_unique<WaveTracer>())
     {
         parse_args(args);
         memory = std::make_unique<Memory>(memory_words);
         if (!instruction_filename.empty()) {
             memory->load_binary(instruction_filename);
         }
+        resolve_addresses();
+    }
+
+    // -halt and -signature take numbers or symbols of the loaded ELF; halting
+    // on tohost waits for the 1 that RVMODEL_HALT stores there.
+    void resolve_addresses()
+    {
+        if (!halt_spec.empty()) {
+            halt_address = resolve_address(halt_spec);
+            if (halt_spec == "tohost")
+                halt_value = 1;
+        }
+        if (dump_signature) {
+            signature_begin = resolve_address(signature_begin_spec);
+            signature_end = resolve_address(signature_end_spec);
+        }
+        // -watch ADDR or -watch BEGIN:END (end exclusive)
+        watch_ranges.clear();
+        for (auto const &spec : watch_specs) {
+            auto colon = spec.find(':');
+            uint32_t begin = resolve_address(spec.substr(0, colon));
+            uint32_t end = colon == std::string::npos
+                               ? begin + 4
+                               : resolve_address(spec.substr(colon + 1));
+            watch_ranges.emplace_back(begin, end);
+        }
+    }
+
+    // Print -watch hits; returns true when the halt watch fired
+    bool report_watch_hits(std::optional<unsigned> halt_watch)
+    {
+        bool halt = false;
+        for (auto const &hit : memory->watches.take()) {
+            if (hit.id == halt_watch) {
+                halt = true;
+                continue;
+            }
+            std::cerr << "[watch] time " << main_time << ": 0x" << std::hex
+                      << hit.address << " = 0x" << hit.value << std::dec
+                      << std::endl;
+        }
+        return halt;
     }
 
-    void run()
+    uint32_t resolve_address(std::string const &spec)
+    {
+        if (auto address = memory->symbol(spec))
+            return *address;
+        if (spec.empty() || !isdigit(static_cast<unsigned char>(spec[0])))
+            throw std::runtime_error("Unknown symbol " + spec);
+        return parse_number(spec);
+    }
+
+    // Prepare a reused model for the next -batch test: clear memory, load the
+    // program and take halt/signature settings from the manifest entry. The
+    // model itself is returned to its reset state by run(). A fork-server
+    // child (warm) is already in reset and keeps its time; its signature goes
+    // to the parent through write_signature() rather than to a file.
+    void load_test(BatchTest const &test, bool warm = false)
+    {
+        if (!warm)
+            main_time = 0;
+        memory->clear();
+        memory->load_binary(test.instruction_filename);
+        halt_spec = test.halt_address;
+        dump_signature = true;
+        signature_begin_spec = test.signature_begin;
+        signature_end_spec = test.signature_end;
+        resolve_addresses();
+        halt_value = 1;  // RVMODEL_HALT stores 1 to tohost
+        signature_filename = warm ? "" : test.signature_filename;
+        report_progress = false;
+    }
+
+    unsigned threads() const { return top->contextp()->threads(); }
+
+    void write_signature(std::ostream &out)
+    {
+        char data[9] = {0};
+        for (size_t addr = signature_begin; addr < signature_end; addr += 4) {
+            snprintf(data, 9, "%08x", memory->read(addr));
+            out << data << std::endl;
+        }
+    }
+
+    // Halt and -watch ranges of the loaded program
+    std::optional<unsigned> arm_watches()
+    {
+        memory->watches.clear();
+        std::optional<unsigned> halt_watch;
+        if (halt_address)
+            halt_watch = memory->watches.add_word(halt_address, halt_value);
+        for (auto const &range : watch_ranges)
+            memory->watches.add(range.first, range.second);
+        return halt_watch;
+    }
+
+    // Returns true when the halt condition was met, false on timeout
+    bool run()
     {
         top->reset = 1;
         top->clock = 0;
         top->io_instruction_valid = 1;
-        top->eval();
+        stats.eval(*top);
         vcd_tracer->dump(main_time);
         uint32_t data_memory_read_word = 0;
         uint32_t inst_memory_read_word = 0;
@@ -206,7 +365,13 @@ public:
         int uart_write_time_counter = 0,
             uart_write_time_limit =
                 4;  // every limit, an UART write completes; this is tricky part
-        while (main_time < max_sim_time && !Verilated::gotFinish()) {
+        bool halted = false;
+
+        // Writes are the only way to change memory, so halt and -watch are
+        // checked by Memory::write() rather than by polling here
+        std::optional<unsigned> halt_watch = arm_watches();
+        heartbeat.restart();
+        while (main_time < max_sim_time && !top->contextp()->gotFinish()) {
             ++main_time;
             ++counter;
             if (counter > clocktime) {
@@ -220,7 +385,14 @@ public:
             top->io_memory_bundle_read_data = data_memory_read_word;
             top->io_instruction = inst_memory_read_word;
             top->clock = !top->clock;
-            top->eval();
+            stats.eval(*top);
+            // Reset is still held here, so nothing the model has seen of the
+            // (empty) memory so far is kept
+            if (on_reset && main_time == 2) {
+                if (!on_reset())
+                    return false;
+                halt_watch = arm_watches();
+            }
 
             if (top->io_deviceSelect == 2 &&
                 top->io_memory_bundle_write_enable) {
@@ -246,30 +418,26 @@ public:
                               top->io_memory_bundle_write_data,
                               memory_write_strobe);
             }
+            vcd_tracer->check_pc(top->io_instruction_address);
+            if (top->io_memory_bundle_write_enable)
+                vcd_tracer->check_store(top->io_memory_bundle_address);
             vcd_tracer->dump(main_time);
-            if (halt_address) {
-                if (memory->read(halt_address) == 0xBABECAFE) {
-                    break;
-                }
+            if (memory->watches.pending() && report_watch_hits(halt_watch)) {
+                halted = true;
+                break;
             }
 
-            // print simulation progress in percentage every 10%
-            if (main_time % (max_sim_time / 10) == 0 && main_time > 0) {
-                std::cerr << "Simulation progress: "
-                          << (main_time * 100 / max_sim_time) << "%"
-                          << std::endl;
-            }
+            if (report_progress)
+                heartbeat.tick(main_time, max_sim_time);
         }
 
-        if (dump_signature) {
-            char data[9] = {0};
+        if (dump_signature && !signature_filename.empty()) {
             std::ofstream signature_file(signature_filename);
-            for (size_t addr = signature_begin; addr < signature_end;
-                 addr += 4) {
-                snprintf(data, 9, "%08x", memory->read(addr));
-                signature_file << data << std::endl;
-            }
+            write_signature(signature_file);
         }
+        if (print_stats)
+            stats.report();
+        return halted;
     }
 
     ~Simulator()
@@ -280,10 +448,131 @@ public:
     }
 };
 
+// Per-test options come from the manifest; tracing is not supported
+std::vector<std::string> batch_args(std::vector<std::string> const &args)
+{
+    std::vector<std::string> worker_args;
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        if ((*it == "-vcd" || *it == "-instruction") &&
+            std::next(it) != args.end())
+            ++it;
+        else
+            worker_args.push_back(*it);
+    }
+    return worker_args;
+}
+
+// Runs every manifest entry on a pool of worker threads. Each worker owns a
+// VerilatedContext and one model that is reset and reloaded for each test,
+// so a test costs only its own simulation time.
+int run_batch(std::vector<std::string> const &args,
+              std::string const &manifest,
+              unsigned jobs)
+{
+    auto tests = load_manifest(manifest);
+    auto worker_args = batch_args(args);
+
+    std::atomic<size_t> next_test{0};
+    std::atomic<size_t> failures{0};
+    std::mutex report_mutex;
+    auto worker = [&]() {
+        VerilatedContext context;
+        Simulator simulator(worker_args, &context);
+        for (size_t i = next_test++; i < tests.size(); i = next_test++) {
+            std::string status;
+            try {
+                simulator.load_test(tests[i]);
+                status = simulator.run() ? "halted" : "TIMEOUT";
+            } catch (const std::exception &e) {
+                status = std::string("ERROR: ") + e.what();
+            }
+            if (status != "halted")
+                ++failures;
+            std::lock_guard<std::mutex> lock(report_mutex);
+            std::cout << "[batch] " << tests[i].instruction_filename << ": "
+                      << status << std::endl;
+        }
+    };
+
+    jobs = std::max(1u, std::min<unsigned>(jobs, tests.size()));
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; ++i)
+        workers.emplace_back(worker);
+    for (auto &w : workers)
+        w.join();
+
+    std::cout << "[batch] " << tests.size() - failures << "/" << tests.size()
+              << " tests halted (" << jobs << " jobs)" << std::endl;
+    return failures ? 1 : 0;
+}
+
+// -batch -fork: one model is built and reset here, and every test runs in a
+// fork()ed copy of it (see fork_server.h), `jobs` at a time
+int run_fork_server(std::vector<std::string> const &args,
+                    std::string const &manifest,
+                    unsigned jobs)
+{
+    auto tests = load_manifest(manifest);
+    Simulator simulator(batch_args(args));
+    if (simulator.threads() > 1) {
+        std::cerr << "-fork needs a single-threaded model "
+                     "(VERILATOR_THREADS=1)"
+                  << std::endl;
+        return 1;
+    }
+
+    size_t failures = 0;
+    auto report = [&](size_t test, std::string const &status,
+                      std::string const &signature) {
+        if (status != "halted")
+            ++failures;
+        if (!signature.empty())
+            std::ofstream(tests[test].signature_filename) << signature;
+        std::cout << "[batch] " << tests[test].instruction_filename << ": "
+                  << status << std::endl;
+    };
+
+    ForkServer server(jobs);
+    std::optional<size_t> child;
+    simulator.on_reset = [&]() {
+        child = server.serve(tests.size(), report);
+        if (child)
+            simulator.load_test(tests[*child], true);
+        return child.has_value();
+    };
+    try {
+        bool halted = simulator.run();
+        if (child) {
+            std::ostringstream signature;
+            simulator.write_signature(signature);
+            server.finish(halted ? "halted" : "TIMEOUT", signature.str());
+        }
+    } catch (const std::exception &e) {
+        if (child)
+            server.finish(std::string("ERROR: ") + e.what(), "");
+        throw;
+    }
+
+    std::cout << "[batch] " << tests.size() - failures << "/" << tests.size()
+              << " tests halted (" << jobs << " jobs, fork server)"
+              << std::endl;
+    return failures ? 1 : 0;
+}
+
 int main(int argc, char **argv)
 {
     Verilated::commandArgs(argc, argv);
     std::vector<std::string> args(argv, argv + argc);
+    if (auto it = std::find(args.begin(), args.end(), "-batch");
+        it != args.end() && std::next(it) != args.end()) {
+        unsigned jobs = std::thread::hardware_concurrency();
+        if (auto jt = std::find(args.begin(), args.end(), "-jobs");
+            jt != args.end() && std::next(jt) != args.end())
+            jobs = std::stoul(*(jt + 1));
+        if (std::find(args.begin(), args.end(), "-fork") != args.end())
+            return run_fork_server(args, *(it + 1), jobs);
+        return run_batch(args, *(it + 1), jobs);
+    }
     Simulator simulator(args);
     simulator.run();
     return 0;
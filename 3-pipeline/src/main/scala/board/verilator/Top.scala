@@ -10,10 +10,10 @@ import riscv.core.CPU
 import riscv.core.CPUBundle
 import riscv.ImplementationType
 
-class Top extends Module {
+class Top(implementation: Int = ImplementationType.ThreeStage) extends Module {
   val io = IO(new CPUBundle)
 
-  val cpu = Module(new CPU(implementation = ImplementationType.ThreeStage))
+  val cpu = Module(new CPU(implementation = implementation))
 
   io.device_select              := 0.U
   cpu.io.debug_read_address     := io.debug_read_address
@@ -27,11 +27,32 @@ class Top extends Module {
 
   cpu.io.interrupt_flag    := io.interrupt_flag
   cpu.io.instruction_valid := io.instruction_valid
+
+  io.retire_valid   := cpu.io.retire_valid
+  io.retire_address := cpu.io.retire_address
 }
 
 object VerilogGenerator extends App {
-  (new ChiselStage).emitVerilog(
-    new Top(),
-    Array("--target-dir", "3-pipeline/verilog/verilator")
+  // Core variants by package name, as used for the per-variant model directories
+  val variants = Seq(
+    "threestage"        -> ImplementationType.ThreeStage,
+    "fivestage_stall"   -> ImplementationType.FiveStageStall,
+    "fivestage_forward" -> ImplementationType.FiveStageForward,
+    "fivestage_final"   -> ImplementationType.FiveStageFinal
   )
+
+  // --variants emits every core into verilog/verilator/<variant>/Top.v for
+  // `make cpi`; without it the ThreeStage core goes to verilog/verilator.
+  if (args.contains("--variants")) {
+    for ((name, implementation) <- variants)
+      (new ChiselStage).emitVerilog(
+        new Top(implementation),
+        Array("--target-dir", s"3-pipeline/verilog/verilator/$name")
+      )
+  } else {
+    (new ChiselStage).emitVerilog(
+      new Top(),
+      Array("--target-dir", "3-pipeline/verilog/verilator")
+    )
+  }
 }
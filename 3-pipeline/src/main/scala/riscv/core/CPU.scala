@@ -79,6 +79,8 @@ import riscv.ImplementationType
  * Design Notes:
  * - All implementations pass RISC-V compliance tests
  * - Choice between implementations is a performance/complexity trade-off
+ * - `make cpi` measures cycles, CPI and stall/flush counts of all four on the
+ *   same programs; the CPI row above is only a rough guide
  * - ThreeStage recommended for educational purposes
  * - FiveStageFinal recommended for performance-critical applications
  * - See claudedocs/pipeline_implementations_guide.md for detailed comparison
@@ -19,4 +19,8 @@ class CPUBundle extends Bundle {
   val debug_read_data        = Output(UInt(Parameters.DataWidth))
   val csr_debug_read_address = Input(UInt(Parameters.CSRRegisterAddrWidth))
   val csr_debug_read_data    = Output(UInt(Parameters.DataWidth))
+
+  // Instruction leaving the last pipeline stage this cycle (bubbles excluded)
+  val retire_valid   = Output(Bool())
+  val retire_address = Output(UInt(Parameters.AddrWidth))
 }
@@ -11,14 +11,19 @@ import riscv.Parameters
 
 object CSRRegister {
   // Refer to Spec. Vol.II Page 8-10
-  val MSTATUS  = 0x300.U(Parameters.CSRRegisterAddrWidth)
-  val MIE      = 0x304.U(Parameters.CSRRegisterAddrWidth)
-  val MTVEC    = 0x305.U(Parameters.CSRRegisterAddrWidth)
-  val MSCRATCH = 0x340.U(Parameters.CSRRegisterAddrWidth)
-  val MEPC     = 0x341.U(Parameters.CSRRegisterAddrWidth)
-  val MCAUSE   = 0x342.U(Parameters.CSRRegisterAddrWidth)
-  val CycleL   = 0xc00.U(Parameters.CSRRegisterAddrWidth)
-  val CycleH   = 0xc80.U(Parameters.CSRRegisterAddrWidth)
+  val MSTATUS     = 0x300.U(Parameters.CSRRegisterAddrWidth)
+  val MIE         = 0x304.U(Parameters.CSRRegisterAddrWidth)
+  val MTVEC       = 0x305.U(Parameters.CSRRegisterAddrWidth)
+  val MSCRATCH    = 0x340.U(Parameters.CSRRegisterAddrWidth)
+  val MEPC        = 0x341.U(Parameters.CSRRegisterAddrWidth)
+  val MCAUSE      = 0x342.U(Parameters.CSRRegisterAddrWidth)
+  val CycleL      = 0xc00.U(Parameters.CSRRegisterAddrWidth)
+  val CycleH      = 0xc80.U(Parameters.CSRRegisterAddrWidth)
+  val InstretL    = 0xc02.U(Parameters.CSRRegisterAddrWidth)
+  val InstretH    = 0xc82.U(Parameters.CSRRegisterAddrWidth)
+  // Hazard event counters, numbered as mhpmcounter4/6 in 4-soc
+  val HPMCounter4 = 0xc04.U(Parameters.CSRRegisterAddrWidth) // cycles the PC stalls on a data hazard
+  val HPMCounter6 = 0xc06.U(Parameters.CSRRegisterAddrWidth) // cycles fetch is flushed by a control transfer
 }
 
 class CSR extends Module {
@@ -29,6 +34,11 @@ class CSR extends Module {
     val reg_write_data_ex      = Input(UInt(Parameters.DataWidth))
     val debug_reg_read_address = Input(UInt(Parameters.CSRRegisterAddrWidth))
 
+    // Per-cycle events from the pipeline for instret and the hazard counters
+    val retired       = Input(Bool())
+    val hazard_stall  = Input(Bool())
+    val control_flush = Input(Bool())
+
     val id_reg_read_data    = Output(UInt(Parameters.DataWidth))
     val debug_reg_read_data = Output(UInt(Parameters.DataWidth))
 
@@ -42,18 +52,28 @@ class CSR extends Module {
   val mepc     = RegInit(UInt(Parameters.DataWidth), 0.U)
   val mcause   = RegInit(UInt(Parameters.DataWidth), 0.U)
   val cycles   = RegInit(UInt(64.W), 0.U)
+  val instret  = RegInit(UInt(64.W), 0.U)
+  val stalls   = RegInit(UInt(Parameters.DataWidth), 0.U)
+  val flushes  = RegInit(UInt(Parameters.DataWidth), 0.U)
   val regLUT =
     IndexedSeq(
-      CSRRegister.MSTATUS  -> mstatus,
-      CSRRegister.MIE      -> mie,
-      CSRRegister.MTVEC    -> mtvec,
-      CSRRegister.MSCRATCH -> mscratch,
-      CSRRegister.MEPC     -> mepc,
-      CSRRegister.MCAUSE   -> mcause,
-      CSRRegister.CycleL   -> cycles(31, 0),
-      CSRRegister.CycleH   -> cycles(63, 32),
+      CSRRegister.MSTATUS     -> mstatus,
+      CSRRegister.MIE         -> mie,
+      CSRRegister.MTVEC       -> mtvec,
+      CSRRegister.MSCRATCH    -> mscratch,
+      CSRRegister.MEPC        -> mepc,
+      CSRRegister.MCAUSE      -> mcause,
+      CSRRegister.CycleL      -> cycles(31, 0),
+      CSRRegister.CycleH      -> cycles(63, 32),
+      CSRRegister.InstretL    -> instret(31, 0),
+      CSRRegister.InstretH    -> instret(63, 32),
+      CSRRegister.HPMCounter4 -> stalls,
+      CSRRegister.HPMCounter6 -> flushes,
     )
-  cycles := cycles + 1.U
+  cycles  := cycles + 1.U
+  instret := instret + io.retired
+  stalls  := stalls + io.hazard_stall
+  flushes := flushes + io.control_flush
 
   // If the pipeline and the CLINT are going to read and write the CSR at the same time, let the pipeline write first.
   // This is implemented in a single cycle by passing reg_write_data_ex to clint and writing the data from the CLINT to the CSR.
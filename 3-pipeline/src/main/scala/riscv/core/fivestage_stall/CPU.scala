@@ -7,6 +7,7 @@ package riscv.core.fivestage_stall
 import chisel3._
 import riscv.core.CPUBundle
 import riscv.core.CSR
+import riscv.core.PipelineRegister
 import riscv.core.RegisterFile
 import riscv.Parameters
 
@@ -160,10 +161,35 @@ class CPU extends Module {
   clint.io.interrupt_flag         := io.interrupt_flag // Direct connection, bypass IF2ID pipeline delay
   clint.io.csr_bundle <> csr_regs.io.clint_access_bundle
 
+  // Valid bits riding alongside IF2ID..MEM2WB: stall bubbles, flushed
+  // wrong-path fetches and fetch wait states never count as retired
+  val if2id_valid  = Module(new PipelineRegister(1))
+  val id2ex_valid  = Module(new PipelineRegister(1))
+  val ex2mem_valid = Module(new PipelineRegister(1))
+  val mem2wb_valid = Module(new PipelineRegister(1))
+  if2id_valid.io.stall  := ctrl.io.if_stall
+  if2id_valid.io.flush  := ctrl.io.if_flush
+  if2id_valid.io.in     := io.instruction_valid
+  id2ex_valid.io.stall  := false.B
+  id2ex_valid.io.flush  := ctrl.io.id_flush
+  id2ex_valid.io.in     := if2id_valid.io.out
+  ex2mem_valid.io.stall := false.B
+  ex2mem_valid.io.flush := false.B
+  ex2mem_valid.io.in    := id2ex_valid.io.out
+  mem2wb_valid.io.stall := false.B
+  mem2wb_valid.io.flush := false.B
+  mem2wb_valid.io.in    := ex2mem_valid.io.out
+
+  io.retire_valid   := mem2wb_valid.io.out
+  io.retire_address := mem2wb.io.output_instruction_address
+
   csr_regs.io.reg_read_address_id    := id.io.ex_csr_address
   csr_regs.io.reg_write_enable_ex    := id2ex.io.output_csr_write_enable
   csr_regs.io.reg_write_address_ex   := id2ex.io.output_csr_address
   csr_regs.io.reg_write_data_ex      := ex.io.csr_write_data
   csr_regs.io.debug_reg_read_address := io.csr_debug_read_address
   io.csr_debug_read_data             := csr_regs.io.debug_reg_read_data
+  csr_regs.io.retired                := mem2wb_valid.io.out
+  csr_regs.io.hazard_stall           := ctrl.io.pc_stall
+  csr_regs.io.control_flush          := ctrl.io.if_flush
 }
@@ -7,6 +7,7 @@ package riscv.core.threestage
 import chisel3._
 import riscv.core.CPUBundle
 import riscv.core.CSR
+import riscv.core.PipelineRegister
 import riscv.core.RegisterFile
 import riscv.Parameters
 
@@ -113,10 +114,27 @@ class CPU extends Module {
   clint.io.interrupt_flag         := io.interrupt_flag // Direct connection, bypass IF2ID pipeline delay
   clint.io.csr_bundle <> csr_regs.io.clint_access_bundle
 
+  // Valid bits riding alongside IF2ID and ID2EX: flushed wrong-path
+  // fetches and fetch wait states never count as retired
+  val if2id_valid = Module(new PipelineRegister(1))
+  val id2ex_valid = Module(new PipelineRegister(1))
+  if2id_valid.io.stall := false.B
+  if2id_valid.io.flush := ctrl.io.Flush
+  if2id_valid.io.in    := io.instruction_valid
+  id2ex_valid.io.stall := false.B
+  id2ex_valid.io.flush := ctrl.io.Flush
+  id2ex_valid.io.in    := if2id_valid.io.out
+
+  io.retire_valid   := id2ex_valid.io.out
+  io.retire_address := id2ex.io.output_instruction_address
+
   csr_regs.io.reg_read_address_id    := id.io.ex_csr_address
   csr_regs.io.reg_write_enable_ex    := id2ex.io.output_csr_write_enable
   csr_regs.io.reg_write_address_ex   := id2ex.io.output_csr_address
   csr_regs.io.reg_write_data_ex      := ex.io.csr_write_data
   csr_regs.io.debug_reg_read_address := io.csr_debug_read_address
   io.csr_debug_read_data             := csr_regs.io.debug_reg_read_data
+  csr_regs.io.retired                := id2ex_valid.io.out
+  csr_regs.io.hazard_stall           := false.B
+  csr_regs.io.control_flush          := ctrl.io.Flush
 }
@@ -156,6 +156,28 @@ class PipelineProgramTest extends AnyFlatSpec with ChiselScalatestTester {
       }
     }
 
+    it should "count retired instructions and hazard events" in {
+      runProgram("hazard_extended.asmbin", cfg) { c =>
+        c.clock.step(1000)
+        def csr(address: UInt): BigInt = {
+          c.io.csr_debug_read_address.poke(address)
+          c.io.csr_debug_read_data.peek().litValue
+        }
+        val cycles  = csr(CSRRegister.CycleL)
+        val instret = csr(CSRRegister.InstretL)
+        val stalls  = csr(CSRRegister.HPMCounter4)
+        val flushes = csr(CSRRegister.HPMCounter6)
+        assert(instret > 0 && instret <= cycles, s"${cfg.name}: instret $instret, cycles $cycles")
+        // Spinning in `loop: j loop` flushes fetch on every iteration
+        assert(flushes > 0, s"${cfg.name}: no control flushes counted")
+        cfg.implementation match {
+          case ImplementationType.ThreeStage     => assert(stalls == 0, s"ThreeStage never stalls, got $stalls")
+          case ImplementationType.FiveStageStall => assert(stalls > 0, "RAW hazards must stall without forwarding")
+          case _                                 =>
+        }
+      }
+    }
+
     it should "handle machine-mode traps" in {
       runProgram("irqtrap.asmbin", cfg) { c =>
         c.clock.setTimeout(0)
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+#include <stddef.h>
+
+#include "bench.h"
+#include "mmio.h"
+
+/* Magic value to signal test completion to simulator */
+#define TEST_DONE_MAGIC 0xCAFEF00Du
+
+/* sim.cpp reports this result as TEST PASSED */
+#define BENCH_RESULT_PASS 0x0Fu
+
+/*
+ * Freestanding C library subset. Programs are linked without libc, and GCC
+ * may still emit calls to these for structure copies and clearing loops
+ * (-fno-builtin only stops it from expanding the calls inline).
+ */
+void *memcpy(void *dest, const void *src, size_t n)
+{
+    char *d = dest;
+    const char *s = src;
+    while (n--)
+        *d++ = *s++;
+    return dest;
+}
+
+void *memset(void *dest, int c, size_t n)
+{
+    unsigned char *d = dest;
+    while (n--)
+        *d++ = (unsigned char) c;
+    return dest;
+}
+
+char *strcpy(char *dest, const char *src)
+{
+    char *d = dest;
+    while ((*d++ = *src++))
+        ;
+    return dest;
+}
+
+int strcmp(const char *a, const char *b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (unsigned char) *a - (unsigned char) *b;
+}
+
+void bench_putc(char c)
+{
+    while (!(*UART_STATUS & UART_STATUS_TX_READY))
+        ;  // Wait for room in the TX FIFO
+    *UART_SEND = (unsigned char) c;
+}
+
+void bench_puts(const char *s)
+{
+    while (*s)
+        bench_putc(*s++);
+}
+
+/* Emit one converted field, padded to width; returns characters written */
+static int emit_field(const char *digits,
+                      int len,
+                      int negative,
+                      int width,
+                      int zero_pad)
+{
+    int count = 0;
+    int pad = width - len - negative;
+
+    if (negative && zero_pad) {
+        bench_putc('-');
+        count++;
+    }
+    for (; pad > 0; pad--, count++)
+        bench_putc(zero_pad ? '0' : ' ');
+    if (negative && !zero_pad) {
+        bench_putc('-');
+        count++;
+    }
+    for (int i = 0; i < len; i++, count++)
+        bench_putc(digits[i]);
+    return count;
+}
+
+int bench_vprintf(const char *fmt, va_list ap)
+{
+    int count = 0;
+
+    for (; *fmt; fmt++) {
+        if (*fmt != '%') {
+            bench_putc(*fmt);
+            count++;
+            continue;
+        }
+
+        int zero_pad = 0;
+        int width = 0;
+        fmt++;
+        if (*fmt == '0') {
+            zero_pad = 1;
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9')
+            width = width * 10 + (*fmt++ - '0');
+        while (*fmt == 'l')
+            fmt++;
+
+        char buf[12];
+        char *end = buf + sizeof(buf);
+        char *p = end;
+        int negative = 0;
+        uint32_t value;
+
+        switch (*fmt) {
+        case 'd':
+        case 'i': {
+            int32_t v = va_arg(ap, int32_t);
+            negative = v < 0;
+            value = negative ? 0u - (uint32_t) v : (uint32_t) v;
+            do {
+                *--p = '0' + value % 10;
+                value /= 10;
+            } while (value);
+            break;
+        }
+        case 'u':
+            value = va_arg(ap, uint32_t);
+            do {
+                *--p = '0' + value % 10;
+                value /= 10;
+            } while (value);
+            break;
+        case 'x':
+        case 'X': {
+            const char *hex =
+                *fmt == 'x' ? "0123456789abcdef" : "0123456789ABCDEF";
+            value = va_arg(ap, uint32_t);
+            do {
+                *--p = hex[value & 0xF];
+                value >>= 4;
+            } while (value);
+            break;
+        }
+        case 'c':
+            *--p = (char) va_arg(ap, int);
+            break;
+        case 's': {
+            const char *s = va_arg(ap, const char *);
+            int len = 0;
+            while (s[len])
+                len++;
+            count += emit_field(s, len, 0, width, 0);
+            continue;
+        }
+        case '%':
+            *--p = '%';
+            break;
+        default:  // Unknown conversion: print it verbatim
+            bench_putc('%');
+            count++;
+            if (!*fmt)
+                return count;
+            *--p = *fmt;
+            break;
+        }
+        count += emit_field(p, end - p, negative, width, zero_pad);
+    }
+    return count;
+}
+
+int bench_printf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int count = bench_vprintf(fmt, ap);
+    va_end(ap);
+    return count;
+}
+
+void bench_report(const char *name,
+                  uint32_t iterations,
+                  const struct bench_counters *elapsed)
+{
+    bench_printf(
+        "BENCH name=%s iterations=%u cycles=%u instret=%u branches=%u "
+        "mispredicts=%u\n",
+        name, iterations, elapsed->cycles, elapsed->instret,
+        elapsed->branches, elapsed->mispredicts);
+}
+
+void bench_exit(int valid)
+{
+    // The simulation stops at the done store, so drain the TX FIFO first:
+    // TX idle is set once the FIFO is empty and the last frame, stop bits
+    // included, has left the shift register (TX ready only means room for
+    // one more byte)
+    while (!(*UART_STATUS & UART_STATUS_TX_IDLE))
+        ;
+
+    *TEST_RESULT = valid ? BENCH_RESULT_PASS : 0;
+    *TEST_DONE_FLAG = TEST_DONE_MAGIC;
+}
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdarg.h>
+#include <stdint.h>
+
+/**
+ * Benchmark support shared by the CoreMark and Dhrystone ports
+ *
+ * Timing comes from the core's own counters rather than a timer peripheral:
+ * mcycle and minstret, plus mhpmcounter3 (branch mispredictions) and
+ * mhpmcounter8 (branches resolved) for the prediction statistics. Only the
+ * low halves are read, so a timed region must stay below 2^32 cycles
+ * (about 85 s of 50 MHz model time).
+ *
+ * Each benchmark prints its free-form output first and then exactly one
+ * result line with raw counts only:
+ *
+ *   BENCH name=<benchmark> iterations=N cycles=N instret=N branches=N
+ *         mispredicts=N
+ *
+ * (on one line). Derived figures (CoreMark/MHz, DMIPS/MHz, IPC,
+ * misprediction rate) are computed on the host by scripts/bench-report.py,
+ * which also requires the "Correct operation validated" line a benchmark
+ * prints when its self-check passes.
+ */
+
+/* Model clock, used only to convert cycles to seconds in reports */
+#define BENCH_CLOCK_HZ 50000000u
+
+struct bench_counters {
+    uint32_t cycles;
+    uint32_t instret;
+    uint32_t branches;
+    uint32_t mispredicts;
+};
+
+static inline void bench_read(struct bench_counters *c)
+{
+    uint32_t cycles, instret, branches, mispredicts;
+    __asm__ volatile("csrr %0, mcycle" : "=r"(cycles));
+    __asm__ volatile("csrr %0, minstret" : "=r"(instret));
+    __asm__ volatile("csrr %0, mhpmcounter8" : "=r"(branches));
+    __asm__ volatile("csrr %0, mhpmcounter3" : "=r"(mispredicts));
+    c->cycles = cycles;
+    c->instret = instret;
+    c->branches = branches;
+    c->mispredicts = mispredicts;
+}
+
+/* Counter deltas of the timed region (unsigned, so a single wrap is fine) */
+static inline void bench_elapsed(struct bench_counters *d,
+                                 const struct bench_counters *start,
+                                 const struct bench_counters *stop)
+{
+    d->cycles = stop->cycles - start->cycles;
+    d->instret = stop->instret - start->instret;
+    d->branches = stop->branches - start->branches;
+    d->mispredicts = stop->mispredicts - start->mispredicts;
+}
+
+/* UART output; bench_printf knows %d %i %u %x %X %s %c %% with an optional
+ * '0' flag, field width and 'l' modifier (long is 32 bits on ilp32) */
+void bench_putc(char c);
+void bench_puts(const char *s);
+int bench_vprintf(const char *fmt, va_list ap);
+int bench_printf(const char *fmt, ...);
+
+/* Print the BENCH result line for one timed region */
+void bench_report(const char *name,
+                  uint32_t iterations,
+                  const struct bench_counters *elapsed);
+
+/* Wait for the UART to drain, then end the simulation through the test
+ * harness registers (result 0xF when valid, which sim.cpp reports as
+ * TEST PASSED) */
+void bench_exit(int valid);
+
+#endif /* BENCH_H */
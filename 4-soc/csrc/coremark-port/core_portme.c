@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "../bench.h"
+#include "coremark.h"
+
+#ifndef ITERATIONS
+#define ITERATIONS 10
+#endif
+
+#if VALIDATION_RUN
+volatile ee_s32 seed1_volatile = 0x3415;
+volatile ee_s32 seed2_volatile = 0x3415;
+volatile ee_s32 seed3_volatile = 0x66;
+#endif
+#if PERFORMANCE_RUN
+volatile ee_s32 seed1_volatile = 0x0;
+volatile ee_s32 seed2_volatile = 0x0;
+volatile ee_s32 seed3_volatile = 0x66;
+#endif
+#if PROFILE_RUN
+volatile ee_s32 seed1_volatile = 0x8;
+volatile ee_s32 seed2_volatile = 0x8;
+volatile ee_s32 seed3_volatile = 0x8;
+#endif
+volatile ee_s32 seed4_volatile = ITERATIONS;
+volatile ee_s32 seed5_volatile = 0;
+
+ee_u32 default_num_contexts = 1;
+
+/* Counter snapshots around the timed region; mcycle doubles as the tick */
+static struct bench_counters start_counters, stop_counters;
+
+void start_time(void)
+{
+    bench_read(&start_counters);
+}
+
+void stop_time(void)
+{
+    bench_read(&stop_counters);
+}
+
+CORE_TICKS get_time(void)
+{
+    return stop_counters.cycles - start_counters.cycles;
+}
+
+secs_ret time_in_secs(CORE_TICKS ticks)
+{
+    return ticks / BENCH_CLOCK_HZ;
+}
+
+int ee_printf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int count = bench_vprintf(fmt, ap);
+    va_end(ap);
+    return count;
+}
+
+void portable_init(core_portable *p, int *argc, char *argv[])
+{
+    (void) argc;
+    (void) argv;
+    if (sizeof(ee_ptr_int) != sizeof(ee_u8 *))
+        ee_printf(
+            "ERROR! Please define ee_ptr_int to a type that holds a "
+            "pointer!\n");
+    if (sizeof(ee_u32) != 4)
+        ee_printf("ERROR! Please define ee_u32 to a 32b unsigned type!\n");
+    p->portable_id = 1;
+}
+
+/* Called last by core_main() with &results[0].port: the enclosing result
+ * holds the iteration count and the error count of the CRC self-check */
+void portable_fini(core_portable *p)
+{
+    core_results *r =
+        (core_results *) ((char *) p - offsetof(core_results, port));
+    struct bench_counters elapsed;
+
+    p->portable_id = 0;
+    bench_elapsed(&elapsed, &start_counters, &stop_counters);
+    bench_report("coremark", r->iterations, &elapsed);
+    bench_exit(r->err == 0);
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+/*
+ * CSR write masks, run under `make check-lockstep`
+ *
+ * Every value is read back into a register, so --lockstep compares the
+ * ISS against CSR.scala on each read. mcountinhibit implements CY, IR and
+ * HPM3..13 (0x3FFD); all ones must read back as exactly that.
+ */
+
+#include <stdint.h>
+
+#define MCOUNTINHIBIT_MASK 0x3FFDu
+
+/* sim.cpp reports this result as TEST PASSED */
+#define CSR_RESULT_PASS 0x1Fu
+
+static inline uint32_t swap_mcountinhibit(uint32_t value)
+{
+    uint32_t old;
+    __asm__ volatile("csrrw %0, mcountinhibit, %1" : "=r"(old) : "r"(value));
+    return old;
+}
+
+static inline uint32_t read_mcountinhibit(void)
+{
+    uint32_t value;
+    __asm__ volatile("csrr %0, mcountinhibit" : "=r"(value));
+    return value;
+}
+
+int main(void)
+{
+    int valid = 1;
+
+    swap_mcountinhibit(0xFFFFFFFFu);
+    valid &= read_mcountinhibit() == MCOUNTINHIBIT_MASK;
+    /* The old value of a swap goes through the same read path */
+    valid &= swap_mcountinhibit(0) == MCOUNTINHIBIT_MASK;
+    valid &= read_mcountinhibit() == 0;
+
+    /* Each inhibit bit on its own, to catch a mask that drops one */
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        swap_mcountinhibit(1u << bit);
+        valid &= read_mcountinhibit() == ((1u << bit) & MCOUNTINHIBIT_MASK);
+    }
+    swap_mcountinhibit(0);
+
+    *(volatile uint32_t *) 0x104 = valid ? CSR_RESULT_PASS : 0x01;
+    *(volatile uint32_t *) 0x100 = 0xCAFEF00D; /* Signal completion to sim.cpp */
+    return 0;
+}
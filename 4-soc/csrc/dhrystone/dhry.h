@@ -0,0 +1,92 @@
+/*
+ * Dhrystone 2.1 benchmark, after the C version by Rick Richardson of the
+ * original Ada benchmark by Reinhold P. Weicker (Siemens AG, 1984, 1988).
+ *
+ * Port for MyCPU 4-soc. The measured code (Proc_1 .. Proc_8, Func_1 ..
+ * Func_3 and the main loop) follows the 2.1 sources statement by statement,
+ * still split over two translation units so procedure calls across
+ * dhry_1.c and dhry_2.c cannot be inlined. Changes from the original:
+ * - ANSI prototypes instead of K&R definitions
+ * - The two records come from static storage instead of malloc()
+ * - Timing uses mcycle (bench.h) around the main loop; the result is
+ *   checked against the values the original asks the reader to compare
+ *   and printed as one BENCH line instead of the long listing
+ * - NUMBER_OF_RUNS is fixed at build time rather than read from stdin
+ */
+
+#ifndef DHRY_H
+#define DHRY_H
+
+#ifndef NUMBER_OF_RUNS
+#define NUMBER_OF_RUNS 2000
+#endif
+
+#define Null 0
+#define true 1
+#define false 0
+
+#define structassign(d, s) d = s
+
+typedef enum { Ident_1, Ident_2, Ident_3, Ident_4, Ident_5 } Enumeration;
+
+typedef int One_Thirty;
+typedef int One_Fifty;
+typedef char Capital_Letter;
+typedef int Boolean;
+typedef char Str_30[31];
+typedef int Arr_1_Dim[50];
+typedef int Arr_2_Dim[50][50];
+
+typedef struct record {
+    struct record *Ptr_Comp;
+    Enumeration Discr;
+    union {
+        struct {
+            Enumeration Enum_Comp;
+            int Int_Comp;
+            char Str_Comp[31];
+        } var_1;
+        struct {
+            Enumeration E_Comp_2;
+            char Str_2_Comp[31];
+        } var_2;
+        struct {
+            char Ch_1_Comp;
+            char Ch_2_Comp;
+        } var_3;
+    } variant;
+} Rec_Type, *Rec_Pointer;
+
+/* Globals, defined in dhry_1.c */
+extern Rec_Pointer Ptr_Glob, Next_Ptr_Glob;
+extern int Int_Glob;
+extern Boolean Bool_Glob;
+extern char Ch_1_Glob, Ch_2_Glob;
+extern int Arr_1_Glob[50];
+extern int Arr_2_Glob[50][50];
+
+/* dhry_1.c */
+void Proc_1(Rec_Pointer Ptr_Val_Par);
+void Proc_2(One_Fifty *Int_Par_Ref);
+void Proc_3(Rec_Pointer *Ptr_Ref_Par);
+void Proc_4(void);
+void Proc_5(void);
+
+/* dhry_2.c */
+void Proc_6(Enumeration Enum_Val_Par, Enumeration *Enum_Ref_Par);
+void Proc_7(One_Fifty Int_1_Par_Val,
+            One_Fifty Int_2_Par_Val,
+            One_Fifty *Int_Par_Ref);
+void Proc_8(Arr_1_Dim Arr_1_Par_Ref,
+            Arr_2_Dim Arr_2_Par_Ref,
+            int Int_1_Par_Val,
+            int Int_2_Par_Val);
+Enumeration Func_1(Capital_Letter Ch_1_Par_Val, Capital_Letter Ch_2_Par_Val);
+Boolean Func_2(Str_30 Str_1_Par_Ref, Str_30 Str_2_Par_Ref);
+Boolean Func_3(Enumeration Enum_Par_Val);
+
+/* bench.c */
+char *strcpy(char *dest, const char *src);
+int strcmp(const char *a, const char *b);
+
+#endif /* DHRY_H */
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+/*
+ * DMA controller demo: cycles a bulk transfer costs the CPU with and
+ * without the DMA engine (see DMA_BASE in mmio.h)
+ *
+ * Each kernel moves the same words twice, first with a CPU load/store loop
+ * and then with one DMA descriptor that the CPU polls to completion, and
+ * prints one line with the mcycle counts and the DMA status counters:
+ *
+ *   DMA kernel=<name> words=N cpu_cycles=N dma_cycles=N saved=N
+ *       dma_busy=N dma_wait=N
+ *
+ * (on one line; saved is cpu_cycles - dma_cycles, negative when the CPU
+ * loop wins).
+ *
+ *   memcpy   RAM to RAM, stride 4 on both sides (bursts)
+ *   memset   DMA_CTRL_FILL into RAM
+ *   frame    RAM to VGA_STREAM_DATA (destination stride 0), one 64x64
+ *            frame upload as nyancat does it
+ *
+ * A final "overlap" line starts the memcpy with DMA_CTRL_IRQ_EN and keeps
+ * the CPU computing until the completion interrupt arrives; work=N is the
+ * number of loop iterations the CPU got through meanwhile.
+ *
+ * Every destination is checked, and the program ends with bench_exit, so
+ * sim.cpp reports TEST PASSED only when all of them are right. The DMA does
+ * not go through the caches: run it without the D-cache (the default).
+ */
+
+#include <stdint.h>
+
+#include "bench.h"
+#include "mmio.h"
+
+#ifndef COPY_WORDS
+#define COPY_WORDS 1024
+#endif
+
+#define FILL_PATTERN 0x5A5AA5A5u
+
+static uint32_t source[COPY_WORDS];
+static uint32_t destination[COPY_WORDS];
+static uint32_t frame[VGA_WORDS_PER_FRAME];
+
+static volatile uint32_t dma_interrupts;
+
+void enable_interrupt(void); /* init.S: mtvec, MIE, MTIE and MEIE */
+
+static inline uint32_t cycles_now(void)
+{
+    uint32_t cycles;
+    __asm__ volatile("csrr %0, mcycle" : "=r"(cycles));
+    return cycles;
+}
+
+/* The CPU copies through volatile pointers so the compiler keeps one load
+ * and one store per word (and emits no memcpy call) */
+static void cpu_copy(volatile uint32_t *dst,
+                     const volatile uint32_t *src,
+                     uint32_t words,
+                     int dst_fixed)
+{
+    for (uint32_t i = 0; i < words; i++)
+        dst[dst_fixed ? 0 : i] = src[i];
+}
+
+static void cpu_fill(volatile uint32_t *dst, uint32_t value, uint32_t words)
+{
+    for (uint32_t i = 0; i < words; i++)
+        dst[i] = value;
+}
+
+static void clear(uint32_t *dst, uint32_t words)
+{
+    for (uint32_t i = 0; i < words; i++)
+        ((volatile uint32_t *) dst)[i] = 0;
+}
+
+static int check_copy(const uint32_t *dst, uint32_t words)
+{
+    for (uint32_t i = 0; i < words; i++)
+        if (dst[i] != source[i])
+            return 0;
+    return 1;
+}
+
+static int check_fill(const uint32_t *dst, uint32_t words)
+{
+    for (uint32_t i = 0; i < words; i++)
+        if (dst[i] != FILL_PATTERN)
+            return 0;
+    return 1;
+}
+
+static void report(const char *name,
+                   uint32_t words,
+                   uint32_t cpu_cycles,
+                   uint32_t dma_cycles,
+                   uint32_t busy,
+                   uint32_t wait)
+{
+    bench_printf(
+        "DMA kernel=%s words=%u cpu_cycles=%u dma_cycles=%u saved=%d "
+        "dma_busy=%u dma_wait=%u\n",
+        name, words, cpu_cycles, dma_cycles,
+        (int) (cpu_cycles - dma_cycles), busy, wait);
+}
+
+/* Time one DMA descriptor from the first register write to !BUSY */
+static uint32_t dma_run(uint32_t dst,
+                        uint32_t src,
+                        uint32_t words,
+                        uint32_t dst_stride,
+                        uint32_t ctrl,
+                        uint32_t *busy,
+                        uint32_t *wait)
+{
+    uint32_t busy_start = *DMA_BUSY_CYCLES, wait_start = *DMA_WAIT_CYCLES;
+    uint32_t start = cycles_now();
+    dma_start(dst, src, words, dst_stride, 4, ctrl);
+    dma_wait();
+    uint32_t elapsed = cycles_now() - start;
+    *busy = *DMA_BUSY_CYCLES - busy_start;
+    *wait = *DMA_WAIT_CYCLES - wait_start;
+    *DMA_STATUS = DMA_STATUS_DONE;
+    return elapsed;
+}
+
+void trap_handler(uint32_t mepc, uint32_t mcause)
+{
+    (void) mepc;
+    if (mcause == 0x8000000Bu && (*DMA_STATUS & DMA_STATUS_DONE)) {
+        *DMA_STATUS = DMA_STATUS_DONE;
+        dma_interrupts++;
+    }
+}
+
+int main(void)
+{
+    uint32_t start, cpu_cycles, dma_cycles, busy, wait;
+    int valid = 1;
+
+    for (uint32_t i = 0; i < COPY_WORDS; i++)
+        source[i] = i * 0x9E3779B9u;
+    for (uint32_t i = 0; i < VGA_WORDS_PER_FRAME; i++)
+        frame[i] = source[i];
+
+    /* memcpy */
+    start = cycles_now();
+    cpu_copy(destination, source, COPY_WORDS, 0);
+    cpu_cycles = cycles_now() - start;
+    valid &= check_copy(destination, COPY_WORDS);
+    clear(destination, COPY_WORDS);
+    dma_cycles = dma_run((uint32_t) destination, (uint32_t) source,
+                         COPY_WORDS, 4, 0, &busy, &wait);
+    valid &= check_copy(destination, COPY_WORDS);
+    report("memcpy", COPY_WORDS, cpu_cycles, dma_cycles, busy, wait);
+
+    /* memset */
+    start = cycles_now();
+    cpu_fill(destination, FILL_PATTERN, COPY_WORDS);
+    cpu_cycles = cycles_now() - start;
+    valid &= check_fill(destination, COPY_WORDS);
+    clear(destination, COPY_WORDS);
+    *DMA_FILL = FILL_PATTERN;
+    dma_cycles = dma_run((uint32_t) destination, 0, COPY_WORDS, 4,
+                         DMA_CTRL_FILL, &busy, &wait);
+    valid &= check_fill(destination, COPY_WORDS);
+    report("memset", COPY_WORDS, cpu_cycles, dma_cycles, busy, wait);
+
+    /* frame: the stream port is write-only, so only the number of words
+     * the DMA wrote is checked */
+    vga_write32(VGA_ADDR_UPLOAD_ADDR, 0);
+    start = cycles_now();
+    cpu_copy(VGA_STREAM_DATA, frame, VGA_WORDS_PER_FRAME, 1);
+    cpu_cycles = cycles_now() - start;
+    vga_write32(VGA_ADDR_UPLOAD_ADDR, 0);
+    uint32_t words_start = *DMA_WORDS;
+    dma_cycles = dma_run(VGA_ADDR_STREAM_DATA, (uint32_t) frame,
+                         VGA_WORDS_PER_FRAME, 0, 0, &busy, &wait);
+    valid &= *DMA_WORDS - words_start == VGA_WORDS_PER_FRAME;
+    report("frame", VGA_WORDS_PER_FRAME, cpu_cycles, dma_cycles, busy, wait);
+
+    /* overlap: compute while the copy runs, until the interrupt */
+    clear(destination, COPY_WORDS);
+    enable_interrupt();
+    uint32_t transfers = *DMA_TRANSFERS;
+    uint32_t x = 1, work = 0;
+    start = cycles_now();
+    dma_start((uint32_t) destination, (uint32_t) source, COPY_WORDS, 4, 4,
+              DMA_CTRL_IRQ_EN);
+    while (!dma_interrupts) {
+        x = x * 1664525u + 1013904223u;
+        work++;
+    }
+    dma_cycles = cycles_now() - start;
+    *DMA_CTRL = 0;
+    valid &= check_copy(destination, COPY_WORDS);
+    valid &= dma_interrupts == 1 && *DMA_TRANSFERS - transfers == 1;
+    bench_printf("DMA kernel=overlap words=%u cycles=%u work=%u x=%x\n",
+                 COPY_WORDS, dma_cycles, work, x);
+
+    bench_printf("dma: %u transfers, %u words, %u interrupt(s)\n",
+                 *DMA_TRANSFERS, *DMA_WORDS, dma_interrupts);
+    if (valid)
+        bench_printf("Correct operation validated.\n");
+    bench_exit(valid);
+    return 0;
+}
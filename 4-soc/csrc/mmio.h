@@ -19,13 +19,24 @@
  *
  * Register Map:
  *   +0x00: VGA_ID          - Peripheral ID (RO: 0x56474131 = 'VGA1')
- *   +0x04: VGA_STATUS      - Vblank status, safe to swap, upload busy
+ *   +0x04: VGA_STATUS      - Vblank, safe to swap, fill busy, flip pending
  *   +0x08: VGA_INTR_STATUS - Vblank interrupt flag (W1C)
  *   +0x10: VGA_UPLOAD_ADDR - Framebuffer upload address (nibble index + frame)
  *   +0x14: VGA_STREAM_DATA - 8 pixels packed in 32-bit word (auto-increment)
- *   +0x20: VGA_CTRL        - Display enable, blank, swap request, frame select
+ *   +0x18: VGA_FILL_DATA   - Word written by the fill engine
+ *   +0x1C: VGA_FILL_COUNT  - Write N: fill N words from VGA_UPLOAD_ADDR
+ *   +0x20: VGA_CTRL        - Display enable, blank, swap at vblank, frame
  *   +0x24-0x60: VGA_PALETTE[0-15] - 6-bit VGA colors (RRGGBB)
  *
+ * Double buffering: render into a frame that is not displayed, then write
+ * VGA_CTRL with VGA_CTRL_SWAP and the new frame. The switch happens at the
+ * next vblank; VGA_STATUS_FLIP_PENDING clears once it is on screen, after
+ * which the old frame is free to draw into.
+ *
+ * Fill engine: writing VGA_FILL_COUNT stores VGA_FILL_DATA into that many
+ * consecutive words (one per cycle) from the VGA_UPLOAD_ADDR position, while
+ * VGA_STATUS_BUSY is set. VGA_UPLOAD_ADDR is left unchanged.
+ *
  * Two access patterns are supported:
  *   1. Pointer-based (direct dereference): *VGA_CTRL = 0x01;
  *   2. Address-based (function access): vga_write32(VGA_ADDR_CTRL, 0x01);
@@ -38,6 +49,8 @@
 #define VGA_ADDR_INTR_STATUS (VGA_BASE + 0x08)
 #define VGA_ADDR_UPLOAD_ADDR (VGA_BASE + 0x10)
 #define VGA_ADDR_STREAM_DATA (VGA_BASE + 0x14)
+#define VGA_ADDR_FILL_DATA (VGA_BASE + 0x18)
+#define VGA_ADDR_FILL_COUNT (VGA_BASE + 0x1C)
 #define VGA_ADDR_CTRL (VGA_BASE + 0x20)
 #define VGA_ADDR_PALETTE(n) (VGA_BASE + 0x24 + ((n) << 2))
 
@@ -47,6 +60,8 @@
 #define VGA_INTR_STATUS ((volatile uint32_t *) (VGA_BASE + 0x08)) /* W1C */
 #define VGA_UPLOAD_ADDR ((volatile uint32_t *) (VGA_BASE + 0x10)) /* R/W */
 #define VGA_STREAM_DATA ((volatile uint32_t *) (VGA_BASE + 0x14)) /* WO */
+#define VGA_FILL_DATA ((volatile uint32_t *) (VGA_BASE + 0x18))   /* R/W */
+#define VGA_FILL_COUNT ((volatile uint32_t *) (VGA_BASE + 0x1C))  /* R/W */
 #define VGA_CTRL ((volatile uint32_t *) (VGA_BASE + 0x20))        /* R/W */
 #define VGA_PALETTE_BASE (VGA_BASE + 0x24)
 #define VGA_PALETTE(n) ((volatile uint32_t *) (VGA_PALETTE_BASE + ((n) << 2)))
@@ -60,6 +75,20 @@
 #define VGA_NUM_FRAMES 12
 #define VGA_EXPECTED_ID 0x56474131u /* 'VGA1' */
 
+/* VGA_CTRL bits */
+#define VGA_CTRL_EN 0x001u
+#define VGA_CTRL_BLANK 0x002u
+#define VGA_CTRL_SWAP 0x004u /* Apply the frame select at the next vblank */
+#define VGA_CTRL_FRAME(n) (((uint32_t) (n) & 0xF) << 4)
+#define VGA_CTRL_VBLANK_IE 0x100u
+
+/* VGA_STATUS bits */
+#define VGA_STATUS_VBLANK 0x01u
+#define VGA_STATUS_SAFE 0x02u
+#define VGA_STATUS_BUSY 0x04u         /* Fill engine running */
+#define VGA_STATUS_FLIP_PENDING 0x08u /* Swap requested, not yet displayed */
+#define VGA_STATUS_FRAME(s) (((s) >> 4) & 0xF)
+
 /* VGA MMIO access helper functions */
 static inline void vga_write32(uint32_t addr, uint32_t val)
 {
@@ -76,6 +105,21 @@ static inline uint32_t vga_read32(uint32_t addr)
     return val;
 }
 
+/* Fill `words` framebuffer words of `frame` with `pattern`, from the start */
+static inline void vga_fill(uint32_t frame, uint32_t pattern, uint32_t words)
+{
+    vga_write32(VGA_ADDR_UPLOAD_ADDR, (frame & 0xF) << 16);
+    vga_write32(VGA_ADDR_FILL_DATA, pattern);
+    vga_write32(VGA_ADDR_FILL_COUNT, words);
+}
+
+/* Show `frame` from the next vblank on; `ctrl` carries the other CTRL bits */
+static inline void vga_flip(uint32_t frame, uint32_t ctrl)
+{
+    vga_write32(VGA_ADDR_CTRL, (ctrl & ~0xF0u) | VGA_CTRL_SWAP |
+                                   VGA_CTRL_FRAME(frame));
+}
+
 /* Pack 8 4-bit pixels into a 32-bit word for VGA framebuffer upload */
 static inline uint32_t vga_pack8_pixels(const uint8_t *pixels)
 {
@@ -94,54 +138,253 @@ static inline uint32_t vga_pack8_pixels(const uint8_t *pixels)
 #define TIMER_LIMIT ((volatile uint32_t *) (TIMER_BASE + 0x04))   /* R/W */
 #define TIMER_ENABLED ((volatile uint32_t *) (TIMER_BASE + 0x08)) /* R/W */
 
+/**
+ * Hart control registers (base: 0x60000000)
+ *
+ * Every Top has them; HART_NHARTS is the --harts N the Verilog was generated
+ * with (make HARTS=N), 1 by default.
+ *
+ * Register Map (SiFive CLINT layout, then the bus contention counters):
+ *   +0x0000 + 4h: HART_MSIP(h)         - bit 0 raises hart h's software
+ *                                        interrupt (mcause 0x80000003, MSIE)
+ *   +0x4000 + 8h: HART_MTIMECMP_LO/HI(h) - hart h's timer interrupt
+ *                                        (mcause 0x80000007, MTIE) is pending
+ *                                        while MTIME >= MTIMECMP; resets to
+ *                                        all ones
+ *   +0xBFF8:      HART_MTIME_LO/HI     - 64-bit cycle count (R/W)
+ *   +0xC000:      HART_BUS_BUSY        - cycles the shared bus was in use (RO)
+ *   +0xC004:      HART_NHARTS          - number of harts (RO)
+ *   +0xC008:      HART_ARBITRATION     - 0 priority, 1 round-robin (RO)
+ *   +0xC100 + 4h: HART_BUS_WAIT(h)     - cycles hart h waited for the bus (RO)
+ *   +0xC200 + 4h: HART_BUS_GRANT(h)    - bus transactions of hart h (RO)
+ *
+ * The counters are 32 bits and wrap; take differences like the CSR counters.
+ * Write MTIMECMP_HI = ~0 before MTIMECMP_LO, then the real high word, so the
+ * timer does not fire on a half-written compare value.
+ */
+#define HART_BASE 0x60000000u
+#define HART_REG(offset) ((volatile uint32_t *) (HART_BASE + (offset)))
+#define HART_MSIP(h) HART_REG(0x0000 + 4 * (h))           /* R/W */
+#define HART_MTIMECMP_LO(h) HART_REG(0x4000 + 8 * (h))    /* R/W */
+#define HART_MTIMECMP_HI(h) HART_REG(0x4004 + 8 * (h))    /* R/W */
+#define HART_MTIME_LO HART_REG(0xBFF8)                    /* R/W */
+#define HART_MTIME_HI HART_REG(0xBFFC)                    /* R/W */
+#define HART_BUS_BUSY HART_REG(0xC000)                    /* RO */
+#define HART_NHARTS HART_REG(0xC004)                      /* RO */
+#define HART_ARBITRATION HART_REG(0xC008)                 /* RO */
+#define HART_BUS_WAIT(h) HART_REG(0xC100 + 4 * (h))       /* RO */
+#define HART_BUS_GRANT(h) HART_REG(0xC200 + 4 * (h))      /* RO */
+
+static inline uint32_t hart_id(void)
+{
+    uint32_t id;
+    __asm__ volatile("csrr %0, mhartid" : "=r"(id));
+    return id;
+}
+
+/* LR.W/SC.W, spelled with .insn so MARCH needs no 'a' extension. The core
+ * implements only these two A-extension instructions; sc_w returns 0 on
+ * success like the instruction. */
+static inline uint32_t lr_w(volatile uint32_t *addr)
+{
+    uint32_t value;
+    __asm__ volatile(".insn r 0x2f, 2, 0x08, %0, %1, x0"
+                     : "=r"(value)
+                     : "r"(addr)
+                     : "memory");
+    return value;
+}
+
+static inline uint32_t sc_w(volatile uint32_t *addr, uint32_t value)
+{
+    uint32_t failed;
+    __asm__ volatile(".insn r 0x2f, 2, 0x0C, %0, %1, %2"
+                     : "=r"(failed)
+                     : "r"(addr), "r"(value)
+                     : "memory");
+    return failed;
+}
+
+/* Atomic add built from an LR/SC retry loop; returns the old value */
+static inline uint32_t atomic_add(volatile uint32_t *addr, uint32_t delta)
+{
+    uint32_t old;
+    do {
+        old = lr_w(addr);
+    } while (sc_w(addr, old + delta));
+    return old;
+}
+
+/**
+ * DMA controller registers (base: 0xA0000000)
+ *
+ * A second bus master: it moves DMA_COUNT words from DMA_SRC to DMA_DST
+ * while the harts keep running, and waits behind their bus transactions
+ * (lowest priority). The strides are byte offsets added after every word:
+ * 4 walks consecutive words as memcpy does and is sent as bursts of up to
+ * 8 words, 0 stays on one address such as VGA_STREAM_DATA.
+ *
+ * Register Map:
+ *   +0x00: DMA_SRC         - Source address, word aligned
+ *   +0x04: DMA_DST         - Destination address, word aligned
+ *   +0x08: DMA_COUNT       - Words left to move
+ *   +0x0C: DMA_SRC_STRIDE  - Bytes added to DMA_SRC per word (reset 4)
+ *   +0x10: DMA_DST_STRIDE  - Bytes added to DMA_DST per word (reset 4)
+ *   +0x14: DMA_FILL        - Source word in DMA_CTRL_FILL mode (memset)
+ *   +0x18: DMA_CTRL        - Start, fill mode, completion interrupt enable
+ *   +0x1C: DMA_STATUS      - Busy (RO), done (W1C)
+ *   +0x20: DMA_WORDS       - Words written since reset (RO)
+ *   +0x24: DMA_BUSY_CYCLES - Cycles a transfer was running (RO)
+ *   +0x28: DMA_WAIT_CYCLES - Cycles the DMA waited for a hart's access (RO)
+ *   +0x2C: DMA_TRANSFERS   - Transfers completed (RO)
+ *
+ * DMA_SRC, DMA_DST and DMA_COUNT advance during the transfer and ignore
+ * writes while DMA_STATUS_BUSY is set. A transfer must not cross from one
+ * device into another. With DMA_CTRL_IRQ_EN the done flag raises the
+ * external interrupt (mcause 0x8000000B, MEIE, shared with the UART) until
+ * the handler writes DMA_STATUS_DONE to DMA_STATUS. The DMA bypasses the
+ * caches: RAM it writes is not seen through a D-cache line or an I-cache.
+ */
+#define DMA_BASE 0xA0000000u
+#define DMA_REG(offset) ((volatile uint32_t *) (DMA_BASE + (offset)))
+#define DMA_SRC DMA_REG(0x00)         /* R/W */
+#define DMA_DST DMA_REG(0x04)         /* R/W */
+#define DMA_COUNT DMA_REG(0x08)       /* R/W */
+#define DMA_SRC_STRIDE DMA_REG(0x0C)  /* R/W */
+#define DMA_DST_STRIDE DMA_REG(0x10)  /* R/W */
+#define DMA_FILL DMA_REG(0x14)        /* R/W */
+#define DMA_CTRL DMA_REG(0x18)        /* R/W */
+#define DMA_STATUS DMA_REG(0x1C)      /* R/W1C */
+#define DMA_WORDS DMA_REG(0x20)       /* RO */
+#define DMA_BUSY_CYCLES DMA_REG(0x24) /* RO */
+#define DMA_WAIT_CYCLES DMA_REG(0x28) /* RO */
+#define DMA_TRANSFERS DMA_REG(0x2C)   /* RO */
+
+/* DMA_CTRL bits */
+#define DMA_CTRL_START 0x01u /* Write only: start the programmed transfer */
+#define DMA_CTRL_FILL 0x02u  /* Source is DMA_FILL instead of DMA_SRC */
+#define DMA_CTRL_IRQ_EN 0x04u
+
+/* DMA_STATUS bits */
+#define DMA_STATUS_BUSY 0x01u
+#define DMA_STATUS_DONE 0x02u
+
+/* Start a transfer of `words` words; `ctrl` adds DMA_CTRL_FILL/IRQ_EN */
+static inline void dma_start(uint32_t dst,
+                             uint32_t src,
+                             uint32_t words,
+                             uint32_t dst_stride,
+                             uint32_t src_stride,
+                             uint32_t ctrl)
+{
+    *DMA_SRC = src;
+    *DMA_DST = dst;
+    *DMA_COUNT = words;
+    *DMA_SRC_STRIDE = src_stride;
+    *DMA_DST_STRIDE = dst_stride;
+    *DMA_CTRL = ctrl | DMA_CTRL_START;
+}
+
+static inline void dma_wait(void)
+{
+    while (*DMA_STATUS & DMA_STATUS_BUSY)
+        ;
+}
+
 /**
  * UART peripheral registers (base: 0x40000000)
  *
  * Hardware Architecture:
  *   The UART uses ready/valid handshaking internally (Chisel DecoupledIO)
- *   with BufferedTx (single-byte buffer) for transmission and Rx with
- *   interrupt signaling for reception.
+ *   with a TX FIFO in front of the transmitter and an RX FIFO behind the
+ *   receiver. Both depths are fixed when the Verilog is generated
+ *   (UART_TX_DEPTH/UART_RX_DEPTH, 16 by default) and read from
+ *   UART_FIFO_DEPTH.
  *
  * Register Map:
- *   +0x00: UART_STATUS    - Status register (read-only)
- *                           bit 0: TX ready (buffer can accept data)
- *                           bit 1: RX valid (received data available)
- *   +0x04: UART_BAUDRATE  - Configured baud rate (read-only, compile-time)
- *   +0x08: UART_INTERRUPT - Interrupt enable (write: non-zero enables)
- *   +0x0C: UART_RECV      - Receive data register (read clears interrupt)
- *   +0x10: UART_SEND      - Transmit data register (write-only)
+ *   +0x00: UART_STATUS       - Status register (read-only)
+ *                              bit 0: TX ready (TX FIFO not full)
+ *                              bit 1: RX valid (RX FIFO not empty)
+ *                              bit 2: TX idle (FIFO empty, last byte sent)
+ *   +0x04: UART_BAUDRATE     - Configured baud rate (read-only, compile-time)
+ *   +0x08: UART_INTERRUPT    - RX flag (write: non-zero sets, zero clears)
+ *   +0x0C: UART_RECV         - Receive data register (reads one FIFO byte)
+ *   +0x10: UART_SEND         - Transmit data register (write-only)
+ *   +0x14: UART_FIFO_DEPTH   - TX depth [15:0], RX depth [31:16] (read-only)
+ *   +0x18: UART_TX_LEVEL     - Bytes waiting in the TX FIFO (read-only)
+ *   +0x1C: UART_RX_LEVEL     - Bytes waiting in the RX FIFO (read-only)
+ *   +0x20: UART_TX_THRESHOLD - TX IRQ while TX level <= value (R/W, reset 0)
+ *   +0x24: UART_RX_THRESHOLD - RX IRQ while RX level >= value (R/W, reset 1)
+ *   +0x28: UART_IRQ_ENABLE   - UART_IRQ_RX | UART_IRQ_TX (R/W, reset 0)
+ *   +0x2C: UART_IRQ_PENDING  - Threshold conditions met, plus the RX flag
+ *                              (UART_IRQ_FLAG) (read-only)
  *
  * TX Operation:
- *   - Architecture: CPU → Buffer (1 byte) → Tx (shift register) → txd pin
- *   - Poll UART_STATUS bit 0 before writing to ensure buffer ready
- *   - Writes when buffer full are silently dropped
+ *   - Architecture: CPU → TX FIFO → Tx (shift register) → txd pin
+ *   - Write bytes while UART_STATUS bit 0 is set; a burst of up to the FIFO
+ *     depth needs no waiting at all
+ *   - Writes when the FIFO is full are silently dropped
  *
  * RX Operation:
- *   - Architecture: rxd pin → Rx (shift register) → rxData register
- *   - Poll UART_STATUS bit 1 to check for valid data
- *   - Reading UART_RECV clears the RX interrupt flag
+ *   - Architecture: rxd pin → Rx (shift register) → RX FIFO
+ *   - Poll UART_STATUS bit 1 (or UART_RX_LEVEL) to check for data
+ *   - Reading UART_RECV that empties the FIFO clears the RX flag
  *   - Can reliably receive all byte values 0x00-0xFF using STATUS polling
  *
+ * Interrupts:
+ *   The UART drives the core's external interrupt (mcause 0x8000000B, MEIE).
+ *   With UART_IRQ_ENABLE = 0 this is the RX flag, set on every received
+ *   byte. Enabling a threshold interrupt clears the flag and stops setting
+ *   it; the threshold interrupts are level-sensitive and stay asserted while
+ *   the condition holds, so the handler moves the level (reads UART_RECV,
+ *   refills the TX FIFO) or disables the source.
+ *
  * Limitations:
  *   - Baud rate is fixed at compile time (read-only via UART_BAUDRATE)
- *   - Single-byte TX buffer: poll STATUS before each write
- *   - Single-byte RX buffer: read promptly to avoid overrun
  *
  * Usage Pattern:
- *   // TX: Wait for ready, then send
- *   while (!(*UART_STATUS & 0x01)) ;  // Wait for TX ready
+ *   // TX: Wait for FIFO space, then send
+ *   while (!(*UART_STATUS & UART_STATUS_TX_READY)) ;
  *   *UART_SEND = byte;
  *
  *   // RX: Wait for valid, then read
- *   while (!(*UART_STATUS & 0x02)) ;  // Wait for RX valid
+ *   while (!(*UART_STATUS & UART_STATUS_RX_VALID)) ;
  *   byte = *UART_RECV;
+ *
+ *   // Burst, then sleep until the TX FIFO has drained
+ *   for (i = 0; i < n && (*UART_STATUS & UART_STATUS_TX_READY); i++)
+ *     *UART_SEND = buf[i];
+ *   *UART_TX_THRESHOLD = 0;
+ *   *UART_IRQ_ENABLE = UART_IRQ_TX;   // with MIE and MEIE set
+ *   __asm__ volatile("wfi");
  */
 #define UART_BASE 0x40000000u
-#define UART_STATUS ((volatile uint32_t *) (UART_BASE + 0x00))    /* RO */
-#define UART_BAUDRATE ((volatile uint32_t *) (UART_BASE + 0x04))  /* RO */
-#define UART_INTERRUPT ((volatile uint32_t *) (UART_BASE + 0x08)) /* WO */
-#define UART_RECV ((volatile uint32_t *) (UART_BASE + 0x0C))      /* RO */
-#define UART_SEND ((volatile uint32_t *) (UART_BASE + 0x10))      /* WO */
+#define UART_STATUS ((volatile uint32_t *) (UART_BASE + 0x00))       /* RO */
+#define UART_BAUDRATE ((volatile uint32_t *) (UART_BASE + 0x04))     /* RO */
+#define UART_INTERRUPT ((volatile uint32_t *) (UART_BASE + 0x08))    /* WO */
+#define UART_RECV ((volatile uint32_t *) (UART_BASE + 0x0C))         /* RO */
+#define UART_SEND ((volatile uint32_t *) (UART_BASE + 0x10))         /* WO */
+#define UART_FIFO_DEPTH ((volatile uint32_t *) (UART_BASE + 0x14))   /* RO */
+#define UART_TX_LEVEL ((volatile uint32_t *) (UART_BASE + 0x18))     /* RO */
+#define UART_RX_LEVEL ((volatile uint32_t *) (UART_BASE + 0x1C))     /* RO */
+#define UART_TX_THRESHOLD ((volatile uint32_t *) (UART_BASE + 0x20)) /* R/W */
+#define UART_RX_THRESHOLD ((volatile uint32_t *) (UART_BASE + 0x24)) /* R/W */
+#define UART_IRQ_ENABLE ((volatile uint32_t *) (UART_BASE + 0x28))   /* R/W */
+#define UART_IRQ_PENDING ((volatile uint32_t *) (UART_BASE + 0x2C))  /* RO */
+
+/* UART_STATUS bits */
+#define UART_STATUS_TX_READY 0x01u
+#define UART_STATUS_RX_VALID 0x02u
+#define UART_STATUS_TX_IDLE 0x04u
+
+/* UART_IRQ_ENABLE / UART_IRQ_PENDING bits */
+#define UART_IRQ_RX 0x01u
+#define UART_IRQ_TX 0x02u
+#define UART_IRQ_FLAG 0x04u /* UART_IRQ_PENDING only */
+
+/* UART_FIFO_DEPTH fields */
+#define UART_TX_DEPTH() (*UART_FIFO_DEPTH & 0xFFFFu)
+#define UART_RX_DEPTH() (*UART_FIFO_DEPTH >> 16)
 
 /* Legacy alias for backward compatibility */
 #define UART_ENABLE UART_INTERRUPT
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+/*
+ * Multi-hart scaling workloads (make HARTS=N, see scripts/hart-scaling.py)
+ *
+ * Every hart runs the same kernels on its share of a fixed amount of work,
+ * between LR/SC barriers. Hart 0 times each kernel with mcycle, from the
+ * barrier that starts it to the one the slowest hart reaches last, and
+ * prints one line per kernel with the shared-bus counters of HartControl:
+ *
+ *   MULTIHART kernel=<name> harts=N arbitration=N work=N cycles=N
+ *             bus_busy=N bus_wait=N bus_grants=N
+ *
+ * (on one line; bus_wait and bus_grants are summed over the harts).
+ *
+ *   compute  register-only arithmetic; scales with the harts once the
+ *            I-cache is warm
+ *   memory   sums a private slice of an array; every load crosses the bus
+ *   atomic   LR/SC increments of one shared counter; serializes on the bus
+ *            and on the reservation
+ *
+ * The memory sum and the atomic counter are checked, and the program ends
+ * with bench_exit, so sim.cpp reports TEST PASSED only when both are right.
+ * It also runs on the single-hart Top as the scaling baseline.
+ */
+
+#include <stdint.h>
+
+#include "bench.h"
+#include "mmio.h"
+
+#define MAX_HARTS 8
+
+#ifndef COMPUTE_WORK
+#define COMPUTE_WORK 65536
+#endif
+#ifndef MEMORY_WORDS
+#define MEMORY_WORDS 16384
+#endif
+#ifndef ATOMIC_WORK
+#define ATOMIC_WORK 2048
+#endif
+
+static volatile uint32_t nharts;
+
+/* Sense-reversing barrier: the last hart to arrive resets the count and
+ * advances the phase the others are polling */
+static volatile uint32_t barrier_arrived;
+static volatile uint32_t barrier_phase;
+
+static void barrier(void)
+{
+    uint32_t phase = barrier_phase;
+    if (atomic_add(&barrier_arrived, 1) == nharts - 1) {
+        barrier_arrived = 0;
+        barrier_phase = phase + 1;
+    } else {
+        while (barrier_phase == phase)
+            ;
+    }
+}
+
+static uint32_t memory_data[MEMORY_WORDS];
+static volatile uint32_t partial[MAX_HARTS];
+static volatile uint32_t shared_counter;
+
+/* [begin, end) of hart h's share of n items */
+static void share(uint32_t h, uint32_t n, uint32_t *begin, uint32_t *end)
+{
+    *begin = n * h / nharts;
+    *end = n * (h + 1) / nharts;
+}
+
+static void kernel_compute(uint32_t h)
+{
+    uint32_t begin, end;
+    share(h, COMPUTE_WORK, &begin, &end);
+    uint32_t x = h + 1;
+    for (uint32_t i = begin; i < end; i++)
+        x = x * 1664525u + 1013904223u;
+    partial[h] = x;
+}
+
+static void kernel_memory(uint32_t h)
+{
+    uint32_t begin, end, sum = 0;
+    share(h, MEMORY_WORDS, &begin, &end);
+    for (uint32_t i = begin; i < end; i++)
+        sum += memory_data[i];
+    partial[h] = sum;
+}
+
+static void kernel_atomic(uint32_t h)
+{
+    uint32_t begin, end;
+    share(h, ATOMIC_WORK, &begin, &end);
+    for (uint32_t i = begin; i < end; i++)
+        atomic_add(&shared_counter, 1);
+}
+
+struct kernel {
+    const char *name;
+    uint32_t work;
+    void (*run)(uint32_t hart);
+};
+
+static const struct kernel kernels[] = {
+    {"compute", COMPUTE_WORK, kernel_compute},
+    {"memory", MEMORY_WORDS, kernel_memory},
+    {"atomic", ATOMIC_WORK, kernel_atomic},
+};
+
+#define KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+struct bus_counters {
+    uint32_t cycles;
+    uint32_t busy;
+    uint32_t wait;
+    uint32_t grants;
+};
+
+static void bus_read(struct bus_counters *c)
+{
+    uint32_t cycles;
+    __asm__ volatile("csrr %0, mcycle" : "=r"(cycles));
+    c->cycles = cycles;
+    c->busy = *HART_BUS_BUSY;
+    c->wait = 0;
+    c->grants = 0;
+    for (uint32_t h = 0; h < nharts; h++) {
+        c->wait += *HART_BUS_WAIT(h);
+        c->grants += *HART_BUS_GRANT(h);
+    }
+}
+
+/* Harts 1.. enter here from init.S once hart 0 has cleared .bss */
+void secondary_main(uint32_t hart)
+{
+    /* Wait for hart 0 to publish the hart count */
+    while (!nharts)
+        ;
+    if (hart >= MAX_HARTS)
+        return;
+    for (uint32_t k = 0; k < KERNELS; k++) {
+        barrier();
+        kernels[k].run(hart);
+        barrier();
+    }
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < MEMORY_WORDS; i++)
+        memory_data[i] = i;
+
+    uint32_t harts = *HART_NHARTS;
+    if (harts > MAX_HARTS) {
+        bench_printf("multihart: %u harts, built for at most %u\n", harts,
+                     MAX_HARTS);
+        harts = MAX_HARTS;
+    }
+    nharts = harts;
+
+    for (uint32_t k = 0; k < KERNELS; k++) {
+        struct bus_counters start, stop;
+        barrier();
+        bus_read(&start);
+        kernels[k].run(0);
+        barrier();
+        bus_read(&stop);
+        bench_printf(
+            "MULTIHART kernel=%s harts=%u arbitration=%u work=%u cycles=%u "
+            "bus_busy=%u bus_wait=%u bus_grants=%u\n",
+            kernels[k].name, nharts, *HART_ARBITRATION, kernels[k].work,
+            stop.cycles - start.cycles, stop.busy - start.busy,
+            stop.wait - start.wait, stop.grants - start.grants);
+    }
+
+    uint32_t sum = 0;
+    for (uint32_t h = 0; h < nharts; h++)
+        sum += partial[h];
+    uint32_t expected_sum = (uint32_t) MEMORY_WORDS * (MEMORY_WORDS - 1) / 2;
+    int valid = sum == expected_sum && shared_counter == ATOMIC_WORK;
+    bench_printf("multihart: memory sum %u (expected %u), counter %u "
+                 "(expected %u)\n",
+                 sum, expected_sum, shared_counter, ATOMIC_WORK);
+    if (valid)
+        bench_printf("Correct operation validated.\n");
+    bench_exit(valid);
+    return 0;
+}
@@ -268,31 +268,28 @@ int main(void)
     if (id != VGA_EXPECTED_ID)
         return 1;
 
-    // Initialize palette and enable display
+    // Clear every frame to the background color with the fill engine (one
+    // command instead of 6144 stores), then initialize palette and display
+    vga_fill(0, 0, FRAME_COUNT * WORDS_PER_FRAME);
+    while (vga_read32(VGA_ADDR_STATUS) & VGA_STATUS_BUSY)
+        ;
     vga_init_palette();
-    vga_write32(VGA_ADDR_CTRL, 0x01);
+    vga_write32(VGA_ADDR_CTRL, VGA_CTRL_EN);
 
+    // Upload all frames while keeping frame 0 displayed
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
 #if NYANCAT_COMPRESSION_DELTA
-    // Upload all frames (delta decompression) while keeping frame 0 displayed
-    for (int frame = 0; frame < FRAME_COUNT; frame++)
         vga_upload_frame_delta(frame);
-
-    // Animate: cycle through frames infinitely
-    for (uint32_t frame = 0;;) {
-        vga_write32(VGA_ADDR_CTRL, (frame << 4) | 0x01);
-        delay(50000);
-        frame = (frame + 1 < FRAME_COUNT) ? frame + 1 : 0;
-    }
 #else
-    // Upload all frames (baseline RLE) while keeping frame 0 displayed
-    for (int frame = 0; frame < FRAME_COUNT; frame++)
         vga_upload_frame_rle(frame);
+#endif
+    }
 
-    // Animate: cycle through frames infinitely
+    // Animate: every frame is already in the framebuffer, so each step is a
+    // page flip latched at vblank (no tearing, no vblank polling needed)
     for (uint32_t frame = 0;;) {
-        vga_write32(VGA_ADDR_CTRL, (frame << 4) | 0x01);
+        vga_flip(frame, VGA_CTRL_EN);
         delay(50000);
         frame = (frame + 1 < FRAME_COUNT) ? frame + 1 : 0;
     }
-#endif
 }
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+/*
+ * PC profile of compressed code, run under `make check-profile`
+ *
+ * The loop body holds two compressed instructions in one aligned word
+ * (built with .option rvc, so any MARCH works). --profile must report them
+ * as two PCs, 2 bytes apart, each with its own disassembly.
+ */
+
+#include <stdint.h>
+
+#define ITERATIONS 1000
+
+/* sim.cpp reports this result as TEST PASSED */
+#define PROFILE_RESULT_PASS 0x1Fu
+
+int main(void)
+{
+    register uint32_t a0 __asm__("a0") = 0;
+    register uint32_t a1 __asm__("a1") = 0;
+
+    for (int i = 0; i < ITERATIONS; i++)
+        __asm__ volatile(
+            ".option push\n\t"
+            ".option rvc\n\t"
+            ".balign 4\n\t"
+            "c.addi a0, 3\n\t"
+            "c.addi a1, 5\n\t"
+            ".option pop"
+            : "+r"(a0), "+r"(a1));
+
+    int valid = a0 == 3 * ITERATIONS && a1 == 5 * ITERATIONS;
+    *(volatile uint32_t *) 0x104 = valid ? PROFILE_RESULT_PASS : 0x01;
+    *(volatile uint32_t *) 0x100 = 0xCAFEF00D; /* Signal completion to sim.cpp */
+    return 0;
+}
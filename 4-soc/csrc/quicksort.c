@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+#define SIZE 50
+
+#include "bubblesort_data.h"
+
+/* Lomuto partition around the last element, recursing on both halves */
+void quicksort(int *arr, int low, int high)
+{
+    while (low < high) {
+        int pivot = arr[high];
+        int i = low, j, temp;
+        for (j = low; j < high; j++) {
+            if (arr[j] < pivot) {
+                temp = arr[i];
+                arr[i] = arr[j];
+                arr[j] = temp;
+                i++;
+            }
+        }
+        arr[high] = arr[i];
+        arr[i] = pivot;
+
+        /* Recurse into the smaller half so the stack stays O(log n) */
+        if (i - low < high - i) {
+            quicksort(arr, low, i - 1);
+            low = i + 1;
+        } else {
+            quicksort(arr, i + 1, high);
+            high = i - 1;
+        }
+    }
+}
+
+int verify(int *arr, int n)
+{
+    int i;
+    for (i = 0; i < n - 1; i++) {
+        if (arr[i] > arr[i + 1])
+            return 0; // Failed
+    }
+    return 1; // Passed
+}
+
+int main()
+{
+    quicksort(data, 0, SIZE - 1);
+
+    if (verify(data, SIZE)) {
+        *(volatile int *) (0x104) = 0x1F; // Signal success (UART_TEST_PASS)
+    } else {
+        *(volatile int *) (0x104) = 0x01; // Signal failure (general code)
+    }
+
+    *(volatile int *) (0x100) = 0xCAFEF00D; // Signal completion to sim.cpp
+
+    return 0;
+}
@@ -16,6 +16,8 @@
  *    - Multi-byte sequential reception (5-char "HELLO")
  *    - Binary data reception (0x00, 0x01, 0x7F, 0x80, 0xFF)
  *    - Timeout-based polling mechanism
+ * 3. FIFO: Sends a burst without per-byte polling and reads it back once the
+ *    TX FIFO has drained
  *
  * Test Result Encoding:
  *   TEST_RESULT bits:
@@ -23,7 +25,8 @@
  *     [1]: Multi-byte RX test passed
  *     [2]: Binary RX test passed (includes 0x00 byte)
  *     [3]: Timeout RX test passed
- *   Expected: 0xF (0b1111) = all tests passed
+ *     [4]: FIFO burst test passed
+ *   Expected: 0x1F (0b11111) = all tests passed
  *
  * Implementation Notes:
  *   - Uses UART_STATUS bit 0 (TX ready) for reliable transmission
@@ -175,6 +178,46 @@ static unsigned int test_timeout_rx(void)
     return (!timed_out && received == 'T') ? 1 : 0;
 }
 
+// Test 5: FIFO burst - fill the TX FIFO back to back, wait for it to drain,
+// then find the whole burst in the RX FIFO
+static unsigned int test_fifo_burst(void)
+{
+    const char burst[] = "FIFO0123";
+    unsigned int depth = UART_TX_DEPTH();
+    if (UART_RX_DEPTH() < depth)
+        depth = UART_RX_DEPTH();
+    unsigned int n = depth < sizeof(burst) - 1 ? depth : sizeof(burst) - 1;
+
+    for (unsigned int i = 0; i < n; i++) {
+        if (!(*UART_STATUS & UART_STATUS_TX_READY))
+            return 0;  // FIFO filled up before its advertised depth
+        *UART_SEND = (unsigned int) burst[i];
+    }
+    // At most one byte has moved on to the shift register
+    if (*UART_TX_LEVEL + 1 < n)
+        return 0;
+
+    unsigned int timeout = 200000;
+    while (!(*UART_STATUS & UART_STATUS_TX_IDLE) && --timeout)
+        ;
+    // TX level 0 is at the (reset) threshold of 0
+    if (!timeout || !(*UART_IRQ_PENDING & UART_IRQ_TX))
+        return 0;
+
+    // The last byte is still being received when TX goes idle
+    timeout = 200000;
+    while (*UART_RX_LEVEL < n && --timeout)
+        ;
+    if (!timeout)
+        return 0;
+
+    for (unsigned int i = 0; i < n; i++) {
+        if ((char) (*UART_RECV & 0xFF) != burst[i])
+            return 0;
+    }
+    return (*UART_RX_LEVEL == 0) ? 1 : 0;
+}
+
 int main(void)
 {
     unsigned int result = 0;
@@ -199,8 +242,12 @@ int main(void)
     if (test_timeout_rx())
         result |= (1 << 3);  // Set bit 3
 
+    // Run Test 5: FIFO burst
+    if (test_fifo_burst())
+        result |= (1 << 4);  // Set bit 4
+
     // Report results
-    // result = 0xF (0b1111) means all tests passed
+    // result = 0x1F (0b11111) means all tests passed
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Warray-bounds"
     *TEST_RESULT = result;
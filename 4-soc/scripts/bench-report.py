@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Benchmark report for the 4-soc CoreMark and Dhrystone ports
+
+Reads simulator output (VTop stdout, which carries the UART) and turns each
+BENCH line of raw counter deltas into the figures tracked over time:
+
+    CoreMark/MHz   iterations * 1e6 / cycles
+    DMIPS/MHz      runs * 1e6 / cycles / 1757  (VAX 11/780 Dhrystones/s)
+    IPC            instret / cycles
+    mispredict     mispredicts / branches
+
+A result only counts as valid when the benchmark printed its
+"Correct operation validated" line before the BENCH line. One output line
+per benchmark, in a fixed key order (or JSON lines with --json):
+
+    bench=coremark valid=1 iterations=10 cycles=... instret=... ipc=0.812
+    branches=... mispredicts=... mispredict_rate=0.0712 coremark_per_mhz=2.345
+
+Usage:
+    ./VTop -i coremark.elf --headless | python3 scripts/bench-report.py
+    python3 scripts/bench-report.py --json run1.log run2.log
+"""
+
+import argparse
+import json
+import re
+import sys
+from typing import Dict, Iterable, List, Union
+
+BENCH_PATTERN = re.compile(r"BENCH((?:\s+\w+=\S+)+)")
+FIELD_PATTERN = re.compile(r"(\w+)=(\S+)")
+VALIDATED = "Correct operation validated"
+COUNT_FIELDS = ("iterations", "cycles", "instret", "branches", "mispredicts")
+
+DHRYSTONES_PER_DMIPS = 1757
+
+Result = Dict[str, Union[str, int, float]]
+
+
+def score(name: str, iterations: int, cycles: int) -> Dict[str, float]:
+    """Per-benchmark headline figure, normalized to a 1 MHz clock"""
+    if cycles == 0:
+        return {}
+    per_mhz = iterations * 1e6 / cycles
+    if name == "coremark":
+        return {"coremark_per_mhz": round(per_mhz, 4)}
+    if name == "dhrystone":
+        return {"dmips_per_mhz": round(per_mhz / DHRYSTONES_PER_DMIPS, 4)}
+    return {"iterations_per_mhz": round(per_mhz, 4)}
+
+
+def parse(lines: Iterable[str]) -> List[Result]:
+    """Collect one result per BENCH line, validated by the preceding output"""
+    results: List[Result] = []
+    validated = False
+    for line in lines:
+        if VALIDATED in line:
+            validated = True
+        match = BENCH_PATTERN.search(line)
+        if not match:
+            continue
+        fields = dict(FIELD_PATTERN.findall(match.group(1)))
+        # A BENCH line cut short (e.g. the run ended with bytes still in the
+        # UART) must not turn into zero counts
+        missing = [key for key in COUNT_FIELDS if key not in fields]
+        if missing:
+            raise ValueError(f"BENCH line is missing {', '.join(missing)}: "
+                             f"{line.strip()}")
+        counts = {key: int(fields[key]) for key in COUNT_FIELDS}
+        cycles = counts["cycles"]
+        branches = counts["branches"]
+        result: Result = {
+            "bench": fields.get("name", "unknown"),
+            "valid": int(validated),
+            "iterations": counts["iterations"],
+            "cycles": cycles,
+            "instret": counts["instret"],
+            "ipc": round(counts["instret"] / cycles, 4) if cycles else 0.0,
+            "branches": branches,
+            "mispredicts": counts["mispredicts"],
+            "mispredict_rate":
+                round(counts["mispredicts"] / branches, 4) if branches else 0.0,
+        }
+        result.update(score(str(result["bench"]), counts["iterations"], cycles))
+        results.append(result)
+        validated = False
+    return results
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description="Report CoreMark/MHz, DMIPS/MHz, IPC and misprediction "
+                    "rate from 4-soc benchmark output")
+    parser.add_argument("logs", nargs="*",
+                        help="simulator output files (default: stdin)")
+    parser.add_argument("--json", action="store_true",
+                        help="print one JSON object per benchmark")
+    args = parser.parse_args()
+
+    lines: List[str] = []
+    if args.logs:
+        for log in args.logs:
+            with open(log, errors="replace") as f:
+                lines.extend(f)
+    else:
+        lines.extend(sys.stdin)
+
+    try:
+        results = parse(lines)
+    except ValueError as error:
+        print(error, file=sys.stderr)
+        return 1
+    if not results:
+        print("No BENCH lines found", file=sys.stderr)
+        return 1
+
+    for result in results:
+        if args.json:
+            print(json.dumps(result))
+        else:
+            print(" ".join(f"{key}={value}" for key, value in result.items()))
+
+    invalid = [str(r["bench"]) for r in results if not r["valid"]]
+    if invalid:
+        print(f"Not validated: {', '.join(invalid)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+D-cache CPI comparison for 4-soc
+
+Generates two Tops (VerilogGenerator --target-dir
+4-soc/verilog/verilator/dcache/<name>): "uncached", where every load and
+store is a bus transaction, and "dcache" with the given D-cache geometry.
+Builds both with `make verilator-variant`, runs csrc/bubblesort.elf and
+csrc/quicksort.elf on each and reports per program and configuration:
+
+    instructions  minstret at the end of the run
+    cpi           mcycle / minstret, from the harness summary
+    misses        D-cache line allocations (mhpmcounter12)
+    mem_stalls    memory stall cycles (mhpmcounter5)
+    cpi_change    CPI against the uncached run of the same program
+
+Usage:
+    make dcache-compare DCACHE_SETS=64 DCACHE_WAYS=2
+    python3 scripts/dcache-compare.py --sets 16 --ways 1 --line-words 4
+    python3 scripts/dcache-compare.py --no-build --json
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Dict, List, Optional, Union
+
+SOC_DIR = Path(__file__).resolve().parent.parent
+REPO_ROOT = SOC_DIR.parent
+COMPARE_DIR = "dcache"
+
+PROGRAMS = ["bubblesort", "quicksort"]
+
+SUMMARY_PATTERNS = {
+    "instructions": re.compile(r"^\s*Instructions: (\d+)$"),
+    "cpi": re.compile(r"^\s*CPI: ([\d.]+)$"),
+    "misses": re.compile(r"^\s*Misses: (\d+)$"),
+    "mem_stalls": re.compile(r"^\s*Memory stall cycles: (\d+)$"),
+}
+PASSED = "TEST PASSED"
+
+Config = Dict[str, Union[str, int]]
+Result = Dict[str, Union[str, int, float]]
+
+
+def configs_for(sets: int, ways: int, line_words: int, store_buffer: int) -> List[Config]:
+    return [
+        {"name": "uncached", "sets": 0, "ways": 1, "line_words": line_words,
+         "store_buffer": store_buffer},
+        {"name": "dcache", "sets": sets, "ways": ways, "line_words": line_words,
+         "store_buffer": store_buffer},
+    ]
+
+
+def target_dir(config: Config) -> str:
+    return f"4-soc/verilog/verilator/{COMPARE_DIR}/{config['name']}"
+
+
+def generate(configs: List[Config]) -> None:
+    """Emit both configurations' Top.v in one sbt run"""
+    commands = []
+    for config in configs:
+        flags = [f"--target-dir {target_dir(config)}",
+                 f"--dcache-sets {config['sets']}", f"--dcache-ways {config['ways']}",
+                 f"--dcache-line-words {config['line_words']}",
+                 f"--dcache-store-buffer {config['store_buffer']}"]
+        commands.append(f"runMain board.verilator.VerilogGenerator {' '.join(flags)}")
+    cmd = ["sbt", "project soc"] + commands
+    print(f"[generate] {len(configs)} configurations", file=sys.stderr)
+    env = dict(os.environ, PATH=f"{Path.home()}/.local/bin:{os.environ['PATH']}")
+    subprocess.run(cmd, cwd=REPO_ROOT, env=env, check=True,
+                   stdout=subprocess.DEVNULL)
+
+
+def build(config: Config) -> None:
+    cmd = ["make", "-C", str(SOC_DIR), "verilator-variant",
+           f"VARIANT_DIR={COMPARE_DIR}/{config['name']}", "VERILATOR_THREADS=1"]
+    print(f"[build] {config['name']}", file=sys.stderr)
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+
+
+def run(job) -> List[str]:
+    """Simulator output of one program on one configuration"""
+    config, program = job
+    vtop = (SOC_DIR / "verilog" / "verilator" / COMPARE_DIR /
+            str(config["name"]) / "obj_dir" / "VTop")
+    elf = SOC_DIR / "csrc" / f"{program}.elf"
+    result = subprocess.run([str(vtop), "-i", str(elf), "--headless"],
+                            cwd=vtop.parent, stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, text=True,
+                            errors="replace")
+    print(f"[run] {config['name']} {program}", file=sys.stderr)
+    return result.stdout.splitlines()
+
+
+def parse(config: Config, program: str, lines: List[str]) -> Optional[Result]:
+    fields: Dict[str, str] = {}
+    for line in lines:
+        for key, pattern in SUMMARY_PATTERNS.items():
+            match = pattern.match(line)
+            if match:
+                fields[key] = match.group(1)
+    if "instructions" not in fields or "cpi" not in fields:
+        return None
+    return {
+        "program": program,
+        "config": config["name"],
+        "sets": config["sets"],
+        "valid": int(any(PASSED in line for line in lines)),
+        "instructions": int(fields["instructions"]),
+        "cpi": float(fields["cpi"]),
+        "misses": int(fields.get("misses", 0)),  # no Data Cache block when uncached
+        "mem_stalls": int(fields.get("mem_stalls", 0)),
+    }
+
+
+def derive(results: List[Result]) -> None:
+    """Relative CPI change against the uncached run of the same program"""
+    baseline = {r["program"]: float(r["cpi"]) for r in results if r["config"] == "uncached"}
+    for r in results:
+        base = baseline.get(str(r["program"]))
+        r["cpi_change"] = round(float(r["cpi"]) / base - 1, 4) if base else 0.0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description="Run bubblesort and quicksort on 4-soc with and without "
+                    "the D-cache and compare CPI")
+    parser.add_argument("--sets", type=int, default=64, help="D-cache sets (default: 64)")
+    parser.add_argument("--ways", type=int, default=2, help="D-cache ways (default: 2)")
+    parser.add_argument("--line-words", type=int, default=8,
+                        help="D-cache line words (default: 8)")
+    parser.add_argument("--store-buffer", type=int, default=4,
+                        help="store buffer entries (default: 4)")
+    parser.add_argument("--no-build", action="store_true",
+                        help="reuse the models of a previous run")
+    parser.add_argument("--json", action="store_true",
+                        help="print one JSON object per program and configuration")
+    args = parser.parse_args()
+
+    if args.sets <= 0:
+        print("--sets must be positive: the uncached model is the baseline", file=sys.stderr)
+        return 1
+    missing = [p for p in PROGRAMS if not (SOC_DIR / "csrc" / f"{p}.elf").exists()]
+    if missing:
+        print(f"Missing {', '.join(f'csrc/{p}.elf' for p in missing)} "
+              f"(make -C csrc {' '.join(f'{p}.elf' for p in missing)})", file=sys.stderr)
+        return 1
+
+    configs = configs_for(args.sets, args.ways, args.line_words, args.store_buffer)
+    if not args.no_build:
+        generate(configs)
+        with ThreadPoolExecutor(max_workers=len(configs)) as pool:
+            list(pool.map(build, configs))
+
+    jobs = [(config, program) for config in configs for program in PROGRAMS]
+    with ThreadPoolExecutor(max_workers=os.cpu_count() or 1) as pool:
+        outputs = list(pool.map(run, jobs))
+
+    results: List[Result] = []
+    failed: List[str] = []
+    for (config, program), lines in zip(jobs, outputs):
+        result = parse(config, program, lines)
+        if result is None or not result["valid"]:
+            failed.append(f"{program} on {config['name']}")
+        if result is not None:
+            results.append(result)
+    derive(results)
+
+    if args.json:
+        for result in results:
+            print(json.dumps(result))
+    else:
+        print(f"{'program':<12}{'config':<10}{'instructions':>13}{'cpi':>8}"
+              f"{'misses':>9}{'mem_stalls':>12}{'cpi_change':>12}{'valid':>7}")
+        for r in sorted(results, key=lambda r: (r["program"], -int(r["sets"] == 0))):
+            print(f"{r['program']:<12}{r['config']:<10}{r['instructions']:>13}"
+                  f"{r['cpi']:>8.3f}{r['misses']:>9}{r['mem_stalls']:>12}"
+                  f"{r['cpi_change']:>+12.1%}{r['valid']:>7}")
+
+    if failed:
+        print(f"Not validated: {', '.join(failed)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Multi-hart throughput scaling for 4-soc
+
+Generates one Top per hart count and arbitration policy (VerilogGenerator
+--harts N --arbitration P --target-dir 4-soc/verilog/verilator/harts/<name>,
+all with the same I-cache, which extra harts need), builds the models in
+parallel with `make verilator-variant`, runs csrc/multihart.elf on each and
+reports per kernel and configuration:
+
+    cycles       hart 0's mcycle delta over the kernel (fixed total work)
+    speedup      cycles of the 1-hart model / cycles
+    efficiency   speedup / harts
+    bus_util     HartControl BUS_BUSY / cycles; near 1 the shared bus is
+                 saturated and more harts stop helping
+    wait_grant   BUS_WAIT / BUS_GRANT summed over harts: average cycles a
+                 transaction waited for another hart's
+
+Usage:
+    make hart-scaling HART_SCALING=1,2,4,8
+    python3 scripts/hart-scaling.py --harts 1 2 4 --arbitration round-robin
+    python3 scripts/hart-scaling.py --no-build --json
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Dict, List, Union
+
+SOC_DIR = Path(__file__).resolve().parent.parent
+REPO_ROOT = SOC_DIR.parent
+SCALING_DIR = "harts"
+
+# Must match UART_FAST_BAUD in the Makefile; multihart.c prints outside its
+# timed regions
+UART_BAUD = 1562500
+
+POLICIES = ["priority", "round-robin"]
+
+LINE_PATTERN = re.compile(r"^MULTIHART ((?:\w+=\S+ ?)+)$")
+VALID_LINE = "Correct operation validated"
+
+Config = Dict[str, Union[str, int]]
+Result = Dict[str, Union[str, int, float]]
+
+
+def configs_for(harts: List[int], policies: List[str]) -> List[Config]:
+    # One hart has nothing to arbitrate: a single priority baseline
+    configs: List[Config] = []
+    for n in harts:
+        for policy in (policies if n > 1 else policies[:1]):
+            configs.append({"name": f"h{n}-{policy}", "harts": n,
+                            "arbitration": policy})
+    return configs
+
+
+def target_dir(config: Config) -> str:
+    return f"4-soc/verilog/verilator/{SCALING_DIR}/{config['name']}"
+
+
+def generate(configs: List[Config], icache_sets: int) -> None:
+    """Emit every configuration's Top.v in one sbt run"""
+    commands = []
+    for config in configs:
+        flags = [f"--uart-baud {UART_BAUD}", f"--target-dir {target_dir(config)}",
+                 f"--icache-sets {icache_sets}", f"--harts {config['harts']}",
+                 f"--arbitration {config['arbitration']}"]
+        commands.append(f"runMain board.verilator.VerilogGenerator {' '.join(flags)}")
+    cmd = ["sbt", "project soc"] + commands
+    print(f"[generate] {len(configs)} configurations", file=sys.stderr)
+    env = dict(os.environ, PATH=f"{Path.home()}/.local/bin:{os.environ['PATH']}")
+    subprocess.run(cmd, cwd=REPO_ROOT, env=env, check=True,
+                   stdout=subprocess.DEVNULL)
+
+
+def build(config: Config) -> None:
+    cmd = ["make", "-C", str(SOC_DIR), "verilator-variant",
+           f"VARIANT_DIR={SCALING_DIR}/{config['name']}",
+           f"SIM_UART_BAUD={UART_BAUD}", "VERILATOR_THREADS=1"]
+    print(f"[build] {config['name']}", file=sys.stderr)
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+
+
+def run(config: Config) -> List[str]:
+    """Simulator output of multihart.elf on one configuration"""
+    vtop = (SOC_DIR / "verilog" / "verilator" / SCALING_DIR /
+            str(config["name"]) / "obj_dir" / "VTop")
+    elf = SOC_DIR / "csrc" / "multihart.elf"
+    result = subprocess.run([str(vtop), "-i", str(elf), "--headless"],
+                            cwd=vtop.parent, stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, text=True,
+                            errors="replace")
+    print(f"[run] {config['name']}", file=sys.stderr)
+    return result.stdout.splitlines()
+
+
+def parse(config: Config, lines: List[str]) -> List[Result]:
+    valid = int(any(VALID_LINE in line for line in lines))
+    results: List[Result] = []
+    for line in lines:
+        match = LINE_PATTERN.match(line.strip())
+        if not match:
+            continue
+        fields = dict(kv.split("=", 1) for kv in match.group(1).split())
+        result: Result = {"config": config["name"],
+                          "arbitration": config["arbitration"],
+                          "kernel": fields["kernel"], "valid": valid}
+        for key in ("harts", "work", "cycles", "bus_busy", "bus_wait", "bus_grants"):
+            result[key] = int(fields[key])
+        results.append(result)
+    return results
+
+
+def derive(results: List[Result]) -> None:
+    """Speedup against the 1-hart run of the same kernel, bus utilization"""
+    baseline = {r["kernel"]: int(r["cycles"]) for r in results if r["harts"] == 1}
+    for r in results:
+        cycles = int(r["cycles"])
+        base = baseline.get(str(r["kernel"]))
+        speedup = base / cycles if base and cycles else 0.0
+        r["speedup"] = round(speedup, 3)
+        r["efficiency"] = round(speedup / int(r["harts"]), 3)
+        r["bus_util"] = round(int(r["bus_busy"]) / cycles, 3) if cycles else 0.0
+        grants = int(r["bus_grants"])
+        r["wait_grant"] = round(int(r["bus_wait"]) / grants, 2) if grants else 0.0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description="Run csrc/multihart.elf on 4-soc models with 1..N harts "
+                    "and report speedup and shared-bus utilization")
+    parser.add_argument("--harts", default="1,2,4",
+                        help="comma-separated hart counts (default: 1,2,4)")
+    parser.add_argument("--arbitration", nargs="+", choices=POLICIES,
+                        default=POLICIES, help="arbitration policies to compare")
+    parser.add_argument("--icache-sets", type=int, default=64,
+                        help="I-cache sets of every model (default: 64)")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                        help="parallel model builds and runs")
+    parser.add_argument("--no-build", action="store_true",
+                        help="reuse the models of a previous run")
+    parser.add_argument("--json", action="store_true",
+                        help="print one JSON object per kernel and configuration")
+    args = parser.parse_args()
+
+    harts = sorted({int(n) for n in args.harts.split(",")})
+    if 1 not in harts:
+        harts.insert(0, 1)  # the speedup baseline
+    if args.icache_sets <= 0:
+        print("Extra harts need an I-cache (--icache-sets > 0)", file=sys.stderr)
+        return 1
+    if not (SOC_DIR / "csrc" / "multihart.elf").exists():
+        print("Missing csrc/multihart.elf (make -C csrc multihart.elf)", file=sys.stderr)
+        return 1
+
+    configs = configs_for(harts, args.arbitration)
+    if not args.no_build:
+        generate(configs, args.icache_sets)
+        with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            list(pool.map(build, configs))
+
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        outputs = list(pool.map(run, configs))
+
+    results = [r for config, lines in zip(configs, outputs)
+               for r in parse(config, lines)]
+    derive(results)
+
+    if args.json:
+        for result in results:
+            print(json.dumps(result))
+    else:
+        print(f"{'kernel':<9}{'harts':>6}  {'arbitration':<13}{'cycles':>10}"
+              f"{'speedup':>9}{'effic':>7}{'bus_util':>10}{'wait/grant':>12}{'valid':>7}")
+        for r in sorted(results, key=lambda r: (r["kernel"], r["harts"], r["arbitration"])):
+            print(f"{r['kernel']:<9}{r['harts']:>6}  {r['arbitration']:<13}{r['cycles']:>10}"
+                  f"{r['speedup']:>9.3f}{r['efficiency']:>7.3f}{r['bus_util']:>10.3f}"
+                  f"{r['wait_grant']:>12.2f}{r['valid']:>7}")
+
+    missing = [str(c["name"]) for c, lines in zip(configs, outputs)
+               if not any(VALID_LINE in line for line in lines)]
+    if missing:
+        print(f"Not validated: {', '.join(missing)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Branch predictor design-space sweep for 4-soc
+
+Each configuration in a JSON list overrides some PredictorConfig fields:
+
+    [{"name": "baseline"},
+     {"name": "perc16-h12", "perceptrons": 16, "history_length": 12}]
+
+Keys: direction ("perceptron" or "tournament"), btb_entries, ras_depth,
+ibtb_entries, perceptrons, history_length, weight_bits, training_threshold,
+pht_entries. The sweep generates Verilog for every
+configuration in one sbt session (VerilogGenerator --target-dir
+4-soc/verilog/verilator/sweep/<name>), builds the models in parallel with
+`make verilator-variant`, runs the CoreMark/Dhrystone ELFs on each, and
+reports per configuration, summed over the benchmarks:
+
+    mispredict_rate   mhpmcounter3 / mhpmcounter8
+    ipc               instret / cycles
+    state_bits        predictor register bits (PredictorConfig.stateBits)
+    pareto            1 if no other configuration has both fewer state bits
+                      and a lower misprediction rate
+
+Usage:
+    make predictor-sweep
+    python3 scripts/predictor-sweep.py --configs my-sweep.json --jobs 8
+    python3 scripts/predictor-sweep.py --no-build --json
+"""
+
+import argparse
+import importlib.util
+import json
+import os
+import re
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Dict, List, Union
+
+SOC_DIR = Path(__file__).resolve().parent.parent
+REPO_ROOT = SOC_DIR.parent
+SWEEP_DIR = "sweep"
+
+# Must match UART_FAST_BAUD in the Makefile; the benchmarks print outside
+# their timed regions, so the rate only shortens the runs
+UART_BAUD = 1562500
+
+# JSON key -> VerilogGenerator flag
+FLAGS = {
+    "direction": "--direction",
+    "btb_entries": "--btb-entries",
+    "ras_depth": "--ras-depth",
+    "ibtb_entries": "--ibtb-entries",
+    "perceptrons": "--perceptrons",
+    "history_length": "--history-length",
+    "weight_bits": "--weight-bits",
+    "training_threshold": "--training-threshold",
+    "pht_entries": "--pht-entries",
+}
+
+STATE_BITS_PATTERN = re.compile(r"\[predictor\] target-dir=(\S+) state-bits=(\d+)")
+
+Config = Dict[str, Union[str, int]]
+Result = Dict[str, Union[str, int, float]]
+
+
+def load_bench_report():
+    """scripts/bench-report.py is not importable by name (dash)"""
+    path = SOC_DIR / "scripts" / "bench-report.py"
+    spec = importlib.util.spec_from_file_location("bench_report", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def target_dir(config: Config) -> str:
+    return f"4-soc/verilog/verilator/{SWEEP_DIR}/{config['name']}"
+
+
+def generate(configs: List[Config]) -> Dict[str, int]:
+    """Emit every configuration's Top.v in one sbt run; returns state bits"""
+    commands = []
+    for config in configs:
+        flags = [f"--uart-baud {UART_BAUD}", f"--target-dir {target_dir(config)}"]
+        flags += [f"{FLAGS[key]} {value}" for key, value in config.items()
+                  if key in FLAGS]
+        commands.append(f"runMain board.verilator.VerilogGenerator {' '.join(flags)}")
+    cmd = ["sbt", "project soc"] + commands
+    print(f"[generate] {len(configs)} configurations", file=sys.stderr)
+    env = dict(os.environ, PATH=f"{Path.home()}/.local/bin:{os.environ['PATH']}")
+    result = subprocess.run(cmd, cwd=REPO_ROOT, env=env, check=True,
+                            stdout=subprocess.PIPE, text=True)
+    return {Path(d).name: int(bits)
+            for d, bits in STATE_BITS_PATTERN.findall(result.stdout)}
+
+
+def build(config: Config) -> None:
+    cmd = ["make", "-C", str(SOC_DIR), "verilator-variant",
+           f"VARIANT_DIR={SWEEP_DIR}/{config['name']}",
+           f"SIM_UART_BAUD={UART_BAUD}", "VERILATOR_THREADS=1"]
+    print(f"[build] {config['name']}", file=sys.stderr)
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+
+
+def run(config: Config, benchmarks: List[str]) -> List[str]:
+    """Simulator output of every benchmark on one configuration"""
+    model_dir = SOC_DIR / "verilog" / "verilator" / SWEEP_DIR / str(config["name"])
+    vtop = model_dir / "obj_dir" / "VTop"
+    lines: List[str] = []
+    for bench in benchmarks:
+        elf = SOC_DIR / "csrc" / f"{bench}.elf"
+        result = subprocess.run([str(vtop), "-i", str(elf), "--headless"],
+                                cwd=vtop.parent, stdout=subprocess.PIPE,
+                                stderr=subprocess.DEVNULL, text=True,
+                                errors="replace")
+        lines.extend(result.stdout.splitlines())
+    print(f"[run] {config['name']}", file=sys.stderr)
+    return lines
+
+
+def summarize(config: Config, bench_results: List[Result],
+              benchmarks: List[str], state_bits: int) -> Result:
+    totals = {key: sum(int(r[key]) for r in bench_results)
+              for key in ("cycles", "instret", "branches", "mispredicts")}
+    valid = (len(bench_results) == len(benchmarks) and
+             all(r["valid"] for r in bench_results))
+    result: Result = {"config": config["name"], "valid": int(valid)}
+    result.update({key: value for key, value in config.items()
+                   if key in FLAGS})
+    result.update({
+        "state_bits": state_bits,
+        "ipc": round(totals["instret"] / totals["cycles"], 4)
+        if totals["cycles"] else 0.0,
+        "mispredict_rate": round(totals["mispredicts"] / totals["branches"], 4)
+        if totals["branches"] else 0.0,
+    })
+    for r in bench_results:
+        result[f"{r['bench']}_ipc"] = r["ipc"]
+    return result
+
+
+def mark_pareto(results: List[Result]) -> None:
+    """Flag results that no other valid result beats on bits and accuracy"""
+    for r in results:
+        dominated = any(
+            o is not r and o["valid"] and
+            o["state_bits"] <= r["state_bits"] and
+            o["mispredict_rate"] <= r["mispredict_rate"] and
+            (o["state_bits"] < r["state_bits"] or
+             o["mispredict_rate"] < r["mispredict_rate"])
+            for o in results)
+        r["pareto"] = int(bool(r["valid"]) and not dominated)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description="Sweep 4-soc branch predictor sizing and report "
+                    "misprediction rate, IPC and state bits")
+    parser.add_argument("--configs", default=str(SOC_DIR / "scripts" / "predictor-sweep.json"),
+                        help="JSON list of configurations")
+    parser.add_argument("--benchmarks", nargs="+", default=["coremark", "dhrystone"],
+                        help="csrc benchmark ELFs to run (default: coremark dhrystone)")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                        help="parallel model builds and runs")
+    parser.add_argument("--no-build", action="store_true",
+                        help="reuse the models of a previous sweep")
+    parser.add_argument("--json", action="store_true",
+                        help="print one JSON object per configuration")
+    args = parser.parse_args()
+
+    with open(args.configs) as f:
+        configs: List[Config] = json.load(f)
+    names = [str(c.get("name", "")) for c in configs]
+    if "" in names or len(set(names)) != len(names):
+        print("Every configuration needs a unique name", file=sys.stderr)
+        return 1
+    unknown = {k for c in configs for k in c if k != "name" and k not in FLAGS}
+    if unknown:
+        print(f"Unknown keys: {', '.join(sorted(unknown))}", file=sys.stderr)
+        return 1
+
+    for bench in args.benchmarks:
+        if not (SOC_DIR / "csrc" / f"{bench}.elf").exists():
+            print(f"Missing csrc/{bench}.elf (make -C csrc {bench}.elf)", file=sys.stderr)
+            return 1
+
+    # State bits are printed at generation; --no-build reuses the last log
+    bits_log = SOC_DIR / "verilog" / "verilator" / SWEEP_DIR / "state-bits.json"
+    if args.no_build:
+        state_bits = json.loads(bits_log.read_text()) if bits_log.exists() else {}
+    else:
+        state_bits = generate(configs)
+        bits_log.parent.mkdir(parents=True, exist_ok=True)
+        bits_log.write_text(json.dumps(state_bits))
+        with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            list(pool.map(build, configs))
+
+    bench_report = load_bench_report()
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        outputs = list(pool.map(lambda c: run(c, args.benchmarks), configs))
+
+    results = [summarize(config, bench_report.parse(lines), args.benchmarks,
+                         state_bits.get(str(config["name"]), 0))
+               for config, lines in zip(configs, outputs)]
+    mark_pareto(results)
+
+    if args.json:
+        for result in results:
+            print(json.dumps(result))
+    else:
+        print(f"{'config':<16}{'state_bits':>11}{'ipc':>8}{'mispredict':>12}"
+              f"{'valid':>7}{'pareto':>8}")
+        for r in sorted(results, key=lambda r: r["state_bits"]):
+            print(f"{r['config']:<16}{r['state_bits']:>11}{r['ipc']:>8.4f}"
+                  f"{r['mispredict_rate']:>12.4f}{r['valid']:>7}{r['pareto']:>8}")
+
+    invalid = [str(r["config"]) for r in results if not r["valid"]]
+    if invalid:
+        print(f"Not validated: {', '.join(invalid)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -6,17 +6,52 @@ package board.verilator
 
 import bus.AXI4LiteSlave
 import bus.AXI4LiteSlaveBundle
-import bus.BusArbiter
+import bus.AXI4MasterMux
 import bus.BusSwitch
+import bus.MasterArbitration
 import chisel3._
 import chisel3.stage.ChiselStage
+import chisel3.util.Cat
+import peripheral.DMA
 import peripheral.DummySlave
+import peripheral.HartControl
 import peripheral.Uart
 import peripheral.VGA
 import riscv.core.CPU
+import riscv.core.DCacheConfig
+import riscv.core.DirectionPredictor
+import riscv.core.ICacheConfig
+import riscv.core.PredictorConfig
 import riscv.Parameters
 
-class Top extends Module {
+// uartBaudRate: simulation-only UART rate; the Verilator harness must be
+// built with the same SIM_UART_BAUD (the Makefile passes both)
+// icache: instruction cache in front of RAM; disabled, fetch uses io.instruction
+// dcache: write-back data cache for RAM loads and stores; disabled, every
+// access crosses the bus
+// predictor: BTB, RAS and IndirectBTB sizing and the direction predictor
+// uartTxDepth/uartRxDepth: UART TX and RX FIFO entries
+// harts: cores sharing the bus with the DMA controller through one
+// AXI4MasterMux; more than one needs
+// the I-cache (only hart 0 has the instruction port) and no D-cache (nothing
+// keeps per-hart caches coherent). Only hart 0 drives the debug, commit
+// trace and profile ports and takes the UART and DMA interrupts.
+// arbitration: MasterArbitration.Priority (higher hart wins, the DMA
+// controller last) or .RoundRobin
+class Top(
+    uartBaudRate: Int = 115200,
+    icache: ICacheConfig = ICacheConfig(),
+    dcache: DCacheConfig = DCacheConfig(),
+    predictor: PredictorConfig = PredictorConfig(),
+    uartTxDepth: Int = 16,
+    uartRxDepth: Int = 16,
+    harts: Int = 1,
+    arbitration: String = MasterArbitration.Priority
+) extends Module {
+  require(harts >= 1)
+  require(harts == 1 || icache.enabled, "Extra harts fetch through the I-cache (--icache-sets)")
+  require(harts == 1 || !dcache.enabled, "The D-cache is not coherent across harts")
+
   val io = IO(new Bundle {
     val signal_interrupt = Input(Bool())
 
@@ -41,10 +76,29 @@ class Top extends Module {
     val uart_rxd       = Input(UInt(1.W))  // UART RX data
     val uart_interrupt = Output(Bool())    // UART interrupt signal
 
+    // An interrupt source other than the UART may still fire: a timer or MSIP,
+    // or a running DMA transfer (sim.cpp --idle-stop)
+    val wake_pending = Output(Bool())
+
     val cpu_debug_read_address     = Input(UInt(Parameters.PhysicalRegisterAddrWidth))
     val cpu_debug_read_data        = Output(UInt(Parameters.DataWidth))
     val cpu_csr_debug_read_address = Input(UInt(Parameters.CSRRegisterAddrWidth))
     val cpu_csr_debug_read_data    = Output(UInt(Parameters.DataWidth))
+    val cpu_debug_pc               = Output(UInt(Parameters.AddrWidth)) // PC in IF, not the fetch address
+
+    // Commit trace for sim.cpp --lockstep and --trace-insn
+    val cpu_retire_valid        = Output(Bool())
+    val cpu_retire_instruction  = Output(UInt(Parameters.InstructionWidth))
+    val cpu_retire_pc           = Output(UInt(Parameters.AddrWidth))
+    val cpu_retire_write_enable = Output(Bool())
+    val cpu_retire_rd           = Output(UInt(Parameters.PhysicalRegisterAddrWidth))
+    val cpu_retire_data         = Output(UInt(Parameters.DataWidth))
+    val cpu_retire_mem_address  = Output(UInt(Parameters.AddrWidth))
+
+    // Per-PC profile events for sim.cpp --profile
+    val cpu_perf_events = Output(UInt(4.W))
+    val cpu_perf_id_pc  = Output(UInt(Parameters.AddrWidth))
+    val cpu_perf_mem_pc = Output(UInt(Parameters.AddrWidth))
   })
 
   // AXI4-Lite memory model provided by Verilator C++ harness (sim.cpp)
@@ -54,40 +108,71 @@ class Top extends Module {
   // VGA peripheral
   val vga = Module(new VGA)
 
-  // UART peripheral (115200 baud standard rate)
-  val uart = Module(new Uart(frequency = 50000000, baudRate = 115200))
+  // UART peripheral (115200 baud standard rate unless overridden)
+  val uart = Module(
+    new Uart(frequency = 50000000, baudRate = uartBaudRate, txDepth = uartTxDepth, rxDepth = uartRxDepth)
+  )
 
-  val cpu         = Module(new CPU)
-  val dummy       = Module(new DummySlave)
-  val bus_arbiter = Module(new BusArbiter)
-  val bus_switch  = Module(new BusSwitch)
+  val cpus = (0 until harts).map(h =>
+    Module(new CPU(icache = icache, dcache = dcache, predictor = predictor, hartId = h))
+  )
+  val cpu          = cpus.head
+  val dummy        = Module(new DummySlave)
+  val bus_switch   = Module(new BusSwitch)
+  val hart_control = Module(new HartControl(harts, arbitration == MasterArbitration.RoundRobin))
+  val dma          = Module(new DMA)
 
-  // Instruction fetch (external ROM in testbench)
-  io.instruction_address   := cpu.io.instruction_address
-  cpu.io.instruction       := io.instruction
-  cpu.io.instruction_valid := io.instruction_valid
+  // Instruction fetch (external ROM in testbench); the other harts only
+  // refill their I-cache over the bus, gated by the same valid
+  io.instruction_address := cpu.io.instruction_address
+  for ((core, h) <- cpus.zipWithIndex) {
+    core.io.instruction       := (if (h == 0) io.instruction else 0.U)
+    core.io.instruction_valid := io.instruction_valid
+  }
 
   // Terminate unused memory_bundle inputs with explicit values
   // These signals are not used because memory access goes through AXI4-Lite channels,
   // but Chisel requires all bundle inputs to be driven. Using explicit zeros instead
   // of DontCare for deterministic simulation behavior and cleaner waveforms.
-  cpu.io.memory_bundle.read_data           := 0.U
-  cpu.io.memory_bundle.read_valid          := false.B
-  cpu.io.memory_bundle.write_valid         := false.B
-  cpu.io.memory_bundle.write_data_accepted := false.B
-  cpu.io.memory_bundle.busy                := false.B
-  cpu.io.memory_bundle.granted             := false.B
+  for (core <- cpus) {
+    core.io.memory_bundle.read_data           := 0.U
+    core.io.memory_bundle.read_valid          := false.B
+    core.io.memory_bundle.write_valid         := false.B
+    core.io.memory_bundle.write_data_accepted := false.B
+    core.io.memory_bundle.write_exclusive_ok  := false.B
+    core.io.memory_bundle.busy                := false.B
+    core.io.memory_bundle.granted             := false.B
+  }
 
-  // Bus arbiter
-  bus_arbiter.io.bus_request(0) := true.B
+  // Harts and the DMA controller share the bus switch; the mux also keeps
+  // the LR/SC reservations (one hart still goes through it, so SC.W sees
+  // EXOKAY). The DMA controller is master 0, the lowest priority, and hart h
+  // is master h + 1.
+  val hart_mux = Module(
+    new AXI4MasterMux(harts + 1, Parameters.AddrBits, Parameters.DataBits, arbitration, exclusiveMonitor = true)
+  )
+  hart_mux.io.masters(0) <> dma.io.master
+  hart_mux.io.addresses(0) := dma.io.bus_address
+  hart_mux.io.exclusive(0) := false.B
+  for ((core, h) <- cpus.zipWithIndex) {
+    hart_mux.io.masters(h + 1) <> core.io.axi4_channels
+    hart_mux.io.addresses(h + 1) := core.io.bus_address
+    hart_mux.io.exclusive(h + 1) := core.io.bus_exclusive
+  }
+  hart_control.io.bus_busy_cycles := hart_mux.io.busy_cycles
+  hart_control.io.bus_wait_cycles := VecInit(hart_mux.io.wait_cycles.drop(1))
+  hart_control.io.bus_grants      := VecInit(hart_mux.io.grants.drop(1))
+  dma.io.bus_wait_cycles          := hart_mux.io.wait_cycles(0)
 
   // Bus switch
-  bus_switch.io.master <> cpu.io.axi4_channels
-  bus_switch.io.address := cpu.io.bus_address
+  bus_switch.io.master <> hart_mux.io.slave
+  bus_switch.io.address := hart_mux.io.address
   bus_switch.io.slaves(0) <> mem_slave.io.channels
   bus_switch.io.slaves(1) <> vga.io.channels
   bus_switch.io.slaves(2) <> uart.io.channels
-  for (i <- 3 until Parameters.SlaveDeviceCount) {
+  bus_switch.io.slaves(3) <> hart_control.io.channels
+  bus_switch.io.slaves(5) <> dma.io.channels
+  for (i <- Seq(4, 6, 7)) {
     bus_switch.io.slaves(i) <> dummy.io.channels
   }
 
@@ -105,19 +190,90 @@ class Top extends Module {
   uart.io.rxd       := io.uart_rxd
   io.uart_interrupt := uart.io.signal_interrupt
 
-  // Interrupt
-  cpu.io.interrupt_flag := io.signal_interrupt
+  io.wake_pending := hart_control.io.wake_pending || dma.io.busy
+
+  // Interrupts: the timer (bit 0, mcause 7) is HartControl MTIMECMP, and for
+  // hart 0 also io.signal_interrupt; the UART FIFO/RX and DMA completion
+  // interrupts are external (bit 1, mcause 11) to hart 0 only; MSIP is the
+  // software interrupt (bit 2, mcause 3)
+  for ((core, h) <- cpus.zipWithIndex) {
+    val timer    = if (h == 0) hart_control.io.mtip(h) || io.signal_interrupt else hart_control.io.mtip(h)
+    val external = if (h == 0) uart.io.signal_interrupt || dma.io.interrupt else false.B
+    core.io.interrupt_flag := Cat(hart_control.io.msip(h), external, timer)
+  }
+
+  // Harts 1.. have no debug ports; their register and CSR reads are left at x0
+  for (core <- cpus.tail) {
+    core.io.debug_read_address     := 0.U
+    core.io.csr_debug_read_address := 0.U
+  }
 
   // Debug interfaces
   cpu.io.debug_read_address     := io.cpu_debug_read_address
   io.cpu_debug_read_data        := cpu.io.debug_read_data
   cpu.io.csr_debug_read_address := io.cpu_csr_debug_read_address
   io.cpu_csr_debug_read_data    := cpu.io.csr_debug_read_data
+  io.cpu_debug_pc               := cpu.io.debug_pc
+  io.cpu_retire_valid           := cpu.io.debug_retire_valid
+  io.cpu_retire_instruction     := cpu.io.debug_retire_instruction
+  io.cpu_retire_pc              := cpu.io.debug_retire_pc
+  io.cpu_retire_write_enable    := cpu.io.debug_retire_write_enable
+  io.cpu_retire_rd              := cpu.io.debug_retire_rd
+  io.cpu_retire_data            := cpu.io.debug_retire_data
+  io.cpu_retire_mem_address     := cpu.io.debug_retire_mem_address
+  io.cpu_perf_events            := cpu.io.debug_perf_events
+  io.cpu_perf_id_pc             := cpu.io.debug_perf_id_pc
+  io.cpu_perf_mem_pc            := cpu.io.debug_perf_mem_pc
 }
 
 object VerilogGenerator extends App {
+  def stringOption(flag: String, default: String): String =
+    args.sliding(2).collectFirst { case Array(`flag`, value) => value }.getOrElse(default)
+  def option(flag: String, default: Int): Int = stringOption(flag, default.toString).toInt
+
+  // --uart-baud N shortens the UART bit time for faster simulation
+  val uartBaudRate = option("--uart-baud", 115200)
+  // --uart-tx-depth N, --uart-rx-depth N: UART FIFO entries
+  val uartTxDepth = option("--uart-tx-depth", 16)
+  val uartRxDepth = option("--uart-rx-depth", 16)
+  // --icache-sets N (0 = no I-cache), --icache-ways 1|2, --icache-line-words N
+  val icache = ICacheConfig(
+    sets = option("--icache-sets", 0),
+    ways = option("--icache-ways", 1),
+    lineWords = option("--icache-line-words", 8)
+  )
+  // --dcache-sets N (0 = no D-cache), --dcache-ways 1|2, --dcache-line-words N,
+  // --dcache-store-buffer N
+  val dcache = DCacheConfig(
+    sets = option("--dcache-sets", 0),
+    ways = option("--dcache-ways", 1),
+    lineWords = option("--dcache-line-words", 8),
+    storeBuffer = option("--dcache-store-buffer", 4)
+  )
+  // --direction perceptron|tournament, --btb-entries N, --ras-depth N,
+  // --ibtb-entries N, --perceptrons N, --history-length N, --weight-bits N,
+  // --training-threshold N, --pht-entries N
+  val predictor = PredictorConfig(
+    direction = stringOption("--direction", DirectionPredictor.Perceptron),
+    btbEntries = option("--btb-entries", 32),
+    rasDepth = option("--ras-depth", 4),
+    ibtbEntries = option("--ibtb-entries", 8),
+    perceptrons = option("--perceptrons", 8),
+    historyLength = option("--history-length", 7),
+    weightBits = option("--weight-bits", 8),
+    trainingThreshold = option("--training-threshold", 15),
+    phtEntries = option("--pht-entries", 256)
+  )
+  // --target-dir DIR (relative to the repository root) keeps configuration
+  // variants apart, e.g. for scripts/predictor-sweep.py
+  val targetDir = stringOption("--target-dir", "4-soc/verilog/verilator")
+  // --harts N (needs --icache-sets), --arbitration priority|round-robin
+  val harts       = option("--harts", 1)
+  val arbitration = stringOption("--arbitration", MasterArbitration.Priority)
   (new ChiselStage).emitVerilog(
-    new Top(),
-    Array("--target-dir", "4-soc/verilog/verilator")
+    new Top(uartBaudRate, icache, dcache, predictor, uartTxDepth, uartRxDepth, harts, arbitration),
+    Array("--target-dir", targetDir)
   )
+  // Area estimate for the sweep: register bits of all predictor structures
+  println(s"[predictor] target-dir=$targetDir state-bits=${predictor.stateBits}")
 }
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package bus
+
+import chisel3._
+import chisel3.util._
+import riscv.Parameters
+
+// Bundle for a line-refill client (cache) driving an AXI4BurstMaster.
+// Bursts are INCR, one 32-bit word per beat; length is beats - 1 as in ARLEN.
+class AXI4BurstMasterBundle(addrWidth: Int, dataWidth: Int) extends Bundle {
+  val address      = Input(UInt(addrWidth.W))              // address of beat 0, word aligned
+  val length       = Input(UInt(AXI4Lite.lenWidth.W))
+  val read         = Input(Bool())                         // request a burst read
+  val write        = Input(Bool())                         // request a burst write
+  val write_data   = Input(UInt(dataWidth.W))              // data for beat `beat`, sampled combinationally
+  val write_strobe = Input(Vec(Parameters.WordSize, Bool()))
+  val read_data    = Output(UInt(dataWidth.W))
+  val read_valid   = Output(Bool())                        // read_data holds beat `beat`, one pulse per beat
+  val beat         = Output(UInt(AXI4Lite.lenWidth.W))     // beat of read_data, or of the wanted write_data
+  val busy         = Output(Bool())                        // if busy, master is not ready
+  val done         = Output(Bool())                        // last read beat delivered / BRESP received
+}
+
+/**
+ * AXI4 INCR burst master
+ *
+ * Counterpart of AXI4LiteMaster for block transfers: one address handshake
+ * moves length + 1 consecutive words. Reads hold RREADY for the whole burst
+ * and finish on RLAST; writes stream the beats while the client presents the
+ * word selected by io.bundle.beat, raising WLAST on the last one.
+ *
+ * The address must reach BusSwitch unchanged until done, exactly as for
+ * AXI4LiteMaster (BusSwitch decodes write beats combinationally).
+ */
+class AXI4BurstMaster(addrWidth: Int, dataWidth: Int) extends Module {
+  val io = IO(new Bundle {
+    val channels = new AXI4LiteChannels(addrWidth, dataWidth)
+    val bundle   = new AXI4BurstMasterBundle(addrWidth, dataWidth)
+  })
+
+  val state = RegInit(AXI4LiteStates.Idle)
+  io.bundle.busy := state =/= AXI4LiteStates.Idle
+
+  val addr   = RegInit(0.U(addrWidth.W))
+  val length = RegInit(0.U(AXI4Lite.lenWidth.W))
+  val count  = RegInit(0.U(AXI4Lite.lenWidth.W)) // next beat on the data channel
+  io.channels.read_address_channel.ARADDR  := addr
+  io.channels.write_address_channel.AWADDR := addr
+  io.channels.read_address_channel.ARLEN   := length
+  io.channels.write_address_channel.AWLEN  := length
+  io.channels.read_address_channel.ARPROT  := 0.U
+  io.channels.write_address_channel.AWPROT := 0.U
+
+  // Read signals
+  val read_valid = RegInit(false.B)
+  io.bundle.read_valid := read_valid
+  val read_data = RegInit(0.U(dataWidth.W))
+  io.bundle.read_data := read_data
+  val read_beat = RegInit(0.U(AXI4Lite.lenWidth.W))
+
+  val ARVALID = RegInit(false.B)
+  io.channels.read_address_channel.ARVALID := ARVALID
+  val RREADY = RegInit(false.B)
+  io.channels.read_data_channel.RREADY := RREADY
+
+  // Write signals: data comes straight from the client for the current beat
+  val AWVALID = RegInit(false.B)
+  io.channels.write_address_channel.AWVALID := AWVALID
+  val WVALID = RegInit(false.B)
+  io.channels.write_data_channel.WVALID := WVALID
+  io.channels.write_data_channel.WDATA  := io.bundle.write_data
+  io.channels.write_data_channel.WSTRB  := io.bundle.write_strobe.asUInt
+  io.channels.write_data_channel.WLAST  := count === length
+  val BREADY = RegInit(false.B)
+  io.channels.write_response_channel.BREADY := BREADY
+
+  val writing = state === AXI4LiteStates.WriteData || state === AXI4LiteStates.WriteResp
+  io.bundle.beat := Mux(writing, count, read_beat)
+
+  val done = RegInit(false.B)
+  io.bundle.done := done
+
+  read_valid := false.B
+  done       := false.B
+
+  switch(state) {
+    is(AXI4LiteStates.Idle) {
+      when(io.bundle.read && !io.bundle.write) {
+        addr    := io.bundle.address
+        length  := io.bundle.length
+        count   := 0.U
+        ARVALID := true.B
+        RREADY  := true.B
+        state   := AXI4LiteStates.ReadData
+      }.elsewhen(io.bundle.write) {
+        addr    := io.bundle.address
+        length  := io.bundle.length
+        count   := 0.U
+        AWVALID := true.B
+        WVALID  := true.B
+        state   := AXI4LiteStates.WriteData
+      }
+    }
+
+    is(AXI4LiteStates.ReadData) {
+      when(ARVALID && io.channels.read_address_channel.ARREADY) {
+        ARVALID := false.B
+      }
+
+      when(io.channels.read_data_channel.RVALID && RREADY) {
+        read_data  := io.channels.read_data_channel.RDATA
+        read_valid := true.B
+        read_beat  := count
+        count      := count + 1.U
+        when(io.channels.read_data_channel.RLAST) {
+          RREADY := false.B
+          done   := true.B
+          state  := AXI4LiteStates.Idle
+        }
+      }
+    }
+
+    is(AXI4LiteStates.WriteData) {
+      when(AWVALID && io.channels.write_address_channel.AWREADY) {
+        AWVALID := false.B
+      }
+
+      when(WVALID && io.channels.write_data_channel.WREADY) {
+        when(count === length) {
+          WVALID := false.B
+          BREADY := true.B
+          state  := AXI4LiteStates.WriteResp
+        }.otherwise {
+          count := count + 1.U
+        }
+      }
+    }
+
+    is(AXI4LiteStates.WriteResp) {
+      when(AWVALID && io.channels.write_address_channel.AWREADY) {
+        AWVALID := false.B
+      }
+
+      when(io.channels.write_response_channel.BVALID && BREADY) {
+        BREADY := false.B
+        done   := true.B
+        state  := AXI4LiteStates.Idle
+      }
+    }
+  }
+}
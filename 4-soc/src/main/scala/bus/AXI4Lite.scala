@@ -14,10 +14,13 @@ import riscv.Parameters
  *
  * Implements ARM AMBA AXI4-Lite protocol for simple memory-mapped I/O.
  * AXI4-Lite is a subset of full AXI4, optimized for low-throughput
- * control/status register access with single-beat transactions only.
+ * control/status register access with single-beat transactions.
  *
  * Protocol Characteristics:
- * - Single-beat (non-burst) transactions only
+ * - Single-beat transactions, plus the AXI4 INCR burst subset: ARLEN/AWLEN
+ *   (beats - 1), RLAST and WLAST. Beats are always one 32-bit word and the
+ *   address increments by 4. AXI4LiteMaster only issues single beats
+ *   (LEN = 0); AXI4BurstMaster issues bursts for line refills.
  * - Fixed data width (32-bit in this implementation)
  * - Separate read and write channels (can operate independently)
  * - VALID/READY handshake on all channels
@@ -32,6 +35,10 @@ import riscv.Parameters
 object AXI4Lite {
   val protWidth = 3 // Protection type width (privileged, secure, instruction/data)
   val respWidth = 2 // Response width (OKAY=0, EXOKAY=1, SLVERR=2, DECERR=3)
+  val lenWidth  = 8 // Burst length width (AXI4 ARLEN/AWLEN: beats - 1)
+
+  val Okay   = 0.U(respWidth.W)
+  val ExOkay = 1.U(respWidth.W) // exclusive access succeeded (AXI4MasterMux monitor)
 }
 
 class AXI4LiteWriteAddressChannel(addrWidth: Int) extends Bundle {
@@ -39,6 +46,7 @@ class AXI4LiteWriteAddressChannel(addrWidth: Int) extends Bundle {
   val AWREADY = Input(Bool())
   val AWADDR  = Output(UInt(addrWidth.W))
   val AWPROT  = Output(UInt(AXI4Lite.protWidth.W))
+  val AWLEN   = Output(UInt(AXI4Lite.lenWidth.W))
 }
 
 class AXI4LiteWriteDataChannel(dataWidth: Int) extends Bundle {
@@ -46,6 +54,7 @@ class AXI4LiteWriteDataChannel(dataWidth: Int) extends Bundle {
   val WREADY = Input(Bool())
   val WDATA  = Output(UInt(dataWidth.W))
   val WSTRB  = Output(UInt((dataWidth / 8).W))
+  val WLAST  = Output(Bool())
 }
 
 class AXI4LiteWriteResponseChannel extends Bundle {
@@ -59,6 +68,7 @@ class AXI4LiteReadAddressChannel(addrWidth: Int) extends Bundle {
   val ARREADY = Input(Bool())
   val ARADDR  = Output(UInt(addrWidth.W))
   val ARPROT  = Output(UInt(AXI4Lite.protWidth.W))
+  val ARLEN   = Output(UInt(AXI4Lite.lenWidth.W))
 }
 
 class AXI4LiteReadDataChannel(dataWidth: Int) extends Bundle {
@@ -66,6 +76,7 @@ class AXI4LiteReadDataChannel(dataWidth: Int) extends Bundle {
   val RREADY = Output(Bool())
   val RDATA  = Input(UInt(dataWidth.W))
   val RRESP  = Input(UInt(AXI4Lite.respWidth.W))
+  val RLAST  = Input(Bool())
 }
 
 class AXI4LiteInterface(addrWidth: Int, dataWidth: Int) extends Bundle {
@@ -73,10 +84,12 @@ class AXI4LiteInterface(addrWidth: Int, dataWidth: Int) extends Bundle {
   val AWREADY = Input(Bool())
   val AWADDR  = Output(UInt(addrWidth.W))
   val AWPROT  = Output(UInt(AXI4Lite.protWidth.W))
+  val AWLEN   = Output(UInt(AXI4Lite.lenWidth.W))
   val WVALID  = Output(Bool())
   val WREADY  = Input(Bool())
   val WDATA   = Output(UInt(dataWidth.W))
   val WSTRB   = Output(UInt((dataWidth / 8).W))
+  val WLAST   = Output(Bool())
   val BVALID  = Input(Bool())
   val BREADY  = Output(Bool())
   val BRESP   = Input(UInt(AXI4Lite.respWidth.W))
@@ -84,10 +97,12 @@ class AXI4LiteInterface(addrWidth: Int, dataWidth: Int) extends Bundle {
   val ARREADY = Input(Bool())
   val ARADDR  = Output(UInt(addrWidth.W))
   val ARPROT  = Output(UInt(AXI4Lite.protWidth.W))
+  val ARLEN   = Output(UInt(AXI4Lite.lenWidth.W))
   val RVALID  = Input(Bool())
   val RREADY  = Output(Bool())
   val RDATA   = Input(UInt(dataWidth.W))
   val RRESP   = Input(UInt(AXI4Lite.respWidth.W))
+  val RLAST   = Input(Bool())
 }
 
 class AXI4LiteChannels(addrWidth: Int, dataWidth: Int) extends Bundle {
@@ -98,7 +113,8 @@ class AXI4LiteChannels(addrWidth: Int, dataWidth: Int) extends Bundle {
   val read_data_channel      = new AXI4LiteReadDataChannel(dataWidth)
 }
 
-// Bundle for slave device to interact with AXI4-Lite bus
+// Bundle for slave device to interact with AXI4-Lite bus. A burst reaches
+// the device as one read or write per beat at increasing addresses.
 class AXI4LiteSlaveBundle(addrWidth: Int, dataWidth: Int) extends Bundle {
   val address      = Output(UInt(addrWidth.W))
   val read         = Output(Bool())           // tell slave device to read
@@ -107,6 +123,7 @@ class AXI4LiteSlaveBundle(addrWidth: Int, dataWidth: Int) extends Bundle {
   val write        = Output(Bool())           // tell slave device to write
   val write_data   = Output(UInt(dataWidth.W))
   val write_strobe = Output(Vec(Parameters.WordSize, Bool()))
+  val burst        = Output(Bool())           // this beat continues a burst (not the first)
 }
 
 // Bundle for master device to interact with AXI4-Lite bus
@@ -121,6 +138,7 @@ class AXI4LiteMasterBundle(addrWidth: Int, dataWidth: Int) extends Bundle {
   val read_valid          = Output(Bool()) // read transaction complete
   val write_valid         = Output(Bool()) // write transaction complete (BRESP received)
   val write_data_accepted = Output(Bool()) // write data accepted by slave (WREADY && WVALID)
+  val write_exclusive_ok  = Output(Bool()) // with write_valid: BRESP was EXOKAY
 }
 
 object AXI4LiteStates extends ChiselEnum {
@@ -138,6 +156,12 @@ class AXI4LiteSlave(addrWidth: Int, dataWidth: Int) extends Module {
   val addr = RegInit(0.U(addrWidth.W)) // Fixed: was dataWidth, should be addrWidth
   io.bundle.address := addr
 
+  // Burst state: beats still to transfer after the current one, and whether
+  // the current beat follows an earlier one of the same burst
+  val beats_left = RegInit(0.U(AXI4Lite.lenWidth.W))
+  val burst      = RegInit(false.B)
+  io.bundle.burst := burst
+
   // Read signals
   val read = RegInit(false.B)
   io.bundle.read := read
@@ -150,6 +174,8 @@ class AXI4LiteSlave(addrWidth: Int, dataWidth: Int) extends Module {
   io.channels.read_data_channel.RVALID := RVALID
   val RRESP = RegInit(0.U(AXI4Lite.respWidth.W))
   io.channels.read_data_channel.RRESP := RRESP
+  val RLAST = RegInit(false.B)
+  io.channels.read_data_channel.RLAST := RLAST
 
   // Write signals
   val write = RegInit(false.B)
@@ -186,11 +212,13 @@ class AXI4LiteSlave(addrWidth: Int, dataWidth: Int) extends Module {
 
     is(AXI4LiteStates.ReadAddr) {
       when(io.channels.read_address_channel.ARVALID && ARREADY) {
-        // Capture address
-        addr    := io.channels.read_address_channel.ARADDR
-        ARREADY := false.B
-        read    := true.B
-        state   := AXI4LiteStates.ReadData
+        // Capture address and burst length
+        addr       := io.channels.read_address_channel.ARADDR
+        beats_left := io.channels.read_address_channel.ARLEN
+        burst      := false.B
+        ARREADY    := false.B
+        read       := true.B
+        state      := AXI4LiteStates.ReadData
       }
     }
 
@@ -200,34 +228,55 @@ class AXI4LiteSlave(addrWidth: Int, dataWidth: Int) extends Module {
         read_data := io.bundle.read_data
         RVALID    := true.B
         RRESP     := 0.U // OKAY response
+        RLAST     := beats_left === 0.U
         read      := false.B
       }
 
       when(RVALID && io.channels.read_data_channel.RREADY) {
-        // Master acknowledged data
+        // Master acknowledged data; a burst asks the device for the next word
         RVALID := false.B
-        state  := AXI4LiteStates.Idle
+        when(beats_left === 0.U) {
+          state := AXI4LiteStates.Idle
+        }.otherwise {
+          addr       := addr + (dataWidth / 8).U
+          beats_left := beats_left - 1.U
+          burst      := true.B
+          read       := true.B
+        }
       }
     }
 
     is(AXI4LiteStates.WriteAddr) {
       when(io.channels.write_address_channel.AWVALID && AWREADY) {
-        // Capture write address
-        addr    := io.channels.write_address_channel.AWADDR
-        AWREADY := false.B
-        WREADY  := true.B
-        state   := AXI4LiteStates.WriteData
+        // Capture write address and burst length
+        addr       := io.channels.write_address_channel.AWADDR
+        beats_left := io.channels.write_address_channel.AWLEN
+        burst      := false.B
+        AWREADY    := false.B
+        WREADY     := true.B
+        state      := AXI4LiteStates.WriteData
       }
     }
 
     is(AXI4LiteStates.WriteData) {
+      // The device consumed the previous beat; the next one goes one word up
+      write := false.B
+      when(write) {
+        addr  := addr + (dataWidth / 8).U
+        burst := true.B
+      }
+
       when(io.channels.write_data_channel.WVALID && WREADY) {
-        // Capture write data
+        // Capture write data; the beat count from AWLEN decides the last beat
         write_data   := io.channels.write_data_channel.WDATA
         write_strobe := VecInit(io.channels.write_data_channel.WSTRB.asBools)
-        WREADY       := false.B
         write        := true.B
-        state        := AXI4LiteStates.WriteResp
+        when(beats_left === 0.U) {
+          WREADY := false.B
+          state  := AXI4LiteStates.WriteResp
+        }.otherwise {
+          beats_left := beats_left - 1.U
+        }
       }
     }
 
@@ -270,10 +319,13 @@ class AXI4LiteMaster(addrWidth: Int, dataWidth: Int) extends Module {
   io.channels.read_data_channel.RREADY := RREADY
 
   io.channels.read_address_channel.ARPROT := 0.U
+  io.channels.read_address_channel.ARLEN  := 0.U // single beat
 
   // Write signals
   val write_valid = RegInit(false.B)
   io.bundle.write_valid := write_valid
+  val write_exclusive_ok = RegInit(false.B)
+  io.bundle.write_exclusive_ok := write_exclusive_ok
   val write_data = RegInit(0.U(dataWidth.W))
   io.channels.write_data_channel.WDATA := write_data
   val write_strobe = RegInit(VecInit(Seq.fill(Parameters.WordSize)(false.B)))
@@ -291,6 +343,8 @@ class AXI4LiteMaster(addrWidth: Int, dataWidth: Int) extends Module {
   io.bundle.write_data_accepted := write_data_accepted
 
   io.channels.write_address_channel.AWPROT := 0.U
+  io.channels.write_address_channel.AWLEN  := 0.U // single beat
+  io.channels.write_data_channel.WLAST     := true.B
 
   // Performance optimization: Assert ARVALID/AWVALID in Idle to save 1 cycle
   // per transaction. Both addr and ARVALID/AWVALID are registered, so they
@@ -358,9 +412,10 @@ class AXI4LiteMaster(addrWidth: Int, dataWidth: Int) extends Module {
 
       when(io.channels.write_response_channel.BVALID && BREADY) {
         // Write acknowledged
-        BREADY      := false.B
-        write_valid := true.B
-        state       := AXI4LiteStates.Idle
+        BREADY             := false.B
+        write_valid        := true.B
+        write_exclusive_ok := io.channels.write_response_channel.BRESP === AXI4Lite.ExOkay
+        state              := AXI4LiteStates.Idle
       }
     }
   }
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package bus
+
+import chisel3._
+import chisel3.util._
+import riscv.Parameters
+
+object MasterArbitration {
+  val Priority   = "priority"
+  val RoundRobin = "round-robin"
+  val All        = Seq(Priority, RoundRobin)
+}
+
+/**
+ * N:1 AXI4 master multiplexer
+ *
+ * Shares the single BusSwitch port between several masters that each keep
+ * their own address register (io.addresses) stable for a whole transaction,
+ * as AXI4LiteMaster and AXI4BurstMaster do.
+ *
+ * Arbitration follows BusArbiter by default: static priority, higher-numbered
+ * masters win. "round-robin" instead grants the first requester after the
+ * previous owner, so no master waits for more than masters - 1
+ * transactions. Unlike BusArbiter the grant is locked from the first ARVALID,
+ * AWVALID or WVALID until the transaction ends (read handshake with RLAST, or
+ * the B handshake), so a burst is never split and a waiting master sees only
+ * ARREADY/AWREADY/WREADY low.
+ *
+ * Contention counters (free-running, wrapping):
+ * - busy_cycles: cycles a transaction owned the bus or was being granted
+ * - wait_cycles(i): cycles master i requested while another master owned
+ *   the bus
+ * - grants(i): transactions granted to master i
+ *
+ * Exclusive monitor (exclusiveMonitor = true), for LR.W/SC.W across harts:
+ * - An exclusive read (io.exclusive(i) with ARVALID) reserves its word for
+ *   master i when the address handshake passes
+ * - Any write that reaches the slave clears every reservation of its word
+ * - An exclusive write whose master holds no reservation of its word fails:
+ *   it is answered here (AWREADY/WREADY, then BRESP OKAY) and never reaches
+ *   the slave. One that succeeds gets BRESP EXOKAY, and the write itself
+ *   clears the reservation
+ * The reservation granule is one word, and every slave is covered.
+ *
+ * @param arbitration MasterArbitration.Priority or .RoundRobin
+ */
+class AXI4MasterMux(
+    masters: Int,
+    addrWidth: Int,
+    dataWidth: Int,
+    arbitration: String = MasterArbitration.Priority,
+    exclusiveMonitor: Boolean = false
+) extends Module {
+  require(masters >= 1)
+  require(MasterArbitration.All.contains(arbitration), s"Unknown arbitration: $arbitration")
+  val indexWidth = log2Ceil(masters + 1)
+  val io = IO(new Bundle {
+    val masters   = Vec(masters, Flipped(new AXI4LiteChannels(addrWidth, dataWidth)))
+    val addresses = Input(Vec(masters, UInt(Parameters.AddrWidth)))
+    val exclusive = Input(Vec(masters, Bool())) // with the request; ignored without the monitor
+    val slave     = new AXI4LiteChannels(addrWidth, dataWidth)
+    val address   = Output(UInt(Parameters.AddrWidth)) // to BusSwitch
+    val selected  = Output(UInt(indexWidth.W))         // master the slave channels follow
+
+    val busy_cycles = Output(UInt(32.W))
+    val wait_cycles = Output(Vec(masters, UInt(32.W)))
+    val grants      = Output(Vec(masters, UInt(32.W)))
+  })
+
+  val requests = io.masters.map(m =>
+    m.read_address_channel.ARVALID || m.write_address_channel.AWVALID || m.write_data_channel.WVALID
+  )
+
+  val locked = RegInit(false.B)
+  val owner  = RegInit(0.U(indexWidth.W))
+
+  val pick = Wire(UInt(indexWidth.W))
+  pick := 0.U
+  if (arbitration == MasterArbitration.Priority) {
+    for (i <- 0 until masters) {
+      when(requests(i)) {
+        pick := i.U
+      }
+    }
+  } else {
+    // Lowest requester above the previous owner, else the lowest overall
+    val pending = VecInit(requests).asUInt
+    val after   = VecInit(requests.zipWithIndex.map { case (r, i) => r && i.U > owner }).asUInt
+    pick := Mux(after.orR, PriorityEncoder(after), PriorityEncoder(pending))
+  }
+
+  val select = Mux(locked, owner, pick)
+  io.selected := select
+
+  // Reservations, one word per master
+  val word                = (address: UInt) => address(Parameters.AddrBits - 1, 2)
+  val reservation_valid   = RegInit(VecInit(Seq.fill(masters)(false.B)))
+  val reservation_address = Reg(Vec(masters, UInt((Parameters.AddrBits - 2).W)))
+  val holds_reservation   = (i: UInt) => reservation_valid(i) && reservation_address(i) === word(io.addresses(i))
+
+  // Exclusive write failed by the monitor: answered locally. Decided when
+  // the grant is taken, so not even the first AWVALID reaches the slave.
+  val squash_pick = exclusiveMonitor.B && io.exclusive(pick) && !holds_reservation(pick) &&
+    (io.masters(pick).write_address_channel.AWVALID || io.masters(pick).write_data_channel.WVALID)
+  val squash      = RegInit(false.B)
+  val squash_resp = RegInit(false.B)
+  val squashing   = Mux(locked, squash, squash_pick)
+
+  val m = io.masters(select)
+  io.slave.read_address_channel.ARADDR   := m.read_address_channel.ARADDR
+  io.slave.read_address_channel.ARPROT   := m.read_address_channel.ARPROT
+  io.slave.read_address_channel.ARLEN    := m.read_address_channel.ARLEN
+  io.slave.read_address_channel.ARVALID  := m.read_address_channel.ARVALID
+  io.slave.read_data_channel.RREADY      := m.read_data_channel.RREADY
+  io.slave.write_address_channel.AWADDR  := m.write_address_channel.AWADDR
+  io.slave.write_address_channel.AWPROT  := m.write_address_channel.AWPROT
+  io.slave.write_address_channel.AWLEN   := m.write_address_channel.AWLEN
+  io.slave.write_address_channel.AWVALID := m.write_address_channel.AWVALID && !squashing
+  io.slave.write_data_channel.WDATA      := m.write_data_channel.WDATA
+  io.slave.write_data_channel.WSTRB      := m.write_data_channel.WSTRB
+  io.slave.write_data_channel.WLAST      := m.write_data_channel.WLAST
+  io.slave.write_data_channel.WVALID     := m.write_data_channel.WVALID && !squashing
+  io.slave.write_response_channel.BREADY := m.write_response_channel.BREADY && !squashing
+  io.address                             := io.addresses(select)
+
+  // EXOKAY for an exclusive write that passed the monitor
+  val exclusive_ok = exclusiveMonitor.B && locked && io.exclusive(owner) && !squash &&
+    io.slave.write_response_channel.BRESP === AXI4Lite.Okay
+  val bresp = Mux(
+    squashing,
+    AXI4Lite.Okay,
+    Mux(exclusive_ok, AXI4Lite.ExOkay, io.slave.write_response_channel.BRESP)
+  )
+
+  for (i <- 0 until masters) {
+    val selected = select === i.U
+    val channels = io.masters(i)
+    channels.read_address_channel.ARREADY  := selected && io.slave.read_address_channel.ARREADY
+    channels.read_data_channel.RVALID      := selected && io.slave.read_data_channel.RVALID
+    channels.read_data_channel.RDATA       := io.slave.read_data_channel.RDATA
+    channels.read_data_channel.RRESP       := io.slave.read_data_channel.RRESP
+    channels.read_data_channel.RLAST       := io.slave.read_data_channel.RLAST
+    channels.write_address_channel.AWREADY := selected && (squashing || io.slave.write_address_channel.AWREADY)
+    channels.write_data_channel.WREADY     := selected && (squashing || io.slave.write_data_channel.WREADY)
+    channels.write_response_channel.BVALID := selected &&
+      Mux(squashing, squash_resp, io.slave.write_response_channel.BVALID)
+    channels.write_response_channel.BRESP := bresp
+  }
+
+  val read_done = io.slave.read_data_channel.RVALID && io.slave.read_data_channel.RREADY &&
+    io.slave.read_data_channel.RLAST
+  val write_done = Mux(
+    squashing,
+    squash_resp && m.write_response_channel.BREADY,
+    io.slave.write_response_channel.BVALID && io.slave.write_response_channel.BREADY
+  )
+
+  when(locked) {
+    when(read_done || write_done) {
+      locked      := false.B
+      squash      := false.B
+      squash_resp := false.B
+    }
+  }.elsewhen(requests.reduce(_ || _)) {
+    locked := true.B
+    owner  := pick
+    squash := squash_pick
+  }
+  // WREADY was given: the B response follows in the next cycle
+  when(squashing && m.write_data_channel.WVALID) {
+    squash_resp := true.B
+  }
+
+  if (exclusiveMonitor) {
+    when(io.slave.read_address_channel.ARVALID && io.slave.read_address_channel.ARREADY && io.exclusive(select)) {
+      reservation_valid(select)   := true.B
+      reservation_address(select) := word(io.address)
+    }
+    val write_forwarded = io.slave.write_address_channel.AWVALID && io.slave.write_address_channel.AWREADY
+    for (i <- 0 until masters) {
+      when(write_forwarded && reservation_valid(i) && reservation_address(i) === word(io.address)) {
+        reservation_valid(i) := false.B
+      }
+    }
+    // A failed SC.W gives up its reservation (of another word) as well
+    when(squashing && write_done) {
+      reservation_valid(owner) := false.B
+    }
+  }
+
+  // Contention counters
+  val busy_cycles = RegInit(0.U(32.W))
+  val wait_cycles = RegInit(VecInit(Seq.fill(masters)(0.U(32.W))))
+  val grants      = RegInit(VecInit(Seq.fill(masters)(0.U(32.W))))
+  when(locked || requests.reduce(_ || _)) {
+    busy_cycles := busy_cycles + 1.U
+  }
+  for (i <- 0 until masters) {
+    when(requests(i) && select =/= i.U) {
+      wait_cycles(i) := wait_cycles(i) + 1.U
+    }
+    when(!locked && requests(i) && pick === i.U) {
+      grants(i) := grants(i) + 1.U
+    }
+  }
+  io.busy_cycles := busy_cycles
+  io.wait_cycles := wait_cycles
+  io.grants      := grants
+}
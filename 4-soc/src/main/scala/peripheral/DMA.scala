@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package peripheral
+
+import bus.AXI4BurstMaster
+import bus.AXI4Lite
+import bus.AXI4LiteChannels
+import bus.AXI4LiteSlave
+import chisel3._
+import chisel3.util._
+import riscv.Parameters
+
+/**
+ * Bulk-transfer DMA controller: a bus master that moves words between any
+ * two bus addresses while the harts keep executing
+ *
+ * One descriptor moves COUNT words from SRC to DST, adding SRC_STRIDE and
+ * DST_STRIDE (bytes, two's complement) after every word. Stride 4 copies
+ * consecutive words, as memcpy does, and 0 stays on one address, e.g. a
+ * device data port such as VGA STREAM_DATA. With CTRL.FILL the source is
+ * the FILL register instead of SRC, as memset needs. Words move in chunks
+ * of up to `burstWords` through an internal buffer. A side with stride 4
+ * transfers a chunk as one AXI4 INCR burst; any other stride takes one
+ * single-beat transaction per word.
+ *
+ * Writing CTRL with START while idle runs the descriptor. SRC, DST and
+ * COUNT advance as words are written, so at the end they point past the
+ * transfer and COUNT reads 0. The next chunk of a longer copy needs only a
+ * new COUNT and START. Descriptor registers are read-only while BUSY;
+ * CTRL.IRQ_EN and the DONE flag stay writable.
+ *
+ * Register map:
+ *   0x00 SRC          source address, word aligned
+ *   0x04 DST          destination address, word aligned
+ *   0x08 COUNT        words left to move
+ *   0x0C SRC_STRIDE   bytes added to SRC per word (reset 4)
+ *   0x10 DST_STRIDE   bytes added to DST per word (reset 4)
+ *   0x14 FILL         source word of a CTRL.FILL descriptor
+ *   0x18 CTRL         bit 0 START (write only), bit 1 FILL, bit 2 IRQ_EN
+ *   0x1C STATUS       bit 0 BUSY; bit 1 DONE, set at the end of a
+ *                     descriptor, write 1 to clear
+ *   0x20 WORDS        words written since reset
+ *   0x24 BUSY_CYCLES  cycles with a descriptor running
+ *   0x28 WAIT_CYCLES  cycles a DMA request waited for a hart's transaction
+ *   0x2C TRANSFERS    descriptors completed
+ *
+ * The interrupt is DONE && IRQ_EN, a level that stays asserted until the
+ * handler clears DONE. A transfer must stay inside one device, because a
+ * burst is routed by its first address. Bus errors are not reported.
+ */
+object DMA {
+  val SRC         = 0x00
+  val DST         = 0x04
+  val COUNT       = 0x08
+  val SRC_STRIDE  = 0x0c
+  val DST_STRIDE  = 0x10
+  val FILL        = 0x14
+  val CTRL        = 0x18
+  val STATUS      = 0x1c
+  val WORDS       = 0x20
+  val BUSY_CYCLES = 0x24
+  val WAIT_CYCLES = 0x28
+  val TRANSFERS   = 0x2c
+
+  // CTRL and STATUS bit positions
+  val CtrlStart     = 0
+  val CtrlFill      = 1
+  val CtrlIrqEnable = 2
+  val StatusBusy    = 0
+  val StatusDone    = 1
+}
+
+object DMAStates extends ChiselEnum {
+  val Idle, ReadIssue, ReadWait, WriteIssue, WriteWait = Value
+}
+
+class DMA(burstWords: Int = 8) extends Module {
+  import DMA._
+  require(isPow2(burstWords) && burstWords >= 2 && burstWords <= 256, "burstWords: a power of two, 2 to 256")
+
+  val io = IO(new Bundle {
+    val channels = Flipped(new AXI4LiteChannels(8, Parameters.DataBits)) // registers
+    val master   = new AXI4LiteChannels(Parameters.AddrBits, Parameters.DataBits)
+
+    // Held for the whole transaction, for AXI4MasterMux and BusSwitch
+    val bus_address     = Output(UInt(Parameters.AddrWidth))
+    val bus_wait_cycles = Input(UInt(32.W)) // AXI4MasterMux wait_cycles of this master
+    val interrupt       = Output(Bool())
+    val busy            = Output(Bool()) // STATUS.BUSY: DONE and the interrupt are still to come
+  })
+
+  val slave = Module(new AXI4LiteSlave(8, Parameters.DataBits))
+  slave.io.channels <> io.channels
+  val bus = Module(new AXI4BurstMaster(Parameters.AddrBits, Parameters.DataBits))
+  io.master <> bus.io.channels
+
+  // Descriptor
+  val src        = RegInit(0.U(32.W))
+  val dst        = RegInit(0.U(32.W))
+  val count      = RegInit(0.U(32.W))
+  val src_stride = RegInit(4.U(32.W))
+  val dst_stride = RegInit(4.U(32.W))
+  val fill_data  = RegInit(0.U(32.W))
+  val fill_mode  = RegInit(false.B)
+  val irq_enable = RegInit(false.B)
+  val done       = RegInit(false.B)
+
+  // Status counters (wrapping)
+  val words       = RegInit(0.U(32.W))
+  val busy_cycles = RegInit(0.U(32.W))
+  val transfers   = RegInit(0.U(32.W))
+
+  val state = RegInit(DMAStates.Idle)
+  val busy  = state =/= DMAStates.Idle
+
+  val countWidth = log2Ceil(burstWords + 1)
+  val buffer     = Reg(Vec(burstWords, UInt(Parameters.DataWidth)))
+  val chunk      = RegInit(0.U(countWidth.W)) // words in the buffer round
+  val index      = RegInit(0.U(countWidth.W)) // of them read, or written
+  val beats      = RegInit(0.U(countWidth.W)) // words of the transaction in flight
+  val address    = RegInit(0.U(Parameters.AddrWidth))
+  io.bus_address := address
+
+  val slot      = (i: UInt) => i(log2Ceil(burstWords) - 1, 0)
+  val left      = chunk - index
+  val src_burst = src_stride === 4.U
+  val dst_burst = dst_stride === 4.U
+  // AXI4 ARLEN/AWLEN of an n-word transaction
+  val lengthOf = (n: UInt) => (n - 1.U)(math.min(countWidth, AXI4Lite.lenWidth) - 1, 0)
+  // One burst advances the address by 4 per beat, a single beat by the stride
+  val advance = (stride: UInt) => Mux(beats === 1.U, stride, beats << 2)
+
+  def startChunk(remaining: UInt, fill: Bool): Unit = {
+    chunk := Mux(remaining > burstWords.U, burstWords.U, remaining)
+    index := 0.U
+    state := Mux(fill, DMAStates.WriteIssue, DMAStates.ReadIssue)
+  }
+
+  // Register interface
+  val addr = slave.io.bundle.address
+  slave.io.bundle.read_valid := slave.io.bundle.read
+  slave.io.bundle.read_data := MuxLookup(addr, 0.U)(
+    Seq(
+      SRC         -> src,
+      DST         -> dst,
+      COUNT       -> count,
+      SRC_STRIDE  -> src_stride,
+      DST_STRIDE  -> dst_stride,
+      FILL        -> fill_data,
+      CTRL        -> Cat(irq_enable, fill_mode, 0.U(1.W)),
+      STATUS      -> Cat(done, busy),
+      WORDS       -> words,
+      BUSY_CYCLES -> busy_cycles,
+      WAIT_CYCLES -> io.bus_wait_cycles,
+      TRANSFERS   -> transfers
+    ).map { case (offset, value) => offset.U -> value }
+  )
+
+  val data  = slave.io.bundle.write_data
+  val write = (offset: Int) => slave.io.bundle.write && addr === offset.U
+
+  when(write(STATUS) && data(StatusDone)) {
+    done := false.B
+  }
+  when(write(CTRL)) {
+    irq_enable := data(CtrlIrqEnable)
+  }
+  when(!busy) {
+    when(write(SRC)) {
+      src := data
+    }
+    when(write(DST)) {
+      dst := data
+    }
+    when(write(COUNT)) {
+      count := data
+    }
+    when(write(SRC_STRIDE)) {
+      src_stride := data
+    }
+    when(write(DST_STRIDE)) {
+      dst_stride := data
+    }
+    when(write(FILL)) {
+      fill_data := data
+    }
+    when(write(CTRL)) {
+      fill_mode := data(CtrlFill)
+      when(data(CtrlStart)) {
+        done := false.B
+        when(count === 0.U) {
+          done      := true.B
+          transfers := transfers + 1.U
+        }.otherwise {
+          startChunk(count, data(CtrlFill))
+        }
+      }
+    }
+  }
+
+  // Transfer engine
+  bus.io.bundle.address      := address
+  bus.io.bundle.length       := 0.U
+  bus.io.bundle.read         := false.B
+  bus.io.bundle.write        := false.B
+  bus.io.bundle.write_data   := Mux(fill_mode, fill_data, buffer(slot(index + bus.io.bundle.beat)))
+  bus.io.bundle.write_strobe := VecInit(Seq.fill(Parameters.WordSize)(true.B))
+
+  when(busy) {
+    busy_cycles := busy_cycles + 1.U
+  }
+
+  switch(state) {
+    is(DMAStates.ReadIssue) {
+      val n = Mux(src_burst, left, 1.U)
+      bus.io.bundle.address := src
+      bus.io.bundle.length  := lengthOf(n)
+      bus.io.bundle.read    := true.B
+      address               := src
+      beats                 := n
+      state                 := DMAStates.ReadWait
+    }
+    is(DMAStates.ReadWait) {
+      when(bus.io.bundle.read_valid) {
+        buffer(slot(index + bus.io.bundle.beat)) := bus.io.bundle.read_data
+      }
+      when(bus.io.bundle.done) {
+        src := src + advance(src_stride)
+        when(index + beats === chunk) {
+          index := 0.U
+          state := DMAStates.WriteIssue
+        }.otherwise {
+          index := index + beats
+          state := DMAStates.ReadIssue
+        }
+      }
+    }
+    is(DMAStates.WriteIssue) {
+      val n = Mux(dst_burst, left, 1.U)
+      bus.io.bundle.address := dst
+      bus.io.bundle.length  := lengthOf(n)
+      bus.io.bundle.write   := true.B
+      address               := dst
+      beats                 := n
+      state                 := DMAStates.WriteWait
+    }
+    is(DMAStates.WriteWait) {
+      when(bus.io.bundle.done) {
+        dst   := dst + advance(dst_stride)
+        count := count - beats
+        words := words + beats
+        when(index + beats =/= chunk) {
+          index := index + beats
+          state := DMAStates.WriteIssue
+        }.elsewhen(count === beats) {
+          done      := true.B
+          transfers := transfers + 1.U
+          state     := DMAStates.Idle
+        }.otherwise {
+          startChunk(count - beats, fill_mode)
+        }
+      }
+    }
+  }
+
+  io.interrupt := done && irq_enable
+  io.busy      := busy
+}
@@ -17,13 +17,16 @@ class DummyMaster extends Module {
   io.channels.read_address_channel.ARVALID := false.B
   io.channels.read_address_channel.ARADDR  := 0.U
   io.channels.read_address_channel.ARPROT  := 0.U
+  io.channels.read_address_channel.ARLEN   := 0.U
   io.channels.read_data_channel.RREADY     := false.B
 
   io.channels.write_address_channel.AWVALID := false.B
   io.channels.write_address_channel.AWADDR  := 0.U
   io.channels.write_address_channel.AWPROT  := 0.U
+  io.channels.write_address_channel.AWLEN   := 0.U
   io.channels.write_data_channel.WVALID     := false.B
   io.channels.write_data_channel.WDATA      := 0.U
   io.channels.write_data_channel.WSTRB      := 0.U
+  io.channels.write_data_channel.WLAST      := false.B
   io.channels.write_response_channel.BREADY := false.B
 }
@@ -18,9 +18,12 @@ import riscv.Parameters
  *
  * AXI4-Lite response codes:
  *   OKAY   = 0 - Normal access success
- *   EXOKAY = 1 - Exclusive access success (not used in AXI4-Lite)
+ *   EXOKAY = 1 - Exclusive access success (AXI4MasterMux exclusive monitor, SC.W)
  *   SLVERR = 2 - Slave error (device exists but access failed)
  *   DECERR = 3 - Decode error (no device at this address)
+ *
+ * Bursts get one DECERR beat per requested beat, so a burst master always
+ * sees its RLAST / sends its WLAST and never waits forever.
  */
 class DummySlave extends Module {
   val io = IO(new Bundle {
@@ -33,21 +36,29 @@ class DummySlave extends Module {
   val read_pending  = RegInit(false.B)
   val write_pending = RegInit(false.B)
   val write_data_ok = RegInit(false.B)
+  val read_beats    = RegInit(0.U(AXI4Lite.lenWidth.W)) // beats left after the current one
+  val write_beats   = RegInit(0.U(AXI4Lite.lenWidth.W))
 
   // Read address channel - accept immediately
   io.channels.read_address_channel.ARREADY := !read_pending
 
   when(io.channels.read_address_channel.ARVALID && io.channels.read_address_channel.ARREADY) {
     read_pending := true.B
+    read_beats   := io.channels.read_address_channel.ARLEN
   }
 
   // Read data channel - respond with DECERR
   io.channels.read_data_channel.RVALID := read_pending
   io.channels.read_data_channel.RDATA  := "hDEADBEEF".U // Distinctive pattern for debugging
   io.channels.read_data_channel.RRESP  := DECERR
+  io.channels.read_data_channel.RLAST  := read_beats === 0.U
 
   when(read_pending && io.channels.read_data_channel.RREADY) {
-    read_pending := false.B
+    when(read_beats === 0.U) {
+      read_pending := false.B
+    }.otherwise {
+      read_beats := read_beats - 1.U
+    }
   }
 
   // Write address channel - accept immediately
@@ -55,13 +66,18 @@ class DummySlave extends Module {
 
   when(io.channels.write_address_channel.AWVALID && io.channels.write_address_channel.AWREADY) {
     write_pending := true.B
+    write_beats   := io.channels.write_address_channel.AWLEN
   }
 
   // Write data channel - accept immediately when write pending
   io.channels.write_data_channel.WREADY := write_pending && !write_data_ok
 
   when(write_pending && io.channels.write_data_channel.WVALID && io.channels.write_data_channel.WREADY) {
-    write_data_ok := true.B
+    when(write_beats === 0.U) {
+      write_data_ok := true.B
+    }.otherwise {
+      write_beats := write_beats - 1.U
+    }
   }
 
   // Write response channel - respond with DECERR
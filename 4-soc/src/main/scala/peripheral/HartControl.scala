@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package peripheral
+
+import bus.AXI4LiteChannels
+import bus.AXI4LiteSlave
+import chisel3._
+import chisel3.util._
+import riscv.Parameters
+
+/**
+ * Per-hart interrupt sources and bus contention counters of a multi-hart Top
+ *
+ * The first three blocks follow the SiFive CLINT layout, so offsets are the
+ * ones software for other RISC-V boards expects:
+ *
+ *   0x0000 + 4h  MSIP[h]      bit 0 raises hart h's software interrupt
+ *                             (interrupt_flag bit 2, mcause 3, mie.MSIE)
+ *   0x4000 + 8h  MTIMECMP[h]  64-bit compare, low word first; hart h's timer
+ *                             interrupt (interrupt_flag bit 0, mcause 7,
+ *                             mie.MTIE) is pending while MTIME >= MTIMECMP[h].
+ *                             Resets to all ones (never)
+ *   0xBFF8       MTIME        64-bit, +1 every clock, writable
+ *
+ * Contention counters of the hart AXI4MasterMux, read-only and wrapping:
+ *
+ *   0xC000       BUS_BUSY     cycles the shared bus was owned or granted
+ *   0xC004       NHARTS       number of harts
+ *   0xC008       ARBITRATION  0 static priority, 1 round-robin
+ *   0xC100 + 4h  BUS_WAIT[h]  cycles hart h requested while another owned it
+ *   0xC200 + 4h  BUS_GRANT[h] transactions granted to hart h
+ *
+ * The 64-bit registers are written one half at a time; software sets the
+ * high MTIMECMP word to all ones first so no half-written value fires.
+ */
+object HartControl {
+  val MSIP        = 0x0000
+  val MTIMECMP    = 0x4000
+  val MTIME       = 0xbff8
+  val BUS_BUSY    = 0xc000
+  val NHARTS      = 0xc004
+  val ARBITRATION = 0xc008
+  val BUS_WAIT    = 0xc100
+  val BUS_GRANT   = 0xc200
+
+  // BUS_WAIT/BUS_GRANT leave room for 64 harts
+  val MaxHarts = 64
+}
+
+class HartControl(harts: Int, roundRobin: Boolean = false) extends Module {
+  import HartControl._
+  require(harts >= 1 && harts <= MaxHarts, s"HartControl supports 1 to $MaxHarts harts")
+
+  val io = IO(new Bundle {
+    val channels = Flipped(new AXI4LiteChannels(16, Parameters.DataBits))
+
+    val msip = Output(Vec(harts, Bool())) // software interrupt per hart
+    val mtip = Output(Vec(harts, Bool())) // timer interrupt per hart
+    // Some MTIMECMP is set (due or not) or some MSIP raised: an interrupt
+    // can still arrive without any bus access (sim.cpp --idle-stop)
+    val wake_pending = Output(Bool())
+
+    val bus_busy_cycles = Input(UInt(32.W))
+    val bus_wait_cycles = Input(Vec(harts, UInt(32.W)))
+    val bus_grants      = Input(Vec(harts, UInt(32.W)))
+  })
+
+  val slave = Module(new AXI4LiteSlave(16, Parameters.DataBits))
+  slave.io.channels <> io.channels
+
+  val msip     = RegInit(VecInit(Seq.fill(harts)(false.B)))
+  val mtimecmp = RegInit(VecInit(Seq.fill(harts)("hffffffffffffffff".U(64.W))))
+  val mtime    = RegInit(0.U(64.W))
+
+  io.msip := msip
+  for (h <- 0 until harts) {
+    io.mtip(h) := mtime >= mtimecmp(h)
+  }
+  io.wake_pending := msip.asUInt.orR || mtimecmp.map(_ =/= "hffffffffffffffff".U).reduce(_ || _)
+
+  def low(value: UInt)  = value(31, 0)
+  def high(value: UInt) = value(63, 32)
+
+  val registers = Seq(
+    MTIME       -> low(mtime),
+    MTIME + 4   -> high(mtime),
+    BUS_BUSY    -> io.bus_busy_cycles,
+    NHARTS      -> harts.U,
+    ARBITRATION -> roundRobin.B.asUInt
+  ) ++ (0 until harts).flatMap(h =>
+    Seq(
+      MSIP + 4 * h         -> msip(h).asUInt,
+      MTIMECMP + 8 * h     -> low(mtimecmp(h)),
+      MTIMECMP + 8 * h + 4 -> high(mtimecmp(h)),
+      BUS_WAIT + 4 * h     -> io.bus_wait_cycles(h),
+      BUS_GRANT + 4 * h    -> io.bus_grants(h)
+    )
+  )
+
+  val addr = slave.io.bundle.address
+  slave.io.bundle.read_valid := slave.io.bundle.read
+  slave.io.bundle.read_data := MuxLookup(addr, 0.U)(
+    registers.map { case (offset, value) => offset.U -> value }
+  )
+
+  val data  = slave.io.bundle.write_data
+  val write = (offset: Int) => slave.io.bundle.write && addr === offset.U
+
+  mtime := mtime + 1.U
+  when(write(MTIME)) {
+    mtime := high(mtime) ## data
+  }.elsewhen(write(MTIME + 4)) {
+    mtime := data ## low(mtime)
+  }
+  for (h <- 0 until harts) {
+    when(write(MSIP + 4 * h)) {
+      msip(h) := data(0)
+    }
+    when(write(MTIMECMP + 8 * h)) {
+      mtimecmp(h) := high(mtimecmp(h)) ## data
+    }
+    when(write(MTIMECMP + 8 * h + 4)) {
+      mtimecmp(h) := data ## low(mtimecmp(h))
+    }
+  }
+}
@@ -6,6 +6,7 @@ package peripheral
 
 import chisel3._
 import chisel3.util._
+import chisel3.util.experimental.loadMemoryFromFileInline
 import riscv.Parameters
 
 class RAMBundle extends Bundle {
@@ -56,7 +57,12 @@ class BlockRAM(capacity: Int) extends Module {
 // Note: In 2-mmio-trap design, memory-mapped I/O addresses (UART, Timer)
 // are routed through CPU.scala before reaching this module. Only valid
 // memory addresses reach this module, so no bounds checking needed here.
-class Memory(capacity: Int) extends Module {
+//
+// preload (simulation only): start with a program image in place. $readmemh
+// initialisation needs memories of a ground type, so a preloaded Memory keeps
+// each byte lane in its own SyncReadMem; without it the generated RAM is
+// unchanged.
+class Memory(capacity: Int, preload: Option[MemoryImage] = None) extends Module {
   val io = IO(new Bundle {
     val bundle = new RAMBundle
 
@@ -67,17 +73,40 @@ class Memory(capacity: Int) extends Module {
     val debug_read_data    = Output(UInt(Parameters.DataWidth))
   })
 
-  val mem = SyncReadMem(capacity, Vec(Parameters.WordSize, UInt(Parameters.ByteWidth)))
-
-  when(io.bundle.write_enable) {
-    val write_data_vec = Wire(Vec(Parameters.WordSize, UInt(Parameters.ByteWidth)))
-    for (i <- 0 until Parameters.WordSize) {
-      write_data_vec(i) := io.bundle.write_data((i + 1) * Parameters.ByteBits - 1, i * Parameters.ByteBits)
-    }
-    mem.write((io.bundle.address >> 2.U).asUInt, write_data_vec, io.bundle.write_strobe)
+  val write_data_vec = Wire(Vec(Parameters.WordSize, UInt(Parameters.ByteWidth)))
+  for (i <- 0 until Parameters.WordSize) {
+    write_data_vec(i) := io.bundle.write_data((i + 1) * Parameters.ByteBits - 1, i * Parameters.ByteBits)
   }
 
-  io.bundle.read_data := mem.read((io.bundle.address >> 2.U).asUInt, true.B).asUInt
-  io.debug_read_data  := mem.read((io.debug_read_address >> 2.U).asUInt, true.B).asUInt
-  io.instruction      := mem.read((io.instruction_address >> 2.U).asUInt, true.B).asUInt
+  preload match {
+    case None =>
+      val mem = SyncReadMem(capacity, Vec(Parameters.WordSize, UInt(Parameters.ByteWidth)))
+
+      when(io.bundle.write_enable) {
+        mem.write((io.bundle.address >> 2.U).asUInt, write_data_vec, io.bundle.write_strobe)
+      }
+
+      io.bundle.read_data := mem.read((io.bundle.address >> 2.U).asUInt, true.B).asUInt
+      io.debug_read_data  := mem.read((io.debug_read_address >> 2.U).asUInt, true.B).asUInt
+      io.instruction      := mem.read((io.instruction_address >> 2.U).asUInt, true.B).asUInt
+
+    case Some(image) =>
+      require(image.laneFiles.length == Parameters.WordSize)
+      val lanes = image.laneFiles.map { file =>
+        val lane = SyncReadMem(capacity, UInt(Parameters.ByteWidth))
+        loadMemoryFromFileInline(lane, file)
+        lane
+      }
+      def read(address: UInt) = Cat(lanes.reverse.map(_.read((address >> 2.U).asUInt, true.B)))
+
+      for (i <- lanes.indices) {
+        when(io.bundle.write_enable && io.bundle.write_strobe(i)) {
+          lanes(i).write((io.bundle.address >> 2.U).asUInt, write_data_vec(i))
+        }
+      }
+
+      io.bundle.read_data := read(io.bundle.address)
+      io.debug_read_data  := read(io.debug_read_address)
+      io.instruction      := read(io.instruction_address)
+  }
 }
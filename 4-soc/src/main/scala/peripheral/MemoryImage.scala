@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package peripheral
+
+import java.io.FileWriter
+import java.nio.file.Files
+import java.nio.file.Paths
+
+import riscv.Parameters
+
+// Simulation-only back-door program image for Memory(capacity, Some(image))
+//
+// The program is written as one $readmemh file per byte lane, addressed by
+// the word index of loadAddress, so the RAM already holds the program when
+// simulation starts and no ROMLoader copy loop is needed. The image gets the
+// same three trailing NOPs as InstructionROM.
+case class MemoryImage(laneFiles: Seq[String], words: Int)
+
+object MemoryImage {
+  def apply(instructionFilename: String, loadAddress: Int = Parameters.EntryAddress.litValue.toInt): MemoryImage = {
+    val bytes = if (Files.exists(Paths.get(instructionFilename))) {
+      Files.readAllBytes(Paths.get(instructionFilename))
+    } else {
+      getClass.getClassLoader.getResourceAsStream(instructionFilename).readAllBytes()
+    }
+    val nop   = Array[Byte](0x13, 0, 0, 0)
+    val image = bytes.take(bytes.length / 4 * 4) ++ Array.fill(3)(nop).flatten
+    val words = image.length / 4
+
+    val baseName  = Paths.get(instructionFilename).getFileName.toString
+    val outputDir = Paths.get(System.getProperty("user.dir"), "verilog")
+    Files.createDirectories(outputDir)
+    val laneFiles = (0 until Parameters.WordSize).map { lane =>
+      val path   = outputDir.resolve(f"$baseName.lane$lane.txt")
+      val writer = new FileWriter(path.toString)
+      writer.write(f"@${loadAddress / 4}%x\n")
+      for (i <- 0 until words) {
+        writer.write(f"${image(i * 4 + lane) & 0xff}%02x\n")
+      }
+      writer.close()
+      path.toString.replaceAll("\\\\", "/")
+    }
+    MemoryImage(laneFiles, words)
+  }
+}
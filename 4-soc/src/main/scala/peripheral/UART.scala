@@ -24,11 +24,21 @@ object UartConstants {
   val COUNTER_WIDTH  = 16                                 // Supports clock/baud up to 65535 (100MHz @ 1526 baud minimum)
 
   // Register offsets from UART base address
-  val REG_STATUS    = 0x00 // TX ready (bit 0), RX valid (bit 1) - read-only
-  val REG_BAUD_RATE = 0x04 // Configured baud rate - read-only
-  val REG_INTERRUPT = 0x08 // Interrupt enable - write-only
-  val REG_RX_DATA   = 0x0c // Received data - read clears interrupt
-  val REG_TX_DATA   = 0x10 // Transmit data - write-only
+  val REG_STATUS       = 0x00 // TX ready (bit 0), RX valid (bit 1), TX idle (bit 2) - read-only
+  val REG_BAUD_RATE    = 0x04 // Configured baud rate - read-only
+  val REG_INTERRUPT    = 0x08 // Interrupt enable - write-only
+  val REG_RX_DATA      = 0x0c // Received data - read clears interrupt
+  val REG_TX_DATA      = 0x10 // Transmit data - write-only
+  val REG_FIFO_DEPTH   = 0x14 // TX FIFO depth [15:0], RX FIFO depth [31:16] - read-only
+  val REG_TX_LEVEL     = 0x18 // Bytes waiting in the TX FIFO - read-only
+  val REG_RX_LEVEL     = 0x1c // Bytes waiting in the RX FIFO - read-only
+  val REG_TX_THRESHOLD = 0x20 // TX interrupt while TX level <= threshold - read/write
+  val REG_RX_THRESHOLD = 0x24 // RX interrupt while RX level >= threshold - read/write
+  val REG_IRQ_ENABLE   = 0x28 // RX threshold (bit 0), TX threshold (bit 1) enable - read/write
+  val REG_IRQ_PENDING  = 0x2c // RX threshold (bit 0), TX threshold (bit 1), RX flag (bit 2) - read-only
+
+  val IRQ_RX = 0x1
+  val IRQ_TX = 0x2
 }
 
 class UartIO extends DecoupledIO(UInt(8.W))
@@ -176,27 +186,50 @@ class BufferedTx(frequency: Int, baudRate: Int) extends Module {
  * UART peripheral with AXI4-Lite interface
  *
  * Memory map (offset from base address):
- *   0x00: STATUS    - TX ready (bit 0), RX FIFO non-empty (bit 1) (read-only)
- *   0x04: BAUD_RATE - Configured baud rate (read-only)
- *   0x08: INTERRUPT - Interrupt enable/status (write: enable, read: N/A)
- *   0x0C: RX_DATA   - Received data from FIFO (read dequeues one byte)
- *   0x10: TX_DATA   - Transmit data (write-only)
+ *   0x00: STATUS       - TX FIFO not full (bit 0), RX FIFO non-empty (bit 1),
+ *                        TX FIFO empty and transmitter idle (bit 2) (read-only)
+ *   0x04: BAUD_RATE    - Configured baud rate (read-only)
+ *   0x08: INTERRUPT    - RX flag (write: non-zero sets, zero clears)
+ *   0x0C: RX_DATA      - Received data from FIFO (read dequeues one byte)
+ *   0x10: TX_DATA      - Transmit data into the TX FIFO (write-only)
+ *   0x14: FIFO_DEPTH   - txDepth [15:0], rxDepth [31:16] (read-only)
+ *   0x18: TX_LEVEL     - Bytes in the TX FIFO, not counting the one being
+ *                        shifted out (read-only)
+ *   0x1C: RX_LEVEL     - Bytes in the RX FIFO (read-only)
+ *   0x20: TX_THRESHOLD - TX condition while TX_LEVEL <= value (reset 0)
+ *   0x24: RX_THRESHOLD - RX condition while RX_LEVEL >= value (reset 1)
+ *   0x28: IRQ_ENABLE   - RX threshold (bit 0), TX threshold (bit 1) (reset 0)
+ *   0x2C: IRQ_PENDING  - RX threshold (bit 0), TX threshold (bit 1) met, and
+ *                        the RX flag (bit 2) (read-only)
  *
  * Features:
- *   - 4-entry RX FIFO: Buffers incoming bytes to prevent character loss
- *     when CPU is busy. STATUS.rx_valid reflects FIFO non-empty status.
- *   - Backpressure: RX module won't start receiving new byte if FIFO is full.
+ *   - RX FIFO (rxDepth entries): buffers incoming bytes so the CPU can read
+ *     them in a burst. Backpressure: Rx won't start a new byte while it is full.
+ *   - TX FIFO (txDepth entries) in front of the transmitter: software writes a
+ *     burst while STATUS.tx_ready is set instead of polling per character
+ *   - Threshold interrupts: level-sensitive, enabled in IRQ_ENABLE, cleared by
+ *     moving the level (reading RX_DATA, the TX FIFO draining below or being
+ *     refilled above the threshold) or raising/lowering the threshold.
+ *     signal_interrupt reaches the core as the external interrupt (mcause 11),
+ *     so a program can fill the TX FIFO, set TX_THRESHOLD and wfi until it
+ *     drains.
+ *   - RX flag: the original single-bit interrupt, set on each received byte
+ *     and cleared when RX_DATA empties the FIFO. Set as long as IRQ_ENABLE is
+ *     0; enabling a threshold interrupt clears it and stops setting it, so
+ *     threshold users are not woken by every byte.
  *
  * Limitations:
- *   - Single-byte TX buffer: If TX buffer is full when CPU writes to TX_DATA,
- *     the write is silently dropped. Software should poll STATUS.tx_ready
- *     before writing. For production use, consider adding a TX FIFO.
+ *   - A write to TX_DATA while the TX FIFO is full is silently dropped.
+ *     Software should check STATUS.tx_ready (or TX_LEVEL) before writing.
  *
  * @param frequency System clock frequency in Hz
  * @param baudRate  Serial baud rate (e.g., 115200)
+ * @param txDepth   TX FIFO entries
+ * @param rxDepth   RX FIFO entries
  */
-class Uart(frequency: Int, baudRate: Int) extends Module {
+class Uart(frequency: Int, baudRate: Int, txDepth: Int = 16, rxDepth: Int = 16) extends Module {
   import UartConstants._
+  require(txDepth >= 1 && rxDepth >= 1, "UART FIFOs need at least one entry")
 
   val io = IO(new Bundle {
     val channels         = Flipped(new AXI4LiteChannels(8, Parameters.DataBits))
@@ -209,21 +242,34 @@ class Uart(frequency: Int, baudRate: Int) extends Module {
   val slave     = Module(new AXI4LiteSlave(8, Parameters.DataBits))
   slave.io.channels <> io.channels
 
-  val tx = Module(new BufferedTx(frequency, baudRate))
+  val tx = Module(new Tx(frequency, baudRate))
   val rx = Module(new Rx(frequency, baudRate))
 
-  // RX FIFO: 4-entry buffer to absorb bursts and prevent character loss
+  // FIFOs on both sides: absorb bursts and prevent character loss
   // pipe=true allows same-cycle enqueue/dequeue, flow=false requires explicit ready
-  val rxFifo = Module(new Queue(UInt(8.W), entries = 4, pipe = true, flow = false))
+  val txFifo = Module(new Queue(UInt(8.W), entries = txDepth, pipe = true, flow = false))
+  val rxFifo = Module(new Queue(UInt(8.W), entries = rxDepth, pipe = true, flow = false))
+
+  // Threshold interrupt configuration
+  val txThreshold = RegInit(0.U(log2Ceil(txDepth + 1).W))
+  val rxThreshold = RegInit(1.U(log2Ceil(rxDepth + 1).W))
+  val irqEnable   = RegInit(0.U(2.W))
+
+  val txPending = txFifo.io.count <= txThreshold
+  val rxPending = rxFifo.io.count >= rxThreshold
+  val txIdle    = !txFifo.io.deq.valid && tx.io.channel.ready
 
   // MMIO address decode (mask to get offset within peripheral)
-  // UART registers at 0x00-0x1F, base address 0x40000000
-  val addr           = slave.io.bundle.address & 0xff.U
-  val addr_status    = addr === REG_STATUS.U
-  val addr_baud_rate = addr === REG_BAUD_RATE.U
-  val addr_interrupt = addr === REG_INTERRUPT.U
-  val addr_rx_data   = addr === REG_RX_DATA.U
-  val addr_tx_data   = addr === REG_TX_DATA.U
+  // UART registers at 0x00-0x2F, base address 0x40000000
+  val addr              = slave.io.bundle.address & 0xff.U
+  val addr_status       = addr === REG_STATUS.U
+  val addr_baud_rate    = addr === REG_BAUD_RATE.U
+  val addr_interrupt    = addr === REG_INTERRUPT.U
+  val addr_rx_data      = addr === REG_RX_DATA.U
+  val addr_tx_data      = addr === REG_TX_DATA.U
+  val addr_tx_threshold = addr === REG_TX_THRESHOLD.U
+  val addr_rx_threshold = addr === REG_RX_THRESHOLD.U
+  val addr_irq_enable   = addr === REG_IRQ_ENABLE.U
 
   // AXI4-Lite Read handling
   // Only assert read_valid when there's an active read request
@@ -232,12 +278,27 @@ class Uart(frequency: Int, baudRate: Int) extends Module {
   slave.io.bundle.read_data  := read_data_prepared
 
   when(addr_status) {
-    // Status register: bit 0 = TX ready, bit 1 = RX data valid (FIFO non-empty)
-    read_data_prepared := Cat(0.U(30.W), rxFifo.io.deq.valid, tx.io.channel.ready)
+    // Status register: bit 0 = TX FIFO has space, bit 1 = RX data valid
+    // (FIFO non-empty), bit 2 = everything written has been sent
+    read_data_prepared := Cat(0.U(29.W), txIdle, rxFifo.io.deq.valid, txFifo.io.enq.ready)
   }.elsewhen(addr_baud_rate) {
     read_data_prepared := baudRate.U
   }.elsewhen(addr_rx_data) {
     read_data_prepared := rxFifo.io.deq.bits
+  }.elsewhen(addr === REG_FIFO_DEPTH.U) {
+    read_data_prepared := Cat(rxDepth.U(16.W), txDepth.U(16.W))
+  }.elsewhen(addr === REG_TX_LEVEL.U) {
+    read_data_prepared := txFifo.io.count
+  }.elsewhen(addr === REG_RX_LEVEL.U) {
+    read_data_prepared := rxFifo.io.count
+  }.elsewhen(addr_tx_threshold) {
+    read_data_prepared := txThreshold
+  }.elsewhen(addr_rx_threshold) {
+    read_data_prepared := rxThreshold
+  }.elsewhen(addr_irq_enable) {
+    read_data_prepared := irqEnable
+  }.elsewhen(addr === REG_IRQ_PENDING.U) {
+    read_data_prepared := Cat(interrupt, txPending, rxPending)
   }
 
   // RX FIFO connections: RX module -> FIFO -> CPU read
@@ -245,13 +306,18 @@ class Uart(frequency: Int, baudRate: Int) extends Module {
   // Dequeue from FIFO when CPU reads UART_RECV
   rxFifo.io.deq.ready := slave.io.bundle.read && addr_rx_data
 
+  // TX FIFO connections: CPU write -> FIFO -> Tx shift register
+  tx.io.channel <> txFifo.io.deq
+
   // Interrupt handling:
-  // - Set when FIFO receives data
+  // - Set when FIFO receives data (only while no threshold interrupt is enabled)
   // - Clear when reading RX_DATA makes FIFO empty, OR software writes 0 to INTERRUPT
   // - Software can manually set/clear via INTERRUPT register
   when(slave.io.bundle.write && addr_interrupt) {
     // Manual interrupt control takes priority
     interrupt := slave.io.bundle.write_data =/= 0.U
+  }.elsewhen(irqEnable =/= 0.U) {
+    interrupt := false.B
   }.elsewhen(rxFifo.io.enq.fire) {
     // Set interrupt when new data arrives in FIFO
     interrupt := true.B
@@ -263,22 +329,33 @@ class Uart(frequency: Int, baudRate: Int) extends Module {
     }
   }
 
-  // TX channel: only write when buffer is ready (backpressure handling)
-  tx.io.channel.valid := false.B
-  tx.io.channel.bits  := 0.U
+  // Threshold and enable registers; thresholds saturate at the FIFO depth
+  when(slave.io.bundle.write) {
+    when(addr_tx_threshold) {
+      txThreshold := Mux(slave.io.bundle.write_data >= txDepth.U, txDepth.U, slave.io.bundle.write_data)
+    }
+    when(addr_rx_threshold) {
+      rxThreshold := Mux(slave.io.bundle.write_data >= rxDepth.U, rxDepth.U, slave.io.bundle.write_data)
+    }
+    when(addr_irq_enable) {
+      irqEnable := slave.io.bundle.write_data(1, 0)
+    }
+  }
+
+  // TX FIFO: only enqueue when there is space (backpressure handling)
+  txFifo.io.enq.valid := false.B
+  txFifo.io.enq.bits  := 0.U
   when(slave.io.bundle.write) {
-    when(addr_tx_data && tx.io.channel.ready) {
-      // Only write to TX when buffer has space (prevents silent data loss)
-      tx.io.channel.valid := true.B
+    when(addr_tx_data && txFifo.io.enq.ready) {
+      txFifo.io.enq.valid := true.B
       // Explicit 8-bit slice: UART TX is 8 bits, write_data is 32 bits
       // Standard UART practice: use lower byte, ignore upper bits
-      tx.io.channel.bits := slave.io.bundle.write_data(7, 0)
+      txFifo.io.enq.bits := slave.io.bundle.write_data(7, 0)
     }
-    // Note: If TX buffer full (ready=false), AXI write completes but data is dropped.
-    // Production implementation should stall AXI response until buffer ready.
+    // Note: If the TX FIFO is full (ready=false), AXI write completes but data is dropped.
   }
 
   io.txd              := tx.io.txd
   rx.io.rxd           := io.rxd
-  io.signal_interrupt := interrupt
+  io.signal_interrupt := interrupt || (irqEnable(0) && rxPending) || (irqEnable(1) && txPending)
 }
@@ -15,16 +15,33 @@ import riscv.Parameters
  *
  * Memory map (Base: 0x20000000):
  *   0x00: ID          - Peripheral identification (RO: 0x56474131 = 'VGA1')
- *   0x04: STATUS      - [31:16] timing_error_count, [7:4] frame, [2] busy, [1] safe, [0] vblank
+ *   0x04: STATUS      - [31:16] timing_error_count, [7:4] frame, [3] flip pending, [2] busy, [1] safe,
+ *                       [0] vblank
  *   0x08: INTR_STATUS - Vblank interrupt flag (W1C)
  *   0x10: UPLOAD_ADDR - Framebuffer upload address (nibble index + frame)
  *   0x14: STREAM_DATA - 8 pixels packed in 32-bit word (auto-increment)
- *   0x20: CTRL        - Display enable, blank, swap request, frame select, interrupt enable
+ *   0x18: FILL_DATA   - Word the fill engine writes (8 packed pixels)
+ *   0x1C: FILL_COUNT  - Write N: fill N words from UPLOAD_ADDR; read: words left
+ *   0x20: CTRL        - Display enable, blank, swap at vblank, frame select, interrupt enable
  *   0x24-0x60: PALETTE[0-15] - 16 entries, 6-bit VGA colors (RRGGBB)
  *
  * VGA timing: 640×480 @ 72Hz
  *   H_TOTAL=832, V_TOTAL=520, pixel clock=31.5 MHz
  *
+ * Page flip:
+ *   With CTRL.swap (bit 2) set, a new frame select is latched by the pixel
+ *   domain at the start of vblank, so the scan-out never switches frames
+ *   mid-screen. STATUS.flip_pending stays set until the requested frame is on
+ *   display; software can then render into the previous front frame while
+ *   the new one scans out. With swap clear the switch is immediate, as before.
+ *
+ * Fill engine:
+ *   Writing N to FILL_COUNT stores FILL_DATA into N consecutive framebuffer
+ *   words starting at the UPLOAD_ADDR position, one word per cycle, and keeps
+ *   STATUS.busy set until done. STREAM_DATA writes take priority and stall the
+ *   engine for that cycle; UPLOAD_ADDR itself is not advanced. A fill stops at
+ *   the end of the framebuffer, so one command can clear several frames.
+ *
  * Lost-sync detection:
  *   The timing_error_count field in STATUS tracks timing anomalies in the pixel
  *   clock domain. Errors indicate counter overflow (h_count >= H_TOTAL or
@@ -87,6 +104,8 @@ class VGA extends Module {
     val INTR_STATUS  = 0x08 // Interrupt status (W1C)
     val UPLOAD_ADDR  = 0x10 // Framebuffer upload address
     val STREAM_DATA  = 0x14 // Pixel data streaming port
+    val FILL_DATA    = 0x18 // Fill engine pattern word
+    val FILL_COUNT   = 0x1c // Fill engine word count (write starts a fill)
     val CTRL         = 0x20 // Control register
     val PALETTE_BASE = 0x24 // Palette entries start here
     val PALETTE_END  = 0x64 // Palette entries end here (16 entries: 0x24-0x60)
@@ -110,11 +129,12 @@ class VGA extends Module {
   val intrStatusReg = RegInit(0.U(32.W))
   val uploadAddrReg = RegInit(0.U(32.W))
   val paletteReg    = RegInit(VecInit(Seq.fill(16)(0.U(6.W))))
+  val fillDataReg   = RegInit(0.U(32.W))
 
   // Control register bit fields
   val ctrl_en        = ctrlReg(0)
   val ctrl_blank     = ctrlReg(1)
-  val ctrl_swap_req  = ctrlReg(2)
+  val ctrl_swap_req  = ctrlReg(2) // Latch frame select at vblank
   val ctrl_frame_sel = ctrlReg(7, 4)
   val ctrl_vblank_ie = ctrlReg(8)
 
@@ -128,6 +148,12 @@ class VGA extends Module {
     val upload_pix_addr  = uploadAddrReg(15, 0)
     val upload_frame_raw = uploadAddrReg(19, 16)
     val upload_frame     = Mux(upload_frame_raw >= NUM_FRAMES.U, (NUM_FRAMES - 1).U, upload_frame_raw)
+    val upload_fb_addr   = upload_frame * WORDS_PER_FRAME.U + (upload_pix_addr >> 3)
+
+    // Fill engine state: next word and words remaining
+    val fill_addr   = RegInit(0.U(ADDR_WIDTH.W))
+    val fill_left   = RegInit(0.U(ADDR_WIDTH.W))
+    val fill_active = fill_left =/= 0.U
 
     // CDC: Synchronize status signals from pixel domain
     val vblank_sync1      = RegNext(wire_in_vblank)
@@ -150,8 +176,9 @@ class VGA extends Module {
     // Status signals
     val status_in_vblank    = vblank_synced
     val status_safe_to_swap = vblank_synced
-    val status_upload_busy  = false.B
+    val status_upload_busy  = fill_active
     val status_curr_frame   = curr_frame_synced
+    val status_flip_pending = ctrl_swap_req && (ctrl_frame_sel =/= curr_frame_synced)
 
     // Vblank interrupt: Edge detection
     val vblank_prev        = RegNext(vblank_synced)
@@ -170,6 +197,8 @@ class VGA extends Module {
     val addr_intr_status = addr === Reg.INTR_STATUS.U
     val addr_upload_addr = addr === Reg.UPLOAD_ADDR.U
     val addr_stream_data = addr === Reg.STREAM_DATA.U
+    val addr_fill_data   = addr === Reg.FILL_DATA.U
+    val addr_fill_count  = addr === Reg.FILL_COUNT.U
     val addr_ctrl        = addr === Reg.CTRL.U
     val addr_palette     = (addr >= Reg.PALETTE_BASE.U) && (addr < Reg.PALETTE_END.U)
     val palette_idx      = (addr - Reg.PALETTE_BASE.U) >> 2
@@ -199,7 +228,7 @@ class VGA extends Module {
       //   [31:16] timing_error_count - Lost-sync error counter (sys domain, CDC-safe)
       //   [15:8]  reserved
       //   [7:4]   curr_frame         - Current display frame index
-      //   [3]     reserved
+      //   [3]     flip_pending       - Swap requested, new frame not yet on display
       //   [2]     upload_busy        - Framebuffer upload in progress
       //   [1]     safe_to_swap       - Safe to swap frames (same as vblank)
       //   [0]     in_vblank          - Currently in vertical blanking period
@@ -207,7 +236,7 @@ class VGA extends Module {
         timing_error_count,
         0.U(8.W),
         status_curr_frame,
-        0.U(1.W),
+        status_flip_pending,
         status_upload_busy,
         status_safe_to_swap,
         status_in_vblank
@@ -216,6 +245,10 @@ class VGA extends Module {
       read_data_prepared := intrStatusReg
     }.elsewhen(addr_upload_addr) {
       read_data_prepared := uploadAddrReg
+    }.elsewhen(addr_fill_data) {
+      read_data_prepared := fillDataReg
+    }.elsewhen(addr_fill_count) {
+      read_data_prepared := fill_left
     }.elsewhen(addr_palette) {
       read_data_prepared := paletteReg(palette_idx)
     }
@@ -232,6 +265,15 @@ class VGA extends Module {
     val fb_write_addr = WireDefault(0.U(ADDR_WIDTH.W))
     val fb_write_data = WireDefault(0.U(32.W))
 
+    // Fill engine: one word per cycle unless a STREAM_DATA write needs the port
+    when(fill_active && !(slave.io.bundle.write && addr_stream_data)) {
+      fb_write_en   := true.B
+      fb_write_addr := fill_addr
+      fb_write_data := fillDataReg
+      fill_addr     := fill_addr + 1.U
+      fill_left     := fill_left - 1.U
+    }
+
     // AXI4-Lite Write handling
     when(slave.io.bundle.write) {
       when(addr_ctrl) {
@@ -247,18 +289,21 @@ class VGA extends Module {
       }.elsewhen(addr_upload_addr) {
         uploadAddrReg := slave.io.bundle.write_data
       }.elsewhen(addr_stream_data) {
-        val pixel_nibble_addr = upload_pix_addr
-        val word_offset       = pixel_nibble_addr >> 3
-        val frame_base        = upload_frame * WORDS_PER_FRAME.U
-        val fb_addr           = frame_base + word_offset
-
         fb_write_en   := true.B
-        fb_write_addr := fb_addr
+        fb_write_addr := upload_fb_addr
         fb_write_data := slave.io.bundle.write_data
 
         val next_addr    = upload_pix_addr + 8.U
         val wrapped_addr = Mux(next_addr >= PIXELS_PER_FRAME.U, 0.U, next_addr)
         uploadAddrReg := Cat(upload_frame, wrapped_addr)
+      }.elsewhen(addr_fill_data) {
+        fillDataReg := slave.io.bundle.write_data
+      }.elsewhen(addr_fill_count) {
+        // Clamp to the words left in the framebuffer; restarts a running fill
+        val words_avail = Mux(upload_fb_addr >= TOTAL_WORDS.U, 0.U, TOTAL_WORDS.U - upload_fb_addr)
+        val requested   = slave.io.bundle.write_data
+        fill_addr := upload_fb_addr
+        fill_left := Mux(requested > words_avail, words_avail, requested)
       }.elsewhen(addr_palette) {
         paletteReg(palette_idx) := slave.io.bundle.write_data(5, 0)
       }
@@ -322,8 +367,20 @@ class VGA extends Module {
     val frame_y      = Mux(frame_y_div >= FRAME_HEIGHT.U, (FRAME_HEIGHT - 1).U, frame_y_div(5, 0))
 
     // CDC: Synchronize control signals
-    val curr_frame_sync1 = RegNext(ctrl_frame_sel)
-    val curr_frame       = RegNext(curr_frame_sync1)
+    val frame_sel_sync1  = RegNext(ctrl_frame_sel)
+    val frame_sel_synced = RegNext(frame_sel_sync1)
+
+    val swap_sync1     = RegNext(ctrl_swap_req)
+    val swap_at_vblank = RegNext(swap_sync1)
+
+    // Displayed frame: follows CTRL directly, or only at the first vblank line
+    // when a swap is requested. Taking an unchanged synchronizer value avoids
+    // latching a torn multi-bit frame index.
+    val vblank_start = h_count === 0.U && v_count === V_ACTIVE.U
+    val curr_frame   = RegInit(0.U(4.W))
+    when((!swap_at_vblank || vblank_start) && frame_sel_sync1 === frame_sel_synced) {
+      curr_frame := frame_sel_synced
+    }
 
     val display_enabled_sync1 = RegNext(ctrl_en)
     val display_enabled       = RegNext(display_enabled_sync1)
@@ -9,15 +9,16 @@ import chisel3.util._
 import riscv.Parameters
 
 /**
- * ALU function encoding. Maps to RV32I instruction funct3/funct7 combinations.
+ * ALU function encoding. Maps to RV32I/RV32M instruction funct3/funct7 combinations.
  *
  * The ALUControl module translates instruction encoding to these operations.
  * Special case 'zero' produces constant 0 for non-ALU instructions that still
  * flow through the execute stage (e.g., stores use ALU for address calculation
- * but don't need a separate zero output).
+ * but don't need a separate zero output). Division is not here: the
+ * iterative Divider in Execute produces DIV/DIVU/REM/REMU results.
  */
 object ALUFunctions extends ChiselEnum {
-  val zero, add, sub, sll, slt, xor, or, and, srl, sra, sltu = Value
+  val zero, add, sub, sll, slt, xor, or, and, srl, sra, sltu, mul, mulh, mulhsu, mulhu = Value
 }
 
 /**
@@ -28,11 +29,17 @@ object ALUFunctions extends ChiselEnum {
  * - Logical: AND, OR, XOR (bitwise operations)
  * - Shift: SLL (left), SRL (logical right), SRA (arithmetic right, sign-extends)
  * - Compare: SLT (signed), SLTU (unsigned) - output 1 if op1 < op2, else 0
+ * - Multiply (RV32M): MUL (low word), MULH/MULHSU/MULHU (high word with
+ *   signed x signed, signed x unsigned and unsigned x unsigned operands)
  *
  * Shift amounts use only lower 5 bits of op2 (RISC-V spec: shamt[4:0]).
  * Comparison results are 1-bit values zero-extended to 32 bits.
  *
- * Critical path: SLT/SLTU comparisons and SRA (requires sign extension logic).
+ * All four multiplies share one 33x33-bit signed multiplier: each operand
+ * is extended by its own sign bit for the signed forms and by zero
+ * otherwise, and the product is never wider than 64 bits.
+ *
+ * Critical path: the multiplier, then SLT/SLTU comparisons and SRA.
  */
 class ALU extends Module {
   val io = IO(new Bundle {
@@ -44,6 +51,11 @@ class ALU extends Module {
     val result = Output(UInt(Parameters.DataWidth))
   })
 
+  val op1_signed = io.func === ALUFunctions.mulh || io.func === ALUFunctions.mulhsu
+  val op2_signed = io.func === ALUFunctions.mulh
+  val product =
+    (Cat(op1_signed && io.op1(31), io.op1).asSInt * Cat(op2_signed && io.op2(31), io.op2).asSInt).asUInt
+
   io.result := 0.U
   switch(io.func) {
     is(ALUFunctions.add) {
@@ -76,5 +88,11 @@ class ALU extends Module {
     is(ALUFunctions.sltu) {
       io.result := io.op1 < io.op2
     }
+    is(ALUFunctions.mul) {
+      io.result := product(31, 0)
+    }
+    is(ALUFunctions.mulh, ALUFunctions.mulhsu, ALUFunctions.mulhu) {
+      io.result := product(63, 32)
+    }
   }
 }
@@ -9,6 +9,7 @@ import chisel3.util._
 import riscv.core.InstructionTypes
 import riscv.core.Instructions
 import riscv.core.InstructionsTypeI
+import riscv.core.InstructionsTypeM
 import riscv.core.InstructionsTypeR
 
 class ALUControl extends Module {
@@ -41,7 +42,7 @@ class ALUControl extends Module {
       )
     }
     is(InstructionTypes.RM) {
-      io.alu_funct := MuxLookup(
+      val rv32i = MuxLookup(
         io.funct3,
         ALUFunctions.zero
       )(
@@ -56,6 +57,19 @@ class ALUControl extends Module {
           InstructionsTypeR.sr      -> Mux(io.funct7(5), ALUFunctions.sra, ALUFunctions.srl)
         )
       )
+      // div/divu/rem/remu leave the ALU at zero; Execute takes the Divider result
+      val rv32m = MuxLookup(
+        io.funct3,
+        ALUFunctions.zero
+      )(
+        IndexedSeq(
+          InstructionsTypeM.mul    -> ALUFunctions.mul,
+          InstructionsTypeM.mulh   -> ALUFunctions.mulh,
+          InstructionsTypeM.mulhsu -> ALUFunctions.mulhsu,
+          InstructionsTypeM.mulhu  -> ALUFunctions.mulhu
+        )
+      )
+      io.alu_funct := Mux(io.funct7 === InstructionsTypeM.funct7, rv32m, rv32i)
     }
     is(InstructionTypes.B) {
       io.alu_funct := ALUFunctions.add
@@ -66,6 +80,9 @@ class ALUControl extends Module {
     is(InstructionTypes.S) {
       io.alu_funct := ALUFunctions.add
     }
+    is(InstructionTypes.A) {
+      io.alu_funct := ALUFunctions.add
+    }
     is(Instructions.jal) {
       io.alu_funct := ALUFunctions.add
     }
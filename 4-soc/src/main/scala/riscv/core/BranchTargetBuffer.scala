@@ -13,6 +13,9 @@ import riscv.Parameters
  *
  * Architecture:
  * - Direct-mapped cache indexed by PC bits (configurable size, default 16 entries)
+ * - PCs are 2-byte aligned (RV32C): PC[1] is folded into the lowest index
+ *   bit and kept in the tag, so word-aligned code still uses every entry and
+ *   an instruction at PC+2 lands in the neighbouring one
  * - Each entry stores: valid bit, tag, target address, 2-bit counter
  * - Prediction: taken on hit AND counter >= 2 (weakly/strongly taken)
  *
@@ -41,7 +44,7 @@ class BranchTargetBuffer(entries: Int = 16) extends Module {
   require(isPow2(entries), "BTB entries must be power of 2")
 
   val indexBits = log2Ceil(entries)
-  val tagBits   = Parameters.AddrBits - indexBits - 2 // -2 for 4-byte alignment
+  val tagBits   = Parameters.AddrBits - indexBits - 1 // -1 for 2-byte alignment
 
   val io = IO(new Bundle {
     // Prediction interface (IF stage) - combinational lookup
@@ -67,8 +70,8 @@ class BranchTargetBuffer(entries: Int = 16) extends Module {
   val counters = RegInit(VecInit(Seq.fill(entries)(2.U(2.W)))) // Initialize to Weakly Taken
 
   // Index and tag extraction (index/tag bits computed from entry count)
-  def getIndex(pc: UInt): UInt = pc(indexBits + 1, 2)
-  def getTag(pc: UInt): UInt   = pc(Parameters.AddrBits - 1, indexBits + 2)
+  def getIndex(pc: UInt): UInt = pc(indexBits + 1, 2) ^ pc(1)
+  def getTag(pc: UInt): UInt   = Cat(pc(Parameters.AddrBits - 1, indexBits + 2), pc(1))
 
   // Prediction logic (combinational - available same cycle)
   val pred_index = getIndex(io.pc)
@@ -20,4 +20,6 @@ class BusBundle extends Bundle {
   val busy                = Input(Bool())
   val request             = Output(Bool())
   val granted             = Input(Bool())
+  val exclusive           = Output(Bool()) // LR.W read / SC.W write
+  val write_exclusive_ok  = Input(Bool())  // With write_valid: SC.W succeeded (EXOKAY)
 }
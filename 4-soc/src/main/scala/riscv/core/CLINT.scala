@@ -32,6 +32,7 @@ class CLINT extends Module {
     val csr_bundle = new CSRDirectAccessBundle
   })
   val interrupt_enable_global   = io.csr_bundle.mstatus(3) // MIE bit (global enable)
+  val interrupt_enable_software = io.csr_bundle.mie(3)     // MSIE bit (software enable)
   val interrupt_enable_timer    = io.csr_bundle.mie(7)     // MTIE bit (timer enable)
   val interrupt_enable_external = io.csr_bundle.mie(11)    // MEIE bit (external enable)
 
@@ -49,11 +50,17 @@ class CLINT extends Module {
     io.csr_bundle.mstatus(31, 8) ## 1.U(1.W) ## io.csr_bundle.mstatus(6, 4) ## io.csr_bundle.mstatus(7) ## io.csr_bundle
       .mstatus(2, 0)
 
-  // Check individual interrupt source enable based on interrupt type
-  val interrupt_source_enabled = Mux(
-    io.interrupt_flag(0), // Timer interrupt (bit 0)
-    interrupt_enable_timer,
+  // Bit 0 is the timer, bit 2 the software interrupt (HartControl MSIP),
+  // every other bit an external source; each is gated by its own mie bit
+  val timer_pending    = io.interrupt_flag(0) && interrupt_enable_timer
+  val software_pending = io.interrupt_flag(2) && interrupt_enable_software
+  val external_pending = (io.interrupt_flag & ~0x5.U(Parameters.InterruptFlagWidth)) =/= 0.U &&
     interrupt_enable_external
+  val interrupt_source_enabled = timer_pending || software_pending || external_pending
+  val interrupt_cause = Mux(
+    timer_pending,
+    0x80000007L.U,
+    Mux(software_pending, 0x80000003L.U, 0x8000000bL.U)
   )
 
   when(io.instruction_id === InstructionsEnv.ecall || io.instruction_id === InstructionsEnv.ebreak) {
@@ -74,7 +81,7 @@ class CLINT extends Module {
   }.elsewhen(io.interrupt_flag =/= InterruptStatus.None && interrupt_enable_global && interrupt_source_enabled) {
     io.csr_bundle.mstatus_write_data  := mstatus_disable_interrupt
     io.csr_bundle.mepc_write_data     := instruction_address
-    io.csr_bundle.mcause_write_data   := Mux(io.interrupt_flag(0), 0x80000007L.U, 0x8000000bL.U)
+    io.csr_bundle.mcause_write_data   := interrupt_cause
     io.csr_bundle.direct_write_enable := true.B
     io.id_interrupt_assert            := true.B
     io.id_interrupt_handler_address   := io.csr_bundle.mtvec
@@ -5,17 +5,27 @@
 package riscv.core
 
 import bus.AXI4LiteMaster
+import bus.AXI4MasterMux
 import chisel3._
 import riscv.ImplementationType
 import riscv.Parameters
 // PipelinedCPU is now in the same package (riscv.core)
 
-class CPU(val implementation: Int = ImplementationType.FiveStageFinal) extends Module {
+// icache/dcache: cache geometries, disabled by default (see ICacheConfig, DCacheConfig)
+// predictor: branch predictor sizing and direction backend (see PredictorConfig)
+// hartId: mhartid of this core in a multi-hart Top
+class CPU(
+    val implementation: Int = ImplementationType.FiveStageFinal,
+    icache: ICacheConfig = ICacheConfig(),
+    dcache: DCacheConfig = DCacheConfig(),
+    predictor: PredictorConfig = PredictorConfig(),
+    hartId: Int = 0
+) extends Module {
   val io = IO(new CPUBundle)
 
   implementation match {
     case ImplementationType.FiveStageFinal =>
-      val cpu = Module(new PipelinedCPU)
+      val cpu = Module(new PipelinedCPU(icache, dcache, predictor, hartId))
 
       // Connect instruction fetch interface
       io.instruction_address   := cpu.io.instruction_address
@@ -39,23 +49,11 @@ class CPU(val implementation: Int = ImplementationType.FiveStageFinal) extends M
       cpu.io.memory_bundle.read_data           := axi_master.io.bundle.read_data
       cpu.io.memory_bundle.read_valid          := axi_master.io.bundle.read_valid
       cpu.io.memory_bundle.write_valid         := axi_master.io.bundle.write_valid
+      cpu.io.memory_bundle.write_exclusive_ok  := axi_master.io.bundle.write_exclusive_ok
       cpu.io.memory_bundle.write_data_accepted := axi_master.io.bundle.write_data_accepted
       cpu.io.memory_bundle.busy                := axi_master.io.bundle.busy
       cpu.io.memory_bundle.granted             := !axi_master.io.bundle.busy // Granted when not busy
 
-      // Connect AXI4-Lite channels to top-level
-      io.axi4_channels <> axi_master.io.channels
-
-      // Initialize cpu's unused axi4_channels inputs (FiveStageCPUFinal doesn't use these)
-      cpu.io.axi4_channels.read_address_channel.ARREADY  := false.B
-      cpu.io.axi4_channels.read_data_channel.RVALID      := false.B
-      cpu.io.axi4_channels.read_data_channel.RDATA       := 0.U
-      cpu.io.axi4_channels.read_data_channel.RRESP       := 0.U
-      cpu.io.axi4_channels.write_address_channel.AWREADY := false.B
-      cpu.io.axi4_channels.write_data_channel.WREADY     := false.B
-      cpu.io.axi4_channels.write_response_channel.BVALID := false.B
-      cpu.io.axi4_channels.write_response_channel.BRESP  := 0.U
-
       // Connect device select and bus address from wrapper
       io.device_select := cpu.io.device_select
 
@@ -76,11 +74,45 @@ class CPU(val implementation: Int = ImplementationType.FiveStageFinal) extends M
           cpu.io.memory_bundle.request &&
           (cpu.io.memory_bundle.read || cpu.io.memory_bundle.write)
 
+      // LR.W/SC.W: held with the address for the AXI4MasterMux exclusive monitor
+      val bus_exclusive_reg = RegInit(false.B)
+
       when(start_bus_transaction) {
-        bus_address_reg := next_bus_address
+        bus_address_reg   := next_bus_address
+        bus_exclusive_reg := cpu.io.memory_bundle.exclusive
       }
 
-      io.bus_address := bus_address_reg
+      if (icache.enabled || dcache.enabled) {
+        // Cache line transfers (master 0) and data accesses (master 1) share
+        // the bus; data wins ties since MEM stalls the whole pipeline
+        val master_mux = Module(new AXI4MasterMux(2, Parameters.AddrBits, Parameters.DataBits))
+        master_mux.io.masters(0) <> cpu.io.axi4_channels
+        master_mux.io.masters(1) <> axi_master.io.channels
+        master_mux.io.addresses(0) := cpu.io.bus_address
+        master_mux.io.addresses(1) := bus_address_reg
+        master_mux.io.exclusive(0) := false.B
+        master_mux.io.exclusive(1) := bus_exclusive_reg
+        io.axi4_channels <> master_mux.io.slave
+        io.bus_address   := master_mux.io.address
+        io.bus_exclusive := bus_exclusive_reg && master_mux.io.selected === 1.U
+      } else {
+        // Connect AXI4-Lite channels to top-level
+        io.axi4_channels <> axi_master.io.channels
+
+        // Initialize cpu's unused axi4_channels inputs (FiveStageCPUFinal doesn't use these)
+        cpu.io.axi4_channels.read_address_channel.ARREADY  := false.B
+        cpu.io.axi4_channels.read_data_channel.RVALID      := false.B
+        cpu.io.axi4_channels.read_data_channel.RDATA       := 0.U
+        cpu.io.axi4_channels.read_data_channel.RRESP       := 0.U
+        cpu.io.axi4_channels.read_data_channel.RLAST       := false.B
+        cpu.io.axi4_channels.write_address_channel.AWREADY := false.B
+        cpu.io.axi4_channels.write_data_channel.WREADY     := false.B
+        cpu.io.axi4_channels.write_response_channel.BVALID := false.B
+        cpu.io.axi4_channels.write_response_channel.BRESP  := 0.U
+
+        io.bus_address   := bus_address_reg
+        io.bus_exclusive := bus_exclusive_reg
+      }
 
       // Connect wrapper memory_bundle outputs (pass through from CPU)
       io.memory_bundle.address      := cpu.io.memory_bundle.address
@@ -89,6 +121,7 @@ class CPU(val implementation: Int = ImplementationType.FiveStageFinal) extends M
       io.memory_bundle.write_data   := cpu.io.memory_bundle.write_data
       io.memory_bundle.write_strobe := cpu.io.memory_bundle.write_strobe
       io.memory_bundle.request      := cpu.io.memory_bundle.request
+      io.memory_bundle.exclusive    := cpu.io.memory_bundle.exclusive
 
       // Note: io.memory_bundle inputs (read_data, read_valid, write_valid, busy, granted)
       // are not connected at Top level - they're for debugging/bypass only
@@ -103,6 +136,18 @@ class CPU(val implementation: Int = ImplementationType.FiveStageFinal) extends M
 
       cpu.io.csr_debug_read_address := io.csr_debug_read_address
       io.csr_debug_read_data        := cpu.io.csr_debug_read_data
+      io.debug_pc                   := cpu.io.debug_pc
+
+      io.debug_retire_valid        := cpu.io.debug_retire_valid
+      io.debug_retire_instruction  := cpu.io.debug_retire_instruction
+      io.debug_retire_pc           := cpu.io.debug_retire_pc
+      io.debug_retire_write_enable := cpu.io.debug_retire_write_enable
+      io.debug_retire_rd           := cpu.io.debug_retire_rd
+      io.debug_retire_data         := cpu.io.debug_retire_data
+      io.debug_retire_mem_address  := cpu.io.debug_retire_mem_address
+      io.debug_perf_events         := cpu.io.debug_perf_events
+      io.debug_perf_id_pc          := cpu.io.debug_perf_id_pc
+      io.debug_perf_mem_pc         := cpu.io.debug_perf_mem_pc
 
       // Connect debug bus signals
       io.debug_bus_write_enable := cpu.io.memory_bundle.write
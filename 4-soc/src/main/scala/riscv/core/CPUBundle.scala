@@ -32,8 +32,33 @@ class CPUBundle extends Bundle {
   val csr_debug_read_address = Input(UInt(Parameters.CSRRegisterAddrWidth))
   val csr_debug_read_data    = Output(UInt(Parameters.DataWidth))
 
+  // PC of the instruction in IF. instruction_address is the word fetched,
+  // which is PC+2 for the second half of a straddling 32-bit instruction.
+  val debug_pc = Output(UInt(Parameters.AddrWidth))
+
+  // Commit trace: valid pulses once per instruction leaving WB (canonical
+  // NOPs excluded, they are indistinguishable from bubbles). rd/data are the
+  // register write when write_enable is set (rd may be x0); mem_address is
+  // the load/store address. Used by the harness lockstep ISS and traces.
+  val debug_retire_valid        = Output(Bool())
+  val debug_retire_instruction  = Output(UInt(Parameters.InstructionWidth))
+  val debug_retire_pc           = Output(UInt(Parameters.AddrWidth))
+  val debug_retire_write_enable = Output(Bool())
+  val debug_retire_rd           = Output(UInt(Parameters.PhysicalRegisterAddrWidth))
+  val debug_retire_data         = Output(UInt(Parameters.DataWidth))
+  val debug_retire_mem_address  = Output(UInt(Parameters.AddrWidth))
+
+  // Per-cycle performance events for the harness profiler, tagged with the
+  // instruction they belong to: bit 0 branch misprediction, 1 hazard stall,
+  // 2 memory stall, 3 control flush (the mhpmcounter3-6 increments). Events
+  // resolved in ID use id_pc, memory stalls use mem_pc.
+  val debug_perf_events = Output(UInt(4.W))
+  val debug_perf_id_pc  = Output(UInt(Parameters.AddrWidth))
+  val debug_perf_mem_pc = Output(UInt(Parameters.AddrWidth))
+
   // Bus address and write strobes for BusSwitch/arbiter AXI4-Lite routing
   val bus_address            = Output(UInt(Parameters.AddrWidth))
+  val bus_exclusive          = Output(Bool()) // LR.W/SC.W on axi4_channels (AXI4MasterMux monitor)
   val debug_bus_write_enable = Output(Bool())
   val debug_bus_write_data   = Output(UInt(Parameters.DataWidth))
 }
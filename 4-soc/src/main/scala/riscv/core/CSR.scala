@@ -31,6 +31,7 @@ object CSRRegister {
   val MSCRATCH = 0x340.U(Parameters.CSRRegisterAddrWidth)
   val MEPC     = 0x341.U(Parameters.CSRRegisterAddrWidth)
   val MCAUSE   = 0x342.U(Parameters.CSRRegisterAddrWidth)
+  val MHARTID  = 0xf14.U(Parameters.CSRRegisterAddrWidth) // Read-only hart index
 
   // Machine Counter/Timers (read-only shadows at 0xC00+)
   val CycleL   = 0xc00.U(Parameters.CSRRegisterAddrWidth) // Lower 32 bits of cycle counter
@@ -45,20 +46,28 @@ object CSRRegister {
   val MInstretH = 0xb82.U(Parameters.CSRRegisterAddrWidth) // Upper 32 bits of minstret
 
   // Hardware Performance Counters (M-mode read/write)
-  val MHPMCounter3L = 0xb03.U(Parameters.CSRRegisterAddrWidth) // Branch mispredictions (BTB/RAS wrong)
-  val MHPMCounter3H = 0xb83.U(Parameters.CSRRegisterAddrWidth)
-  val MHPMCounter4L = 0xb04.U(Parameters.CSRRegisterAddrWidth) // Hazard stall cycles
-  val MHPMCounter4H = 0xb84.U(Parameters.CSRRegisterAddrWidth)
-  val MHPMCounter5L = 0xb05.U(Parameters.CSRRegisterAddrWidth) // Memory stall cycles
-  val MHPMCounter5H = 0xb85.U(Parameters.CSRRegisterAddrWidth)
-  val MHPMCounter6L = 0xb06.U(Parameters.CSRRegisterAddrWidth) // Control stall cycles (flush penalty)
-  val MHPMCounter6H = 0xb86.U(Parameters.CSRRegisterAddrWidth)
-  val MHPMCounter7L = 0xb07.U(Parameters.CSRRegisterAddrWidth) // BTB miss penalty (taken but not predicted)
-  val MHPMCounter7H = 0xb87.U(Parameters.CSRRegisterAddrWidth)
-  val MHPMCounter8L = 0xb08.U(Parameters.CSRRegisterAddrWidth) // Total branches resolved
-  val MHPMCounter8H = 0xb88.U(Parameters.CSRRegisterAddrWidth)
-  val MHPMCounter9L = 0xb09.U(Parameters.CSRRegisterAddrWidth) // BTB predictions (BTB said "taken")
-  val MHPMCounter9H = 0xb89.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter3L  = 0xb03.U(Parameters.CSRRegisterAddrWidth) // Branch mispredictions (BTB/RAS wrong)
+  val MHPMCounter3H  = 0xb83.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter4L  = 0xb04.U(Parameters.CSRRegisterAddrWidth) // Hazard stall cycles
+  val MHPMCounter4H  = 0xb84.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter5L  = 0xb05.U(Parameters.CSRRegisterAddrWidth) // Memory stall cycles
+  val MHPMCounter5H  = 0xb85.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter6L  = 0xb06.U(Parameters.CSRRegisterAddrWidth) // Control stall cycles (flush penalty)
+  val MHPMCounter6H  = 0xb86.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter7L  = 0xb07.U(Parameters.CSRRegisterAddrWidth) // BTB miss penalty (taken but not predicted)
+  val MHPMCounter7H  = 0xb87.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter8L  = 0xb08.U(Parameters.CSRRegisterAddrWidth) // Total branches resolved
+  val MHPMCounter8H  = 0xb88.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter9L  = 0xb09.U(Parameters.CSRRegisterAddrWidth) // BTB predictions (BTB said "taken")
+  val MHPMCounter9H  = 0xb89.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter10L = 0xb0a.U(Parameters.CSRRegisterAddrWidth) // I-cache hits
+  val MHPMCounter10H = 0xb8a.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter11L = 0xb0b.U(Parameters.CSRRegisterAddrWidth) // I-cache misses (line refills)
+  val MHPMCounter11H = 0xb8b.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter12L = 0xb0c.U(Parameters.CSRRegisterAddrWidth) // D-cache misses (line allocations)
+  val MHPMCounter12H = 0xb8c.U(Parameters.CSRRegisterAddrWidth)
+  val MHPMCounter13L = 0xb0d.U(Parameters.CSRRegisterAddrWidth) // D-cache dirty line writebacks
+  val MHPMCounter13H = 0xb8d.U(Parameters.CSRRegisterAddrWidth)
 
   // Machine Counter-Inhibit Register (0x320)
   val MCOUNTINHIBIT = 0x320.U(Parameters.CSRRegisterAddrWidth)
@@ -71,6 +80,8 @@ object CSRRegister {
   // mhpmcounter7: BTB miss penalty (branch taken but not in BTB)
   // mhpmcounter8: Total branches resolved (for accuracy = 1 - mhpmcounter3/mhpmcounter8)
   // mhpmcounter9: BTB predictions (BTB predicted "taken" for branch analysis)
+  // mhpmcounter10: I-cache hits (fetches IF consumed from the cache)
+  // mhpmcounter11: I-cache misses (line refills started)
 }
 
 /**
@@ -78,8 +89,9 @@ object CSRRegister {
  *
  * Implements RISC-V privileged architecture CSRs including:
  * - Machine trap setup/handling registers (mstatus, mtvec, mepc, mcause, etc.)
- * - Hardware performance counters (mcycle, minstret, mhpmcounter3-9)
+ * - Hardware performance counters (mcycle, minstret, mhpmcounter3-13)
  * - Counter inhibit register (mcountinhibit) for selective counter gating
+ * - Hart ID register (mhartid, read-only, `hartId` of a multi-hart Top)
  *
  * Performance Counter Mapping:
  * - mcycle/cycle (0xB00/0xC00): CPU clock cycles [CYCLES]
@@ -91,6 +103,10 @@ object CSRRegister {
  * - mhpmcounter7 (0xB07): BTB miss/wrong-target events [EVENTS]
  * - mhpmcounter8 (0xB08): Total branches resolved [EVENTS] (accuracy denominator)
  * - mhpmcounter9 (0xB09): BTB predictions [EVENTS] (BTB predicted "taken")
+ * - mhpmcounter10 (0xB0A): I-cache hits [EVENTS] (0 without the I-cache)
+ * - mhpmcounter11 (0xB0B): I-cache misses [EVENTS] (line refills)
+ * - mhpmcounter12 (0xB0C): D-cache misses [EVENTS] (line allocations, 0 without the D-cache)
+ * - mhpmcounter13 (0xB0D): D-cache writebacks [EVENTS] (dirty lines written to RAM)
  *
  * Counter Semantics (IMPORTANT):
  * - CYCLES counters: Increment once per clock cycle while condition is true
@@ -106,13 +122,15 @@ object CSRRegister {
  * - Control Overhead: mhpmcounter6 events (each flush = 1 cycle penalty)
  * - BTB Cold Miss Rate: mhpmcounter7 / mhpmcounter8
  * - BTB Coverage: mhpmcounter9 / mhpmcounter8 (how often BTB predicts)
+ * - I-cache Hit Rate: mhpmcounter10 / (mhpmcounter10 + mhpmcounter11)
+ * - D-cache Writeback Ratio: mhpmcounter13 / mhpmcounter12 (dirty victims per miss)
  *
  * mcountinhibit (0x320) Bit Mapping:
  * - Bit 0: Inhibit mcycle
  * - Bit 1: Reserved (hardwired to 0)
  * - Bit 2: Inhibit minstret
- * - Bits 3-9: Inhibit mhpmcounter3-9
- * - Bits 10-31: Reserved (hardwired to 0)
+ * - Bits 3-13: Inhibit mhpmcounter3-13
+ * - Bits 14-31: Reserved (hardwired to 0)
  *
  * Features:
  * - Atomic 64-bit reads: Shadow registers latch high word when low word is read
@@ -129,7 +147,7 @@ object CSRRegister {
  * - When CSR write and counter increment occur in same cycle, write wins
  * - Written value will be incremented by 1 on next cycle (for mcycle)
  */
-class CSR extends Module {
+class CSR(hartId: Int = 0) extends Module {
   val io = IO(new Bundle {
     val reg_read_address_id    = Input(UInt(Parameters.CSRRegisterAddrWidth))
     val reg_write_enable_ex    = Input(Bool())
@@ -151,6 +169,10 @@ class CSR extends Module {
     val btb_miss_taken       = Input(Bool()) // Branch taken but not in BTB
     val branch_resolved      = Input(Bool()) // Branch/jump resolved in ID stage
     val btb_predicted        = Input(Bool()) // BTB predicted "taken" for this branch
+    val icache_hit           = Input(Bool()) // IF consumed an I-cache hit
+    val icache_miss          = Input(Bool()) // I-cache line refill started
+    val dcache_miss          = Input(Bool()) // D-cache line allocation started
+    val dcache_writeback     = Input(Bool()) // D-cache dirty line writeback started
   })
 
   // Machine Trap Setup/Handling Registers
@@ -163,46 +185,58 @@ class CSR extends Module {
 
   // Machine Counter-Inhibit Register (mcountinhibit)
   // Bit 0: CY - inhibit mcycle, Bit 2: IR - inhibit minstret
-  // Bits 3-9: HPM3-9 - inhibit mhpmcounter3-9
+  // Bits 3-13: HPM3-13 - inhibit mhpmcounter3-13
   val mcountinhibit = RegInit(0.U(32.W))
 
   // Hardware Performance Counters (64-bit)
-  val mcycle       = RegInit(0.U(64.W)) // Clock cycles
-  val minstret     = RegInit(0.U(64.W)) // Instructions retired
-  val mhpmcounter3 = RegInit(0.U(64.W)) // Branch mispredictions (BTB/RAS wrong)
-  val mhpmcounter4 = RegInit(0.U(64.W)) // Hazard stall cycles
-  val mhpmcounter5 = RegInit(0.U(64.W)) // Memory stall cycles
-  val mhpmcounter6 = RegInit(0.U(64.W)) // Control stall cycles
-  val mhpmcounter7 = RegInit(0.U(64.W)) // BTB miss penalty
-  val mhpmcounter8 = RegInit(0.U(64.W)) // Total branches resolved
-  val mhpmcounter9 = RegInit(0.U(64.W)) // BTB predictions
+  val mcycle        = RegInit(0.U(64.W)) // Clock cycles
+  val minstret      = RegInit(0.U(64.W)) // Instructions retired
+  val mhpmcounter3  = RegInit(0.U(64.W)) // Branch mispredictions (BTB/RAS wrong)
+  val mhpmcounter4  = RegInit(0.U(64.W)) // Hazard stall cycles
+  val mhpmcounter5  = RegInit(0.U(64.W)) // Memory stall cycles
+  val mhpmcounter6  = RegInit(0.U(64.W)) // Control stall cycles
+  val mhpmcounter7  = RegInit(0.U(64.W)) // BTB miss penalty
+  val mhpmcounter8  = RegInit(0.U(64.W)) // Total branches resolved
+  val mhpmcounter9  = RegInit(0.U(64.W)) // BTB predictions
+  val mhpmcounter10 = RegInit(0.U(64.W)) // I-cache hits
+  val mhpmcounter11 = RegInit(0.U(64.W)) // I-cache misses
+  val mhpmcounter12 = RegInit(0.U(64.W)) // D-cache misses
+  val mhpmcounter13 = RegInit(0.U(64.W)) // D-cache writebacks
 
   // Shadow registers for atomic 64-bit reads
   // When software reads the low 32 bits, we latch the high 32 bits into a shadow register.
   // This prevents torn reads when the counter increments between reading low and high words.
   // The shadow register is returned when reading the high word.
-  val mcycle_shadow       = RegInit(0.U(32.W))
-  val minstret_shadow     = RegInit(0.U(32.W))
-  val mhpmcounter3_shadow = RegInit(0.U(32.W))
-  val mhpmcounter4_shadow = RegInit(0.U(32.W))
-  val mhpmcounter5_shadow = RegInit(0.U(32.W))
-  val mhpmcounter6_shadow = RegInit(0.U(32.W))
-  val mhpmcounter7_shadow = RegInit(0.U(32.W))
-  val mhpmcounter8_shadow = RegInit(0.U(32.W))
-  val mhpmcounter9_shadow = RegInit(0.U(32.W))
+  val mcycle_shadow        = RegInit(0.U(32.W))
+  val minstret_shadow      = RegInit(0.U(32.W))
+  val mhpmcounter3_shadow  = RegInit(0.U(32.W))
+  val mhpmcounter4_shadow  = RegInit(0.U(32.W))
+  val mhpmcounter5_shadow  = RegInit(0.U(32.W))
+  val mhpmcounter6_shadow  = RegInit(0.U(32.W))
+  val mhpmcounter7_shadow  = RegInit(0.U(32.W))
+  val mhpmcounter8_shadow  = RegInit(0.U(32.W))
+  val mhpmcounter9_shadow  = RegInit(0.U(32.W))
+  val mhpmcounter10_shadow = RegInit(0.U(32.W))
+  val mhpmcounter11_shadow = RegInit(0.U(32.W))
+  val mhpmcounter12_shadow = RegInit(0.U(32.W))
+  val mhpmcounter13_shadow = RegInit(0.U(32.W))
 
   // Latch high word when low word is read (for atomic 64-bit reads)
   val reading_cycle_low =
     io.reg_read_address_id === CSRRegister.CycleL || io.reg_read_address_id === CSRRegister.MCycleL
   val reading_instret_low =
     io.reg_read_address_id === CSRRegister.InstretL || io.reg_read_address_id === CSRRegister.MInstretL
-  val reading_hpm3_low = io.reg_read_address_id === CSRRegister.MHPMCounter3L
-  val reading_hpm4_low = io.reg_read_address_id === CSRRegister.MHPMCounter4L
-  val reading_hpm5_low = io.reg_read_address_id === CSRRegister.MHPMCounter5L
-  val reading_hpm6_low = io.reg_read_address_id === CSRRegister.MHPMCounter6L
-  val reading_hpm7_low = io.reg_read_address_id === CSRRegister.MHPMCounter7L
-  val reading_hpm8_low = io.reg_read_address_id === CSRRegister.MHPMCounter8L
-  val reading_hpm9_low = io.reg_read_address_id === CSRRegister.MHPMCounter9L
+  val reading_hpm3_low  = io.reg_read_address_id === CSRRegister.MHPMCounter3L
+  val reading_hpm4_low  = io.reg_read_address_id === CSRRegister.MHPMCounter4L
+  val reading_hpm5_low  = io.reg_read_address_id === CSRRegister.MHPMCounter5L
+  val reading_hpm6_low  = io.reg_read_address_id === CSRRegister.MHPMCounter6L
+  val reading_hpm7_low  = io.reg_read_address_id === CSRRegister.MHPMCounter7L
+  val reading_hpm8_low  = io.reg_read_address_id === CSRRegister.MHPMCounter8L
+  val reading_hpm9_low  = io.reg_read_address_id === CSRRegister.MHPMCounter9L
+  val reading_hpm10_low = io.reg_read_address_id === CSRRegister.MHPMCounter10L
+  val reading_hpm11_low = io.reg_read_address_id === CSRRegister.MHPMCounter11L
+  val reading_hpm12_low = io.reg_read_address_id === CSRRegister.MHPMCounter12L
+  val reading_hpm13_low = io.reg_read_address_id === CSRRegister.MHPMCounter13L
 
   when(reading_cycle_low) {
     mcycle_shadow := mcycle(63, 32)
@@ -231,17 +265,33 @@ class CSR extends Module {
   when(reading_hpm9_low) {
     mhpmcounter9_shadow := mhpmcounter9(63, 32)
   }
+  when(reading_hpm10_low) {
+    mhpmcounter10_shadow := mhpmcounter10(63, 32)
+  }
+  when(reading_hpm11_low) {
+    mhpmcounter11_shadow := mhpmcounter11(63, 32)
+  }
+  when(reading_hpm12_low) {
+    mhpmcounter12_shadow := mhpmcounter12(63, 32)
+  }
+  when(reading_hpm13_low) {
+    mhpmcounter13_shadow := mhpmcounter13(63, 32)
+  }
 
   // Counter inhibit bits
-  val inhibit_cy   = mcountinhibit(0) // Bit 0: mcycle
-  val inhibit_ir   = mcountinhibit(2) // Bit 2: minstret
-  val inhibit_hpm3 = mcountinhibit(3) // Bit 3: mhpmcounter3
-  val inhibit_hpm4 = mcountinhibit(4) // Bit 4: mhpmcounter4
-  val inhibit_hpm5 = mcountinhibit(5) // Bit 5: mhpmcounter5
-  val inhibit_hpm6 = mcountinhibit(6) // Bit 6: mhpmcounter6
-  val inhibit_hpm7 = mcountinhibit(7) // Bit 7: mhpmcounter7
-  val inhibit_hpm8 = mcountinhibit(8) // Bit 8: mhpmcounter8
-  val inhibit_hpm9 = mcountinhibit(9) // Bit 9: mhpmcounter9
+  val inhibit_cy    = mcountinhibit(0) // Bit 0: mcycle
+  val inhibit_ir    = mcountinhibit(2) // Bit 2: minstret
+  val inhibit_hpm3  = mcountinhibit(3) // Bit 3: mhpmcounter3
+  val inhibit_hpm4  = mcountinhibit(4) // Bit 4: mhpmcounter4
+  val inhibit_hpm5  = mcountinhibit(5) // Bit 5: mhpmcounter5
+  val inhibit_hpm6  = mcountinhibit(6) // Bit 6: mhpmcounter6
+  val inhibit_hpm7  = mcountinhibit(7) // Bit 7: mhpmcounter7
+  val inhibit_hpm8  = mcountinhibit(8) // Bit 8: mhpmcounter8
+  val inhibit_hpm9  = mcountinhibit(9) // Bit 9: mhpmcounter9
+  val inhibit_hpm10 = mcountinhibit(10) // Bit 10: mhpmcounter10
+  val inhibit_hpm11 = mcountinhibit(11) // Bit 11: mhpmcounter11
+  val inhibit_hpm12 = mcountinhibit(12) // Bit 12: mhpmcounter12
+  val inhibit_hpm13 = mcountinhibit(13) // Bit 13: mhpmcounter13
 
   // Increment counters (after shadow latching to get consistent snapshot)
   // Each counter respects its mcountinhibit bit
@@ -272,6 +322,18 @@ class CSR extends Module {
   when(io.btb_predicted && !inhibit_hpm9) {
     mhpmcounter9 := mhpmcounter9 + 1.U
   }
+  when(io.icache_hit && !inhibit_hpm10) {
+    mhpmcounter10 := mhpmcounter10 + 1.U
+  }
+  when(io.icache_miss && !inhibit_hpm11) {
+    mhpmcounter11 := mhpmcounter11 + 1.U
+  }
+  when(io.dcache_miss && !inhibit_hpm12) {
+    mhpmcounter12 := mhpmcounter12 + 1.U
+  }
+  when(io.dcache_writeback && !inhibit_hpm13) {
+    mhpmcounter13 := mhpmcounter13 + 1.U
+  }
 
   // Register lookup table for CSR reads
   // High word reads use shadow registers for atomic 64-bit reads
@@ -284,6 +346,7 @@ class CSR extends Module {
       CSRRegister.MSCRATCH -> mscratch,
       CSRRegister.MEPC     -> mepc,
       CSRRegister.MCAUSE   -> mcause,
+      CSRRegister.MHARTID  -> hartId.U(Parameters.DataWidth),
       // Machine counter-inhibit register
       CSRRegister.MCOUNTINHIBIT -> mcountinhibit,
       // User-mode read-only shadows (0xC00+)
@@ -298,20 +361,28 @@ class CSR extends Module {
       CSRRegister.MInstretL -> minstret(31, 0),
       CSRRegister.MInstretH -> minstret_shadow,
       // Hardware performance counters
-      CSRRegister.MHPMCounter3L -> mhpmcounter3(31, 0),
-      CSRRegister.MHPMCounter3H -> mhpmcounter3_shadow,
-      CSRRegister.MHPMCounter4L -> mhpmcounter4(31, 0),
-      CSRRegister.MHPMCounter4H -> mhpmcounter4_shadow,
-      CSRRegister.MHPMCounter5L -> mhpmcounter5(31, 0),
-      CSRRegister.MHPMCounter5H -> mhpmcounter5_shadow,
-      CSRRegister.MHPMCounter6L -> mhpmcounter6(31, 0),
-      CSRRegister.MHPMCounter6H -> mhpmcounter6_shadow,
-      CSRRegister.MHPMCounter7L -> mhpmcounter7(31, 0),
-      CSRRegister.MHPMCounter7H -> mhpmcounter7_shadow,
-      CSRRegister.MHPMCounter8L -> mhpmcounter8(31, 0),
-      CSRRegister.MHPMCounter8H -> mhpmcounter8_shadow,
-      CSRRegister.MHPMCounter9L -> mhpmcounter9(31, 0),
-      CSRRegister.MHPMCounter9H -> mhpmcounter9_shadow,
+      CSRRegister.MHPMCounter3L  -> mhpmcounter3(31, 0),
+      CSRRegister.MHPMCounter3H  -> mhpmcounter3_shadow,
+      CSRRegister.MHPMCounter4L  -> mhpmcounter4(31, 0),
+      CSRRegister.MHPMCounter4H  -> mhpmcounter4_shadow,
+      CSRRegister.MHPMCounter5L  -> mhpmcounter5(31, 0),
+      CSRRegister.MHPMCounter5H  -> mhpmcounter5_shadow,
+      CSRRegister.MHPMCounter6L  -> mhpmcounter6(31, 0),
+      CSRRegister.MHPMCounter6H  -> mhpmcounter6_shadow,
+      CSRRegister.MHPMCounter7L  -> mhpmcounter7(31, 0),
+      CSRRegister.MHPMCounter7H  -> mhpmcounter7_shadow,
+      CSRRegister.MHPMCounter8L  -> mhpmcounter8(31, 0),
+      CSRRegister.MHPMCounter8H  -> mhpmcounter8_shadow,
+      CSRRegister.MHPMCounter9L  -> mhpmcounter9(31, 0),
+      CSRRegister.MHPMCounter9H  -> mhpmcounter9_shadow,
+      CSRRegister.MHPMCounter10L -> mhpmcounter10(31, 0),
+      CSRRegister.MHPMCounter10H -> mhpmcounter10_shadow,
+      CSRRegister.MHPMCounter11L -> mhpmcounter11(31, 0),
+      CSRRegister.MHPMCounter11H -> mhpmcounter11_shadow,
+      CSRRegister.MHPMCounter12L -> mhpmcounter12(31, 0),
+      CSRRegister.MHPMCounter12H -> mhpmcounter12_shadow,
+      CSRRegister.MHPMCounter13L -> mhpmcounter13(31, 0),
+      CSRRegister.MHPMCounter13H -> mhpmcounter13_shadow,
     )
 
   // If the pipeline and the CLINT are going to read and write the CSR at the same time, let the pipeline write first.
@@ -367,9 +438,9 @@ class CSR extends Module {
     }.elsewhen(io.reg_write_address_ex === CSRRegister.MSCRATCH) {
       mscratch := io.reg_write_data_ex
     }.elsewhen(io.reg_write_address_ex === CSRRegister.MCOUNTINHIBIT) {
-      // Only bits 0, 2, 3-9 are writable (bit 1 is reserved, upper bits hardwired to 0)
-      // Mask: 0x000003fd = bits 0,2,3,4,5,6,7,8,9 (skip bit 1, clear bits 10-31)
-      mcountinhibit := io.reg_write_data_ex & "h000003fd".U
+      // Only bits 0, 2, 3-13 are writable (bit 1 is reserved, upper bits hardwired to 0)
+      // Mask: 0x00003ffd = bits 0,2,3,...,13 (skip bit 1, clear bits 14-31)
+      mcountinhibit := io.reg_write_data_ex & "h00003ffd".U
     }
   }
 
@@ -413,6 +484,22 @@ class CSR extends Module {
       mhpmcounter9 := Cat(mhpmcounter9(63, 32), io.reg_write_data_ex)
     }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter9H) {
       mhpmcounter9 := Cat(io.reg_write_data_ex, mhpmcounter9(31, 0))
+    }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter10L) {
+      mhpmcounter10 := Cat(mhpmcounter10(63, 32), io.reg_write_data_ex)
+    }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter10H) {
+      mhpmcounter10 := Cat(io.reg_write_data_ex, mhpmcounter10(31, 0))
+    }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter11L) {
+      mhpmcounter11 := Cat(mhpmcounter11(63, 32), io.reg_write_data_ex)
+    }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter11H) {
+      mhpmcounter11 := Cat(io.reg_write_data_ex, mhpmcounter11(31, 0))
+    }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter12L) {
+      mhpmcounter12 := Cat(mhpmcounter12(63, 32), io.reg_write_data_ex)
+    }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter12H) {
+      mhpmcounter12 := Cat(io.reg_write_data_ex, mhpmcounter12(31, 0))
+    }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter13L) {
+      mhpmcounter13 := Cat(mhpmcounter13(63, 32), io.reg_write_data_ex)
+    }.elsewhen(io.reg_write_address_ex === CSRRegister.MHPMCounter13H) {
+      mhpmcounter13 := Cat(io.reg_write_data_ex, mhpmcounter13(31, 0))
     }
   }
 }
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv.core
+
+import chisel3._
+import chisel3.util._
+
+/**
+ * RV32C expander: maps a 16-bit compressed instruction to its 32-bit RV32I
+ * equivalent, so everything after IF only ever sees base instructions.
+ *
+ * Purely combinational; used by InstructionFetch on the halfword at the PC.
+ * Only the integer subset is supported (no F/D, so C.FLW/C.FSW/C.FLD/C.FSD
+ * and their SP forms are illegal here). Illegal and reserved encodings
+ * expand to 0, which is itself an illegal 32-bit instruction:
+ * - the all-zero halfword and C.ADDI4SPN with nzuimm = 0
+ * - C.ADDI16SP and C.LUI with a zero immediate
+ * - C.LWSP with rd = x0 and C.JR with rs1 = x0
+ * - C.SLLI/C.SRLI/C.SRAI with shamt[5] set (RV64 only)
+ * - C.SUBW/C.ADDW and the other quadrant 1 "100 1 11" encodings
+ *
+ * HINT encodings (e.g. C.ADDI with rd = x0, C.MV with rd = x0) expand to the
+ * matching base instruction, which is a HINT there too.
+ */
+object CompressedExpander {
+
+  /** A halfword starts a compressed instruction unless bits 1:0 are 11 */
+  def isCompressed(half: UInt): Bool = half(1, 0) =/= "b11".U
+
+  // Field builders for the base formats; narrower immediates are zero-extended
+  private def iType(imm: UInt, rs1: UInt, funct3: UInt, rd: UInt, opcode: UInt): UInt =
+    Cat(imm.pad(12)(11, 0), rs1, funct3.pad(3), rd, opcode)
+
+  private def sType(imm: UInt, rs2: UInt, rs1: UInt, funct3: UInt, opcode: UInt): UInt = {
+    val i = imm.pad(12)
+    Cat(i(11, 5), rs2, rs1, funct3.pad(3), i(4, 0), opcode)
+  }
+
+  private def bType(imm: UInt, rs2: UInt, rs1: UInt, funct3: UInt): UInt =
+    Cat(imm(12), imm(10, 5), rs2, rs1, funct3.pad(3), imm(4, 1), imm(11), InstructionTypes.B)
+
+  private def jType(imm: UInt, rd: UInt): UInt =
+    Cat(imm(20), imm(10, 1), imm(11), imm(19, 12), rd, Instructions.jal)
+
+  private def rType(funct7: UInt, rs2: UInt, rs1: UInt, funct3: UInt, rd: UInt): UInt =
+    Cat(funct7.pad(7), rs2, rs1, funct3.pad(3), rd, InstructionTypes.RM)
+
+  private def signExtend(value: UInt, width: Int): UInt =
+    Cat(Fill(width - value.getWidth, value(value.getWidth - 1)), value)
+
+  def apply(c: UInt): UInt = {
+    val quadrant = c(1, 0)
+    val funct3   = c(15, 13)
+
+    // Full register fields and the x8-x15 fields of the CIW/CL/CS/CA/CB formats
+    val rd   = c(11, 7)
+    val rs2  = c(6, 2)
+    val rdp  = Cat(1.U(2.W), c(4, 2))
+    val rs1p = Cat(1.U(2.W), c(9, 7))
+    val x0   = 0.U(5.W)
+    val ra   = 1.U(5.W)
+    val sp   = 2.U(5.W)
+
+    // Immediates, in the order of the instruction bits they end up as
+    val addi4spn_imm = Cat(c(10, 7), c(12, 11), c(5), c(6), 0.U(2.W))
+    val lw_imm       = Cat(c(5), c(12, 10), c(6), 0.U(2.W))
+    val ci_imm       = signExtend(Cat(c(12), c(6, 2)), 12)
+    val cj_imm       = signExtend(Cat(c(12), c(8), c(10, 9), c(6), c(7), c(2), c(11), c(5, 3), 0.U(1.W)), 21)
+    val cb_imm       = signExtend(Cat(c(12), c(6, 5), c(2), c(11, 10), c(4, 3), 0.U(1.W)), 13)
+    val addi16sp_imm = signExtend(Cat(c(12), c(4, 3), c(5), c(2), c(6), 0.U(4.W)), 12)
+    val lui_imm      = signExtend(Cat(c(12), c(6, 2)), 20)
+    val lwsp_imm     = Cat(c(3, 2), c(12), c(6, 4), 0.U(2.W))
+    val swsp_imm     = Cat(c(8, 7), c(12, 9), 0.U(2.W))
+    val shamt        = Cat(0.U(7.W), c(6, 2))
+    val ci_zero      = !c(12) && c(6, 2) === 0.U
+
+    // Quadrant 0
+    val q0 = MuxLookup(funct3, 0.U)(
+      IndexedSeq(
+        "b000".U -> Mux(
+          addi4spn_imm === 0.U,
+          0.U,
+          iType(addi4spn_imm, sp, InstructionsTypeI.addi, rdp, InstructionTypes.I)
+        ),
+        "b010".U -> iType(lw_imm, rs1p, InstructionsTypeL.lw, rdp, InstructionTypes.L),
+        "b110".U -> sType(lw_imm, rdp, rs1p, InstructionsTypeS.sw, InstructionTypes.S)
+      )
+    )
+
+    // Quadrant 1: C.SRLI/C.SRAI/C.ANDI and the register-register ALU forms
+    val alu_funct3 = MuxLookup(c(6, 5), 0.U)(
+      IndexedSeq(
+        "b00".U -> InstructionsTypeR.add_sub,
+        "b01".U -> InstructionsTypeR.xor,
+        "b10".U -> InstructionsTypeR.or,
+        "b11".U -> InstructionsTypeR.and
+      )
+    )
+    val misc_alu = MuxLookup(c(11, 10), 0.U)(
+      IndexedSeq(
+        "b00".U -> Mux(c(12), 0.U, iType(shamt, rs1p, InstructionsTypeI.sri, rs1p, InstructionTypes.I)),
+        "b01".U -> Mux(
+          c(12),
+          0.U,
+          iType(Cat("b0100000".U(7.W), c(6, 2)), rs1p, InstructionsTypeI.sri, rs1p, InstructionTypes.I)
+        ),
+        "b10".U -> iType(ci_imm, rs1p, InstructionsTypeI.andi, rs1p, InstructionTypes.I),
+        "b11".U -> Mux(
+          c(12),
+          0.U,
+          rType(Mux(c(6, 5) === 0.U, "b0100000".U(7.W), 0.U(7.W)), rdp, rs1p, alu_funct3, rs1p)
+        )
+      )
+    )
+    val q1 = MuxLookup(funct3, 0.U)(
+      IndexedSeq(
+        "b000".U -> iType(ci_imm, rd, InstructionsTypeI.addi, rd, InstructionTypes.I),
+        "b001".U -> jType(cj_imm, ra),
+        "b010".U -> iType(ci_imm, x0, InstructionsTypeI.addi, rd, InstructionTypes.I),
+        "b011".U -> Mux(
+          ci_zero,
+          0.U,
+          Mux(
+            rd === sp,
+            iType(addi16sp_imm, sp, InstructionsTypeI.addi, sp, InstructionTypes.I),
+            Cat(lui_imm, rd, Instructions.lui)
+          )
+        ),
+        "b100".U -> misc_alu,
+        "b101".U -> jType(cj_imm, x0),
+        "b110".U -> bType(cb_imm, x0, rs1p, InstructionsTypeB.beq),
+        "b111".U -> bType(cb_imm, x0, rs1p, InstructionsTypeB.bne)
+      )
+    )
+
+    // Quadrant 2: C.JR/C.MV/C.EBREAK/C.JALR/C.ADD share funct3 = 100
+    val jump_move = Mux(
+      !c(12),
+      Mux(
+        rs2 === 0.U,
+        Mux(rd === 0.U, 0.U, iType(0.U(12.W), rd, 0.U, x0, Instructions.jalr)),
+        rType(0.U, rs2, x0, InstructionsTypeR.add_sub, rd)
+      ),
+      Mux(
+        rs2 === 0.U,
+        Mux(rd === 0.U, InstructionsEnv.ebreak, iType(0.U(12.W), rd, 0.U, ra, Instructions.jalr)),
+        rType(0.U, rs2, rd, InstructionsTypeR.add_sub, rd)
+      )
+    )
+    val q2 = MuxLookup(funct3, 0.U)(
+      IndexedSeq(
+        "b000".U -> Mux(c(12), 0.U, iType(shamt, rd, InstructionsTypeI.slli, rd, InstructionTypes.I)),
+        "b010".U -> Mux(rd === 0.U, 0.U, iType(lwsp_imm, sp, InstructionsTypeL.lw, rd, InstructionTypes.L)),
+        "b100".U -> jump_move,
+        "b110".U -> sType(swsp_imm, rs2, sp, InstructionsTypeS.sw, InstructionTypes.S)
+      )
+    )
+
+    MuxLookup(quadrant, 0.U)(
+      IndexedSeq(
+        "b00".U -> q0,
+        "b01".U -> q1,
+        "b10".U -> q2
+      )
+    )(31, 0)
+  }
+}
@@ -0,0 +1,391 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv.core
+
+import bus.AXI4BurstMaster
+import bus.AXI4LiteChannels
+import chisel3._
+import chisel3.util._
+import riscv.Parameters
+
+/**
+ * Data cache geometry
+ *
+ * @param sets        Number of sets (power of 2); 0 leaves the cache out and
+ *                    every load and store goes to the bus as before
+ * @param ways        1 (direct-mapped) or 2 (two-way, LRU replacement)
+ * @param lineWords   Words per line (power of 2), moved as one AXI burst
+ * @param storeBuffer Store buffer entries (one word each)
+ */
+case class DCacheConfig(sets: Int = 0, ways: Int = 1, lineWords: Int = 8, storeBuffer: Int = 4) {
+  require(sets == 0 || isPow2(sets), "D-cache sets must be 0 or a power of 2")
+  require(ways == 1 || ways == 2, "D-cache ways must be 1 or 2")
+  require(isPow2(lineWords) && lineWords <= 64, "D-cache line words must be a power of 2 up to 64")
+  require(storeBuffer >= 1 && storeBuffer <= 16, "D-cache store buffer must have 1 to 16 entries")
+
+  def enabled: Boolean = sets > 0
+}
+
+object DataCache {
+  // Harness mailbox in RAM (TEST_DONE_FLAG 0x100, TEST_RESULT 0x104): the
+  // simulator watches the RAM slave for these stores, so the window is never
+  // cached. Lines of up to 64 words never overlap it.
+  val MailboxBase  = 0x100
+  val MailboxBytes = 0x100
+}
+
+object DataCacheStates extends ChiselEnum {
+  val Idle, WriteBack, Refill, Flush = Value
+}
+
+/**
+ * Write-back Data Cache with a coalescing store buffer for the MEM stage
+ *
+ * Sits between MemoryAccess (cpu, a BusBundle slave) and the wrapper's
+ * AXI4LiteMaster (mem). Only RAM (device 0) is cached; VGA, UART and the
+ * other slaves are MMIO and pass through mem unchanged, one access at a
+ * time as before. So does the harness mailbox window at 0x100, whose stores
+ * must reach the RAM slave at once.
+ *
+ * Cached accesses answer in the cycle MemoryAccess issues them, so a hit
+ * costs no stall:
+ * - Load hit: read_valid with the word straight from the data array
+ * - Store: write_valid once the word is in the store buffer, either merged
+ *   into an entry for the same word or in a free entry
+ * - A load of a word still in the store buffer waits until it drains, a
+ *   store to a full buffer waits for a free entry, and an MMIO access waits
+ *   for the buffer to empty so device accesses stay in program order
+ *
+ * The store buffer drains one entry per cycle into the cache. A drain that
+ * misses allocates the line (write-allocate); lines only go back to RAM when
+ * a dirty victim is replaced, as one INCR burst of lineWords beats through
+ * AXI4BurstMaster, followed by the burst refill.
+ *
+ * fence.i:
+ * - flush (fence.i in MEM, so every older store is buffered) drains the
+ *   store buffer and then writes every dirty line back, keeping it valid
+ * - flushing stays set until then; the I-cache holds its refill on it
+ *
+ * Counter Support:
+ * - miss: pulses once per line allocation (load or store-buffer miss)
+ * - writeback: pulses once per dirty line written back
+ */
+class DataCache(config: DCacheConfig) extends Module {
+  require(config.enabled, "DataCache needs at least one set")
+
+  val wordBits   = log2Ceil(config.lineWords)
+  val offsetBits = wordBits + 2
+  val indexBits  = log2Ceil(config.sets)
+  val tagBits    = Parameters.AddrBits - offsetBits - indexBits
+  val entries    = config.storeBuffer
+
+  val io = IO(new Bundle {
+    val cpu = Flipped(new BusBundle) // MemoryAccess
+    val mem = new BusBundle          // MMIO, to the wrapper AXI4LiteMaster
+
+    val flush    = Input(Bool())  // fence.i in MEM
+    val flushing = Output(Bool()) // dirty data still on its way to RAM after flush
+
+    val miss      = Output(Bool())
+    val writeback = Output(Bool())
+
+    // Line refill and writeback port
+    val channels    = new AXI4LiteChannels(Parameters.AddrBits, Parameters.DataBits)
+    val bus_address = Output(UInt(Parameters.AddrWidth))
+  })
+
+  def getWord(addr: UInt): UInt  = if (wordBits == 0) 0.U else addr(offsetBits - 1, 2)
+  def getIndex(addr: UInt): UInt = if (indexBits == 0) 0.U else addr(offsetBits + indexBits - 1, offsetBits)
+  def getTag(addr: UInt): UInt   = addr(Parameters.AddrBits - 1, offsetBits + indexBits)
+
+  // Data array slot: way, set, word packed into one address
+  def slot(way: UInt, index: UInt, word: UInt): UInt = {
+    val fields = Seq(
+      Option.when(config.ways > 1)(way(0)),
+      Option.when(indexBits > 0)(index(math.max(indexBits, 1) - 1, 0)),
+      Option.when(wordBits > 0)(word(math.max(wordBits, 1) - 1, 0))
+    ).flatten
+    if (fields.isEmpty) 0.U else Cat(fields)
+  }
+
+  def lineAddress(tag: UInt, index: UInt): UInt =
+    if (indexBits == 0) tag ## 0.U(offsetBits.W)
+    else tag ## index(indexBits - 1, 0) ## 0.U(offsetBits.W)
+
+  def bytes(word: UInt): Vec[UInt] = VecInit((0 until Parameters.WordSize).map(i => word(8 * i + 7, 8 * i)))
+
+  val valid = RegInit(VecInit(Seq.fill(config.ways)(VecInit(Seq.fill(config.sets)(false.B)))))
+  val dirty = RegInit(VecInit(Seq.fill(config.ways)(VecInit(Seq.fill(config.sets)(false.B)))))
+  val tags  = Reg(Vec(config.ways, Vec(config.sets, UInt(tagBits.W))))
+  val lru   = RegInit(VecInit(Seq.fill(config.sets)(false.B))) // way to replace next (2-way)
+  val data  = Mem(config.ways * config.sets * config.lineWords, Vec(Parameters.WordSize, UInt(Parameters.ByteWidth)))
+
+  // (hit, way) for a word address
+  def lookup(addr: UInt): (Bool, UInt) = {
+    val index = getIndex(addr)
+    val hits  = VecInit((0 until config.ways).map(w => valid(w)(index) && tags(w)(index) === getTag(addr)))
+    (hits.asUInt.orR, if (config.ways == 1) 0.U else hits(1).asUInt)
+  }
+
+  def touch(index: UInt, way: UInt): Unit =
+    if (config.ways > 1) {
+      lru(index) := !way(0)
+    }
+
+  // Store buffer: word-aligned entries with byte masks
+  val sb_valid = RegInit(VecInit(Seq.fill(entries)(false.B)))
+  val sb_addr  = Reg(Vec(entries, UInt(Parameters.AddrWidth)))
+  val sb_data  = Reg(Vec(entries, Vec(Parameters.WordSize, UInt(Parameters.ByteWidth))))
+  val sb_mask  = Reg(Vec(entries, Vec(Parameters.WordSize, Bool())))
+  val sb_empty = !sb_valid.asUInt.orR
+
+  // The access MemoryAccess is waiting for, latched unless it finished in
+  // the cycle it was issued (Read/Write states only hold request)
+  val op_valid   = RegInit(false.B)
+  val op_write   = RegInit(false.B)
+  val op_address = RegInit(0.U(Parameters.AddrWidth))
+  val op_data    = RegInit(0.U(Parameters.DataWidth))
+  val op_strobe  = RegInit(VecInit(Seq.fill(Parameters.WordSize)(false.B)))
+  val issued     = RegInit(false.B) // MMIO access handed to the AXI4LiteMaster
+
+  val incoming = !op_valid && io.cpu.request && (io.cpu.read || io.cpu.write)
+  val active   = op_valid || incoming
+  val write    = Mux(op_valid, op_write, io.cpu.write)
+  val address  = Mux(op_valid, op_address, io.cpu.address)
+  val wdata    = Mux(op_valid, op_data, io.cpu.write_data)
+  val strobe   = Mux(op_valid, op_strobe, io.cpu.write_strobe)
+  val mailbox =
+    address(Parameters.AddrBits - 1, log2Ceil(DataCache.MailboxBytes)) ===
+      (DataCache.MailboxBase / DataCache.MailboxBytes).U
+  val cached =
+    address(Parameters.AddrBits - 1, Parameters.AddrBits - Parameters.SlaveDeviceCountBits) === 0.U && !mailbox
+
+  val index          = getIndex(address)
+  val (hit, hit_way) = lookup(address)
+  val sb_hits        = VecInit((0 until entries).map(i => sb_valid(i) && sb_addr(i) === address))
+  val sb_match       = sb_hits.asUInt.orR
+  val sb_full        = sb_valid.asUInt.andR
+  val load_hit       = active && !write && cached && hit && !sb_match
+  val load_miss      = active && !write && cached && !hit && !sb_match
+  val store_accepted = active && write && cached && (sb_match || !sb_full)
+  val mmio_issue     = active && !cached && !issued && sb_empty
+  val mmio_done      = issued && (io.mem.read_valid || io.mem.write_valid)
+  val cache_word     = data(slot(hit_way, index, getWord(address))).asUInt
+
+  // MMIO through the wrapper, driven like MemoryAccess drives its bus
+  io.mem.request      := mmio_issue || issued
+  io.mem.read         := mmio_issue && !write
+  io.mem.write        := mmio_issue && write
+  io.mem.address      := address
+  io.mem.write_data   := wdata
+  io.mem.write_strobe := strobe
+  io.mem.exclusive    := false.B
+
+  // Single hart only: a reserved SC.W always succeeds here
+  io.cpu.write_exclusive_ok := true.B
+
+  io.cpu.read_valid          := load_hit || (mmio_done && !op_write)
+  io.cpu.write_valid         := store_accepted || (mmio_done && op_write)
+  io.cpu.write_data_accepted := io.cpu.write_valid
+  io.cpu.read_data           := Mux(issued, io.mem.read_data, cache_word)
+  io.cpu.busy                := op_valid
+  io.cpu.granted             := !op_valid
+
+  val finished = io.cpu.read_valid || io.cpu.write_valid
+  when(incoming && !finished) {
+    op_valid   := true.B
+    op_write   := io.cpu.write
+    op_address := io.cpu.address
+    op_data    := io.cpu.write_data
+    op_strobe  := io.cpu.write_strobe
+  }
+  when(op_valid && finished) {
+    op_valid := false.B
+  }
+  when(mmio_issue && io.mem.granted) {
+    issued := true.B
+  }
+  when(mmio_done) {
+    issued := false.B
+  }
+
+  when(load_hit) {
+    touch(index, hit_way)
+  }
+
+  // Line engine: allocation (optional writeback, then refill) and flush
+  val line = Module(new AXI4BurstMaster(Parameters.AddrBits, Parameters.DataBits))
+  io.channels <> line.io.channels
+
+  val state         = RegInit(DataCacheStates.Idle)
+  val line_way      = RegInit(0.U(1.W))
+  val line_index    = RegInit(0.U(math.max(indexBits, 1).W))
+  val refill_tag    = RegInit(0.U(tagBits.W))
+  val burst_address = RegInit(0.U(Parameters.AddrWidth))
+  val flush_pending = RegInit(false.B)
+  val flush_active  = RegInit(false.B)
+  val scan_way      = RegInit(0.U(1.W))
+  val scan_index    = RegInit(0.U(math.max(indexBits, 1).W))
+  val scan_done     = RegInit(false.B)
+
+  val drain                  = PriorityEncoder(sb_valid.asUInt)
+  val drain_address          = sb_addr(drain)
+  val drain_index            = getIndex(drain_address)
+  val (drain_hit, drain_way) = lookup(drain_address)
+  val drain_miss             = !sb_empty && !drain_hit
+
+  val alloc         = state === DataCacheStates.Idle && (load_miss || drain_miss)
+  val alloc_address = Mux(load_miss, address, drain_address)
+  val alloc_index   = getIndex(alloc_address)
+
+  // Fill an invalid way first, otherwise the least recently used one
+  val victim =
+    if (config.ways == 1) 0.U
+    else Mux(!valid(0)(alloc_index), 0.U, Mux(!valid(1)(alloc_index), 1.U, lru(alloc_index).asUInt))
+
+  val issue_address = WireDefault(lineAddress(refill_tag, line_index))
+  line.io.bundle.address      := issue_address
+  line.io.bundle.length       := (config.lineWords - 1).U
+  line.io.bundle.read         := false.B
+  line.io.bundle.write        := false.B
+  line.io.bundle.write_data   := data(slot(line_way, line_index, line.io.bundle.beat)).asUInt
+  line.io.bundle.write_strobe := VecInit(Seq.fill(Parameters.WordSize)(true.B))
+  io.bus_address              := burst_address
+
+  io.miss      := alloc
+  io.writeback := false.B
+
+  def startWriteback(address: UInt): Unit = {
+    issue_address        := address
+    burst_address        := address
+    line.io.bundle.write := true.B
+    io.writeback         := true.B
+    state                := DataCacheStates.WriteBack
+  }
+
+  def startRefill(address: UInt): Unit = {
+    issue_address       := address
+    burst_address       := address
+    line.io.bundle.read := true.B
+    state               := DataCacheStates.Refill
+  }
+
+  def advanceScan(): Unit =
+    when(scan_index === (config.sets - 1).U) {
+      scan_index := 0.U
+      if (config.ways > 1) {
+        scan_way  := !scan_way(0)
+        scan_done := scan_way === 1.U
+      } else {
+        scan_done := true.B
+      }
+    }.otherwise {
+      scan_index := scan_index + 1.U
+    }
+
+  switch(state) {
+    is(DataCacheStates.Idle) {
+      when(alloc) {
+        // The victim is unusable from now on, so no drain can write into it
+        // behind the writeback
+        line_way                   := victim
+        line_index                 := alloc_index
+        refill_tag                 := getTag(alloc_address)
+        valid(victim)(alloc_index) := false.B
+        dirty(victim)(alloc_index) := false.B
+        tags(victim)(alloc_index)  := getTag(alloc_address)
+        when(valid(victim)(alloc_index) && dirty(victim)(alloc_index)) {
+          startWriteback(lineAddress(tags(victim)(alloc_index), alloc_index))
+        }.otherwise {
+          startRefill(lineAddress(getTag(alloc_address), alloc_index))
+        }
+      }.elsewhen(flush_pending && sb_empty) {
+        flush_pending := false.B
+        flush_active  := true.B
+        scan_way      := 0.U
+        scan_index    := 0.U
+        scan_done     := false.B
+        state         := DataCacheStates.Flush
+      }
+    }
+
+    is(DataCacheStates.WriteBack) {
+      when(line.io.bundle.done) {
+        when(flush_active) {
+          state := DataCacheStates.Flush
+        }.otherwise {
+          startRefill(lineAddress(refill_tag, line_index))
+        }
+      }
+    }
+
+    is(DataCacheStates.Refill) {
+      when(line.io.bundle.done) {
+        valid(line_way)(line_index) := true.B
+        touch(line_index, line_way)
+        state := DataCacheStates.Idle
+      }
+    }
+
+    is(DataCacheStates.Flush) {
+      when(scan_done) {
+        flush_active := false.B
+        state        := DataCacheStates.Idle
+      }.otherwise {
+        // Lines stay valid: only RAM has to catch up
+        when(valid(scan_way)(scan_index) && dirty(scan_way)(scan_index)) {
+          line_way                    := scan_way
+          line_index                  := scan_index
+          dirty(scan_way)(scan_index) := false.B
+          startWriteback(lineAddress(tags(scan_way)(scan_index), scan_index))
+        }
+        advanceScan()
+      }
+    }
+  }
+
+  when(io.flush) {
+    flush_pending := true.B
+  }
+  io.flushing := flush_pending || flush_active
+
+  // One data array write per cycle: refill beats win over the drain, and
+  // nothing drains into a victim being allocated this cycle
+  val fill        = line.io.bundle.read_valid
+  val into_victim = alloc && drain_index === alloc_index && drain_way === victim
+  val drain_write = !sb_empty && drain_hit && !fill && !into_victim
+  val fill_slot   = slot(line_way, line_index, line.io.bundle.beat)
+  val drain_slot  = slot(drain_way, drain_index, getWord(drain_address))
+  val full_mask   = VecInit(Seq.fill(Parameters.WordSize)(true.B))
+  when(fill || drain_write) {
+    data.write(
+      Mux(fill, fill_slot, drain_slot),
+      Mux(fill, bytes(line.io.bundle.read_data), sb_data(drain)),
+      Mux(fill, full_mask, sb_mask(drain))
+    )
+  }
+  when(drain_write) {
+    // After the flush scan, so a line written back this cycle stays dirty
+    dirty(drain_way)(drain_index) := true.B
+    sb_valid(drain)               := false.B
+    touch(drain_index, drain_way)
+  }
+
+  // Store buffer insertion last: merging into the entry draining this cycle
+  // keeps it (with both stores' bytes) for another drain
+  val sb_slot = Mux(sb_match, OHToUInt(sb_hits), PriorityEncoder(~sb_valid.asUInt))
+  when(store_accepted) {
+    sb_valid(sb_slot) := true.B
+    sb_addr(sb_slot)  := address
+    for (i <- 0 until Parameters.WordSize) {
+      when(strobe(i)) {
+        sb_data(sb_slot)(i) := wdata(8 * i + 7, 8 * i)
+        sb_mask(sb_slot)(i) := true.B
+      }.elsewhen(!sb_valid(sb_slot)) {
+        sb_mask(sb_slot)(i) := false.B
+      }
+    }
+  }
+}
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv.core
+
+import chisel3._
+import chisel3.util._
+import riscv.Parameters
+
+/**
+ * Iterative divider for RV32M DIV, DIVU, REM and REMU in the EX stage
+ *
+ * Restoring radix-2 division on operand magnitudes, one quotient bit per
+ * cycle, with the signs applied to the result at the end. Early-out keeps
+ * the common cases short:
+ * - Divide by zero, signed overflow (-2^31 / -1) and |dividend| < |divisor|
+ *   (including a zero dividend) need no iteration: ready is set in the same
+ *   cycle, like an ALU operation
+ * - Otherwise only the quotient bits that can be non-zero are computed,
+ *   clz(|divisor|) - clz(|dividend|) + 1 iterations, so small quotients
+ *   finish in a few cycles and 32 is the worst case
+ *
+ * Results for the special cases follow the spec: x / 0 = all ones and
+ * x % 0 = x; -2^31 / -1 = -2^31 and -2^31 % -1 = 0.
+ *
+ * Handshake with the pipeline:
+ * - valid: a divide is in EX
+ * - hold: EX2MEM is frozen (memory stall). The operands may still change
+ *   while MEM waits (they are forwarded from it), so a divide starts only
+ *   once hold is low and a finished result is kept until hold is low again
+ * - ready: result is valid this cycle. While valid && !ready the pipeline
+ *   holds the divide in EX and sends bubbles down to MEM.
+ *
+ * The operands are latched when the divide starts, so what the forwarding
+ * paths do while it iterates does not matter.
+ */
+class Divider extends Module {
+  val io = IO(new Bundle {
+    val valid  = Input(Bool())
+    val hold   = Input(Bool())
+    val funct3 = Input(UInt(3.W)) // div, divu, rem, remu
+    val op1    = Input(UInt(Parameters.DataWidth))
+    val op2    = Input(UInt(Parameters.DataWidth))
+
+    val ready  = Output(Bool())
+    val result = Output(UInt(Parameters.DataWidth))
+  })
+
+  val signed    = !io.funct3(0)
+  val remainder = io.funct3(1)
+
+  val op1_negative = signed && io.op1(31)
+  val op2_negative = signed && io.op2(31)
+  val op1_abs      = Mux(op1_negative, 0.U - io.op1, io.op1)
+  val op2_abs      = Mux(op2_negative, 0.U - io.op2, io.op2)
+
+  // Cases answered without iterating
+  val divide_by_zero = io.op2 === 0.U
+  val overflow       = signed && io.op1 === "h80000000".U && io.op2.andR
+  val too_small      = op1_abs < op2_abs
+  val immediate      = divide_by_zero || overflow || too_small
+  val immediate_result = Mux(
+    remainder,
+    Mux(overflow, 0.U, io.op1),
+    Mux(divide_by_zero, "hffffffff".U, Mux(overflow, io.op1, 0.U))
+  )
+
+  val busy          = RegInit(false.B)
+  val done          = RegInit(false.B)
+  val count         = RegInit(0.U(6.W))
+  val quotient      = RegInit(0.U(Parameters.DataWidth))
+  val partial       = RegInit(0.U(Parameters.DataWidth)) // partial remainder
+  val divisor       = RegInit(0.U(Parameters.DataWidth))
+  val negate_result = RegInit(false.B)
+  val want_rem      = RegInit(false.B)
+
+  // Quotient bits that can be set: the dividend has this many more
+  // significant bits than the divisor, plus one
+  val iterations = (PriorityEncoder(Reverse(op2_abs)) -& PriorityEncoder(Reverse(op1_abs)) +& 1.U)(5, 0)
+  val start      = io.valid && !busy && !done && !io.hold && !immediate
+
+  when(start) {
+    busy          := true.B
+    count         := iterations
+    partial       := op1_abs >> iterations
+    quotient      := (op1_abs << (32.U - iterations))(31, 0)
+    divisor       := op2_abs
+    negate_result := Mux(remainder, op1_negative, op1_negative =/= op2_negative)
+    want_rem      := remainder
+  }
+
+  // One quotient bit per cycle
+  val shifted    = Cat(partial, quotient(31))
+  val difference = shifted -& Cat(0.U(1.W), divisor)
+  val fits       = !difference(33)
+  when(busy) {
+    partial  := Mux(fits, difference(31, 0), shifted(31, 0))
+    quotient := Cat(quotient(30, 0), fits)
+    count    := count - 1.U
+    when(count === 1.U) {
+      busy := false.B
+      done := true.B
+    }
+  }
+
+  when(done && !io.hold) {
+    done := false.B
+  }
+
+  val magnitude = Mux(want_rem, partial, quotient)
+  io.ready  := done || (!busy && immediate)
+  io.result := Mux(done, Mux(negate_result, 0.U - magnitude, magnitude), immediate_result)
+}
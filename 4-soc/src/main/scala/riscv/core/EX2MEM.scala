@@ -21,21 +21,26 @@ import riscv.Parameters
  * - funct3: Memory access width (byte/half/word) and sign-extension mode
  * - memory_*_enable: Triggers AXI4-Lite bus transactions in MEM stage
  *
- * No flush input: EX2MEM never flushes because by the time an instruction
- * reaches this point, all control hazards have been resolved. Memory stalls
- * simply hold the register contents.
+ * Control hazards are all resolved by the time an instruction reaches this
+ * point, so the only flush is the bubble EX leaves behind while a divide is
+ * still iterating (the divide itself stays in ID2EX). Memory stalls simply
+ * hold the register contents.
  */
 class EX2MEM extends Module {
   val io = IO(new Bundle() {
     val stall               = Input(Bool())
+    val flush               = Input(Bool())
     val regs_write_enable   = Input(Bool())
     val regs_write_source   = Input(UInt(2.W))
     val regs_write_address  = Input(UInt(Parameters.AddrWidth))
     val instruction_address = Input(UInt(Parameters.AddrWidth))
+    val compressed          = Input(Bool())
+    val instruction         = Input(UInt(Parameters.InstructionWidth))
     val funct3              = Input(UInt(3.W))
     val reg2_data           = Input(UInt(Parameters.DataWidth))
     val memory_read_enable  = Input(Bool())
     val memory_write_enable = Input(Bool())
+    val memory_exclusive    = Input(Bool())
     val alu_result          = Input(UInt(Parameters.DataWidth))
     val csr_read_data       = Input(UInt(Parameters.DataWidth))
 
@@ -43,16 +48,19 @@ class EX2MEM extends Module {
     val output_regs_write_source   = Output(UInt(2.W))
     val output_regs_write_address  = Output(UInt(Parameters.AddrWidth))
     val output_instruction_address = Output(UInt(Parameters.AddrWidth))
+    val output_compressed          = Output(Bool())
+    val output_instruction         = Output(UInt(Parameters.InstructionWidth))
     val output_funct3              = Output(UInt(Parameters.DataWidth))
     val output_reg2_data           = Output(UInt(Parameters.DataWidth))
     val output_memory_read_enable  = Output(Bool())
     val output_memory_write_enable = Output(Bool())
+    val output_memory_exclusive    = Output(Bool())
     val output_alu_result          = Output(UInt(Parameters.DataWidth))
     val output_csr_read_data       = Output(UInt(Parameters.DataWidth))
   })
 
   val stall = io.stall
-  val flush = false.B
+  val flush = io.flush
 
   val regs_write_enable = Module(new PipelineRegister(1))
   regs_write_enable.io.in     := io.regs_write_enable
@@ -78,6 +86,19 @@ class EX2MEM extends Module {
   instruction_address.io.flush  := flush
   io.output_instruction_address := instruction_address.io.out
 
+  val compressed = Module(new PipelineRegister(1))
+  compressed.io.in     := io.compressed
+  compressed.io.stall  := stall
+  compressed.io.flush  := flush
+  io.output_compressed := compressed.io.out.asBool
+
+  // Only observed by the debug commit port; bubbles carry the NOP default
+  val instruction = Module(new PipelineRegister(Parameters.InstructionBits, InstructionsNop.nop))
+  instruction.io.in     := io.instruction
+  instruction.io.stall  := stall
+  instruction.io.flush  := flush
+  io.output_instruction := instruction.io.out
+
   val funct3 = Module(new PipelineRegister(3))
   funct3.io.in     := io.funct3
   funct3.io.stall  := stall
@@ -108,6 +129,12 @@ class EX2MEM extends Module {
   memory_write_enable.io.flush  := flush
   io.output_memory_write_enable := memory_write_enable.io.out
 
+  val memory_exclusive = Module(new PipelineRegister(1))
+  memory_exclusive.io.in     := io.memory_exclusive
+  memory_exclusive.io.stall  := stall
+  memory_exclusive.io.flush  := flush
+  io.output_memory_exclusive := memory_exclusive.io.out
+
   val csr_read_data = Module(new PipelineRegister())
   csr_read_data.io.in     := io.csr_read_data
   csr_read_data.io.stall  := stall
@@ -24,10 +24,12 @@ class Execute extends Module {
     val forward_from_wb     = Input(UInt(Parameters.DataWidth))
     val reg1_forward        = Input(UInt(2.W))
     val reg2_forward        = Input(UInt(2.W))
+    val hold                = Input(Bool()) // EX2MEM frozen by a memory stall
 
-    val mem_alu_result = Output(UInt(Parameters.DataWidth))
-    val mem_reg2_data  = Output(UInt(Parameters.DataWidth))
-    val csr_write_data = Output(UInt(Parameters.DataWidth))
+    val mem_alu_result  = Output(UInt(Parameters.DataWidth))
+    val mem_reg2_data   = Output(UInt(Parameters.DataWidth))
+    val csr_write_data  = Output(UInt(Parameters.DataWidth))
+    val ctrl_stall_flag = Output(Bool()) // divide still iterating: hold IF-EX, bubble to MEM
   })
 
   val opcode = io.instruction(6, 0)
@@ -72,8 +74,18 @@ class Execute extends Module {
     io.immediate,
     reg2_data
   )
-  io.mem_alu_result := alu.io.result
-  io.mem_reg2_data  := reg2_data
+
+  // RV32M division runs in the iterative Divider; multiplies stay in the ALU
+  val divider = Module(new Divider)
+  divider.io.valid  := opcode === InstructionTypes.RM && funct7 === InstructionsTypeM.funct7 && funct3(2)
+  divider.io.hold   := io.hold
+  divider.io.funct3 := funct3
+  divider.io.op1    := reg1_data
+  divider.io.op2    := reg2_data
+
+  io.ctrl_stall_flag := divider.io.valid && !divider.io.ready
+  io.mem_alu_result  := Mux(divider.io.valid, divider.io.result, alu.io.result)
+  io.mem_reg2_data   := reg2_data
   io.csr_write_data := MuxLookup(
     funct3,
     0.U
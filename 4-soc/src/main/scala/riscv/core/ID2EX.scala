@@ -32,6 +32,7 @@ class ID2EX extends Module {
     val flush                  = Input(Bool())
     val instruction            = Input(UInt(Parameters.InstructionWidth))
     val instruction_address    = Input(UInt(Parameters.AddrWidth))
+    val compressed             = Input(Bool())
     val regs_reg1_read_address = Input(UInt(Parameters.PhysicalRegisterAddrWidth))
     val regs_reg2_read_address = Input(UInt(Parameters.PhysicalRegisterAddrWidth))
     val regs_write_enable      = Input(Bool())
@@ -46,10 +47,12 @@ class ID2EX extends Module {
     val csr_address            = Input(UInt(Parameters.CSRRegisterAddrWidth))
     val memory_read_enable     = Input(Bool())
     val memory_write_enable    = Input(Bool())
+    val memory_exclusive       = Input(Bool())
     val csr_read_data          = Input(UInt(Parameters.DataWidth))
 
     val output_instruction            = Output(UInt(Parameters.DataWidth))
     val output_instruction_address    = Output(UInt(Parameters.AddrWidth))
+    val output_compressed             = Output(Bool())
     val output_regs_reg1_read_address = Output(UInt(Parameters.PhysicalRegisterAddrWidth))
     val output_regs_reg2_read_address = Output(UInt(Parameters.PhysicalRegisterAddrWidth))
     val output_regs_write_enable      = Output(Bool())
@@ -64,6 +67,7 @@ class ID2EX extends Module {
     val output_csr_address            = Output(UInt(Parameters.CSRRegisterAddrWidth))
     val output_memory_read_enable     = Output(Bool())
     val output_memory_write_enable    = Output(Bool())
+    val output_memory_exclusive       = Output(Bool())
     val output_csr_read_data          = Output(UInt(Parameters.DataWidth))
   })
   val stall = io.stall
@@ -80,6 +84,12 @@ class ID2EX extends Module {
   instruction_address.io.flush  := io.flush
   io.output_instruction_address := instruction_address.io.out
 
+  val compressed = Module(new PipelineRegister(1))
+  compressed.io.in     := io.compressed
+  compressed.io.stall  := stall
+  compressed.io.flush  := io.flush
+  io.output_compressed := compressed.io.out.asBool
+
   val regs_reg1_read_address = Module(new PipelineRegister(Parameters.PhysicalRegisterAddrBits))
   regs_reg1_read_address.io.in     := io.regs_reg1_read_address
   regs_reg1_read_address.io.stall  := stall
@@ -164,6 +174,12 @@ class ID2EX extends Module {
   memory_write_enable.io.flush  := io.flush
   io.output_memory_write_enable := memory_write_enable.io.out
 
+  val memory_exclusive = Module(new PipelineRegister(1))
+  memory_exclusive.io.in     := io.memory_exclusive
+  memory_exclusive.io.stall  := stall
+  memory_exclusive.io.flush  := io.flush
+  io.output_memory_exclusive := memory_exclusive.io.out
+
   val csr_read_data = Module(new PipelineRegister())
   csr_read_data.io.in     := io.csr_read_data
   csr_read_data.io.stall  := stall
@@ -28,6 +28,7 @@ class IF2ID extends Module {
     val flush                 = Input(Bool())
     val instruction           = Input(UInt(Parameters.InstructionWidth))
     val instruction_address   = Input(UInt(Parameters.AddrWidth))
+    val compressed            = Input(Bool()) // expanded from a 16-bit instruction
     val interrupt_flag        = Input(UInt(Parameters.InterruptFlagWidth))
     val btb_predicted_taken   = Input(Bool())                     // BTB prediction from IF stage
     val btb_predicted_target  = Input(UInt(Parameters.AddrWidth)) // BTB predicted target
@@ -35,10 +36,11 @@ class IF2ID extends Module {
     val ras_predicted_target  = Input(UInt(Parameters.AddrWidth)) // RAS predicted return address
     val ibtb_predicted_valid  = Input(Bool())                     // IndirectBTB prediction valid from IF
     val ibtb_predicted_target = Input(UInt(Parameters.AddrWidth)) // IndirectBTB predicted target
-    val perceptron_predicted_taken = Input(Bool())                // Perceptron prediction from IF stage
+    val direction_predicted_taken = Input(Bool())                 // Direction prediction from IF stage
 
     val output_instruction           = Output(UInt(Parameters.DataWidth))
     val output_instruction_address   = Output(UInt(Parameters.AddrWidth))
+    val output_compressed            = Output(Bool())
     val output_interrupt_flag        = Output(UInt(Parameters.InterruptFlagWidth))
     val output_btb_predicted_taken   = Output(Bool())                     // BTB prediction to ID stage
     val output_btb_predicted_target  = Output(UInt(Parameters.AddrWidth)) // BTB target to ID stage
@@ -46,7 +48,7 @@ class IF2ID extends Module {
     val output_ras_predicted_target  = Output(UInt(Parameters.AddrWidth)) // RAS target to ID stage
     val output_ibtb_predicted_valid  = Output(Bool())                     // IndirectBTB prediction to ID
     val output_ibtb_predicted_target = Output(UInt(Parameters.AddrWidth)) // IndirectBTB target to ID
-    val output_perceptron_predicted_taken = Output(Bool())                // Perceptron prediction to ID
+    val output_direction_predicted_taken = Output(Bool())                 // Direction prediction to ID
   })
 
   val instruction = Module(new PipelineRegister(defaultValue = InstructionsNop.nop))
@@ -61,6 +63,12 @@ class IF2ID extends Module {
   instruction_address.io.flush  := io.flush
   io.output_instruction_address := instruction_address.io.out
 
+  val compressed = Module(new PipelineRegister(1))
+  compressed.io.in     := io.compressed
+  compressed.io.stall  := io.stall
+  compressed.io.flush  := io.flush
+  io.output_compressed := compressed.io.out.asBool
+
   val interrupt_flag = Module(new PipelineRegister(Parameters.InterruptFlagBits))
   interrupt_flag.io.in     := io.interrupt_flag
   interrupt_flag.io.stall  := io.stall
@@ -106,10 +114,10 @@ class IF2ID extends Module {
   ibtb_predicted_target.io.flush  := io.flush
   io.output_ibtb_predicted_target := ibtb_predicted_target.io.out
 
-  // Perceptron prediction passed through pipeline
-  val perceptron_predicted_taken = Module(new PipelineRegister(1))
-  perceptron_predicted_taken.io.in     := io.perceptron_predicted_taken
-  perceptron_predicted_taken.io.stall  := io.stall
-  perceptron_predicted_taken.io.flush  := io.flush
-  io.output_perceptron_predicted_taken := perceptron_predicted_taken.io.out.asBool
+  // Direction (perceptron or tournament) prediction passed through pipeline
+  val direction_predicted_taken = Module(new PipelineRegister(1))
+  direction_predicted_taken.io.in     := io.direction_predicted_taken
+  direction_predicted_taken.io.stall  := io.stall
+  direction_predicted_taken.io.flush  := io.flush
+  io.output_direction_predicted_taken := direction_predicted_taken.io.out.asBool
 }
@@ -53,7 +53,7 @@ class IndirectBTB(entries: Int = 8) extends Module {
   require(isPow2(entries) && entries >= 4, "IndirectBTB entries must be power of 2 and >= 4")
 
   val indexBits = log2Ceil(entries)
-  val pcTagBits = Parameters.AddrBits - 2 // Full PC except 2 LSBs (word alignment)
+  val pcTagBits = Parameters.AddrBits - 1 // Full PC except the LSB (2-byte alignment)
   val hashBits  = 8                       // rs1 value hash width
 
   val io = IO(new Bundle {
@@ -80,8 +80,8 @@ class IndirectBTB(entries: Int = 8) extends Module {
   val targets   = Reg(Vec(entries, UInt(Parameters.AddrBits.W)))
   val ages      = RegInit(VecInit(Seq.fill(entries)(0.U(log2Ceil(entries).W))))
 
-  // Tag extraction (PC[31:2] for full address match)
-  def getPcTag(pc: UInt): UInt = pc(Parameters.AddrBits - 1, 2)
+  // Tag extraction (PC[31:1] for full address match; PCs are 2-byte aligned with RV32C)
+  def getPcTag(pc: UInt): UInt = pc(Parameters.AddrBits - 1, 1)
 
   // Prediction logic - PC-only associative search
   // Note: rs1_hash not used for lookup (not available in IF stage).
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv.core
+
+import bus.AXI4BurstMaster
+import bus.AXI4LiteChannels
+import chisel3._
+import chisel3.util._
+import riscv.Parameters
+
+/**
+ * Instruction cache geometry
+ *
+ * @param sets      Number of sets (power of 2); 0 leaves the cache out and
+ *                  fetches from the harness instruction port as before
+ * @param ways      1 (direct-mapped) or 2 (two-way, LRU replacement)
+ * @param lineWords Words per line (power of 2), refilled as one AXI burst
+ */
+case class ICacheConfig(sets: Int = 0, ways: Int = 1, lineWords: Int = 8) {
+  require(sets == 0 || isPow2(sets), "I-cache sets must be 0 or a power of 2")
+  require(ways == 1 || ways == 2, "I-cache ways must be 1 or 2")
+  require(isPow2(lineWords) && lineWords <= 256, "I-cache line words must be a power of 2 up to 256")
+
+  def enabled: Boolean = sets > 0
+}
+
+/**
+ * Instruction Cache for the IF stage
+ *
+ * Lookup is combinational on the IF PC, so a hit delivers the instruction in
+ * the same cycle exactly like the harness instruction port. A miss holds
+ * instruction_valid low (IF keeps its PC and feeds NOPs to ID) while the
+ * line is refilled from RAM with one INCR burst of lineWords beats through
+ * AXI4BurstMaster; the next cycle after the last beat hits. Redirects during
+ * a refill are fine: the refill completes for its own line and IF looks up
+ * the new PC.
+ *
+ * fence.i:
+ * - invalidate (fence.i in ID) clears every valid bit; a refill in flight is
+ *   finished but not marked valid, since it may hold pre-store bytes
+ * - The next refill waits while refill_hold is set (a store older than the
+ *   fence.i is still in EX/MEM or on the bus), so it reads the stored code
+ *
+ * Counter Support:
+ * - hit: lookup hit this cycle (the CPU counts the ones IF consumes)
+ * - miss: pulses once per line refill started
+ */
+class InstructionCache(config: ICacheConfig) extends Module {
+  require(config.enabled, "InstructionCache needs at least one set")
+
+  val wordBits   = log2Ceil(config.lineWords)
+  val offsetBits = wordBits + 2
+  val indexBits  = log2Ceil(config.sets)
+  val tagBits    = Parameters.AddrBits - offsetBits - indexBits
+
+  val io = IO(new Bundle {
+    // IF stage interface - combinational lookup
+    val pc                = Input(UInt(Parameters.AddrWidth))
+    val enable            = Input(Bool()) // RAM holds the program (ROMLoader finished)
+    val instruction       = Output(UInt(Parameters.InstructionWidth))
+    val instruction_valid = Output(Bool())
+
+    val invalidate  = Input(Bool()) // fence.i in ID
+    val refill_hold = Input(Bool()) // stores older than the fence.i still draining
+
+    val hit  = Output(Bool())
+    val miss = Output(Bool())
+
+    // Refill port
+    val channels    = new AXI4LiteChannels(Parameters.AddrBits, Parameters.DataBits)
+    val bus_address = Output(UInt(Parameters.AddrWidth))
+  })
+
+  def getWord(addr: UInt): UInt  = if (wordBits == 0) 0.U else addr(offsetBits - 1, 2)
+  def getIndex(addr: UInt): UInt = if (indexBits == 0) 0.U else addr(offsetBits + indexBits - 1, offsetBits)
+  def getTag(addr: UInt): UInt   = addr(Parameters.AddrBits - 1, offsetBits + indexBits)
+
+  // Data array slot: way, set, word packed into one address
+  def slot(way: UInt, index: UInt, word: UInt): UInt = {
+    val fields = Seq(
+      Option.when(config.ways > 1)(way(0)),
+      Option.when(indexBits > 0)(index(math.max(indexBits, 1) - 1, 0)),
+      Option.when(wordBits > 0)(word(math.max(wordBits, 1) - 1, 0))
+    ).flatten
+    if (fields.isEmpty) 0.U else Cat(fields)
+  }
+
+  val valid = RegInit(VecInit(Seq.fill(config.ways)(VecInit(Seq.fill(config.sets)(false.B)))))
+  val tags  = Reg(Vec(config.ways, Vec(config.sets, UInt(tagBits.W))))
+  val lru   = RegInit(VecInit(Seq.fill(config.sets)(false.B))) // way to replace next (2-way)
+  val data  = Mem(config.ways * config.sets * config.lineWords, UInt(Parameters.InstructionWidth))
+
+  // Lookup
+  val pc_index = getIndex(io.pc)
+  val pc_tag   = getTag(io.pc)
+  val way_hits = VecInit((0 until config.ways).map(w => valid(w)(pc_index) && tags(w)(pc_index) === pc_tag))
+  val hit      = way_hits.asUInt.orR && io.enable
+  val hit_way  = if (config.ways == 1) 0.U else way_hits(1).asUInt
+
+  io.instruction       := data(slot(hit_way, pc_index, getWord(io.pc)))
+  io.instruction_valid := hit
+  io.hit               := hit
+
+  if (config.ways > 1) {
+    when(hit) {
+      lru(pc_index) := !way_hits(1)
+    }
+  }
+
+  // Refill
+  val refill = Module(new AXI4BurstMaster(Parameters.AddrBits, Parameters.DataBits))
+  io.channels <> refill.io.channels
+
+  val refilling      = RegInit(false.B)
+  val discard        = RegInit(false.B) // invalidated while refilling
+  val fence_pending  = RegInit(false.B)
+  val refill_way     = RegInit(0.U(1.W))
+  val refill_index   = RegInit(0.U(math.max(indexBits, 1).W))
+  val refill_address = RegInit(0.U(Parameters.AddrWidth))
+  val line_address   = io.pc(Parameters.AddrBits - 1, offsetBits) ## 0.U(offsetBits.W)
+
+  val start = io.enable && !hit && !refilling && !io.invalidate && !(fence_pending && io.refill_hold)
+  io.miss := start
+
+  // Fill an invalid way first, otherwise the least recently used one
+  val victim =
+    if (config.ways == 1) 0.U
+    else Mux(!valid(0)(pc_index), 0.U, Mux(!valid(1)(pc_index), 1.U, lru(pc_index).asUInt))
+
+  refill.io.bundle.address      := line_address
+  refill.io.bundle.length       := (config.lineWords - 1).U
+  refill.io.bundle.read         := start
+  refill.io.bundle.write        := false.B
+  refill.io.bundle.write_data   := 0.U
+  refill.io.bundle.write_strobe := VecInit(Seq.fill(Parameters.WordSize)(false.B))
+  io.bus_address                := refill_address
+
+  when(start) {
+    refilling               := true.B
+    discard                 := false.B
+    refill_way              := victim
+    refill_index            := pc_index
+    refill_address          := line_address
+    valid(victim)(pc_index) := false.B // never hit a partly filled line
+    tags(victim)(pc_index)  := pc_tag
+  }
+
+  when(refill.io.bundle.read_valid) {
+    data.write(slot(refill_way, refill_index, refill.io.bundle.beat), refill.io.bundle.read_data)
+  }
+
+  when(refill.io.bundle.done) {
+    refilling := false.B
+    when(!discard) {
+      valid(refill_way)(refill_index) := true.B
+      if (config.ways > 1) {
+        lru(refill_index) := !refill_way(0)
+      }
+    }
+  }
+
+  // fence.i: drop every line, including one arriving now
+  when(io.invalidate) {
+    valid.foreach(_.foreach(_ := false.B))
+    fence_pending := true.B
+    when(refilling) {
+      discard := true.B
+    }
+  }.elsewhen(!io.refill_hold) {
+    fence_pending := false.B
+  }
+}
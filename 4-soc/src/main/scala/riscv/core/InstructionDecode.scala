@@ -31,6 +31,7 @@ class InstructionDecode extends Module {
     val ex_aluop2_source       = Output(UInt(1.W))
     val ex_memory_read_enable  = Output(Bool())
     val ex_memory_write_enable = Output(Bool())
+    val ex_memory_exclusive    = Output(Bool()) // LR.W / SC.W
     val ex_reg_write_source    = Output(UInt(2.W))
     val ex_reg_write_enable    = Output(Bool())
     val ex_reg_write_address   = Output(UInt(Parameters.PhysicalRegisterAddrWidth))
@@ -41,6 +42,7 @@ class InstructionDecode extends Module {
     val clint_jump_address     = Output(UInt(Parameters.AddrWidth)) // clint.io.jump_address
     val if_jump_flag           = Output(Bool())                     // ctrl.io.jump_flag , inst_fetch.io.jump_flag_id
     val if_jump_address        = Output(UInt(Parameters.AddrWidth)) // inst_fetch.io.jump_address_id
+    val if_fence_i             = Output(Bool())                     // icache.io.invalidate
   })
   val opcode = io.instruction(6, 0)
   val funct3 = io.instruction(14, 12)
@@ -56,10 +58,16 @@ class InstructionDecode extends Module {
       funct3 === InstructionsTypeCSR.csrrci ||
       funct3 === InstructionsTypeCSR.csrrsi
   )
+  // LR.W/SC.W are the only A-extension encodings decoded; anything else on
+  // the A opcode stays a no-op as before
+  val amo = opcode === InstructionTypes.A && funct3 === InstructionsTypeL.lw
+  val lr  = amo && io.instruction(31, 27) === InstructionsTypeA.lr
+  val sc  = amo && io.instruction(31, 27) === InstructionsTypeA.sc
   val uses_rs1 = (opcode === InstructionTypes.RM) || (opcode === InstructionTypes.I) ||
     (opcode === InstructionTypes.L) || (opcode === InstructionTypes.S) || (opcode === InstructionTypes.B) ||
-    (opcode === Instructions.jalr) || (opcode === Instructions.csr && !csr_uses_uimm)
-  val uses_rs2 = (opcode === InstructionTypes.RM) || (opcode === InstructionTypes.S) || (opcode === InstructionTypes.B)
+    (opcode === Instructions.jalr) || (opcode === Instructions.csr && !csr_uses_uimm) || lr || sc
+  val uses_rs2 = (opcode === InstructionTypes.RM) || (opcode === InstructionTypes.S) ||
+    (opcode === InstructionTypes.B) || sc
 
   io.regs_reg1_read_address := Mux(uses_rs1, rs1, 0.U(Parameters.PhysicalRegisterAddrWidth))
   io.regs_reg2_read_address := Mux(uses_rs2, rs2, 0.U(Parameters.PhysicalRegisterAddrWidth))
@@ -68,6 +76,7 @@ class InstructionDecode extends Module {
     Cat(Fill(20, io.instruction(31)), io.instruction(31, 20))
   )(
     IndexedSeq(
+      InstructionTypes.A -> 0.U(Parameters.DataWidth), // address is rs1 alone
       InstructionTypes.I -> Cat(Fill(21, io.instruction(31)), io.instruction(30, 20)),
       InstructionTypes.L -> Cat(Fill(21, io.instruction(31)), io.instruction(30, 20)),
       Instructions.jalr  -> Cat(Fill(21, io.instruction(31)), io.instruction(30, 20)),
@@ -100,14 +109,18 @@ class InstructionDecode extends Module {
     ALUOp2Source.Register,
     ALUOp2Source.Immediate
   )
-  io.ex_memory_read_enable  := opcode === InstructionTypes.L
-  io.ex_memory_write_enable := opcode === InstructionTypes.S
+  // SC.W also reads: its result (0 or 1) comes back through the load path,
+  // so load-use hazards and forwarding treat it like a load
+  io.ex_memory_read_enable  := opcode === InstructionTypes.L || lr || sc
+  io.ex_memory_write_enable := opcode === InstructionTypes.S || sc
+  io.ex_memory_exclusive    := lr || sc
   io.ex_reg_write_source := MuxLookup(
     opcode,
     RegWriteSource.ALUResult
   )(
     IndexedSeq(
       InstructionTypes.L -> RegWriteSource.Memory,
+      InstructionTypes.A -> RegWriteSource.Memory,
       Instructions.csr   -> RegWriteSource.CSR,
       Instructions.jal   -> RegWriteSource.NextInstructionAddress,
       Instructions.jalr  -> RegWriteSource.NextInstructionAddress
@@ -115,7 +128,7 @@ class InstructionDecode extends Module {
   )
   io.ex_reg_write_enable := (opcode === InstructionTypes.RM) || (opcode === InstructionTypes.I) ||
     (opcode === InstructionTypes.L) || (opcode === Instructions.auipc) || (opcode === Instructions.lui) ||
-    (opcode === Instructions.jal) || (opcode === Instructions.jalr) || (opcode === Instructions.csr)
+    (opcode === Instructions.jal) || (opcode === Instructions.jalr) || (opcode === Instructions.csr) || lr || sc
   io.ex_reg_write_address := io.instruction(11, 7)
   io.ex_csr_address       := io.instruction(31, 20)
   io.ex_csr_write_enable := (opcode === Instructions.csr) && (
@@ -169,7 +182,12 @@ class InstructionDecode extends Module {
       )
   )
 
-  io.if_jump_flag := branch_taken || io.interrupt_assert
+  // fence.i redirects to pc + 4 like a taken jump: the instruction IF already
+  // fetched behind it is discarded and fetched again after the invalidation
+  val fence_i = opcode === Instructions.fence && funct3 === InstructionsTypeFence.fencei
+  io.if_fence_i := fence_i
+
+  io.if_jump_flag := branch_taken || fence_i || io.interrupt_assert
 
   val jalr_target = Cat((reg1_data + io.ex_immediate)(Parameters.AddrBits - 1, 1), 0.U(1.W))
 
@@ -180,7 +198,8 @@ class InstructionDecode extends Module {
       IndexedSeq(
         InstructionTypes.B -> (io.instruction_address + io.ex_immediate),
         Instructions.jal   -> (io.instruction_address + io.ex_immediate),
-        Instructions.jalr  -> jalr_target
+        Instructions.jalr  -> jalr_target,
+        Instructions.fence -> (io.instruction_address + 4.U)
       )
     )
   )
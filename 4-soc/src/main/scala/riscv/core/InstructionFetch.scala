@@ -5,6 +5,9 @@
 package riscv.core
 
 import chisel3._
+import chisel3.util.Cat
+import chisel3.util.isPow2
+import chisel3.util.log2Ceil
 import chisel3.util.MuxCase
 import riscv.Parameters
 
@@ -12,6 +15,51 @@ object ProgramCounter {
   val EntryAddress = Parameters.EntryAddress
 }
 
+/**
+ * Branch predictor sizing, fixed at elaboration time
+ *
+ * @param direction         Conditional-branch direction predictor, one of
+ *                          DirectionPredictor.All ("perceptron" or "tournament")
+ * @param btbEntries        BranchTargetBuffer entries (power of 2)
+ * @param rasDepth          ReturnAddressStack depth (power of 2, >= 2)
+ * @param ibtbEntries       IndirectBTB entries (power of 2, >= 4)
+ * @param perceptrons       PerceptronBranchPredictor table size (power of 2)
+ * @param historyLength     Global history bits seen by each perceptron
+ * @param weightBits        Signed perceptron weight width
+ * @param trainingThreshold Perceptrons train while |sum| <= threshold
+ * @param phtEntries        TournamentBranchPredictor counters per table (power of 2)
+ */
+case class PredictorConfig(
+    direction: String = DirectionPredictor.Perceptron,
+    btbEntries: Int = 32,
+    rasDepth: Int = 4,
+    ibtbEntries: Int = 8,
+    perceptrons: Int = 8,
+    historyLength: Int = 7,
+    weightBits: Int = 8,
+    trainingThreshold: Int = 15,
+    phtEntries: Int = 256
+) {
+  require(DirectionPredictor.All.contains(direction), s"Unknown direction predictor $direction")
+  require(isPow2(btbEntries), "BTB entries must be a power of 2")
+  require(rasDepth >= 2 && isPow2(rasDepth), "RAS depth must be a power of 2 and >= 2")
+  require(ibtbEntries >= 4 && isPow2(ibtbEntries), "IndirectBTB entries must be a power of 2 and >= 4")
+  require(isPow2(perceptrons), "Perceptron count must be a power of 2")
+  require(historyLength >= 1 && weightBits >= 2, "Perceptrons need history >= 1 and weights >= 2 bits")
+  require(phtEntries >= 4 && isPow2(phtEntries), "Tournament table entries must be a power of 2 and >= 4")
+
+  // Register bits of each structure, as declared in its module; the
+  // predictor sweep uses the total as its area estimate
+  def btbBits: Int = btbEntries * (1 + (Parameters.AddrBits - log2Ceil(btbEntries) - 1) + Parameters.AddrBits + 2)
+  def rasBits: Int = rasDepth * Parameters.AddrBits + log2Ceil(rasDepth + 1)
+  def ibtbBits: Int =
+    ibtbEntries * (1 + (Parameters.AddrBits - 1) + 8 + Parameters.AddrBits + log2Ceil(ibtbEntries))
+  def perceptronBits: Int = perceptrons * (historyLength + 1) * weightBits + historyLength
+  def tournamentBits: Int = 3 * phtEntries * 2 + log2Ceil(phtEntries)
+  def directionBits: Int  = if (direction == DirectionPredictor.Tournament) tournamentBits else perceptronBits
+  def stateBits: Int      = btbBits + rasBits + ibtbBits + directionBits
+}
+
 /**
  * Instruction Fetch Stage with Branch Prediction (BTB + RAS)
  *
@@ -19,13 +67,13 @@ object ProgramCounter {
  * branch prediction using two complementary predictors:
  *
  * Branch Target Buffer (BTB):
- * - 32-entry direct-mapped cache indexed by PC[6:2]
+ * - Direct-mapped cache (32 entries by default) indexed by PC[6:2] (PC[1] folded in for RV32C)
  * - Stores branch/jump targets with 2-bit saturating counters
  * - Predicts taken when: BTB hit AND counter >= 2 (weakly/strongly taken)
  * - Updated in ID stage when branches resolve
  *
  * Return Address Stack (RAS):
- * - 4-entry circular stack for JALR return prediction
+ * - Circular stack (4 entries by default) for JALR return prediction
  * - Push on call: JAL/JALR with rd=x1 (ra) or rd=x5 (t0)
  * - Pop on return: JALR with rs1=x1/x5, rd=x0
  * - Speculative pop in IF stage when return pattern detected
@@ -36,7 +84,7 @@ object ProgramCounter {
  * 3. Jump from ID stage - actual resolved target
  * 4. RAS prediction - return address prediction (most specific for returns)
  * 5. BTB prediction - branch/jump target prediction
- * 6. Sequential PC+4 - default fall-through
+ * 6. Sequential PC+2/PC+4 - default fall-through
  *
  * BTB vs RAS Selection:
  * For JALR instructions, both BTB and RAS may have predictions:
@@ -57,27 +105,43 @@ object ProgramCounter {
  * - BTB/RAS misprediction: 1 cycle penalty (IF flush)
  * - No prediction (cold miss): 1 cycle penalty for taken branches
  *
+ * Compressed Instructions (RV32C):
+ * - The PC only needs to be 2-byte aligned; memory is still read a word at a
+ *   time, at fetch_address, and CompressedExpander turns a 16-bit instruction
+ *   into its 32-bit form here, so ID onwards only sees base instructions
+ * - A one-halfword buffer keeps the upper half of the last word fetched. A
+ *   32-bit instruction at PC[1] = 1 that straddles two words is assembled from
+ *   that half plus the next word, so a run of misaligned 32-bit instructions
+ *   costs no extra fetches; only the first one after a redirect waits one cycle
+ *   for the buffer to fill
+ * - id_compressed marks a 2-byte instruction so later stages link/fall through
+ *   to PC+2 instead of PC+4
+ * - invalidate (fence.i) empties the buffer along with the I-cache
+ *
  * CSR Counter Support:
  * - mhpmcounter3: Branch mispredictions (BTB/RAS wrong direction or target)
  * - mhpmcounter7: BTB miss penalty (cold misses + wrong target predictions)
  * - mhpmcounter8: Total branches resolved (accuracy denominator)
  * - mhpmcounter9: BTB predictions made (coverage numerator)
  */
-class InstructionFetch extends Module {
+class InstructionFetch(predictor: PredictorConfig = PredictorConfig()) extends Module {
   val io = IO(new Bundle {
     val stall_flag_ctrl   = Input(Bool())
     val jump_flag_id      = Input(Bool())
     val jump_address_id   = Input(UInt(Parameters.AddrWidth))
     val rom_instruction   = Input(UInt(Parameters.DataWidth))
     val instruction_valid = Input(Bool())
+    val invalidate        = Input(Bool()) // fence.i: drop the buffered halfword
 
     // BTB misprediction correction (from ID stage)
     val btb_mispredict         = Input(Bool())                     // BTB predicted wrong
     val btb_correction_addr    = Input(UInt(Parameters.AddrWidth)) // Correct PC
     val btb_correct_prediction = Input(Bool())                     // BTB predicted correctly - skip PC redirect
 
-    val instruction_address = Output(UInt(Parameters.AddrWidth))
+    val instruction_address = Output(UInt(Parameters.AddrWidth)) // PC of the instruction sent to ID
+    val fetch_address       = Output(UInt(Parameters.AddrWidth)) // Word address read from memory this cycle
     val id_instruction      = Output(UInt(Parameters.InstructionWidth))
+    val id_compressed       = Output(Bool()) // id_instruction was expanded from a 16-bit one
 
     // BTB prediction info passed to ID stage
     val btb_predicted_taken  = Output(Bool())
@@ -113,38 +177,73 @@ class InstructionFetch extends Module {
     val ibtb_update_rs1_hash = Input(UInt(8.W))
     val ibtb_update_target   = Input(UInt(Parameters.AddrWidth))
 
-    // Perceptron predictor output and update interface
-    val perceptron_predicted_taken = Output(Bool())
-    val perceptron_update_valid    = Input(Bool())
-    val perceptron_update_pc       = Input(UInt(Parameters.AddrWidth))
-    val perceptron_update_taken    = Input(Bool())
+    // Direction predictor (perceptron or tournament) output and update interface
+    val direction_predicted_taken = Output(Bool())
+    val direction_update_valid    = Input(Bool())
+    val direction_update_pc       = Input(UInt(Parameters.AddrWidth))
+    val direction_update_taken    = Input(Bool())
   })
   val pc = RegInit(ProgramCounter.EntryAddress)
 
-  // Branch Target Buffer for branch prediction (32 entries for better coverage)
-  val btb = Module(new BranchTargetBuffer(entries = 32))
+  // Upper halfword of the last word fetched, for instructions that straddle
+  // a word boundary
+  val half_valid   = RegInit(false.B)
+  val half_address = RegInit(0.U(Parameters.AddrWidth))
+  val half_data    = RegInit(0.U(16.W))
+
+  // At PC[1] = 1 a buffered non-compressed half is the low part of a 32-bit
+  // instruction whose high part is in the next word
+  val straddle      = pc(1) && half_valid && half_address === pc && !CompressedExpander.isCompressed(half_data)
+  val fetch_address = Mux(straddle, pc + 2.U, pc)
+
+  val word       = io.rom_instruction
+  val low_half   = Mux(pc(1), word(31, 16), word(15, 0))
+  val compressed = !straddle && CompressedExpander.isCompressed(low_half)
+  // Misaligned 32-bit instruction without its low half buffered: fill the
+  // buffer this cycle and fetch the next word in the following one
+  val need_next = pc(1) && !straddle && !compressed
+  val fetched = Mux(
+    compressed,
+    CompressedExpander(low_half),
+    Mux(straddle, Cat(word(15, 0), half_data), word)
+  )
+  val fetch_valid = io.instruction_valid && !need_next
+
+  when(io.invalidate) {
+    half_valid := false.B
+  }.elsewhen(io.instruction_valid && (need_next || (fetch_valid && !io.stall_flag_ctrl))) {
+    half_valid   := true.B
+    half_address := Cat(fetch_address(Parameters.AddrBits - 1, 2), "b10".U(2.W))
+    half_data    := word(31, 16)
+  }
+
+  // Branch Target Buffer for branch prediction (32 entries by default)
+  val btb = Module(new BranchTargetBuffer(entries = predictor.btbEntries))
   btb.io.pc := pc
 
-  // BTB prediction: use predicted target if BTB predicts taken
+  // BTB prediction: use predicted target if BTB predicts taken. IF2ID gets a
+  // NOP when nothing was fetched, which must not look like a BTB hit on a
+  // non-branch to ID
   val btb_next_pc = btb.io.predicted_pc
-  io.btb_predicted_taken  := btb.io.predicted_taken
+  io.btb_predicted_taken  := btb.io.predicted_taken && fetch_valid
   io.btb_predicted_target := btb.io.predicted_pc
 
   // Return Address Stack for JALR return prediction
-  val ras = Module(new ReturnAddressStack(depth = 4))
+  val ras = Module(new ReturnAddressStack(depth = predictor.rasDepth))
 
   // Indirect Branch Target Buffer for non-return JALR prediction
   // Handles function pointers, vtables, computed jumps that RAS doesn't cover
-  val ibtb = Module(new IndirectBTB(entries = 8))
+  val ibtb = Module(new IndirectBTB(entries = predictor.ibtbEntries))
   ibtb.io.pc := pc
 
-  // Perceptron Branch Predictor for conditional branches
-  val perceptron = Module(new PerceptronBranchPredictor())
-  perceptron.io.pc := pc
+  // Direction predictor for conditional branches: PerceptronBranchPredictor
+  // or TournamentBranchPredictor, chosen by predictor.direction
+  val direction = DirectionPredictor(predictor)
+  direction.pc := pc
 
   // Detect JALR with rs1=ra (x1) or rs1=t0 (x5) in fetched instruction for speculative pop
   // JALR opcode = 0b1100111, rs1 is bits [19:15], rd is bits [11:7]
-  val inst        = io.rom_instruction
+  val inst        = fetched
   val is_jalr     = inst(6, 0) === "b1100111".U
   val jalr_rs1    = inst(19, 15)
   val jalr_rd     = inst(11, 7)
@@ -152,7 +251,7 @@ class InstructionFetch extends Module {
   val is_return   = is_jalr && is_ra_or_t0 && (jalr_rd === 0.U) // JALR rd=x0, rs1=ra/t0 is return pattern
 
   // Speculative RAS pop in IF stage when return detected and not stalled
-  val speculative_ras_pop = is_return && io.instruction_valid && !io.stall_flag_ctrl
+  val speculative_ras_pop = is_return && fetch_valid && !io.stall_flag_ctrl
 
   // RAS connections
   ras.io.push          := io.ras_push
@@ -168,15 +267,15 @@ class InstructionFetch extends Module {
 
   // IndirectBTB prediction: for non-return JALR (function pointers, vtables)
   // Only predict when instruction is JALR but not a return pattern (RAS handles returns)
-  val is_indirect_jalr    = is_jalr && !is_return && io.instruction_valid && !io.stall_flag_ctrl
+  val is_indirect_jalr    = is_jalr && !is_return && fetch_valid && !io.stall_flag_ctrl
   val ibtb_prediction_hit = ibtb.io.hit && is_indirect_jalr
 
   // IndirectBTB prediction output (for ID stage to detect misprediction)
   io.ibtb_predicted_valid  := ibtb_prediction_hit
   io.ibtb_predicted_target := ibtb.io.predicted_target
 
-  // Perceptron prediction output (for ID stage to detect misprediction)
-  io.perceptron_predicted_taken := perceptron.io.predicted_taken
+  // Direction prediction output (for ID stage to detect misprediction)
+  io.direction_predicted_taken := direction.predicted_taken && fetch_valid
 
   // Latch jump request when stall is active
   // Problem: When mem_stall releases, PipelineRegister's combinational bypass
@@ -214,23 +313,22 @@ class InstructionFetch extends Module {
   // RAS prediction: use RAS target for returns when valid
   val ras_prediction_valid = io.ras_predicted_valid
 
-  // Default PC selection: RAS > IndirectBTB > Perceptron+BTB > sequential
+  // Default PC selection: RAS > IndirectBTB > direction+BTB > sequential
   // Priority for JALR instructions:
   // 1. RAS prediction for returns (highest accuracy for call/return patterns)
   // 2. IndirectBTB for other JALR (function pointers, computed jumps)
-  // 3. Perceptron + BTB for conditional branches:
-  //    - Perceptron provides direction prediction (taken/not-taken)
+  // 3. Direction predictor + BTB for conditional branches:
+  //    - Perceptron or tournament provides direction prediction (taken/not-taken)
   //    - BTB provides target address (only needs valid entry, not direction)
-  //    - Only predict taken if: perceptron says taken AND BTB has valid target
-  // Perceptron direction + BTB target (only predict taken if both agree on valid target and direction)
-  val perceptron_btb_taken = perceptron.io.predicted_taken && btb.io.hit
+  //    - Only predict taken if: direction says taken AND BTB has valid target
+  val direction_btb_taken = direction.predicted_taken && btb.io.hit
   val default_next_pc = Mux(
     ras_prediction_valid,
     ras.io.predicted_addr, // RAS prediction for returns
     Mux(
       ibtb_prediction_hit,
       ibtb.io.predicted_target,                        // IndirectBTB prediction for non-return JALR
-      Mux(perceptron_btb_taken, btb_next_pc, pc + 4.U) // Perceptron direction + BTB target
+      Mux(direction_btb_taken, btb_next_pc, pc + Mux(compressed, 2.U, 4.U)) // Direction + BTB target
     )
   )
 
@@ -240,21 +338,23 @@ class InstructionFetch extends Module {
   // 3. Actual jump from ID stage (branch taken / jump)
   // 4. RAS prediction (speculative return address)
   // 5. BTB prediction (speculative branch target)
-  // 6. Sequential PC+4 (default)
+  // 6. Sequential PC+2/PC+4 (default)
   val next_pc = MuxCase(
     default_next_pc,
     IndexedSeq(
       take_pending                                  -> pending_jump_addr,
       take_btb_correction                           -> io.btb_correction_addr,
       take_current                                  -> io.jump_address_id,
-      (io.stall_flag_ctrl || !io.instruction_valid) -> pc
+      (io.stall_flag_ctrl || !fetch_valid) -> pc
     )
   )
 
   pc := next_pc
 
   io.instruction_address := pc
-  io.id_instruction      := Mux(io.instruction_valid, io.rom_instruction, InstructionsNop.nop)
+  io.fetch_address       := fetch_address
+  io.id_instruction      := Mux(fetch_valid, fetched, InstructionsNop.nop)
+  io.id_compressed       := fetch_valid && compressed
 
   // BTB update interface - connect external update signals to BTB
   btb.io.update_valid  := io.btb_update_valid
@@ -268,8 +368,8 @@ class InstructionFetch extends Module {
   ibtb.io.update_rs1_hash := io.ibtb_update_rs1_hash
   ibtb.io.update_target   := io.ibtb_update_target
 
-  // Perceptron update interface - connect external update signals
-  perceptron.io.update_valid := io.perceptron_update_valid
-  perceptron.io.update_pc    := io.perceptron_update_pc
-  perceptron.io.update_taken := io.perceptron_update_taken
+  // Direction predictor update interface - connect external update signals
+  direction.update_valid := io.direction_update_valid
+  direction.update_pc    := io.direction_update_pc
+  direction.update_taken := io.direction_update_taken
 }
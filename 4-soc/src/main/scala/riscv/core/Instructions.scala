@@ -13,6 +13,7 @@ object InstructionTypes {
   val S  = "b0100011".U
   val RM = "b0110011".U
   val B  = "b1100011".U
+  val A  = "b0101111".U // RV32A subset: LR.W and SC.W only
 }
 
 object Instructions {
@@ -25,6 +26,11 @@ object Instructions {
   val fence = "b0001111".U
 }
 
+object InstructionsTypeFence {
+  val fence  = "b000".U
+  val fencei = "b001".U
+}
+
 object InstructionsTypeL {
   val lb  = "b000".U
   val lh  = "b001".U
@@ -61,17 +67,26 @@ object InstructionsTypeR {
   val and     = 7.U
 }
 
+// RV32M shares the RM opcode; funct7 = 0000001 selects it
 object InstructionsTypeM {
+  val funct7 = "b0000001".U
+
   val mul    = 0.U
   val mulh   = 1.U
   val mulhsu = 2.U
-  val mulhum = 3.U
+  val mulhu  = 3.U
   val div    = 4.U
   val divu   = 5.U
   val rem    = 6.U
   val remu   = 7.U
 }
 
+// funct5 = instruction(31, 27) of the A opcode; funct3 is always 010 (word)
+object InstructionsTypeA {
+  val lr = "b00010".U
+  val sc = "b00011".U
+}
+
 object InstructionsTypeB {
   val beq  = "b000".U
   val bne  = "b001".U
@@ -18,7 +18,8 @@ import riscv.Parameters
  * Key signals buffered:
  * - alu_result: Forwarded for non-memory ALU operations
  * - memory_read_data: Load result after byte/half extraction and sign-extension
- * - instruction_address: Used to compute PC+4 for JAL/JALR writeback
+ * - instruction_address/compressed: Used to compute PC+4 (PC+2 for a
+ *   compressed instruction) for JAL/JALR writeback
  * - regs_write_*: Register file write control signals
  *
  * Critical timing note: The inputs to this register come from MemoryAccess's
@@ -29,6 +30,8 @@ class MEM2WB extends Module {
   val io = IO(new Bundle() {
     val stall               = Input(Bool())
     val instruction_address = Input(UInt(Parameters.AddrWidth))
+    val compressed          = Input(Bool())
+    val instruction         = Input(UInt(Parameters.InstructionWidth))
     val alu_result          = Input(UInt(Parameters.DataWidth))
     val regs_write_enable   = Input(Bool())
     val regs_write_source   = Input(UInt(2.W))
@@ -37,6 +40,8 @@ class MEM2WB extends Module {
     val csr_read_data       = Input(UInt(Parameters.DataWidth))
 
     val output_instruction_address = Output(UInt(Parameters.AddrWidth))
+    val output_compressed          = Output(Bool())
+    val output_instruction         = Output(UInt(Parameters.InstructionWidth))
     val output_alu_result          = Output(UInt(Parameters.DataWidth))
     val output_regs_write_enable   = Output(Bool())
     val output_regs_write_source   = Output(UInt(2.W))
@@ -83,6 +88,19 @@ class MEM2WB extends Module {
   instruction_address.io.flush  := flush
   io.output_instruction_address := instruction_address.io.out
 
+  val compressed = Module(new PipelineRegister(1))
+  compressed.io.in     := io.compressed
+  compressed.io.stall  := stall
+  compressed.io.flush  := flush
+  io.output_compressed := compressed.io.out.asBool
+
+  // Only observed by the debug commit port; bubbles carry the NOP default
+  val instruction = Module(new PipelineRegister(Parameters.InstructionBits, InstructionsNop.nop))
+  instruction.io.in     := io.instruction
+  instruction.io.stall  := stall
+  instruction.io.flush  := flush
+  io.output_instruction := instruction.io.out
+
   val csr_read_data = Module(new PipelineRegister())
   csr_read_data.io.in     := io.csr_read_data
   csr_read_data.io.stall  := stall
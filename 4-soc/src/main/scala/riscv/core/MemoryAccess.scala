@@ -22,12 +22,17 @@ object MemoryAccessStates extends ChiselEnum {
  * Key Features:
  * - Load operations: LB, LBU, LH, LHU, LW with byte/halfword extraction
  * - Store operations: SB, SH, SW with byte strobes
+ * - LR.W/SC.W: LR.W is a load that sets a local reservation; SC.W without a
+ *   matching reservation fails at once (rd = 1), otherwise it is an
+ *   exclusive bus write and rd = 0 only if the bus answers EXOKAY
  * - Pipeline stall generation during bus transactions
  * - Data forwarding to EX stage for load-use hazard mitigation
  * - Latched control signals to handle stall release timing
  *
  * State Machine:
- * - Idle: Monitor memory_read_enable/memory_write_enable, start transactions
+ * - Idle: Monitor memory_read_enable/memory_write_enable, start transactions;
+ *   a bus that answers in the granting cycle (D-cache hit, buffered store)
+ *   completes the access at once without entering Read/Write
  * - Read: Wait for bus.read_valid, extract data, release stall
  * - Write: Wait for bus.write_valid (BRESP), release stall
  *
@@ -46,12 +51,14 @@ class MemoryAccess extends Module {
     val reg2_data           = Input(UInt(Parameters.DataWidth))
     val memory_read_enable  = Input(Bool())
     val memory_write_enable = Input(Bool())
+    val memory_exclusive    = Input(Bool())                                     // LR.W, or SC.W with write_enable
     val funct3              = Input(UInt(3.W))
     val regs_write_source   = Input(UInt(2.W))
     val regs_write_address  = Input(UInt(Parameters.PhysicalRegisterAddrWidth)) // destination register
     val regs_write_enable   = Input(Bool())                                     // register write enable
     val csr_read_data       = Input(UInt(Parameters.DataWidth))
     val instruction_address = Input(UInt(Parameters.AddrWidth))                 // For JAL/JALR forwarding (PC+4)
+    val compressed          = Input(Bool())                                     // Compressed: PC+2
 
     val wb_memory_read_data = Output(UInt(Parameters.DataWidth))
     val forward_to_ex       = Output(UInt(Parameters.DataWidth))
@@ -89,6 +96,11 @@ class MemoryAccess extends Module {
   // loaded data) because effective_regs_write_source switches too early.
   val read_just_completed = RegInit(false.B)
 
+  // LR.W reservation; the bus (AXI4MasterMux) keeps the one other harts'
+  // stores can break, this one only pairs SC.W with the preceding LR.W
+  val reservation_valid   = RegInit(false.B)
+  val reservation_address = Reg(UInt(Parameters.AddrWidth))
+
   // Helper for common transaction completion logic (state machine reset only)
   def on_bus_transaction_finished() = {
     mem_access_state   := MemoryAccessStates.Idle
@@ -97,6 +109,84 @@ class MemoryAccess extends Module {
     // Setting it for Write completions was a bug causing wrong wb_regs_write_source
   }
 
+  // Byte/halfword extraction with sign extension, then complete the read
+  def on_read_finished(data: UInt) = {
+    // Compute the processed data (byte/halfword extraction with sign extension)
+    // Use io.funct3 and mem_address_index directly - PipelineRegister is purely
+    // sequential (io.out := reg), NOT combinational bypass, so these signals
+    // remain stable during the entire bus transaction while mem_stall is asserted.
+    val processed_data = MuxLookup(
+      io.funct3,
+      0.U,
+      IndexedSeq(
+        InstructionsTypeL.lb -> MuxLookup(
+          mem_address_index,
+          Cat(Fill(24, data(31)), data(31, 24)),
+          IndexedSeq(
+            0.U -> Cat(Fill(24, data(7)), data(7, 0)),
+            1.U -> Cat(Fill(24, data(15)), data(15, 8)),
+            2.U -> Cat(Fill(24, data(23)), data(23, 16))
+          )
+        ),
+        InstructionsTypeL.lbu -> MuxLookup(
+          mem_address_index,
+          Cat(Fill(24, 0.U), data(31, 24)),
+          IndexedSeq(
+            0.U -> Cat(Fill(24, 0.U), data(7, 0)),
+            1.U -> Cat(Fill(24, 0.U), data(15, 8)),
+            2.U -> Cat(Fill(24, 0.U), data(23, 16))
+          )
+        ),
+        InstructionsTypeL.lh -> MuxLookup(
+          mem_address_index,
+          Cat(Fill(16, data(31)), data(31, 16)), // offset 3: best-effort (crosses word boundary)
+          IndexedSeq(
+            0.U -> Cat(Fill(16, data(15)), data(15, 0)), // bytes 0-1
+            1.U -> Cat(Fill(16, data(23)), data(23, 8)), // bytes 1-2
+            2.U -> Cat(Fill(16, data(31)), data(31, 16)) // bytes 2-3
+          )
+        ),
+        InstructionsTypeL.lhu -> MuxLookup(
+          mem_address_index,
+          Cat(Fill(16, 0.U), data(31, 16)), // offset 3: best-effort (crosses word boundary)
+          IndexedSeq(
+            0.U -> Cat(Fill(16, 0.U), data(15, 0)), // bytes 0-1
+            1.U -> Cat(Fill(16, 0.U), data(23, 8)), // bytes 1-2
+            2.U -> Cat(Fill(16, 0.U), data(31, 16)) // bytes 2-3
+          )
+        ),
+        InstructionsTypeL.lw -> data
+      )
+    )
+    // Store in register for persistence after read_valid goes low
+    latched_memory_read_data := processed_data
+    // Also output immediately for forwarding on this cycle
+    // Without this, the forwarding path would see the old latch value (0)
+    io.wb_memory_read_data := processed_data
+    // Signal that a read just completed - used by wb_effective_regs_write_source MUX
+    // to extend latched control signals for one more cycle
+    read_just_completed := true.B
+    on_bus_transaction_finished()
+  }
+
+  def latch_regs_write() = {
+    latched_regs_write_source  := io.regs_write_source
+    latched_regs_write_address := io.regs_write_address
+    latched_regs_write_enable  := io.regs_write_enable
+  }
+
+  // SC.W writes rd like a load: 0 on success, 1 on failure
+  val store_conditional = io.memory_exclusive && io.memory_write_enable
+  val reservation_hit   = reservation_valid && reservation_address === io.bus.address
+
+  def finish_write() = {
+    when(store_conditional) {
+      on_read_finished(Mux(io.bus.write_exclusive_ok, 0.U, 1.U))
+    }.otherwise {
+      on_bus_transaction_finished()
+    }
+  }
+
   // Clear read_just_completed on the cycle after it was set.
   // This ensures latched values are used for exactly one cycle after completion.
   // The original implementation had a bug where this signal would
@@ -114,6 +204,7 @@ class MemoryAccess extends Module {
   io.bus.write_data      := 0.U
   io.bus.write_strobe    := VecInit(Seq.fill(Parameters.WordSize)(false.B))
   io.bus.write           := false.B
+  io.bus.exclusive       := false.B
   io.wb_memory_read_data := latched_memory_read_data // Use latched value
   io.ctrl_stall_flag     := false.B
 
@@ -134,65 +225,10 @@ class MemoryAccess extends Module {
   when(mem_access_state === MemoryAccessStates.Read) {
     // In Read state: wait for read_valid, keep stalling
     io.bus.request     := true.B
+    io.bus.exclusive   := io.memory_exclusive
     io.ctrl_stall_flag := true.B
     when(io.bus.read_valid) {
-      val data = io.bus.read_data
-      // Compute the processed data (byte/halfword extraction with sign extension)
-      // Use io.funct3 and mem_address_index directly - PipelineRegister is purely
-      // sequential (io.out := reg), NOT combinational bypass, so these signals
-      // remain stable during the entire bus transaction while mem_stall is asserted.
-      val processed_data = MuxLookup(
-        io.funct3,
-        0.U,
-        IndexedSeq(
-          InstructionsTypeL.lb -> MuxLookup(
-            mem_address_index,
-            Cat(Fill(24, data(31)), data(31, 24)),
-            IndexedSeq(
-              0.U -> Cat(Fill(24, data(7)), data(7, 0)),
-              1.U -> Cat(Fill(24, data(15)), data(15, 8)),
-              2.U -> Cat(Fill(24, data(23)), data(23, 16))
-            )
-          ),
-          InstructionsTypeL.lbu -> MuxLookup(
-            mem_address_index,
-            Cat(Fill(24, 0.U), data(31, 24)),
-            IndexedSeq(
-              0.U -> Cat(Fill(24, 0.U), data(7, 0)),
-              1.U -> Cat(Fill(24, 0.U), data(15, 8)),
-              2.U -> Cat(Fill(24, 0.U), data(23, 16))
-            )
-          ),
-          InstructionsTypeL.lh -> MuxLookup(
-            mem_address_index,
-            Cat(Fill(16, data(31)), data(31, 16)), // offset 3: best-effort (crosses word boundary)
-            IndexedSeq(
-              0.U -> Cat(Fill(16, data(15)), data(15, 0)), // bytes 0-1
-              1.U -> Cat(Fill(16, data(23)), data(23, 8)), // bytes 1-2
-              2.U -> Cat(Fill(16, data(31)), data(31, 16)) // bytes 2-3
-            )
-          ),
-          InstructionsTypeL.lhu -> MuxLookup(
-            mem_address_index,
-            Cat(Fill(16, 0.U), data(31, 16)), // offset 3: best-effort (crosses word boundary)
-            IndexedSeq(
-              0.U -> Cat(Fill(16, 0.U), data(15, 0)), // bytes 0-1
-              1.U -> Cat(Fill(16, 0.U), data(23, 8)), // bytes 1-2
-              2.U -> Cat(Fill(16, 0.U), data(31, 16)) // bytes 2-3
-            )
-          ),
-          InstructionsTypeL.lw -> data
-        )
-      )
-      // Store in register for persistence after read_valid goes low
-      latched_memory_read_data := processed_data
-      // Also output immediately for forwarding on this cycle
-      // Without this, the forwarding path would see the old latch value (0)
-      io.wb_memory_read_data := processed_data
-      // Signal that a read just completed - used by wb_effective_regs_write_source MUX
-      // to extend latched control signals for one more cycle
-      read_just_completed := true.B
-      on_bus_transaction_finished()
+      on_read_finished(io.bus.read_data)
     }
   }.elsewhen(mem_access_state === MemoryAccessStates.Write) {
     // In Write state: wait for write_valid (BRESP) to complete transaction
@@ -203,32 +239,47 @@ class MemoryAccess extends Module {
     // to be ignored (the .otherwise block only runs in Idle state).
     // Conservative fix: stall until write completion to ensure correctness.
     io.bus.request     := true.B
+    io.bus.exclusive   := io.memory_exclusive
     io.ctrl_stall_flag := true.B
 
     when(io.bus.write_valid) {
-      on_bus_transaction_finished()
+      finish_write()
     }
   }.otherwise {
     // Idle state: check enable signals to start new transactions
-    when(io.memory_read_enable) {
+    when(store_conditional && !reservation_hit) {
+      // No reservation: fail without touching the bus
+      latch_regs_write()
+      reservation_valid := false.B
+      on_read_finished(1.U)
+    }.elsewhen(io.memory_read_enable && !store_conditional) {
       // Start the read transaction when the bus is available
       io.ctrl_stall_flag := true.B
       io.bus.read        := true.B
       io.bus.request     := true.B
+      io.bus.exclusive   := io.memory_exclusive
       // Capture control signals for MEM2WB when read starts
       // These are latched so that when read_valid arrives and stall releases,
       // MEM2WB can still capture the correct writeback info for the load instruction
-      latched_regs_write_source  := io.regs_write_source
-      latched_regs_write_address := io.regs_write_address
-      latched_regs_write_enable  := io.regs_write_enable
+      latch_regs_write()
       when(io.bus.granted) {
-        mem_access_state := MemoryAccessStates.Read
+        when(io.memory_exclusive) {
+          reservation_valid   := true.B
+          reservation_address := io.bus.address
+        }
+        when(io.bus.read_valid) {
+          // Answered in the same cycle (D-cache hit): no Read state, no stall
+          on_read_finished(io.bus.read_data)
+        }.otherwise {
+          mem_access_state := MemoryAccessStates.Read
+        }
       }
     }.elsewhen(io.memory_write_enable) {
       // Start the write transaction when the bus is available
       io.ctrl_stall_flag  := true.B
       io.bus.write_data   := io.reg2_data
       io.bus.write        := true.B
+      io.bus.exclusive    := store_conditional
       io.bus.write_strobe := VecInit(Seq.fill(Parameters.WordSize)(false.B))
       when(io.funct3 === InstructionsTypeS.sb) {
         io.bus.write_strobe(mem_address_index) := true.B
@@ -264,8 +315,19 @@ class MemoryAccess extends Module {
         }
       }
       io.bus.request := true.B
+      when(store_conditional) {
+        latch_regs_write()
+      }
       when(io.bus.granted) {
-        mem_access_state := MemoryAccessStates.Write
+        when(store_conditional) {
+          reservation_valid := false.B
+        }
+        when(io.bus.write_valid) {
+          // Accepted in the same cycle (D-cache store buffer)
+          finish_write()
+        }.otherwise {
+          mem_access_state := MemoryAccessStates.Write
+        }
       }
     }
   }
@@ -326,13 +388,13 @@ class MemoryAccess extends Module {
   // Forward to EX stage: Select correct data source based on instruction type
   // - Memory loads (FromMemory): forward loaded data
   // - CSR instructions (FromCSR): forward CSR read data
-  // - JAL/JALR (NextInstructionAddress): forward PC+4 (return address)
+  // - JAL/JALR (NextInstructionAddress): forward PC+4 (return address), PC+2 if compressed
   // - ALU operations (default): forward ALU result
   io.forward_to_ex := MuxLookup(forward_regs_write_source, io.alu_result)(
     Seq(
       RegWriteSource.Memory                 -> io.wb_memory_read_data,
       RegWriteSource.CSR                    -> io.csr_read_data,
-      RegWriteSource.NextInstructionAddress -> (io.instruction_address + 4.U)
+      RegWriteSource.NextInstructionAddress -> (io.instruction_address + Mux(io.compressed, 2.U, 4.U))
     )
   )
 
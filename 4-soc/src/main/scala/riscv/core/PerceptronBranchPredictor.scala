@@ -6,7 +6,6 @@ package riscv.core
 
 import chisel3._
 import chisel3.util._
-import riscv.Parameters
 
 /**
  * Perceptron Branch Predictor
@@ -56,16 +55,7 @@ class PerceptronBranchPredictor(
   // Max weight = 2^(weightBits-1) - 1, so sum can be (historyLength+1) * max_weight
   val sumWidth = log2Ceil((historyLength + 1) * (1 << (weightBits - 1))) + 1
 
-  val io = IO(new Bundle {
-    // Prediction interface (IF stage) - combinational lookup
-    val pc              = Input(UInt(Parameters.AddrWidth))
-    val predicted_taken = Output(Bool())
-
-    // Update interface (ID stage) - registered update
-    val update_valid = Input(Bool())
-    val update_pc    = Input(UInt(Parameters.AddrWidth))
-    val update_taken = Input(Bool()) // Ground truth: was branch actually taken?
-  })
+  val io = IO(new DirectionPredictorIO)
 
   // Weight storage: (numPerceptrons) x (historyLength + 1) weights
   // +1 for bias weight (w0)
@@ -79,8 +69,9 @@ class PerceptronBranchPredictor(
   val historyBuffer = RegInit(0.U(historyLength.W))
 
   // Index extraction from PC: use bits above word alignment
-  // PC[indexBits+1:2] gives word-aligned index
-  def getIndex(pc: UInt): UInt = pc(indexBits + 1, 2)
+  // PC[indexBits+1:2] gives word-aligned index; PC[1] (RV32C) flips the
+  // lowest bit so a branch at PC+2 does not share the perceptron at PC
+  def getIndex(pc: UInt): UInt = pc(indexBits + 1, 2) ^ pc(1)
 
   // ========== Prediction Logic (Combinational) ==========
 
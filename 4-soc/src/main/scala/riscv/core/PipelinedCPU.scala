@@ -4,7 +4,9 @@
 
 package riscv.core
 
+import bus.AXI4MasterMux
 import chisel3._
+import chisel3.util.Cat
 import chisel3.util.MuxLookup
 import riscv.core.CPUBundle
 import riscv.core.CSR
@@ -12,7 +14,7 @@ import riscv.core.RegisterFile
 import riscv.Parameters
 
 /**
- * CPU: Five-stage pipelined RISC-V RV32I processor with advanced optimizations
+ * CPU: Five-stage pipelined RISC-V RV32IMC processor with advanced optimizations
  *
  * Pipeline Architecture: IF → ID → EX → MEM → WB (Classic 5-stage RISC pipeline)
  *
@@ -104,20 +106,38 @@ import riscv.Parameters
  * - Provides reference for production-quality processor implementation
  *
  * Interface (CPUBundle):
- * - instruction_address: PC to instruction memory
+ * - instruction_address: Fetch address to instruction memory (the PC, or PC+2
+ *   for the second half of a 32-bit instruction straddling two words)
  * - instruction/instruction_valid: Instruction memory interface
  * - memory_bundle: Data memory/MMIO interface (AXI4-Lite style)
  * - device_select: Upper address bits for peripheral routing
  * - interrupt_flag: External interrupt input
  * - debug_read_address/data: Register file inspection
  * - csr_debug_read_address/data: CSR inspection
+ * - debug_pc: PC of the instruction in IF
+ * - debug_retire_*: Instructions as they retire from WB
+ * - debug_perf_*: Performance counter events with the PC they belong to
+ * - axi4_channels/bus_address: I-cache and D-cache line transfers (only with
+ *   a cache enabled)
+ *
+ * @param icache Instruction cache geometry; disabled (the default) fetches
+ *               straight from the instruction port
+ * @param dcache Data cache geometry; disabled (the default) sends every load
+ *               and store to memory_bundle
+ * @param predictor BTB, RAS and IndirectBTB sizing and the direction predictor
+ * @param hartId Value of the read-only mhartid CSR
  */
-class PipelinedCPU extends Module {
+class PipelinedCPU(
+    icache: ICacheConfig = ICacheConfig(),
+    dcache: DCacheConfig = DCacheConfig(),
+    predictor: PredictorConfig = PredictorConfig(),
+    hartId: Int = 0
+) extends Module {
   val io = IO(new CPUBundle)
 
   val ctrl       = Module(new Control)
   val regs       = Module(new RegisterFile)
-  val inst_fetch = Module(new InstructionFetch)
+  val inst_fetch = Module(new InstructionFetch(predictor))
   val if2id      = Module(new IF2ID)
   val id         = Module(new InstructionDecode)
   val id2ex      = Module(new ID2EX)
@@ -128,7 +148,7 @@ class PipelinedCPU extends Module {
   val wb         = Module(new WriteBack)
   val forwarding = Module(new Forwarding)
   val clint      = Module(new CLINT)
-  val csr_regs   = Module(new CSR)
+  val csr_regs   = Module(new CSR(hartId))
 
   ctrl.io.jump_flag               := id.io.if_jump_flag
   ctrl.io.jump_instruction_id     := id.io.ctrl_jump_instruction
@@ -159,13 +179,47 @@ class PipelinedCPU extends Module {
   // Memory stall signal: freeze entire pipeline when AXI4 bus transactions are pending
   val mem_stall = mem.io.ctrl_stall_flag
 
+  // Divide stall: while a divide iterates in EX, IF, ID and EX hold and MEM/WB
+  // keep draining (EX2MEM takes bubbles), so an access already in MEM is never
+  // issued twice. front_stall freezes everything up to EX; the ID-stage events
+  // below (predictor updates, flushes, counters) are gated by it.
+  val div_stall   = ex.io.ctrl_stall_flag
+  val front_stall = mem_stall || div_stall
+
+  // MEM2WB holds its instruction while mem_stall is set, so each instruction
+  // retires exactly once: on the cycle the stage advances. Bubbles are NOPs.
+  io.debug_retire_valid        := mem2wb.io.output_instruction =/= InstructionsNop.nop && !mem_stall
+  io.debug_retire_instruction  := mem2wb.io.output_instruction
+  io.debug_retire_pc           := mem2wb.io.output_instruction_address
+  io.debug_retire_write_enable := mem2wb.io.output_regs_write_enable
+  io.debug_retire_rd           := mem2wb.io.output_regs_write_address
+  io.debug_retire_data         := wb.io.regs_write_data
+  io.debug_retire_mem_address  := mem2wb.io.output_alu_result
+
   // Instruction memory interface
-  io.instruction_address          := inst_fetch.io.instruction_address
-  inst_fetch.io.stall_flag_ctrl   := ctrl.io.pc_stall || mem_stall
+  // With RV32C the word fetched is not always the one at the PC (see
+  // InstructionFetch), so memory and the I-cache follow fetch_address
+  io.instruction_address          := inst_fetch.io.fetch_address
+  io.debug_pc                     := inst_fetch.io.instruction_address
+  inst_fetch.io.stall_flag_ctrl   := ctrl.io.pc_stall || front_stall
   inst_fetch.io.jump_flag_id      := id.io.if_jump_flag
   inst_fetch.io.jump_address_id   := id.io.if_jump_address
-  inst_fetch.io.rom_instruction   := io.instruction
-  inst_fetch.io.instruction_valid := io.instruction_valid
+  inst_fetch.io.invalidate        := id.io.if_fence_i
+
+  // Optional instruction cache between IF and RAM. io.instruction_valid still
+  // gates it, so nothing is refilled before ROMLoader has written the program.
+  val inst_cache = Option.when(icache.enabled)(Module(new InstructionCache(icache)))
+  inst_cache match {
+    case Some(cache) =>
+      cache.io.pc                     := inst_fetch.io.fetch_address
+      cache.io.enable                 := io.instruction_valid
+      cache.io.invalidate             := id.io.if_fence_i
+      inst_fetch.io.rom_instruction   := cache.io.instruction
+      inst_fetch.io.instruction_valid := cache.io.instruction_valid
+    case None =>
+      inst_fetch.io.rom_instruction   := io.instruction
+      inst_fetch.io.instruction_valid := io.instruction_valid
+  }
 
   // Prediction signals from IF2ID pipeline register (all predictors)
   val btb_predicted    = if2id.io.output_btb_predicted_taken
@@ -174,7 +228,7 @@ class PipelinedCPU extends Module {
   val ras_pred_target  = if2id.io.output_ras_predicted_target
   val ibtb_predicted   = if2id.io.output_ibtb_predicted_valid
   val ibtb_pred_target = if2id.io.output_ibtb_predicted_target
-  val perceptron_predicted = if2id.io.output_perceptron_predicted_taken
+  val direction_predicted = if2id.io.output_direction_predicted_taken
 
   // Actual branch resolution from ID stage
   val actual_taken      = id.io.if_jump_flag
@@ -209,26 +263,30 @@ class PipelinedCPU extends Module {
   // Misprediction requires correction
   val btb_mispredict_raw = (btb_wrong_direction || btb_non_branch || btb_wrong_target) && !id.io.branch_hazard
 
+  // Sequential successor of the instruction in ID (PC+2 for a compressed one)
+  val id_next_address =
+    if2id.io.output_instruction_address + Mux(if2id.io.output_compressed, 2.U, 4.U)
+
   // BTB misprediction correction address:
-  // - Wrong direction or non-branch: redirect to PC+4 (sequential)
+  // - Wrong direction or non-branch: redirect to the sequential PC
   // - Wrong target: redirect to correct target
-  val btb_correction_addr_raw = Mux(btb_wrong_target, actual_target, if2id.io.output_instruction_address + 4.U)
+  val btb_correction_addr_raw = Mux(btb_wrong_target, actual_target, id_next_address)
 
-  // If a mispredict is detected during mem_stall, defer the correction until the stall releases.
+  // If a mispredict is detected during a stall, defer the correction until the stall releases.
   // Otherwise the correction pulse is lost (IF is stalled and IF2ID flush is suppressed).
   val btb_mispredict_pending      = RegInit(false.B)
   val btb_correction_addr_pending = RegInit(0.U(Parameters.AddrWidth))
 
-  when(mem_stall && btb_mispredict_raw) {
+  when(front_stall && btb_mispredict_raw) {
     btb_mispredict_pending      := true.B
     btb_correction_addr_pending := btb_correction_addr_raw
-  }.elsewhen(btb_mispredict_pending && !mem_stall) {
+  }.elsewhen(btb_mispredict_pending && !front_stall) {
     btb_mispredict_pending := false.B
   }
 
-  val btb_mispredict = btb_mispredict_raw || (btb_mispredict_pending && !mem_stall)
+  val btb_mispredict = btb_mispredict_raw || (btb_mispredict_pending && !front_stall)
   val btb_correction_addr_effective = Mux(
-    btb_mispredict_pending && !mem_stall,
+    btb_mispredict_pending && !front_stall,
     btb_correction_addr_pending,
     btb_correction_addr_raw
   )
@@ -240,7 +298,7 @@ class PipelinedCPU extends Module {
   // BTB update: update when branch/jump resolves in ID stage
   // Also invalidate on non-branch BTB hits to prevent future mispredictions
   val id_is_branch_or_jump = id.io.ctrl_jump_instruction
-  val btb_should_update    = (id_is_branch_or_jump || btb_non_branch) && !id.io.branch_hazard && !mem_stall
+  val btb_should_update    = (id_is_branch_or_jump || btb_non_branch) && !id.io.branch_hazard && !front_stall
   inst_fetch.io.btb_update_valid  := btb_should_update
   inst_fetch.io.btb_update_pc     := if2id.io.output_instruction_address
   inst_fetch.io.btb_update_target := id.io.if_jump_address
@@ -262,8 +320,8 @@ class PipelinedCPU extends Module {
 
   // Push on JAL/JALR with rd=link (call pattern)
   // Note: JALR with rd=link, rs1=link is a co-routine swap, still pushes
-  val ras_push_trigger = (is_jal || is_jalr) && rd_is_link && !id.io.branch_hazard && !mem_stall
-  val ras_push_addr    = if2id.io.output_instruction_address + 4.U // Return address = PC + 4
+  val ras_push_trigger = (is_jal || is_jalr) && rd_is_link && !id.io.branch_hazard && !front_stall
+  val ras_push_addr    = id_next_address // Return address = PC + 4 (PC + 2 for C.JAL/C.JALR)
 
   inst_fetch.io.ras_push      := ras_push_trigger
   inst_fetch.io.ras_push_addr := ras_push_addr
@@ -323,21 +381,21 @@ class PipelinedCPU extends Module {
   // Update with (PC, rs1_hash) → target mapping to improve future predictions
   // Uses forwarded rs1 value for hash calculation (same value used for target computation)
   val ibtb_rs1_hash      = IndirectBTBHash(id_reg1_data_forwarded)
-  val ibtb_should_update = is_indirect_jalr && !id.io.branch_hazard && !mem_stall
+  val ibtb_should_update = is_indirect_jalr && !id.io.branch_hazard && !front_stall
   inst_fetch.io.ibtb_update_valid    := ibtb_should_update
   inst_fetch.io.ibtb_update_pc       := if2id.io.output_instruction_address
   inst_fetch.io.ibtb_update_rs1_hash := ibtb_rs1_hash
   inst_fetch.io.ibtb_update_target   := actual_target
 
-  // Perceptron predictor update: train on all conditional branches when they resolve
-  // Update with actual outcome to train the perceptron weights
+  // Direction predictor update: train on all conditional branches when they resolve
+  // Update with actual outcome to train the perceptron weights or tournament counters
   val is_conditional_branch = id.io.ctrl_jump_instruction && !is_jal && !is_jalr
-  val perceptron_should_update = is_conditional_branch && !id.io.branch_hazard && !mem_stall
-  inst_fetch.io.perceptron_update_valid := perceptron_should_update
-  inst_fetch.io.perceptron_update_pc    := if2id.io.output_instruction_address
-  inst_fetch.io.perceptron_update_taken := actual_taken
+  val direction_should_update = is_conditional_branch && !id.io.branch_hazard && !front_stall
+  inst_fetch.io.direction_update_valid := direction_should_update
+  inst_fetch.io.direction_update_pc    := if2id.io.output_instruction_address
+  inst_fetch.io.direction_update_taken := actual_taken
 
-  if2id.io.stall := ctrl.io.if_stall || mem_stall
+  if2id.io.stall := ctrl.io.if_stall || front_stall
   // Suppress IF2ID flush during mem_stall!
   //
   // When a JAL/JALR triggers if_flush while mem_stall is active:
@@ -367,9 +425,10 @@ class PipelinedCPU extends Module {
   val prediction_correct = btb_correct_prediction || ras_correct_predict || ibtb_correct_predict
   val need_if_flush =
     (ctrl.io.if_flush && !prediction_correct) || btb_mispredict || ras_wrong_target || ibtb_wrong_target
-  if2id.io.flush                 := need_if_flush && !mem_stall
+  if2id.io.flush                 := need_if_flush && !front_stall
   if2id.io.instruction           := inst_fetch.io.id_instruction
   if2id.io.instruction_address   := inst_fetch.io.instruction_address
+  if2id.io.compressed            := inst_fetch.io.id_compressed
   if2id.io.interrupt_flag        := io.interrupt_flag
   if2id.io.btb_predicted_taken   := inst_fetch.io.btb_predicted_taken
   if2id.io.btb_predicted_target  := inst_fetch.io.btb_predicted_target
@@ -377,7 +436,7 @@ class PipelinedCPU extends Module {
   if2id.io.ras_predicted_target  := inst_fetch.io.ras_predicted_target
   if2id.io.ibtb_predicted_valid  := inst_fetch.io.ibtb_predicted_valid
   if2id.io.ibtb_predicted_target := inst_fetch.io.ibtb_predicted_target
-  if2id.io.perceptron_predicted_taken := inst_fetch.io.perceptron_predicted_taken
+  if2id.io.direction_predicted_taken := inst_fetch.io.direction_predicted_taken
 
   id.io.instruction               := if2id.io.output_instruction
   id.io.instruction_address       := if2id.io.output_instruction_address
@@ -391,7 +450,8 @@ class PipelinedCPU extends Module {
   id.io.interrupt_handler_address := clint.io.id_interrupt_handler_address
   id.io.branch_hazard             := ctrl.io.branch_hazard
 
-  id2ex.io.stall := mem_stall
+  id2ex.io.stall := front_stall
+  // Never flush id2ex under an iterating divide: it holds the divide itself.
   // Do not flush id2ex when mem_stall is active - except for JAL/JALR hazards!
   // When the memory is stalling (e.g., multi-cycle store), the id2ex register holds
   // the instruction waiting in EX stage. For load-use hazards, the flush is suppressed
@@ -401,9 +461,10 @@ class PipelinedCPU extends Module {
   // Without this, sw ra captures the stale register file value instead of waiting
   // for the correct forwarded PC+4 value from the JAL/JALR instruction.
   // This was the root cause of the vga_simple bug where sw ra saved 0x1050 instead of 0x125c.
-  id2ex.io.flush               := ctrl.io.id_flush && (!mem_stall || ctrl.io.jal_jalr_hazard)
+  id2ex.io.flush               := ctrl.io.id_flush && !div_stall && (!mem_stall || ctrl.io.jal_jalr_hazard)
   id2ex.io.instruction         := if2id.io.output_instruction
   id2ex.io.instruction_address := if2id.io.output_instruction_address
+  id2ex.io.compressed          := if2id.io.output_compressed
 
   // ID-stage forwarding values (defined earlier) passed to ID2EX pipeline register
   id2ex.io.reg1_data              := id_reg1_data_forwarded
@@ -420,6 +481,7 @@ class PipelinedCPU extends Module {
   id2ex.io.csr_address            := id.io.ex_csr_address
   id2ex.io.memory_read_enable     := id.io.ex_memory_read_enable
   id2ex.io.memory_write_enable    := id.io.ex_memory_write_enable
+  id2ex.io.memory_exclusive       := id.io.ex_memory_exclusive
   id2ex.io.csr_read_data          := csr_regs.io.id_reg_read_data
 
   ex.io.instruction         := id2ex.io.output_instruction
@@ -434,16 +496,21 @@ class PipelinedCPU extends Module {
   ex.io.forward_from_wb     := wb.io.regs_write_data
   ex.io.reg1_forward        := forwarding.io.reg1_forward_ex
   ex.io.reg2_forward        := forwarding.io.reg2_forward_ex
+  ex.io.hold                := mem_stall
 
   ex2mem.io.stall               := mem_stall
+  ex2mem.io.flush               := div_stall && !mem_stall
   ex2mem.io.regs_write_enable   := id2ex.io.output_regs_write_enable
   ex2mem.io.regs_write_source   := id2ex.io.output_regs_write_source
   ex2mem.io.regs_write_address  := id2ex.io.output_regs_write_address
   ex2mem.io.instruction_address := id2ex.io.output_instruction_address
+  ex2mem.io.compressed          := id2ex.io.output_compressed
+  ex2mem.io.instruction         := id2ex.io.output_instruction
   ex2mem.io.funct3              := id2ex.io.output_instruction(14, 12)
   ex2mem.io.reg2_data           := ex.io.mem_reg2_data
   ex2mem.io.memory_read_enable  := id2ex.io.output_memory_read_enable
   ex2mem.io.memory_write_enable := id2ex.io.output_memory_write_enable
+  ex2mem.io.memory_exclusive    := id2ex.io.output_memory_exclusive
   ex2mem.io.alu_result          := ex.io.mem_alu_result
   ex2mem.io.csr_read_data       := id2ex.io.output_csr_read_data
 
@@ -451,20 +518,37 @@ class PipelinedCPU extends Module {
   mem.io.reg2_data           := ex2mem.io.output_reg2_data
   mem.io.memory_read_enable  := ex2mem.io.output_memory_read_enable
   mem.io.memory_write_enable := ex2mem.io.output_memory_write_enable
+  mem.io.memory_exclusive    := ex2mem.io.output_memory_exclusive
   mem.io.funct3              := ex2mem.io.output_funct3
   mem.io.regs_write_source   := ex2mem.io.output_regs_write_source
   mem.io.regs_write_address  := ex2mem.io.output_regs_write_address
   mem.io.regs_write_enable   := ex2mem.io.output_regs_write_enable
   mem.io.csr_read_data       := ex2mem.io.output_csr_read_data
   mem.io.instruction_address := ex2mem.io.output_instruction_address // For JAL/JALR forwarding
-  io.device_select := mem.io.bus
+  mem.io.compressed          := ex2mem.io.output_compressed
+
+  // Optional data cache between MEM and the bus; only MMIO (and every access
+  // without the cache) reaches memory_bundle
+  def is_fence_i(instruction: UInt): Bool =
+    instruction(6, 0) === Instructions.fence && instruction(14, 12) === InstructionsTypeFence.fencei
+  val data_cache = Option.when(dcache.enabled)(Module(new DataCache(dcache)))
+  val data_bus = data_cache match {
+    case Some(cache) =>
+      cache.io.cpu <> mem.io.bus
+      cache.io.flush := is_fence_i(ex2mem.io.output_instruction)
+      cache.io.mem
+    case None => mem.io.bus
+  }
+  io.device_select := data_bus
     .address(Parameters.AddrBits - 1, Parameters.AddrBits - Parameters.SlaveDeviceCountBits)
-  io.memory_bundle <> mem.io.bus
-  io.memory_bundle.address := 0.U(Parameters.SlaveDeviceCountBits.W) ## mem.io.bus
+  io.memory_bundle <> data_bus
+  io.memory_bundle.address := 0.U(Parameters.SlaveDeviceCountBits.W) ## data_bus
     .address(Parameters.AddrBits - 1 - Parameters.SlaveDeviceCountBits, 0)
 
   mem2wb.io.stall               := mem_stall
   mem2wb.io.instruction_address := ex2mem.io.output_instruction_address
+  mem2wb.io.compressed          := ex2mem.io.output_compressed
+  mem2wb.io.instruction         := ex2mem.io.output_instruction
   mem2wb.io.alu_result          := ex2mem.io.output_alu_result
   // Use MEM stage's latched outputs instead of ex2mem outputs for ALL writeback signals
   // This preserves correct values when mem_stall releases (PipelineRegister bypass issue)
@@ -476,6 +560,7 @@ class PipelinedCPU extends Module {
   mem2wb.io.csr_read_data      := ex2mem.io.output_csr_read_data
 
   wb.io.instruction_address := mem2wb.io.output_instruction_address
+  wb.io.compressed          := mem2wb.io.output_compressed
   wb.io.alu_result          := mem2wb.io.output_alu_result
   wb.io.memory_read_data    := mem2wb.io.output_memory_read_data
   wb.io.regs_write_source   := mem2wb.io.output_regs_write_source
@@ -527,17 +612,18 @@ class PipelinedCPU extends Module {
   //
   // For now, we use a simpler but slightly imprecise metric:
   // - Count register-writing instructions in WB
-  // - Count stores when they complete (write_data_accepted)
+  // - Count stores as they leave WB (they have completed in MEM by then, whether
+  //   on the bus or into the D-cache store buffer)
   // This may undercount branches that don't write registers, but matches typical CPI analysis.
   val wb_instruction_valid = mem2wb.io.output_regs_write_enable
-  val store_completed      = mem.io.bus.write && mem.io.bus.write_valid // Store completes
+  val store_completed      = mem2wb.io.output_instruction(6, 0) === InstructionTypes.S
   csr_regs.io.instruction_retired := (wb_instruction_valid || store_completed) && !mem_stall
 
   // Branch misprediction: BTB, RAS, or IndirectBTB predicted wrong
   // Gate with !mem_stall to ensure single-cycle pulse.
   // - mem_stall: Pipeline frozen (would count same misprediction multiple times)
   // Note: All three signals already include !branch_hazard gating.
-  csr_regs.io.branch_misprediction := (btb_mispredict || ras_wrong_target || ibtb_wrong_target) && !mem_stall
+  csr_regs.io.branch_misprediction := (btb_mispredict || ras_wrong_target || ibtb_wrong_target) && !front_stall
 
   // Stall type breakdown for detailed performance analysis
   // Stall counters are mutually exclusive to avoid double-counting.
@@ -561,15 +647,16 @@ class PipelinedCPU extends Module {
   // 2. Next cycle: ID flushed with NOP → signals go low (no branch in ID)
   // 3. mem_stall gating prevents counting during stalls
   // 4. When stall releases, flush completes atomically
-  val control_flush_event = (need_if_flush || btb_mispredict || ras_wrong_target || ibtb_wrong_target) && !mem_stall
+  val control_flush_event = (need_if_flush || btb_mispredict || ras_wrong_target || ibtb_wrong_target) && !front_stall
   csr_regs.io.control_stall := control_flush_event
 
   // Hazard stalls (mhpmcounter4): Data hazards that cause pipeline bubbles (lowest priority)
   // - Load-use hazard: Instruction in ID needs result from load in EX/MEM
   // - JAL/JALR hazard: SW needs ra but JAL/JALR hasn't written it yet
   // - Branch hazard: Branch in ID needs ALU result from EX
+  // - Divide: cycles a divide spends iterating in EX
   // Only counted when not in a memory stall AND not a control flush (mutual exclusion).
-  csr_regs.io.hazard_stall := ctrl.io.pc_stall && !mem_stall && !control_flush_event
+  csr_regs.io.hazard_stall := (ctrl.io.pc_stall && !front_stall && !control_flush_event) || (div_stall && !mem_stall)
 
   // BTB miss penalty (mhpmcounter7): Branch/jump that incurs BTB-related penalty
   // Counts two types of BTB-related penalties:
@@ -582,7 +669,7 @@ class PipelinedCPU extends Module {
   val btb_miss_penalty = (
     (!btb_predicted && is_branch_or_jump && actual_taken) || // BTB miss (cold)
       btb_wrong_target                                       // BTB wrong target (stale)
-  ) && !id.io.branch_hazard && !mem_stall
+  ) && !id.io.branch_hazard && !front_stall
   csr_regs.io.btb_miss_taken := btb_miss_penalty
 
   // Total branches resolved (mhpmcounter8): All branch/jump instructions resolved in ID stage
@@ -592,7 +679,7 @@ class PipelinedCPU extends Module {
   // Does not count branches held due to branch_hazard (they'll be counted when they resolve).
   //
   // Pulse semantics: Single-cycle event per branch (branch_hazard and mem_stall gating).
-  csr_regs.io.branch_resolved := is_branch_or_jump && !id.io.branch_hazard && !mem_stall
+  csr_regs.io.branch_resolved := is_branch_or_jump && !id.io.branch_hazard && !front_stall
 
   // BTB predictions (mhpmcounter9): Count when BTB predicted "taken" for a resolved branch
   // This allows calculating BTB coverage: mhpmcounter9 / mhpmcounter8
@@ -600,21 +687,79 @@ class PipelinedCPU extends Module {
   // Note: Only counts predictions that actually resolved (excludes squashed predictions).
   //
   // Pulse semantics: Single-cycle event per prediction (branch_hazard and mem_stall gating).
-  csr_regs.io.btb_predicted := btb_predicted && is_branch_or_jump && !id.io.branch_hazard && !mem_stall
-
-  // Initialize unused CPUBundle signals (used by wrapper, not by pipeline core)
-  io.bus_address                                 := 0.U
-  io.axi4_channels.read_address_channel.ARADDR   := 0.U
-  io.axi4_channels.read_address_channel.ARPROT   := 0.U
-  io.axi4_channels.read_address_channel.ARVALID  := false.B
-  io.axi4_channels.read_data_channel.RREADY      := false.B
-  io.axi4_channels.write_address_channel.AWADDR  := 0.U
-  io.axi4_channels.write_address_channel.AWPROT  := 0.U
-  io.axi4_channels.write_address_channel.AWVALID := false.B
-  io.axi4_channels.write_data_channel.WDATA      := 0.U
-  io.axi4_channels.write_data_channel.WSTRB      := 0.U
-  io.axi4_channels.write_data_channel.WVALID     := false.B
-  io.axi4_channels.write_response_channel.BREADY := false.B
-  io.debug_bus_write_enable                      := false.B
-  io.debug_bus_write_data                        := 0.U
+  csr_regs.io.btb_predicted := btb_predicted && is_branch_or_jump && !id.io.branch_hazard && !front_stall
+
+  // I-cache hits (mhpmcounter10) and misses (mhpmcounter11)
+  // A hit counts once, on the cycle IF consumes it (not while IF is stalled);
+  // a miss counts once per line refill.
+  csr_regs.io.icache_hit  := inst_cache.fold(false.B)(_.io.hit && !inst_fetch.io.stall_flag_ctrl)
+  csr_regs.io.icache_miss := inst_cache.fold(false.B)(_.io.miss)
+
+  // D-cache misses (mhpmcounter12) and writebacks (mhpmcounter13), one per
+  // line allocation and per dirty line written back (victim or fence.i)
+  csr_regs.io.dcache_miss      := data_cache.fold(false.B)(_.io.miss)
+  csr_regs.io.dcache_writeback := data_cache.fold(false.B)(_.io.writeback)
+
+  // The same mhpmcounter3-6 increments for the harness per-PC profiler.
+  // Mispredictions, flushes and hazard stalls belong to the instruction in
+  // ID; a memory stall belongs to the load or store in MEM.
+  io.debug_perf_events := Cat(
+    control_flush_event,
+    mem_stall,
+    csr_regs.io.hazard_stall,
+    csr_regs.io.branch_misprediction
+  )
+  io.debug_perf_id_pc  := if2id.io.output_instruction_address
+  io.debug_perf_mem_pc := ex2mem.io.output_instruction_address
+
+  // fence.i: refill only once older stores have left EX and MEM, the data
+  // master has no write in flight and the D-cache has written its dirty
+  // lines back (its flush starts when the fence.i reaches MEM)
+  inst_cache.foreach { cache =>
+    val dcache_hold = data_cache.fold(false.B)(dc =>
+      dc.io.flushing || is_fence_i(id2ex.io.output_instruction) || is_fence_i(ex2mem.io.output_instruction)
+    )
+    cache.io.refill_hold := id2ex.io.output_memory_write_enable ||
+      ex2mem.io.output_memory_write_enable || io.memory_bundle.busy || dcache_hold
+  }
+
+  // Cache line transfers leave through axi4_channels; the wrapper shares the
+  // bus with the data-side AXI4LiteMaster
+  val line_masters = inst_cache.map(c => (c.io.channels, c.io.bus_address)).toSeq ++
+    data_cache.map(c => (c.io.channels, c.io.bus_address))
+  line_masters match {
+    case Seq() =>
+      // Initialize unused CPUBundle signals (used by wrapper, not by pipeline core)
+      io.bus_address                                 := 0.U
+      io.axi4_channels.read_address_channel.ARADDR   := 0.U
+      io.axi4_channels.read_address_channel.ARPROT   := 0.U
+      io.axi4_channels.read_address_channel.ARLEN    := 0.U
+      io.axi4_channels.read_address_channel.ARVALID  := false.B
+      io.axi4_channels.read_data_channel.RREADY      := false.B
+      io.axi4_channels.write_address_channel.AWADDR  := 0.U
+      io.axi4_channels.write_address_channel.AWPROT  := 0.U
+      io.axi4_channels.write_address_channel.AWLEN   := 0.U
+      io.axi4_channels.write_address_channel.AWVALID := false.B
+      io.axi4_channels.write_data_channel.WDATA      := 0.U
+      io.axi4_channels.write_data_channel.WSTRB      := 0.U
+      io.axi4_channels.write_data_channel.WLAST      := false.B
+      io.axi4_channels.write_data_channel.WVALID     := false.B
+      io.axi4_channels.write_response_channel.BREADY := false.B
+    case Seq((channels, address)) =>
+      io.axi4_channels <> channels
+      io.bus_address   := address
+    case masters =>
+      // D-cache (master 1) wins over I-cache refills (master 0)
+      val line_mux = Module(new AXI4MasterMux(masters.length, Parameters.AddrBits, Parameters.DataBits))
+      for (((channels, address), i) <- masters.zipWithIndex) {
+        line_mux.io.masters(i) <> channels
+        line_mux.io.addresses(i) := address
+        line_mux.io.exclusive(i) := false.B
+      }
+      io.axi4_channels <> line_mux.io.slave
+      io.bus_address   := line_mux.io.address
+  }
+  io.bus_exclusive          := false.B // line transfers are never exclusive
+  io.debug_bus_write_enable := false.B
+  io.debug_bus_write_data   := 0.U
 }
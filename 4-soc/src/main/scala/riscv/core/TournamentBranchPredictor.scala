@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv.core
+
+import chisel3._
+import chisel3.util._
+import riscv.Parameters
+
+/**
+ * Interface shared by the conditional-branch direction predictors, so
+ * InstructionFetch can instantiate either backend behind the same ports
+ */
+class DirectionPredictorIO extends Bundle {
+  // Prediction interface (IF stage) - combinational lookup
+  val pc              = Input(UInt(Parameters.AddrWidth))
+  val predicted_taken = Output(Bool())
+
+  // Update interface (ID stage) - registered update
+  val update_valid = Input(Bool())
+  val update_pc    = Input(UInt(Parameters.AddrWidth))
+  val update_taken = Input(Bool()) // Ground truth: was branch actually taken?
+}
+
+object DirectionPredictor {
+  val Perceptron = "perceptron"
+  val Tournament = "tournament"
+  val All        = Seq(Perceptron, Tournament)
+
+  /** Instantiate the backend selected by `config.direction` */
+  def apply(config: PredictorConfig): DirectionPredictorIO = config.direction match {
+    case Perceptron =>
+      Module(
+        new PerceptronBranchPredictor(
+          numPerceptrons = config.perceptrons,
+          historyLength = config.historyLength,
+          weightBits = config.weightBits,
+          trainingThreshold = config.trainingThreshold
+        )
+      ).io
+    case Tournament => Module(new TournamentBranchPredictor(config.phtEntries)).io
+  }
+}
+
+/**
+ * Tournament Branch Predictor (gshare + bimodal with a chooser)
+ *
+ * Alternative to PerceptronBranchPredictor with the same interface. Every
+ * lookup is one table read of a 2-bit counter, so the IF-stage path is an
+ * XOR and a mux where the perceptron needs an adder tree over all weights.
+ *
+ * Architecture:
+ * - Bimodal table: 2-bit counters indexed by PC; learns per-branch bias and
+ *   warms up quickly
+ * - Gshare table: 2-bit counters indexed by PC XOR global history; separates
+ *   branches that alias on PC alone (aliasing.c) and learns correlated
+ *   patterns
+ * - Chooser: 2-bit counters indexed by PC; >= 2 selects gshare
+ * - Global history: log2(entries) most recent outcomes, newest in bit 0
+ *
+ * Training (ID stage, when a conditional branch resolves):
+ * - Both tables move their counter toward the outcome
+ * - The chooser moves toward whichever table was right, only when they
+ *   disagreed
+ * - The outcome is shifted into the global history
+ *
+ * As in the perceptron, history is updated at resolution rather than
+ * speculatively, and the update recomputes the gshare index from the
+ * current history.
+ *
+ * Counters start at weakly taken (like a zero-weight perceptron) and the
+ * chooser at weakly bimodal.
+ *
+ * References:
+ * - McFarling, "Combining Branch Predictors" (DEC WRL TN-36, 1993)
+ *
+ * @param entries Counters in each of the three tables (power of 2)
+ */
+class TournamentBranchPredictor(entries: Int = 256) extends Module {
+  require(isPow2(entries) && entries >= 4, "Tournament table entries must be a power of 2 and >= 4")
+
+  val indexBits = log2Ceil(entries)
+
+  val io = IO(new DirectionPredictorIO)
+
+  val bimodal = RegInit(VecInit(Seq.fill(entries)(2.U(2.W))))
+  val gshare  = RegInit(VecInit(Seq.fill(entries)(2.U(2.W))))
+  val chooser = RegInit(VecInit(Seq.fill(entries)(1.U(2.W))))
+  val history = RegInit(0.U(indexBits.W))
+
+  // PC[indexBits+1:2], with PC[1] (RV32C) flipping the lowest bit as in the
+  // other predictors
+  def pcIndex(pc: UInt): UInt     = pc(indexBits + 1, 2) ^ pc(1)
+  def gshareIndex(pc: UInt): UInt = pcIndex(pc) ^ history
+
+  // ========== Prediction Logic (Combinational) ==========
+
+  val predIndex   = pcIndex(io.pc)
+  val bimodalPred = bimodal(predIndex)(1)
+  val gsharePred  = gshare(gshareIndex(io.pc))(1)
+  io.predicted_taken := Mux(chooser(predIndex)(1), gsharePred, bimodalPred)
+
+  // ========== Training Logic (Registered) ==========
+
+  when(io.update_valid) {
+    val trainIndex  = pcIndex(io.update_pc)
+    val trainGshare = gshareIndex(io.update_pc)
+    val bimodalOld  = bimodal(trainIndex)
+    val gshareOld   = gshare(trainGshare)
+
+    bimodal(trainIndex) := saturate(bimodalOld, io.update_taken)
+    gshare(trainGshare) := saturate(gshareOld, io.update_taken)
+
+    val bimodalRight = bimodalOld(1) === io.update_taken
+    val gshareRight  = gshareOld(1) === io.update_taken
+    when(bimodalRight =/= gshareRight) {
+      chooser(trainIndex) := saturate(chooser(trainIndex), gshareRight)
+    }
+
+    history := Cat(history(indexBits - 2, 0), io.update_taken)
+  }
+
+  /** 2-bit saturating counter step toward `up` */
+  def saturate(counter: UInt, up: Bool): UInt =
+    Mux(up, Mux(counter === 3.U, 3.U, counter + 1.U), Mux(counter === 0.U, 0.U, counter - 1.U))
+}
@@ -11,6 +11,7 @@ import riscv.Parameters
 class WriteBack extends Module {
   val io = IO(new Bundle() {
     val instruction_address = Input(UInt(Parameters.AddrWidth))
+    val compressed          = Input(Bool())
     val alu_result          = Input(UInt(Parameters.DataWidth))
     val memory_read_data    = Input(UInt(Parameters.DataWidth))
     val regs_write_source   = Input(UInt(2.W))
@@ -25,7 +26,7 @@ class WriteBack extends Module {
     IndexedSeq(
       RegWriteSource.Memory                 -> io.memory_read_data,
       RegWriteSource.CSR                    -> io.csr_read_data,
-      RegWriteSource.NextInstructionAddress -> (io.instruction_address + 4.U)
+      RegWriteSource.NextInstructionAddress -> (io.instruction_address + Mux(io.compressed, 2.U, 4.U))
     )
   )
 }
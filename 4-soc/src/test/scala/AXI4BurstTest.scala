@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+import bus.AXI4BurstMaster
+import bus.AXI4LiteMaster
+import bus.AXI4LiteSlave
+import chisel3._
+import chiseltest._
+import org.scalatest.flatspec.AnyFlatSpec
+import riscv.Parameters
+
+// AXI4BurstMaster against AXI4LiteSlave in front of a 16-word register memory.
+// Word i initially holds 0x1000_0000 + i.
+class BurstPair extends Module {
+  val io = IO(new Bundle {
+    val address    = Input(UInt(Parameters.AddrWidth))
+    val length     = Input(UInt(8.W))
+    val read       = Input(Bool())
+    val write      = Input(Bool())
+    val read_data  = Output(UInt(Parameters.DataWidth))
+    val read_valid = Output(Bool())
+    val beat       = Output(UInt(8.W))
+    val done       = Output(Bool())
+    val mem        = Output(Vec(16, UInt(Parameters.DataWidth)))
+  })
+
+  val master = Module(new AXI4BurstMaster(Parameters.AddrBits, Parameters.DataBits))
+  val slave  = Module(new AXI4LiteSlave(Parameters.AddrBits, Parameters.DataBits))
+  master.io.channels <> slave.io.channels
+
+  val mem = RegInit(VecInit(Seq.tabulate(16)(i => (0x10000000 + i).U(Parameters.DataWidth))))
+  io.mem := mem
+
+  master.io.bundle.address := io.address
+  master.io.bundle.length  := io.length
+  master.io.bundle.read    := io.read
+  master.io.bundle.write   := io.write
+  // Beat i of a write stores (i + 1) * 0x11111111
+  master.io.bundle.write_data   := ((master.io.bundle.beat +& 1.U) * "h11111111".U)(31, 0)
+  master.io.bundle.write_strobe := VecInit(Seq.fill(Parameters.WordSize)(true.B))
+
+  val index = slave.io.bundle.address(5, 2)
+  slave.io.bundle.read_data  := mem(index)
+  slave.io.bundle.read_valid := slave.io.bundle.read
+  when(slave.io.bundle.write) {
+    mem(index) := slave.io.bundle.write_data
+  }
+
+  io.read_data  := master.io.bundle.read_data
+  io.read_valid := master.io.bundle.read_valid
+  io.beat       := master.io.bundle.beat
+  io.done       := master.io.bundle.done
+}
+
+// AXI4LiteMaster fetching `words` consecutive words one transaction at a time
+class SingleBeatReader(words: Int) extends Module {
+  val io = IO(new Bundle {
+    val done = Output(Bool())
+  })
+
+  val master = Module(new AXI4LiteMaster(Parameters.AddrBits, Parameters.DataBits))
+  val slave  = Module(new AXI4LiteSlave(Parameters.AddrBits, Parameters.DataBits))
+  master.io.channels <> slave.io.channels
+
+  val received = RegInit(0.U(8.W))
+  when(master.io.bundle.read_valid) {
+    received := received + 1.U
+  }
+
+  master.io.bundle.address      := received << 2
+  master.io.bundle.read         := received =/= words.U && !master.io.bundle.read_valid
+  master.io.bundle.write        := false.B
+  master.io.bundle.write_data   := 0.U
+  master.io.bundle.write_strobe := VecInit(Seq.fill(Parameters.WordSize)(false.B))
+
+  slave.io.bundle.read_data  := slave.io.bundle.address
+  slave.io.bundle.read_valid := slave.io.bundle.read
+
+  io.done := received === words.U
+}
+
+class AXI4BurstTest extends AnyFlatSpec with ChiselScalatestTester {
+  behavior.of("AXI4BurstMaster and AXI4LiteSlave")
+
+  // Runs one 8-beat read from word 4 and returns the cycles it took
+  def burstRead(dut: BurstPair): Int = {
+    dut.io.address.poke(0x10.U)
+    dut.io.length.poke(7.U)
+    dut.io.read.poke(true.B)
+    dut.io.write.poke(false.B)
+    dut.clock.step()
+    dut.io.read.poke(false.B)
+
+    var cycles = 1
+    var beats  = 0
+    while (!dut.io.done.peek().litToBoolean && cycles < 100) {
+      if (dut.io.read_valid.peek().litToBoolean) {
+        dut.io.beat.expect(beats.U)
+        dut.io.read_data.expect((0x10000004L + beats).U)
+        beats += 1
+      }
+      dut.clock.step()
+      cycles += 1
+    }
+    assert(dut.io.done.peek().litToBoolean, s"Burst read did not complete in $cycles cycles")
+    // read_valid of the last beat comes with done
+    dut.io.read_valid.expect(true.B)
+    dut.io.beat.expect(7.U)
+    dut.io.read_data.expect(0x1000000bL.U)
+    assert(beats == 7, s"Expected 7 beats before the last, got $beats")
+    cycles
+  }
+
+  it should "read an 8-beat burst in order" in {
+    test(new BurstPair).withAnnotations(Seq(WriteVcdAnnotation)) { dut =>
+      dut.clock.setTimeout(200)
+      burstRead(dut)
+    }
+  }
+
+  it should "write a 4-beat burst to consecutive words" in {
+    test(new BurstPair).withAnnotations(Seq(WriteVcdAnnotation)) { dut =>
+      dut.clock.setTimeout(200)
+      dut.io.address.poke(0x20.U)
+      dut.io.length.poke(3.U)
+      dut.io.read.poke(false.B)
+      dut.io.write.poke(true.B)
+      dut.clock.step()
+      dut.io.write.poke(false.B)
+
+      var cycles = 1
+      while (!dut.io.done.peek().litToBoolean && cycles < 100) {
+        dut.clock.step()
+        cycles += 1
+      }
+      assert(dut.io.done.peek().litToBoolean, s"Burst write did not complete in $cycles cycles")
+
+      for (i <- 0 until 16) {
+        val expected = if (i >= 8 && i < 12) 0x11111111L * (i - 7) else 0x10000000L + i
+        dut.io.mem(i).expect(expected.U, s"word $i")
+      }
+    }
+  }
+
+  it should "move 8 words in fewer cycles than 8 single reads" in {
+    var burst = 0
+    test(new BurstPair) { dut =>
+      dut.clock.setTimeout(200)
+      burst = burstRead(dut)
+    }
+
+    var single = 0
+    test(new SingleBeatReader(8)) { dut =>
+      dut.clock.setTimeout(200)
+      while (!dut.io.done.peek().litToBoolean && single < 150) {
+        dut.clock.step()
+        single += 1
+      }
+      assert(dut.io.done.peek().litToBoolean, s"Single reads did not complete in $single cycles")
+    }
+
+    assert(burst * 3 < single * 2, s"Burst took $burst cycles, single-beat reads $single")
+  }
+}
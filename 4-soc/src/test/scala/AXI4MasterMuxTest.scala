@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+import bus.AXI4LiteMaster
+import bus.AXI4LiteSlave
+import bus.AXI4MasterMux
+import bus.MasterArbitration
+import chisel3._
+import chiseltest._
+import org.scalatest.flatspec.AnyFlatSpec
+import riscv.Parameters
+import riscv.TestAnnotations
+
+// Two AXI4LiteMasters sharing a 16-word memory through the mux
+class MasterMuxHarness(arbitration: String) extends Module {
+  val io = IO(new Bundle {
+    val address    = Input(Vec(2, UInt(Parameters.AddrWidth)))
+    val read       = Input(Vec(2, Bool()))
+    val write      = Input(Vec(2, Bool()))
+    val exclusive  = Input(Vec(2, Bool()))
+    val write_data = Input(Vec(2, UInt(Parameters.DataWidth)))
+
+    val read_data          = Output(Vec(2, UInt(Parameters.DataWidth)))
+    val read_valid         = Output(Vec(2, Bool()))
+    val write_valid        = Output(Vec(2, Bool()))
+    val write_exclusive_ok = Output(Vec(2, Bool()))
+    val grants             = Output(Vec(2, UInt(32.W)))
+    val wait_cycles        = Output(Vec(2, UInt(32.W)))
+    val mem                = Output(Vec(16, UInt(Parameters.DataWidth)))
+  })
+
+  val mux = Module(
+    new AXI4MasterMux(2, Parameters.AddrBits, Parameters.DataBits, arbitration, exclusiveMonitor = true)
+  )
+  for (i <- 0 until 2) {
+    val master = Module(new AXI4LiteMaster(Parameters.AddrBits, Parameters.DataBits))
+    master.io.bundle.address      := io.address(i)
+    master.io.bundle.read         := io.read(i)
+    master.io.bundle.write        := io.write(i)
+    master.io.bundle.write_data   := io.write_data(i)
+    master.io.bundle.write_strobe := VecInit(Seq.fill(Parameters.WordSize)(true.B))
+    mux.io.masters(i) <> master.io.channels
+    mux.io.addresses(i) := io.address(i)
+    mux.io.exclusive(i) := io.exclusive(i)
+
+    io.read_data(i)          := master.io.bundle.read_data
+    io.read_valid(i)         := master.io.bundle.read_valid
+    io.write_valid(i)        := master.io.bundle.write_valid
+    io.write_exclusive_ok(i) := master.io.bundle.write_exclusive_ok
+  }
+  io.grants      := mux.io.grants
+  io.wait_cycles := mux.io.wait_cycles
+
+  val slave = Module(new AXI4LiteSlave(Parameters.AddrBits, Parameters.DataBits))
+  slave.io.channels <> mux.io.slave
+
+  val mem   = RegInit(VecInit(Seq.fill(16)(0.U(Parameters.DataWidth))))
+  val index = slave.io.bundle.address(5, 2)
+  slave.io.bundle.read_data  := mem(index)
+  slave.io.bundle.read_valid := slave.io.bundle.read
+  when(slave.io.bundle.write) {
+    mem(index) := slave.io.bundle.write_data
+  }
+  io.mem := mem
+}
+
+class AXI4MasterMuxTest extends AnyFlatSpec with ChiselScalatestTester {
+  behavior.of("AXI4MasterMux")
+
+  private def idle(dut: MasterMuxHarness): Unit =
+    for (i <- 0 until 2) {
+      dut.io.read(i).poke(false.B)
+      dut.io.write(i).poke(false.B)
+      dut.io.exclusive(i).poke(false.B)
+    }
+
+  // One access by master m; returns the read data or the EXOKAY flag
+  private def access(
+      dut: MasterMuxHarness,
+      m: Int,
+      address: Int,
+      write: Option[Int],
+      exclusive: Boolean = false
+  ): BigInt = {
+    dut.io.address(m).poke(address.U)
+    dut.io.exclusive(m).poke(exclusive.B)
+    dut.io.write_data(m).poke(write.getOrElse(0).U)
+    dut.io.read(m).poke(write.isEmpty.B)
+    dut.io.write(m).poke(write.isDefined.B)
+    dut.clock.step()
+    dut.io.read(m).poke(false.B)
+    dut.io.write(m).poke(false.B)
+    var cycles = 0
+    while (!dut.io.read_valid(m).peek().litToBoolean && !dut.io.write_valid(m).peek().litToBoolean) {
+      assert(cycles < 50, s"master $m access to 0x${address.toHexString} did not complete")
+      dut.clock.step()
+      cycles += 1
+    }
+    val result: BigInt =
+      if (write.isEmpty) dut.io.read_data(m).peek().litValue
+      else if (dut.io.write_exclusive_ok(m).peek().litToBoolean) 1
+      else 0
+    dut.clock.step()
+    dut.io.exclusive(m).poke(false.B)
+    result
+  }
+
+  it should "let a reserved store-conditional through with EXOKAY" in {
+    test(new MasterMuxHarness(MasterArbitration.Priority)).withAnnotations(TestAnnotations.annos) { dut =>
+      idle(dut)
+      access(dut, 0, 0x10, Some(41))
+      assert(access(dut, 0, 0x10, None, exclusive = true) == 41)
+      assert(access(dut, 0, 0x10, Some(42), exclusive = true) == 1)
+      dut.io.mem(4).expect(42.U)
+      // The write consumed the reservation
+      assert(access(dut, 0, 0x10, Some(43), exclusive = true) == 0)
+      dut.io.mem(4).expect(42.U)
+    }
+  }
+
+  it should "fail a store-conditional after another master's store" in {
+    test(new MasterMuxHarness(MasterArbitration.Priority)).withAnnotations(TestAnnotations.annos) { dut =>
+      idle(dut)
+      access(dut, 0, 0x20, None, exclusive = true)
+      access(dut, 1, 0x24, None, exclusive = true)
+      access(dut, 1, 0x20, Some(7))
+      assert(access(dut, 0, 0x20, Some(8), exclusive = true) == 0)
+      dut.io.mem(8).expect(7.U)
+      // Master 1's reservation of another word survived
+      assert(access(dut, 1, 0x24, Some(9), exclusive = true) == 1)
+      dut.io.mem(9).expect(9.U)
+    }
+  }
+
+  it should "share the bus evenly under round-robin and count the waits" in {
+    test(new MasterMuxHarness(MasterArbitration.RoundRobin)).withAnnotations(TestAnnotations.annos) { dut =>
+      idle(dut)
+      for (i <- 0 until 2) {
+        dut.io.address(i).poke((4 * i).U)
+        dut.io.write_data(i).poke(i.U)
+        dut.io.write(i).poke(true.B)
+      }
+      dut.clock.step(200)
+      val grants = (0 until 2).map(i => dut.io.grants(i).peek().litValue)
+      assert(grants.forall(_ > 10), s"grants $grants")
+      assert((grants(0) - grants(1)).abs <= 1, s"grants $grants")
+      assert((0 until 2).forall(i => dut.io.wait_cycles(i).peek().litValue > 0))
+    }
+  }
+}
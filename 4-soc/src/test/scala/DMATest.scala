@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+import bus.AXI4LiteMaster
+import bus.AXI4LiteSlave
+import chisel3._
+import chiseltest._
+import org.scalatest.flatspec.AnyFlatSpec
+import peripheral.DMA
+import riscv.Parameters
+import riscv.TestAnnotations
+
+// An AXI4LiteMaster programs the DMA registers; the DMA moves words in a
+// 64-word register memory behind an AXI4LiteSlave. Word i initially holds
+// 0x1000_0000 + i.
+class DMAHarness extends Module {
+  val io = IO(new Bundle {
+    val address     = Input(UInt(8.W))
+    val read        = Input(Bool())
+    val write       = Input(Bool())
+    val write_data  = Input(UInt(Parameters.DataWidth))
+    val read_data   = Output(UInt(Parameters.DataWidth))
+    val read_valid  = Output(Bool())
+    val write_valid = Output(Bool())
+    val interrupt   = Output(Bool())
+    val mem         = Output(Vec(64, UInt(Parameters.DataWidth)))
+  })
+
+  val dma = Module(new DMA(burstWords = 8))
+  dma.io.bus_wait_cycles := 0.U
+  io.interrupt           := dma.io.interrupt
+
+  val cpu = Module(new AXI4LiteMaster(8, Parameters.DataBits))
+  cpu.io.bundle.address      := io.address
+  cpu.io.bundle.read         := io.read
+  cpu.io.bundle.write        := io.write
+  cpu.io.bundle.write_data   := io.write_data
+  cpu.io.bundle.write_strobe := VecInit(Seq.fill(Parameters.WordSize)(true.B))
+  dma.io.channels <> cpu.io.channels
+  io.read_data   := cpu.io.bundle.read_data
+  io.read_valid  := cpu.io.bundle.read_valid
+  io.write_valid := cpu.io.bundle.write_valid
+
+  val slave = Module(new AXI4LiteSlave(Parameters.AddrBits, Parameters.DataBits))
+  slave.io.channels <> dma.io.master
+
+  val mem   = RegInit(VecInit(Seq.tabulate(64)(i => (0x10000000 + i).U(Parameters.DataWidth))))
+  val index = slave.io.bundle.address(7, 2)
+  slave.io.bundle.read_data  := mem(index)
+  slave.io.bundle.read_valid := slave.io.bundle.read
+  when(slave.io.bundle.write) {
+    mem(index) := slave.io.bundle.write_data
+  }
+  io.mem := mem
+}
+
+class DMATest extends AnyFlatSpec with ChiselScalatestTester {
+  behavior.of("DMA")
+
+  // One register access; returns the read data (0 for a write)
+  private def access(dut: DMAHarness, offset: Int, write: Option[BigInt]): BigInt = {
+    dut.io.address.poke(offset.U)
+    dut.io.write_data.poke(write.getOrElse(BigInt(0)).U)
+    dut.io.read.poke(write.isEmpty.B)
+    dut.io.write.poke(write.isDefined.B)
+    dut.clock.step()
+    dut.io.read.poke(false.B)
+    dut.io.write.poke(false.B)
+    var cycles = 0
+    while (!dut.io.read_valid.peek().litToBoolean && !dut.io.write_valid.peek().litToBoolean) {
+      assert(cycles < 50, s"register access to 0x${offset.toHexString} did not complete")
+      dut.clock.step()
+      cycles += 1
+    }
+    val result = if (write.isEmpty) dut.io.read_data.peek().litValue else BigInt(0)
+    dut.clock.step()
+    result
+  }
+
+  private def read(dut: DMAHarness, offset: Int): BigInt              = access(dut, offset, None)
+  private def write(dut: DMAHarness, offset: Int, value: BigInt): Unit = access(dut, offset, Some(value))
+
+  private def run(dut: DMAHarness, src: Int, dst: Int, count: Int, ctrl: Int): Unit = {
+    write(dut, DMA.SRC, src)
+    write(dut, DMA.DST, dst)
+    write(dut, DMA.COUNT, count)
+    write(dut, DMA.CTRL, ctrl | (1 << DMA.CtrlStart))
+    var polls = 0
+    while ((read(dut, DMA.STATUS) & (1 << DMA.StatusBusy)) != 0) {
+      assert(polls < 200, "transfer did not finish")
+      polls += 1
+    }
+  }
+
+  private def initial(i: Int): BigInt = BigInt(0x10000000 + i)
+
+  it should "copy across burst chunks and leave the pointers past the transfer" in {
+    test(new DMAHarness).withAnnotations(TestAnnotations.annos) { dut =>
+      dut.io.read.poke(false.B)
+      dut.io.write.poke(false.B)
+      // 20 words: two full 8-word bursts and a 4-word one
+      run(dut, 0x00, 0x80, 20, 0)
+      for (i <- 0 until 20)
+        dut.io.mem(32 + i).expect(initial(i).U)
+      dut.io.mem(52).expect(initial(52).U)
+      assert(read(dut, DMA.SRC) == 0x50)
+      assert(read(dut, DMA.DST) == 0xd0)
+      assert(read(dut, DMA.COUNT) == 0)
+      assert(read(dut, DMA.WORDS) == 20)
+      assert(read(dut, DMA.TRANSFERS) == 1)
+      assert(read(dut, DMA.BUSY_CYCLES) > 0)
+      assert((read(dut, DMA.STATUS) & (1 << DMA.StatusDone)) != 0)
+    }
+  }
+
+  it should "gather with a source stride and fill with a fixed word" in {
+    test(new DMAHarness).withAnnotations(TestAnnotations.annos) { dut =>
+      dut.io.read.poke(false.B)
+      dut.io.write.poke(false.B)
+      // Every second word of 0..9 into 40..44, one beat per source word
+      write(dut, DMA.SRC_STRIDE, 8)
+      run(dut, 0x00, 0xa0, 5, 0)
+      for (i <- 0 until 5)
+        dut.io.mem(40 + i).expect(initial(2 * i).U)
+      assert(read(dut, DMA.SRC) == 0x28)
+
+      // memset of 10 words from word 48
+      write(dut, DMA.FILL, BigInt("deadbeef", 16))
+      run(dut, 0x00, 0xc0, 10, 1 << DMA.CtrlFill)
+      for (i <- 48 until 58)
+        dut.io.mem(i).expect(BigInt("deadbeef", 16).U)
+      dut.io.mem(58).expect(initial(58).U)
+      // The fill read nothing
+      assert(read(dut, DMA.SRC) == 0)
+
+      // A destination stride of 0 keeps writing one word, as to a data port
+      write(dut, DMA.SRC_STRIDE, 4)
+      write(dut, DMA.DST_STRIDE, 0)
+      run(dut, 0x00, 0xf0, 6, 0)
+      dut.io.mem(60).expect(initial(5).U)
+      dut.io.mem(61).expect(initial(61).U)
+      assert(read(dut, DMA.WORDS) == 21)
+      assert(read(dut, DMA.TRANSFERS) == 3)
+    }
+  }
+
+  it should "raise the completion interrupt until DONE is cleared" in {
+    test(new DMAHarness).withAnnotations(TestAnnotations.annos) { dut =>
+      dut.io.read.poke(false.B)
+      dut.io.write.poke(false.B)
+      run(dut, 0x00, 0x80, 4, 1 << DMA.CtrlIrqEnable)
+      dut.io.interrupt.expect(true.B)
+      write(dut, DMA.STATUS, 1 << DMA.StatusDone)
+      dut.io.interrupt.expect(false.B)
+      assert(read(dut, DMA.STATUS) == 0)
+
+      // Descriptor writes while busy are ignored
+      write(dut, DMA.SRC, 0)
+      write(dut, DMA.DST, 0x80)
+      write(dut, DMA.COUNT, 32)
+      write(dut, DMA.CTRL, (1 << DMA.CtrlStart) | (1 << DMA.CtrlIrqEnable))
+      write(dut, DMA.COUNT, 1)
+      while ((read(dut, DMA.STATUS) & (1 << DMA.StatusBusy)) != 0) {}
+      dut.io.interrupt.expect(true.B)
+      assert(read(dut, DMA.WORDS) == 36)
+
+      // START with COUNT = 0 completes at once
+      write(dut, DMA.STATUS, 1 << DMA.StatusDone)
+      write(dut, DMA.CTRL, 1 << DMA.CtrlStart)
+      assert(read(dut, DMA.STATUS) == (1 << DMA.StatusDone))
+      dut.io.interrupt.expect(false.B)
+      assert(read(dut, DMA.TRANSFERS) == 3)
+    }
+  }
+}
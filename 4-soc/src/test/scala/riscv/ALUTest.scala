@@ -139,6 +139,28 @@ class ALUTest extends AnyFlatSpec with ChiselScalatestTester {
 
   // ==================== Special Operations ====================
 
+  // ==================== Multiply (RV32M) ====================
+
+  it should "perform MUL (low word) correctly" in {
+    test(new ALU).withAnnotations(TestAnnotations.annos) { dut =>
+      assert(runALU(dut, ALUFunctions.mul, 6, 7) == 42)
+      assert(runALU(dut, ALUFunctions.mul, 0xffffffffL, 3) == 0xfffffffdL) // -1 * 3
+      assert(runALU(dut, ALUFunctions.mul, 0x10000L, 0x10000L) == 0) // 2^32 wraps
+    }
+  }
+
+  it should "perform MULH, MULHSU and MULHU (high word) correctly" in {
+    test(new ALU).withAnnotations(TestAnnotations.annos) { dut =>
+      assert(runALU(dut, ALUFunctions.mulh, 0x10000L, 0x10000L) == 1)
+      assert(runALU(dut, ALUFunctions.mulh, 0xffffffffL, 3) == 0xffffffffL) // -3 >> 32
+      assert(runALU(dut, ALUFunctions.mulh, 0x80000000L, 0x80000000L) == 0x40000000L)
+      assert(runALU(dut, ALUFunctions.mulhsu, 0xffffffffL, 0xffffffffL) == 0xffffffffL)
+      assert(runALU(dut, ALUFunctions.mulhsu, 2, 0x80000000L) == 1)
+      assert(runALU(dut, ALUFunctions.mulhu, 0xffffffffL, 0xffffffffL) == 0xfffffffeL)
+      assert(runALU(dut, ALUFunctions.mulhu, 0x80000000L, 2) == 1)
+    }
+  }
+
   it should "output zero for ALUFunctions.zero" in {
     test(new ALU).withAnnotations(TestAnnotations.annos) { dut =>
       assert(runALU(dut, ALUFunctions.zero, 0xffffffffL, 0xffffffffL) == 0)
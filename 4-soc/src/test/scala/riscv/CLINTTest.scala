@@ -87,6 +87,25 @@ class CLINTTest extends AnyFlatSpec with ChiselScalatestTester {
     }
   }
 
+  it should "assert software interrupt (flag bit 2) only with MSIE" in {
+    test(new CLINT).withAnnotations(TestAnnotations.annos) { dut =>
+      setupDefaultCSR(dut, mie = 0x880) // MTIE and MEIE, MSIE clear
+      dut.io.interrupt_flag.poke(0x4.U)
+      dut.io.instruction_id.poke(0.U)
+      dut.io.instruction_address_if.poke(0x1000.U)
+      dut.io.jump_flag.poke(false.B)
+      dut.io.jump_address.poke(0.U)
+
+      dut.clock.step()
+      dut.io.id_interrupt_assert.expect(false.B)
+
+      dut.io.csr_bundle.mie.poke(0x8.U) // MSIE (bit 3)
+      dut.clock.step()
+      dut.io.id_interrupt_assert.expect(true.B)
+      dut.io.csr_bundle.mcause_write_data.expect(0x80000003L.U) // Machine software interrupt
+    }
+  }
+
   it should "handle ECALL instruction correctly" in {
     test(new CLINT).withAnnotations(TestAnnotations.annos) { dut =>
       setupDefaultCSR(dut)
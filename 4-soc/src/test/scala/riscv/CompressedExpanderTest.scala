@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv
+
+import chisel3._
+import chiseltest._
+import org.scalatest.flatspec.AnyFlatSpec
+import riscv.core.CompressedExpander
+
+class CompressedExpanderWrapper extends Module {
+  val io = IO(new Bundle {
+    val half       = Input(UInt(16.W))
+    val expanded   = Output(UInt(Parameters.InstructionWidth))
+    val compressed = Output(Bool())
+  })
+  io.expanded   := CompressedExpander(io.half)
+  io.compressed := CompressedExpander.isCompressed(io.half)
+}
+
+class CompressedExpanderTest extends AnyFlatSpec with ChiselScalatestTester {
+  behavior.of("CompressedExpander")
+
+  def check(dut: CompressedExpanderWrapper, cases: Seq[(Int, Long, String)]): Unit =
+    for ((half, expected, name) <- cases) {
+      dut.io.half.poke(half.U)
+      dut.io.compressed.expect(true.B, name)
+      dut.io.expanded.expect(expected.U, f"$name: 0x$half%04x")
+    }
+
+  it should "expand the quadrant 0 loads, stores and c.addi4spn" in {
+    test(new CompressedExpanderWrapper).withAnnotations(TestAnnotations.annos) { dut =>
+      check(
+        dut,
+        Seq(
+          (0x0808, 0x01010513L, "c.addi4spn a0, sp, 16"),
+          (0x41c8, 0x0045a503L, "c.lw a0, 4(a1)"),
+          (0xc588, 0x00a5a423L, "c.sw a0, 8(a1)")
+        )
+      )
+    }
+  }
+
+  it should "expand the quadrant 1 immediates, ALU forms, jumps and branches" in {
+    test(new CompressedExpanderWrapper).withAnnotations(TestAnnotations.annos) { dut =>
+      check(
+        dut,
+        Seq(
+          (0x0001, 0x00000013L, "c.nop"),
+          (0x0505, 0x00150513L, "c.addi a0, 1"),
+          (0x557d, 0xfff00513L, "c.li a0, -1"),
+          (0x717d, 0xff010113L, "c.addi16sp sp, -16"),
+          (0x6505, 0x00001537L, "c.lui a0, 0x1"),
+          (0x757d, 0xfffff537L, "c.lui a0, 0xfffff"),
+          (0x810d, 0x00355513L, "c.srli a0, 3"),
+          (0x850d, 0x40355513L, "c.srai a0, 3"),
+          (0x997d, 0xfff57513L, "c.andi a0, -1"),
+          (0x8d0d, 0x40b50533L, "c.sub a0, a1"),
+          (0x8d6d, 0x00b57533L, "c.and a0, a1"),
+          (0x2801, 0x010000efL, "c.jal 16"),
+          (0xbff5, 0xffdff06fL, "c.j -4"),
+          (0xc501, 0x00050463L, "c.beqz a0, 8"),
+          (0xfd7d, 0xfe051fe3L, "c.bnez a0, -2")
+        )
+      )
+    }
+  }
+
+  it should "expand the quadrant 2 stack accesses, moves and register jumps" in {
+    test(new CompressedExpanderWrapper).withAnnotations(TestAnnotations.annos) { dut =>
+      check(
+        dut,
+        Seq(
+          (0x050a, 0x00251513L, "c.slli a0, 2"),
+          (0x40b2, 0x00c12083L, "c.lwsp ra, 12(sp)"),
+          (0xc606, 0x00112623L, "c.swsp ra, 12(sp)"),
+          (0x852e, 0x00b00533L, "c.mv a0, a1"),
+          (0x952e, 0x00b50533L, "c.add a0, a1"),
+          (0x8082, 0x00008067L, "c.jr ra"),
+          (0x9782, 0x000780e7L, "c.jalr a5"),
+          (0x9002, 0x00100073L, "c.ebreak")
+        )
+      )
+    }
+  }
+
+  it should "expand illegal and reserved encodings to 0" in {
+    test(new CompressedExpanderWrapper).withAnnotations(TestAnnotations.annos) { dut =>
+      check(
+        dut,
+        Seq(
+          (0x0000, 0L, "all zero"),
+          (0x6000, 0L, "c.flw"),
+          (0x6101, 0L, "c.addi16sp sp, 0"),
+          (0x9d0d, 0L, "c.subw"),
+          (0x150a, 0L, "c.slli with shamt[5]"),
+          (0x4002, 0L, "c.lwsp x0"),
+          (0x8002, 0L, "c.jr x0")
+        )
+      )
+    }
+  }
+
+  it should "only treat halfwords with bits 1:0 != 11 as compressed" in {
+    test(new CompressedExpanderWrapper).withAnnotations(TestAnnotations.annos) { dut =>
+      dut.io.half.poke(0x0013.U)
+      dut.io.compressed.expect(false.B)
+      dut.io.half.poke(0x8082.U)
+      dut.io.compressed.expect(true.B)
+    }
+  }
+}
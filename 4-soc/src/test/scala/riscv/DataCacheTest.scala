@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv
+
+import bus.AXI4LiteSlave
+import chisel3._
+import chiseltest._
+import org.scalatest.flatspec.AnyFlatSpec
+import riscv.core.DataCache
+import riscv.core.DCacheConfig
+
+// DataCache with its line port on AXI4LiteSlave in front of a 64-word register
+// memory (word i initially 0x1000_0000 + i) and its MMIO port on a device that
+// answers one cycle after each access with 0xc0de_0000 | address.
+class DCachePair(config: DCacheConfig) extends Module {
+  val io = IO(new Bundle {
+    val request      = Input(Bool())
+    val read         = Input(Bool())
+    val write        = Input(Bool())
+    val address      = Input(UInt(Parameters.AddrWidth))
+    val write_data   = Input(UInt(Parameters.DataWidth))
+    val write_strobe = Input(Vec(Parameters.WordSize, Bool()))
+    val flush        = Input(Bool())
+    val read_data    = Output(UInt(Parameters.DataWidth))
+    val read_valid   = Output(Bool())
+    val write_valid  = Output(Bool())
+    val flushing     = Output(Bool())
+    val writebacks   = Output(UInt(8.W))
+    val mmio_writes  = Output(UInt(8.W))
+    val mem          = Output(Vec(64, UInt(Parameters.DataWidth)))
+  })
+
+  val cache = Module(new DataCache(config))
+  val slave = Module(new AXI4LiteSlave(Parameters.AddrBits, Parameters.DataBits))
+  cache.io.channels <> slave.io.channels
+
+  val mem = RegInit(VecInit(Seq.tabulate(64)(i => (0x10000000 + i).U(Parameters.DataWidth))))
+  slave.io.bundle.read_data  := mem(slave.io.bundle.address(7, 2))
+  slave.io.bundle.read_valid := slave.io.bundle.read
+  when(slave.io.bundle.write) {
+    mem(slave.io.bundle.address(7, 2)) := slave.io.bundle.write_data
+  }
+  io.mem := mem
+
+  val pending       = RegInit(false.B)
+  val pending_write = RegInit(false.B)
+  val pending_addr  = RegInit(0.U(Parameters.AddrWidth))
+  val mmio_writes   = RegInit(0.U(8.W))
+  when(!pending && cache.io.mem.request && (cache.io.mem.read || cache.io.mem.write)) {
+    pending       := true.B
+    pending_write := cache.io.mem.write
+    pending_addr  := cache.io.mem.address
+  }
+  when(pending) {
+    pending := false.B
+    when(pending_write) {
+      mmio_writes := mmio_writes + 1.U
+    }
+  }
+  cache.io.mem.granted             := !pending
+  cache.io.mem.busy                := pending
+  cache.io.mem.read_valid          := pending && !pending_write
+  cache.io.mem.write_valid         := pending && pending_write
+  cache.io.mem.write_data_accepted := pending && pending_write
+  cache.io.mem.write_exclusive_ok  := false.B
+  cache.io.mem.read_data           := "hc0de0000".U | pending_addr(15, 0)
+  io.mmio_writes                   := mmio_writes
+
+  val writebacks = RegInit(0.U(8.W))
+  when(cache.io.writeback) {
+    writebacks := writebacks + 1.U
+  }
+  io.writebacks := writebacks
+
+  cache.io.cpu.request      := io.request
+  cache.io.cpu.read         := io.read
+  cache.io.cpu.write        := io.write
+  cache.io.cpu.address      := io.address
+  cache.io.cpu.write_data   := io.write_data
+  cache.io.cpu.write_strobe := io.write_strobe
+  cache.io.cpu.exclusive    := false.B
+  cache.io.flush            := io.flush
+
+  io.read_data   := cache.io.cpu.read_data
+  io.read_valid  := cache.io.cpu.read_valid
+  io.write_valid := cache.io.cpu.write_valid
+  io.flushing    := cache.io.flushing
+}
+
+class DataCacheTest extends AnyFlatSpec with ChiselScalatestTester {
+  behavior.of("Data Cache")
+
+  def idle(dut: DCachePair): Unit = {
+    dut.io.request.poke(false.B)
+    dut.io.read.poke(false.B)
+    dut.io.write.poke(false.B)
+    dut.io.flush.poke(false.B)
+  }
+
+  // One access driven the way MemoryAccess does: read/write with request for
+  // the issuing cycle, then request alone until read_valid/write_valid.
+  // Returns the cycles waited (0 = answered at once) and the read data.
+  def access(dut: DCachePair, address: Long, write: Boolean, data: Long = 0, strobe: Int = 0xf): (Int, BigInt) = {
+    dut.io.address.poke(address.U)
+    dut.io.write_data.poke(data.U)
+    for (i <- 0 until Parameters.WordSize) {
+      dut.io.write_strobe(i).poke(((strobe >> i) & 1) == 1)
+    }
+    dut.io.request.poke(true.B)
+    dut.io.read.poke((!write).B)
+    dut.io.write.poke(write.B)
+    def done = (if (write) dut.io.write_valid else dut.io.read_valid).peek().litToBoolean
+
+    var cycles = 0
+    if (!done) {
+      dut.clock.step()
+      dut.io.read.poke(false.B)
+      dut.io.write.poke(false.B)
+      cycles = 1
+      while (!done && cycles < 200) {
+        dut.clock.step()
+        cycles += 1
+      }
+    }
+    assert(done, f"access to 0x$address%x did not finish after $cycles cycles")
+    val result = dut.io.read_data.peekInt()
+    dut.clock.step()
+    idle(dut)
+    (cycles, result)
+  }
+
+  def load(dut: DCachePair, address: Long): (Int, BigInt) = access(dut, address, write = false)
+
+  def store(dut: DCachePair, address: Long, data: Long, strobe: Int = 0xf): Int =
+    access(dut, address, write = true, data, strobe)._1
+
+  def settle(dut: DCachePair): Unit = dut.clock.step(50)
+
+  it should "refill a line on a load miss and then hit it without waiting" in {
+    test(new DCachePair(DCacheConfig(sets = 4, ways = 1, lineWords = 4))).withAnnotations(TestAnnotations.annos) {
+      dut =>
+        idle(dut)
+        val (miss, first) = load(dut, 0x10)
+        assert(miss > 0)
+        assert(first == 0x10000004L)
+        for (word <- 4 until 8) {
+          assert(load(dut, word * 4) == (0, BigInt(0x10000000L + word)))
+        }
+    }
+  }
+
+  it should "accept stores at once, merge bytes and write dirty lines back only on eviction" in {
+    test(new DCachePair(DCacheConfig(sets = 2, ways = 1, lineWords = 4))).withAnnotations(TestAnnotations.annos) {
+      dut =>
+        idle(dut)
+        assert(store(dut, 0x04, 0xdeadbeefL) == 0)
+        assert(store(dut, 0x04, 0x11, strobe = 0x1) == 0)
+        assert(load(dut, 0x04)._2 == 0xdeadbe11L)
+        settle(dut)
+        dut.io.mem(1).expect(0x10000001L.U, "write-back: RAM untouched while the line is cached")
+        dut.io.writebacks.expect(0.U)
+
+        // 0x20 maps to the same set and evicts the dirty line
+        assert(load(dut, 0x20)._2 == 0x10000008L)
+        dut.io.writebacks.expect(1.U)
+        dut.io.mem(1).expect(0xdeadbe11L.U)
+        dut.io.mem(0).expect(0x10000000L.U)
+    }
+  }
+
+  it should "write every dirty line back on flush and keep it cached" in {
+    test(new DCachePair(DCacheConfig(sets = 2, ways = 2, lineWords = 4))).withAnnotations(TestAnnotations.annos) {
+      dut =>
+        idle(dut)
+        store(dut, 0x08, 0x00100093L)
+        store(dut, 0x34, 0x12345678L)
+        dut.io.flush.poke(true.B)
+        dut.clock.step()
+        dut.io.flush.poke(false.B)
+        var cycles = 0
+        while (dut.io.flushing.peek().litToBoolean && cycles < 200) {
+          dut.clock.step()
+          cycles += 1
+        }
+        dut.io.flushing.expect(false.B)
+        dut.io.mem(2).expect(0x00100093L.U)
+        dut.io.mem(13).expect(0x12345678L.U)
+        dut.io.writebacks.expect(2.U)
+        assert(load(dut, 0x08) == (0, BigInt(0x00100093L)))
+    }
+  }
+
+  it should "send MMIO around the cache, behind buffered stores" in {
+    test(new DCachePair(DCacheConfig(sets = 4, ways = 1, lineWords = 4))).withAnnotations(TestAnnotations.annos) {
+      dut =>
+        idle(dut)
+        assert(store(dut, 0x00, 0x55L) == 0)
+        // The buffered store still needs its line, so the device write waits
+        assert(store(dut, 0x20000010L, 0x1L) > 1)
+        dut.io.mmio_writes.expect(1.U)
+        val (_, data) = load(dut, 0x20000024L)
+        assert(data == 0xc0de0024L)
+        assert(load(dut, 0x00) == (0, BigInt(0x55)))
+    }
+  }
+
+  it should "send the harness mailbox around the cache like MMIO" in {
+    test(new DCachePair(DCacheConfig(sets = 4, ways = 1, lineWords = 4))).withAnnotations(TestAnnotations.annos) {
+      dut =>
+        idle(dut)
+        // TEST_RESULT then TEST_DONE_FLAG: both leave at once, in order
+        assert(store(dut, 0x104, 0x1fL) > 0)
+        dut.io.mmio_writes.expect(1.U)
+        assert(store(dut, 0x100, 0xcafef00dL) > 0)
+        dut.io.mmio_writes.expect(2.U)
+        // Neither allocated a line: the mailbox words are not cached
+        val (_, data) = load(dut, 0x104)
+        assert(data == 0xc0de0104L)
+        settle(dut)
+        dut.io.writebacks.expect(0.U)
+    }
+  }
+}
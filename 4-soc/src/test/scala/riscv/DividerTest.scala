@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv
+
+import chisel3._
+import chiseltest._
+import org.scalatest.flatspec.AnyFlatSpec
+import riscv.core.Divider
+
+class DividerTest extends AnyFlatSpec with ChiselScalatestTester {
+  behavior.of("Divider")
+
+  val DIV  = 4
+  val DIVU = 5
+  val REM  = 6
+  val REMU = 7
+
+  // Hold one divide in "EX" until ready; returns (result, cycles waited)
+  def divide(dut: Divider, funct3: Int, op1: Long, op2: Long): (Long, Int) = {
+    dut.io.valid.poke(true.B)
+    dut.io.hold.poke(false.B)
+    dut.io.funct3.poke(funct3.U)
+    dut.io.op1.poke((op1 & 0xffffffffL).U)
+    dut.io.op2.poke((op2 & 0xffffffffL).U)
+    var cycles = 0
+    while (!dut.io.ready.peek().litToBoolean && cycles < 40) {
+      dut.clock.step()
+      cycles += 1
+    }
+    assert(dut.io.ready.peek().litToBoolean, s"no result after $cycles cycles")
+    val result = dut.io.result.peekInt().toLong & 0xffffffffL
+    dut.clock.step()
+    dut.io.valid.poke(false.B)
+    (result, cycles)
+  }
+
+  def reference(funct3: Int, op1: Long, op2: Long): Long = {
+    val a = op1.toInt
+    val b = op2.toInt
+    val ua = op1 & 0xffffffffL
+    val ub = op2 & 0xffffffffL
+    val value = funct3 match {
+      case DIV  => if (b == 0) -1L else if (a == Int.MinValue && b == -1) a.toLong else (a / b).toLong
+      case DIVU => if (ub == 0) 0xffffffffL else ua / ub
+      case REM  => if (b == 0) a.toLong else if (a == Int.MinValue && b == -1) 0L else (a % b).toLong
+      case REMU => if (ub == 0) ua else ua % ub
+    }
+    value & 0xffffffffL
+  }
+
+  it should "match the RV32M results for signed and unsigned operands" in {
+    test(new Divider).withAnnotations(TestAnnotations.annos) { dut =>
+      val operands = Seq(
+        (100L, 7L),
+        (-100L, 7L),
+        (100L, -7L),
+        (-100L, -7L),
+        (0xffffffffL, 1L),
+        (0x80000000L, 3L),
+        (0x7fffffffL, 0x7fffffffL),
+        (0x12345678L, 0x1234L),
+        (1L, 0x80000000L)
+      )
+      for ((op1, op2) <- operands; funct3 <- Seq(DIV, DIVU, REM, REMU)) {
+        val (result, _) = divide(dut, funct3, op1, op2)
+        assert(result == reference(funct3, op1, op2), f"funct3=$funct3 0x$op1%x / 0x$op2%x")
+      }
+    }
+  }
+
+  it should "answer divide by zero, overflow and small dividends without iterating" in {
+    test(new Divider).withAnnotations(TestAnnotations.annos) { dut =>
+      assert(divide(dut, DIV, 42, 0) == (0xffffffffL, 0))
+      assert(divide(dut, REMU, 42, 0) == (42L, 0))
+      assert(divide(dut, DIV, 0x80000000L, -1) == (0x80000000L, 0))
+      assert(divide(dut, REM, 0x80000000L, -1) == (0L, 0))
+      assert(divide(dut, DIVU, 3, 10) == (0L, 0))
+      assert(divide(dut, REM, -3, 10) == (0xfffffffdL, 0))
+    }
+  }
+
+  it should "iterate only over the quotient bits that can be set" in {
+    test(new Divider).withAnnotations(TestAnnotations.annos) { dut =>
+      // clz(divisor) - clz(dividend) + 1 iterations, plus the start cycle
+      assert(divide(dut, DIVU, 9, 5) == (1L, 3))
+      assert(divide(dut, DIVU, 0xffffffffL, 1)._2 == 33)
+      assert(divide(dut, DIVU, 1000, 10) == (100L, 8))
+    }
+  }
+
+  it should "keep a finished result while hold is set" in {
+    test(new Divider).withAnnotations(TestAnnotations.annos) { dut =>
+      dut.io.valid.poke(true.B)
+      dut.io.hold.poke(false.B)
+      dut.io.funct3.poke(DIVU.U)
+      dut.io.op1.poke(1000.U)
+      dut.io.op2.poke(10.U)
+      dut.clock.step(8)
+      dut.io.ready.expect(true.B)
+      dut.io.hold.poke(true.B)
+      dut.clock.step(3)
+      dut.io.ready.expect(true.B)
+      dut.io.result.expect(100.U)
+    }
+  }
+}
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv
+
+import bus.AXI4LiteSlave
+import chisel3._
+import chiseltest._
+import org.scalatest.flatspec.AnyFlatSpec
+import riscv.core.ICacheConfig
+import riscv.core.InstructionCache
+
+// InstructionCache refilling from AXI4LiteSlave in front of a 64-word
+// register memory. Word i initially holds 0x1000_0000 + i; poke/poke_index
+// overwrite a word directly, standing in for a store.
+class ICachePair(config: ICacheConfig) extends Module {
+  val io = IO(new Bundle {
+    val pc                = Input(UInt(Parameters.AddrWidth))
+    val invalidate        = Input(Bool())
+    val refill_hold       = Input(Bool())
+    val poke              = Input(Bool())
+    val poke_index        = Input(UInt(6.W))
+    val poke_data         = Input(UInt(Parameters.DataWidth))
+    val instruction       = Output(UInt(Parameters.InstructionWidth))
+    val instruction_valid = Output(Bool())
+    val miss              = Output(Bool())
+  })
+
+  val cache = Module(new InstructionCache(config))
+  val slave = Module(new AXI4LiteSlave(Parameters.AddrBits, Parameters.DataBits))
+  cache.io.channels <> slave.io.channels
+
+  val mem = RegInit(VecInit(Seq.tabulate(64)(i => (0x10000000 + i).U(Parameters.DataWidth))))
+  slave.io.bundle.read_data  := mem(slave.io.bundle.address(7, 2))
+  slave.io.bundle.read_valid := slave.io.bundle.read
+  when(io.poke) {
+    mem(io.poke_index) := io.poke_data
+  }
+
+  cache.io.pc          := io.pc
+  cache.io.enable      := true.B
+  cache.io.invalidate  := io.invalidate
+  cache.io.refill_hold := io.refill_hold
+
+  io.instruction       := cache.io.instruction
+  io.instruction_valid := cache.io.instruction_valid
+  io.miss              := cache.io.miss
+}
+
+class InstructionCacheTest extends AnyFlatSpec with ChiselScalatestTester {
+  behavior.of("Instruction Cache")
+
+  def idle(dut: ICachePair): Unit = {
+    dut.io.invalidate.poke(false.B)
+    dut.io.refill_hold.poke(false.B)
+    dut.io.poke.poke(false.B)
+  }
+
+  // Step until pc hits; returns the cycles waited
+  def fetch(dut: ICachePair, pc: Int): Int = {
+    dut.io.pc.poke(pc.U)
+    var cycles = 0
+    while (!dut.io.instruction_valid.peek().litToBoolean && cycles < 100) {
+      dut.clock.step()
+      cycles += 1
+    }
+    assert(dut.io.instruction_valid.peek().litToBoolean, f"0x$pc%x did not hit after $cycles cycles")
+    cycles
+  }
+
+  it should "refill a line on a miss and then hit every word of it" in {
+    test(new ICachePair(ICacheConfig(sets = 4, ways = 1, lineWords = 4))).withAnnotations(TestAnnotations.annos) {
+      dut =>
+        idle(dut)
+        dut.io.pc.poke(0x14.U)
+        dut.io.instruction_valid.expect(false.B)
+        dut.io.miss.expect(true.B)
+        assert(fetch(dut, 0x14) > 0)
+        dut.io.instruction.expect(0x10000005L.U)
+
+        for (word <- 4 until 8) {
+          dut.io.pc.poke((word * 4).U)
+          dut.io.instruction_valid.expect(true.B)
+          dut.io.instruction.expect((0x10000000L + word).U)
+          dut.io.miss.expect(false.B)
+        }
+    }
+  }
+
+  it should "keep two conflicting lines in a 2-way set" in {
+    test(new ICachePair(ICacheConfig(sets = 2, ways = 2, lineWords = 4))).withAnnotations(TestAnnotations.annos) {
+      dut =>
+        idle(dut)
+        // 0x00 and 0x20 map to set 0
+        fetch(dut, 0x00)
+        fetch(dut, 0x20)
+        dut.io.pc.poke(0x00.U)
+        dut.io.instruction_valid.expect(true.B)
+        dut.io.instruction.expect(0x10000000L.U)
+        dut.io.pc.poke(0x24.U)
+        dut.io.instruction_valid.expect(true.B)
+        dut.io.instruction.expect(0x10000009L.U)
+
+        // A third line evicts the least recently used one (0x00)
+        fetch(dut, 0x40)
+        dut.io.pc.poke(0x20.U)
+        dut.io.instruction_valid.expect(true.B)
+        dut.io.pc.poke(0x00.U)
+        dut.io.instruction_valid.expect(false.B)
+    }
+  }
+
+  it should "refetch modified code after invalidate, once refill_hold drops" in {
+    test(new ICachePair(ICacheConfig(sets = 4, ways = 1, lineWords = 4))).withAnnotations(TestAnnotations.annos) {
+      dut =>
+        idle(dut)
+        fetch(dut, 0x08)
+        dut.io.instruction.expect(0x10000002L.U)
+
+        // Store to the cached word, then fence.i with the store still draining
+        dut.io.poke.poke(true.B)
+        dut.io.poke_index.poke(2.U)
+        dut.io.poke_data.poke("h00100093".U)
+        dut.io.invalidate.poke(true.B)
+        dut.io.refill_hold.poke(true.B)
+        dut.clock.step()
+        dut.io.poke.poke(false.B)
+        dut.io.invalidate.poke(false.B)
+
+        for (_ <- 0 until 5) {
+          dut.io.instruction_valid.expect(false.B)
+          dut.io.miss.expect(false.B)
+          dut.clock.step()
+        }
+
+        dut.io.refill_hold.poke(false.B)
+        fetch(dut, 0x08)
+        dut.io.instruction.expect("h00100093".U)
+    }
+  }
+}
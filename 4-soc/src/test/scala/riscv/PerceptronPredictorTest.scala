@@ -8,6 +8,7 @@ import chisel3._
 import chiseltest._
 import org.scalatest.flatspec.AnyFlatSpec
 import riscv.core.PerceptronBranchPredictor
+import riscv.core.PredictorConfig
 
 class PerceptronBranchPredictorTest extends AnyFlatSpec with ChiselScalatestTester {
   behavior.of("Perceptron Branch Predictor")
@@ -158,4 +159,35 @@ class PerceptronBranchPredictorTest extends AnyFlatSpec with ChiselScalatestTest
       assert(prediction == true || prediction == false)
     }
   }
+
+  it should "train at the smallest and largest sweep sizes" in {
+    val sizes = Seq(
+      PredictorConfig(perceptrons = 4, historyLength = 4),
+      PredictorConfig(perceptrons = 32, historyLength = 12)
+    )
+    for (cfg <- sizes) {
+      test(
+        new PerceptronBranchPredictor(cfg.perceptrons, cfg.historyLength, cfg.weightBits, cfg.trainingThreshold)
+      ).withAnnotations(TestAnnotations.annos) { dut =>
+        val branchPC = 0x1000L
+        for (_ <- 0 until 10) {
+          dut.io.update_valid.poke(true.B)
+          dut.io.update_pc.poke(branchPC.U)
+          dut.io.update_taken.poke(false.B)
+          dut.clock.step()
+        }
+        dut.io.update_valid.poke(false.B)
+        dut.io.pc.poke(branchPC.U)
+        dut.clock.step()
+        dut.io.predicted_taken.expect(false.B)
+      }
+    }
+  }
+
+  it should "count predictor state bits from the configured sizes" in {
+    val base = PredictorConfig()
+    assert(base.perceptronBits == 8 * 8 * 8 + 7)
+    assert(PredictorConfig(btbEntries = 64).btbBits > base.btbBits)
+    assert(PredictorConfig(rasDepth = 8).stateBits == base.stateBits + 4 * 32 + 1)
+  }
 }
@@ -47,6 +47,13 @@ object WriteVcdEnabler {
   }
 }
 
+// FAST_LOAD=1: TestTopModule preloads the program instead of booting
+// through ROMLoader (see TestTopModule); any other value, e.g. FAST_LOAD=0
+// passed through make, keeps the ROMLoader boot
+object FastLoadEnabler {
+  val enabled = sys.env.get("FAST_LOAD").contains("1")
+}
+
 object TestAnnotations {
   val annos = VerilatorEnabler.annos ++ WriteVcdEnabler.annos
 }
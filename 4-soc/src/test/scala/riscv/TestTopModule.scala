@@ -8,12 +8,17 @@ import bus.AXI4LiteSlave
 import chisel3._
 import peripheral.InstructionROM
 import peripheral.Memory
+import peripheral.MemoryImage
 import peripheral.ROMLoader
 import riscv.core.CPU
 
 // Simplified test harness for RISCOF compliance tests
 // Uses AXI4-Lite to connect CPU to Memory, matching the 4-soc architecture
-class TestTopModule(exeFilename: String) extends Module {
+//
+// preload (FAST_LOAD=1): the program is placed in Memory through $readmemh
+// and the CPU starts at once, instead of ROMLoader copying one word per clock
+// for the whole image before load_finished.
+class TestTopModule(exeFilename: String, preload: Boolean = FastLoadEnabler.enabled) extends Module {
   val io = IO(new Bundle {
     val regs_debug_read_address = Input(UInt(Parameters.PhysicalRegisterAddrWidth))
     val mem_debug_read_address  = Input(UInt(Parameters.AddrWidth))
@@ -24,13 +29,21 @@ class TestTopModule(exeFilename: String) extends Module {
     val interrupt_flag          = Input(UInt(Parameters.InterruptFlagWidth))
   })
 
-  val mem             = Module(new Memory(8192))
-  val instruction_rom = Module(new InstructionROM(exeFilename))
-  val rom_loader      = Module(new ROMLoader(instruction_rom.capacity))
+  val image = Option.when(preload)(MemoryImage(exeFilename))
+  val mem   = Module(new Memory(8192, image))
+  // Clock steps a preloaded run saves, ROMLoader copying one word per clock
+  val boot_cycles_saved = image.fold(0)(_.words)
 
-  rom_loader.io.rom_data     := instruction_rom.io.data
-  rom_loader.io.load_address := Parameters.EntryAddress
-  instruction_rom.io.address := rom_loader.io.rom_address
+  val rom_loader = Option.unless(preload) {
+    val instruction_rom = Module(new InstructionROM(exeFilename))
+    val rom_loader      = Module(new ROMLoader(instruction_rom.capacity))
+
+    rom_loader.io.rom_data     := instruction_rom.io.data
+    rom_loader.io.load_address := Parameters.EntryAddress
+    instruction_rom.io.address := rom_loader.io.rom_address
+    rom_loader
+  }
+  val load_finished = rom_loader.fold(true.B)(_.io.load_finished)
 
   // Clock divider for CPU (4:1 ratio for AXI4-Lite timing compatibility)
   val CPU_clkdiv = RegInit(UInt(2.W), 0.U)
@@ -48,7 +61,7 @@ class TestTopModule(exeFilename: String) extends Module {
 
     cpu.io.debug_read_address     := 0.U
     cpu.io.csr_debug_read_address := 0.U
-    cpu.io.instruction_valid      := rom_loader.io.load_finished
+    cpu.io.instruction_valid      := load_finished
 
     // Instruction fetch from memory
     mem.io.instruction_address := cpu.io.instruction_address
@@ -60,16 +73,18 @@ class TestTopModule(exeFilename: String) extends Module {
     mem_slave.io.channels <> cpu.io.axi4_channels
 
     // Memory connections using Mux to select between ROM loading and normal operation
-    val loading = !rom_loader.io.load_finished
+    val loading = !load_finished
 
     // Memory bundle connections (select between ROMLoader and AXI slave)
-    mem.io.bundle.address      := Mux(loading, rom_loader.io.bundle.address, mem_slave.io.bundle.address)
-    mem.io.bundle.write_data   := Mux(loading, rom_loader.io.bundle.write_data, mem_slave.io.bundle.write_data)
-    mem.io.bundle.write_enable := Mux(loading, rom_loader.io.bundle.write_enable, mem_slave.io.bundle.write)
-    mem.io.bundle.write_strobe := Mux(loading, rom_loader.io.bundle.write_strobe, mem_slave.io.bundle.write_strobe)
+    def fromLoader[T <: Data](loader: ROMLoader => T, slave: T): T =
+      rom_loader.fold(slave)(r => Mux(loading, loader(r), slave))
+    mem.io.bundle.address      := fromLoader(_.io.bundle.address, mem_slave.io.bundle.address)
+    mem.io.bundle.write_data   := fromLoader(_.io.bundle.write_data, mem_slave.io.bundle.write_data)
+    mem.io.bundle.write_enable := fromLoader(_.io.bundle.write_enable, mem_slave.io.bundle.write)
+    mem.io.bundle.write_strobe := fromLoader(_.io.bundle.write_strobe, mem_slave.io.bundle.write_strobe)
 
     // ROMLoader read_data (always connect to memory, not used during loading)
-    rom_loader.io.bundle.read_data := mem.io.bundle.read_data
+    rom_loader.foreach(_.io.bundle.read_data := mem.io.bundle.read_data)
 
     // AXI slave read responses
     // Memory is SyncReadMem with 1-cycle read latency.
@@ -93,6 +108,7 @@ class TestTopModule(exeFilename: String) extends Module {
     cpu.io.memory_bundle.read_valid          := false.B
     cpu.io.memory_bundle.write_valid         := false.B
     cpu.io.memory_bundle.write_data_accepted := false.B
+    cpu.io.memory_bundle.write_exclusive_ok  := false.B
     cpu.io.memory_bundle.busy                := false.B
     cpu.io.memory_bundle.granted             := true.B
   }
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+// MyCPU is freely redistributable under the MIT License. See the file
+// "LICENSE" for information on usage and redistribution of this file.
+
+package riscv
+
+import chisel3._
+import chiseltest._
+import org.scalatest.flatspec.AnyFlatSpec
+import riscv.core.PredictorConfig
+import riscv.core.TournamentBranchPredictor
+
+class TournamentBranchPredictorTest extends AnyFlatSpec with ChiselScalatestTester {
+  behavior.of("Tournament Branch Predictor")
+
+  private def train(dut: TournamentBranchPredictor, pc: Long, taken: Boolean): Unit = {
+    dut.io.update_valid.poke(true.B)
+    dut.io.update_pc.poke(pc.U)
+    dut.io.update_taken.poke(taken.B)
+    dut.clock.step()
+    dut.io.update_valid.poke(false.B)
+  }
+
+  it should "initially predict taken (counters start weakly taken)" in {
+    test(new TournamentBranchPredictor()).withAnnotations(TestAnnotations.annos) { dut =>
+      dut.io.update_valid.poke(false.B)
+      dut.io.pc.poke(0x1000.U)
+      dut.io.predicted_taken.expect(true.B)
+    }
+  }
+
+  it should "learn to predict not taken after training with not-taken branches" in {
+    test(new TournamentBranchPredictor()).withAnnotations(TestAnnotations.annos) { dut =>
+      for (_ <- 0 until 4) train(dut, 0x1000L, taken = false)
+      dut.io.pc.poke(0x1000.U)
+      dut.io.predicted_taken.expect(false.B)
+    }
+  }
+
+  it should "keep separate counters for different branches" in {
+    test(new TournamentBranchPredictor()).withAnnotations(TestAnnotations.annos) { dut =>
+      for (_ <- 0 until 4) train(dut, 0x1000L, taken = false)
+      dut.io.pc.poke(0x1004.U)
+      dut.io.predicted_taken.expect(true.B)
+      // PC[1] selects a different entry for a compressed branch at PC+2
+      dut.io.pc.poke(0x1002.U)
+      dut.io.predicted_taken.expect(true.B)
+    }
+  }
+
+  it should "separate PC-aliased branches through global history" in {
+    // With 4 entries, 0x1000 and 0x1010 share the bimodal and chooser entry,
+    // so only gshare can tell the always-taken one from the never-taken one
+    test(new TournamentBranchPredictor(entries = 4)).withAnnotations(TestAnnotations.annos) { dut =>
+      for (_ <- 0 until 12) {
+        train(dut, 0x1000L, taken = true)
+        train(dut, 0x1010L, taken = false)
+      }
+      dut.io.pc.poke(0x1000.U)
+      dut.io.predicted_taken.expect(true.B)
+      train(dut, 0x1000L, taken = true)
+      dut.io.pc.poke(0x1010.U)
+      dut.io.predicted_taken.expect(false.B)
+    }
+  }
+
+  it should "count its state bits in place of the perceptron's" in {
+    val tournament = PredictorConfig(direction = "tournament", phtEntries = 128)
+    assert(tournament.directionBits == 3 * 128 * 2 + 7)
+    val perceptron = PredictorConfig()
+    assert(tournament.stateBits - tournament.directionBits == perceptron.stateBits - perceptron.perceptronBits)
+  }
+}
@@ -293,10 +293,12 @@ class UARTTest extends AnyFlatSpec with ChiselScalatestTester {
     dut.io.channels.write_address_channel.AWVALID.poke(true.B)
     dut.io.channels.write_address_channel.AWADDR.poke(addr.U)
     dut.io.channels.write_address_channel.AWPROT.poke(0.U)
+    dut.io.channels.write_address_channel.AWLEN.poke(0.U)
     // Write data channel
     dut.io.channels.write_data_channel.WVALID.poke(true.B)
     dut.io.channels.write_data_channel.WDATA.poke(data.U)
     dut.io.channels.write_data_channel.WSTRB.poke(0xf.U)
+    dut.io.channels.write_data_channel.WLAST.poke(true.B)
     // Response channel ready
     dut.io.channels.write_response_channel.BREADY.poke(true.B)
 
@@ -321,6 +323,7 @@ class UARTTest extends AnyFlatSpec with ChiselScalatestTester {
     dut.io.channels.read_address_channel.ARVALID.poke(true.B)
     dut.io.channels.read_address_channel.ARADDR.poke(addr.U)
     dut.io.channels.read_address_channel.ARPROT.poke(0.U)
+    dut.io.channels.read_address_channel.ARLEN.poke(0.U)
     // Read data channel ready
     dut.io.channels.read_data_channel.RREADY.poke(true.B)
 
@@ -470,6 +473,115 @@ class UARTTest extends AnyFlatSpec with ChiselScalatestTester {
     }
   }
 
+  /** Helper: Drive one 8N1 frame into rxd, LSB first */
+  def sendRxByte(dut: Uart, byte: Int): Unit = {
+    dut.io.rxd.poke(0.U)
+    dut.clock.step(bitCycles)
+    for (i <- 0 until 8) {
+      dut.io.rxd.poke(((byte >> i) & 1).U)
+      dut.clock.step(bitCycles)
+    }
+    dut.io.rxd.poke(1.U)
+    dut.clock.step(bitCycles + 5)
+  }
+
+  /**
+   * Helper: Decode the frames on txd for the given number of cycles. Capture
+   * may begin mid-frame, so the first start bit must follow two stop bits'
+   * worth of idle line.
+   */
+  def captureTx(dut: Uart, cycles: Int): Seq[Int] = {
+    val bytes   = Seq.newBuilder[Int]
+    var elapsed = 0
+    var highRun = 0
+    while (elapsed < cycles) {
+      val line = dut.io.txd.peekInt()
+      if (line == 0 && highRun >= 2 * bitCycles - 1) {
+        // Start bit: sample the middle of each data bit, then skip the stop bits
+        dut.clock.step(bitCycles + bitCycles / 2)
+        var byte = 0
+        for (i <- 0 until 8) {
+          byte |= dut.io.txd.peekInt().toInt << i
+          dut.clock.step(bitCycles)
+        }
+        dut.clock.step(bitCycles)
+        elapsed += 10 * bitCycles + bitCycles / 2
+        bytes += byte
+        highRun = 2 * bitCycles // frames may follow back to back
+      } else {
+        highRun = if (line == 1) highRun + 1 else 0
+        dut.clock.step()
+        elapsed += 1
+      }
+    }
+    bytes.result()
+  }
+
+  it should "report its FIFO depths and queue a TX burst" in {
+    test(new Uart(testFrequency, testBaudRate, txDepth = 4, rxDepth = 8))
+      .withAnnotations(TestAnnotations.annos) { dut =>
+        dut.io.rxd.poke(1.U)
+        dut.clock.step(5)
+        assert(axiRead(dut, REG_FIFO_DEPTH) == ((8 << 16) | 4))
+
+        // The first byte moves on to the shift register at the next bit
+        // boundary; the other four then fill the FIFO
+        axiWrite(dut, REG_TX_DATA, 0x41)
+        dut.clock.step(bitCycles + 2)
+        for (b <- 0x42 to 0x45) axiWrite(dut, REG_TX_DATA, b)
+        assert(axiRead(dut, REG_TX_LEVEL) == 4)
+        val full = axiRead(dut, REG_STATUS)
+        assert((full & 0x01) == 0, s"TX FIFO should be full, status=$full")
+        assert((full & 0x04) == 0, s"TX should not be idle, status=$full")
+
+        // Dropped: no room left
+        axiWrite(dut, REG_TX_DATA, 0x46)
+        assert(axiRead(dut, REG_TX_LEVEL) == 4)
+
+        val sent = captureTx(dut, 6 * 12 * bitCycles)
+        assert(sent == Seq(0x42, 0x43, 0x44, 0x45), s"Unexpected TX bytes $sent")
+        val idle = axiRead(dut, REG_STATUS)
+        assert((idle & 0x05) == 0x05, s"TX should be ready and idle, status=$idle")
+        assert(axiRead(dut, REG_TX_LEVEL) == 0)
+      }
+  }
+
+  it should "raise threshold interrupts only while enabled and met" in {
+    test(new Uart(testFrequency, testBaudRate)).withAnnotations(TestAnnotations.annos) { dut =>
+      dut.io.rxd.poke(1.U)
+      dut.clock.step(5)
+
+      // TX: level 0 <= threshold 0 as soon as it is enabled
+      dut.io.signal_interrupt.expect(false.B)
+      axiWrite(dut, REG_IRQ_ENABLE, IRQ_TX)
+      dut.io.signal_interrupt.expect(true.B)
+      axiWrite(dut, REG_TX_DATA, 0x11)
+      axiWrite(dut, REG_TX_DATA, 0x22)
+      dut.io.signal_interrupt.expect(false.B)
+      assert((axiRead(dut, REG_IRQ_PENDING) & IRQ_TX) == 0)
+      // Drains once the first frame is out and the second one is shifting
+      dut.clock.step(2 * 11 * bitCycles)
+      dut.io.signal_interrupt.expect(true.B)
+
+      // RX: a threshold of 2 waits for the second byte; the RX flag stays
+      // clear while a threshold interrupt is enabled
+      axiWrite(dut, REG_IRQ_ENABLE, IRQ_RX)
+      axiWrite(dut, REG_RX_THRESHOLD, 2)
+      assert(axiRead(dut, REG_RX_THRESHOLD) == 2)
+      sendRxByte(dut, 0x5a)
+      dut.io.signal_interrupt.expect(false.B)
+      assert(axiRead(dut, REG_RX_LEVEL) == 1)
+      sendRxByte(dut, 0xa5)
+      dut.io.signal_interrupt.expect(true.B)
+      // The empty TX FIFO still meets its threshold; only RX is enabled
+      assert(axiRead(dut, REG_IRQ_PENDING) == (IRQ_RX | IRQ_TX))
+      assert((axiRead(dut, REG_RX_DATA) & 0xff) == 0x5a)
+      dut.clock.step(2)
+      dut.io.signal_interrupt.expect(false.B)
+      assert((axiRead(dut, REG_RX_DATA) & 0xff) == 0xa5)
+    }
+  }
+
   behavior.of("Uart TX/RX Loopback")
 
   it should "receive transmitted data in loopback" in {
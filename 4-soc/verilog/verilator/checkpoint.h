@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: MIT
+// Warm-start checkpoints for long SoC workloads (--checkpoint-at, --restore)
+//
+// A checkpoint file is Verilator's save of the model, which needs a --savable
+// build (make verilator-savable), followed by the harness state: guest RAM as
+// a list of non-zero pages, the UART terminal, the simulation loop counters
+// and the last VGA frame. Harness classes describe their state once in a
+// checkpoint(Archive &) member that CheckpointWriter and CheckpointReader
+// both implement, so saving and restoring can never disagree on the layout.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../../../common/verilator/elf_loader.h"
+
+#if VM_SAVABLE
+#include <verilated_save.h>
+#endif
+
+// --checkpoint-at N fires after CPU cycle N, --checkpoint-at pc:ADDR the
+// first time the fetch PC reaches ADDR
+class CheckpointTrigger
+{
+    std::optional<uint64_t> at_cycle;
+    std::optional<uint32_t> at_pc;
+    bool fired = false;
+
+public:
+    void parse(std::string const &spec)
+    {
+        if (spec.compare(0, 3, "pc:") == 0)
+            at_pc = std::stoul(spec.substr(3), nullptr, 0);
+        else
+            at_cycle = std::stoull(spec, nullptr, 0);
+    }
+
+    bool armed() const { return !fired && (at_cycle || at_pc); }
+
+    // Called once per CPU cycle; true at most once
+    bool check(uint64_t cpu_cycle, uint32_t pc)
+    {
+        if (!armed())
+            return false;
+        fired = (at_cycle && cpu_cycle >= *at_cycle) || (at_pc && pc == *at_pc);
+        return fired;
+    }
+};
+
+class Checkpoint
+{
+public:
+    static constexpr char MAGIC[8] = {'M', 'Y', 'C', 'P', 'U', 'S', 'O', 'C'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t PAGE_WORDS = 1024;  // 4 KiB
+    static constexpr uint32_t END_OF_PAGES = ~uint32_t(0);
+
+#if VM_SAVABLE
+    static constexpr bool SUPPORTED = true;
+#else
+    static constexpr bool SUPPORTED = false;
+#endif
+
+    static std::runtime_error unsupported()
+    {
+        return std::runtime_error(
+            "Checkpoints need a model verilated with --savable "
+            "(make verilator-savable)");
+    }
+};
+
+#if VM_SAVABLE
+class CheckpointWriter
+{
+    VerilatedSave os;
+
+public:
+    explicit CheckpointWriter(std::string const &path)
+    {
+        os.open(path.c_str());
+        if (!os.isOpen())
+            throw std::runtime_error("Cannot write checkpoint " + path);
+        os.write(Checkpoint::MAGIC, sizeof(Checkpoint::MAGIC));
+        uint32_t version = Checkpoint::VERSION;
+        value(version);
+    }
+
+    template <typename Model>
+    void model(Model &top)
+    {
+        os << top;
+    }
+
+    template <typename T>
+    void value(T &v)
+    {
+        os.write(&v, sizeof(v));
+    }
+
+    void bytes(uint8_t *data, size_t size) { os.write(data, size); }
+
+    void text(std::string &s)
+    {
+        uint32_t size = s.size();
+        value(size);
+        os.write(s.data(), size);
+    }
+
+    void bytes(std::vector<uint8_t> &data)
+    {
+        uint32_t size = data.size();
+        value(size);
+        os.write(data.data(), size);
+    }
+
+    // Pages that were never written are all zero and are skipped
+    void ram(GuestRAM &ram)
+    {
+        for (size_t first = 0; first < ram.size(); first += Checkpoint::PAGE_WORDS) {
+            size_t words = std::min(Checkpoint::PAGE_WORDS, ram.size() - first);
+            bool zero = true;
+            for (size_t i = 0; i < words && zero; i++)
+                zero = !ram[first + i];
+            if (zero)
+                continue;
+            uint32_t page = first / Checkpoint::PAGE_WORDS;
+            value(page);
+            os.write(ram.data() + first * 4, words * 4);
+        }
+        uint32_t end = Checkpoint::END_OF_PAGES;
+        value(end);
+    }
+};
+
+class CheckpointReader
+{
+    VerilatedRestore is;
+    std::string path;
+
+public:
+    explicit CheckpointReader(std::string const &filename) : path(filename)
+    {
+        is.open(path.c_str());
+        if (!is.isOpen())
+            throw std::runtime_error("Cannot read checkpoint " + path);
+        char magic[sizeof(Checkpoint::MAGIC)];
+        uint32_t version = 0;
+        is.read(magic, sizeof(magic));
+        value(version);
+        if (memcmp(magic, Checkpoint::MAGIC, sizeof(magic)) ||
+            version != Checkpoint::VERSION)
+            throw std::runtime_error("Not a version " +
+                                     std::to_string(Checkpoint::VERSION) +
+                                     " SoC checkpoint: " + path);
+    }
+
+    // Verilator rejects a save from a different design with a fatal error
+    template <typename Model>
+    void model(Model &top)
+    {
+        is >> top;
+    }
+
+    template <typename T>
+    void value(T &v)
+    {
+        is.read(&v, sizeof(v));
+    }
+
+    void bytes(uint8_t *data, size_t size) { is.read(data, size); }
+
+    void text(std::string &s)
+    {
+        uint32_t size = 0;
+        value(size);
+        s.resize(size);
+        is.read(&s[0], size);
+    }
+
+    void bytes(std::vector<uint8_t> &data)
+    {
+        uint32_t size = 0;
+        value(size);
+        data.resize(size);
+        is.read(data.data(), size);
+    }
+
+    void ram(GuestRAM &ram)
+    {
+        ram.clear();
+        while (true) {
+            uint32_t page = 0;
+            value(page);
+            if (page == Checkpoint::END_OF_PAGES)
+                return;
+            size_t first = size_t(page) * Checkpoint::PAGE_WORDS;
+            if (first >= ram.size())
+                throw std::runtime_error("Checkpoint " + path +
+                                         " does not fit in guest memory");
+            size_t words = std::min(Checkpoint::PAGE_WORDS, ram.size() - first);
+            is.read(ram.data() + first * 4, words * 4);
+        }
+    }
+};
+#else
+// Model built without --savable: same interface, rejected when opened
+class CheckpointWriter
+{
+public:
+    explicit CheckpointWriter(std::string const &) { throw Checkpoint::unsupported(); }
+    template <typename Model>
+    void model(Model &)
+    {
+    }
+    template <typename T>
+    void value(T &)
+    {
+    }
+    void bytes(uint8_t *, size_t) {}
+    void bytes(std::vector<uint8_t> &) {}
+    void text(std::string &) {}
+    void ram(GuestRAM &) {}
+};
+
+using CheckpointReader = CheckpointWriter;
+#endif
@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: MIT
+// Headless VGA frame capture - no SDL, for CI and display-less hosts
+//
+// Frames are collected as 6-bit RRGGBB indices between vsync edges. Every
+// completed frame gets a CRC32 line in the hash log; only frames whose CRC
+// differs from the previous one are written out, as
+//   *.raw          640x480 index bytes per frame, appended to one file
+//   *.png          one indexed PNG per frame (name.000003.png)
+//   anything else  RGB24 piped into ffmpeg (e.g. out.mp4, out.gif)
+// Golden checks compare the sequence of distinct CRCs against an earlier
+// hash log, so they do not depend on how many frames a picture was held.
+
+#pragma once
+
+#include <signal.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// CRC-32 (IEEE, as used by PNG and zlib)
+static constexpr std::array<uint32_t, 256> make_crc32_table()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}
+
+class FrameCapture
+{
+public:
+    static constexpr int WIDTH = 640;
+    static constexpr int HEIGHT = 480;
+
+private:
+    enum class Format { None, Raw, Png, Ffmpeg };
+
+    static constexpr std::array<uint32_t, 256> CRC_TABLE = make_crc32_table();
+
+    std::vector<uint8_t> frame;
+    Format format = Format::None;
+    std::string dump_path;
+    FILE *dump = nullptr;
+    bool dump_is_pipe = false;
+    std::ofstream log;
+    std::vector<uint32_t> distinct;  // CRC of every frame that was new
+    bool started = false;
+    uint64_t frame_count = 0, written = 0;
+
+    static uint32_t crc32(uint8_t const *data, size_t len, uint32_t crc = 0)
+    {
+        crc = ~crc;
+        for (size_t i = 0; i < len; i++)
+            crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    // Same 2-bit -> 8-bit scaling as VGADisplay
+    static void palette_rgb(uint8_t index, uint8_t rgb[3])
+    {
+        rgb[0] = ((index >> 4) & 0x3) * 0x55;
+        rgb[1] = ((index >> 2) & 0x3) * 0x55;
+        rgb[2] = (index & 0x3) * 0x55;
+    }
+
+    // trace.png -> trace.000003.png
+    std::string numbered(uint64_t index) const
+    {
+        char suffix[24];
+        snprintf(suffix, sizeof(suffix), ".%06llu", (unsigned long long) index);
+        auto dot = dump_path.rfind('.');
+        return dump_path.substr(0, dot) + suffix + dump_path.substr(dot);
+    }
+
+    static void put_be32(std::vector<uint8_t> &out, uint32_t v)
+    {
+        out.push_back(v >> 24);
+        out.push_back(v >> 16);
+        out.push_back(v >> 8);
+        out.push_back(v);
+    }
+
+    static void png_chunk(FILE *f, char const *type,
+                          std::vector<uint8_t> const &data)
+    {
+        std::vector<uint8_t> head;
+        put_be32(head, data.size());
+        head.insert(head.end(), type, type + 4);
+        uint32_t crc = crc32(head.data() + 4, 4);
+        crc = crc32(data.data(), data.size(), crc);
+        std::vector<uint8_t> tail;
+        put_be32(tail, crc);
+        fwrite(head.data(), 1, head.size(), f);
+        fwrite(data.data(), 1, data.size(), f);
+        fwrite(tail.data(), 1, tail.size(), f);
+    }
+
+    // 8-bit palette PNG with stored (uncompressed) deflate blocks, which
+    // keeps the writer free of a zlib dependency
+    void write_png(std::string const &name) const
+    {
+        FILE *f = fopen(name.c_str(), "wb");
+        if (!f)
+            throw std::runtime_error("Cannot write frame " + name);
+        static uint8_t const signature[8] = {0x89, 'P',  'N',  'G',
+                                             '\r', '\n', 0x1A, '\n'};
+        fwrite(signature, 1, sizeof(signature), f);
+
+        std::vector<uint8_t> ihdr;
+        put_be32(ihdr, WIDTH);
+        put_be32(ihdr, HEIGHT);
+        ihdr.insert(ihdr.end(), {8, 3, 0, 0, 0});  // 8-bit indexed
+        png_chunk(f, "IHDR", ihdr);
+
+        std::vector<uint8_t> plte(64 * 3);
+        for (int i = 0; i < 64; i++)
+            palette_rgb(i, &plte[i * 3]);
+        png_chunk(f, "PLTE", plte);
+
+        // Scanlines with filter type 0, Adler-32 over the raw stream
+        std::vector<uint8_t> raw;
+        raw.reserve(HEIGHT * (WIDTH + 1));
+        for (int y = 0; y < HEIGHT; y++) {
+            raw.push_back(0);
+            raw.insert(raw.end(), &frame[y * WIDTH], &frame[(y + 1) * WIDTH]);
+        }
+        uint32_t a = 1, b = 0;
+        for (uint8_t byte : raw) {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        std::vector<uint8_t> idat = {0x78, 0x01};
+        for (size_t pos = 0; pos < raw.size(); pos += 65535) {
+            uint16_t len = std::min<size_t>(65535, raw.size() - pos);
+            bool last = pos + len == raw.size();
+            idat.insert(idat.end(),
+                        {uint8_t(last), uint8_t(len), uint8_t(len >> 8),
+                         uint8_t(~len), uint8_t(~len >> 8)});
+            idat.insert(idat.end(), &raw[pos], &raw[pos] + len);
+        }
+        put_be32(idat, (b << 16) | a);
+        png_chunk(f, "IDAT", idat);
+        png_chunk(f, "IEND", {});
+        fclose(f);
+    }
+
+    void write_frame()
+    {
+        switch (format) {
+        case Format::Raw:
+            fwrite(frame.data(), 1, frame.size(), dump);
+            break;
+        case Format::Png:
+            write_png(numbered(written));
+            break;
+        case Format::Ffmpeg: {
+            std::vector<uint8_t> rgb(frame.size() * 3);
+            for (size_t i = 0; i < frame.size(); i++)
+                palette_rgb(frame[i], &rgb[i * 3]);
+            fwrite(rgb.data(), 1, rgb.size(), dump);
+            break;
+        }
+        case Format::None:
+            return;
+        }
+        written++;
+    }
+
+public:
+    FrameCapture() : frame(WIDTH * HEIGHT, 0) {}
+
+    ~FrameCapture()
+    {
+        if (!dump)
+            return;
+        if (dump_is_pipe)
+            pclose(dump);
+        else
+            fclose(dump);
+    }
+
+    FrameCapture(FrameCapture const &) = delete;
+    FrameCapture &operator=(FrameCapture const &) = delete;
+
+    void open_dump(std::string const &path)
+    {
+        dump_path = path;
+        auto dot = path.rfind('.');
+        std::string ext = dot == std::string::npos ? "" : path.substr(dot);
+        if (ext == ".raw") {
+            format = Format::Raw;
+            dump = fopen(path.c_str(), "wb");
+        } else if (ext == ".png") {
+            format = Format::Png;
+            return;
+        } else {
+            format = Format::Ffmpeg;
+            std::string cmd =
+                "ffmpeg -loglevel error -y -f rawvideo -pix_fmt rgb24 -s " +
+                std::to_string(WIDTH) + "x" + std::to_string(HEIGHT) +
+                " -r 60 -i - -pix_fmt yuv420p '" + path + "'";
+            signal(SIGPIPE, SIG_IGN);  // report a dead ffmpeg, do not die
+            dump = popen(cmd.c_str(), "w");
+            dump_is_pipe = true;
+        }
+        if (!dump)
+            throw std::runtime_error("Cannot open frame dump " + path);
+    }
+
+    void open_log(std::string const &path)
+    {
+        log.open(path);
+        if (!log)
+            throw std::runtime_error("Cannot write frame log " + path);
+        log << "# frame cpu_cycle crc32 new\n";
+    }
+
+    void update_pixel(uint16_t x, uint16_t y, uint8_t rrggbb, bool active)
+    {
+        if (active && x < WIDTH && y < HEIGHT)
+            frame[y * WIDTH + x] = rrggbb & 0x3F;
+    }
+
+    // Called on every vsync rising edge; the partial frame before the first
+    // edge is discarded. Pixels keep their value until redrawn.
+    void end_frame(uint64_t cpu_cycle)
+    {
+        if (!started) {
+            started = true;
+            return;
+        }
+        uint32_t crc = crc32(frame.data(), frame.size());
+        bool is_new = distinct.empty() || distinct.back() != crc;
+        if (is_new) {
+            distinct.push_back(crc);
+            write_frame();
+        }
+        if (log) {
+            char line[64];
+            snprintf(line, sizeof(line), "%llu %llu %08x %d\n",
+                     (unsigned long long) frame_count,
+                     (unsigned long long) cpu_cycle, crc, is_new);
+            log << line;
+        }
+        frame_count++;
+    }
+
+    uint8_t *pixels() { return frame.data(); }
+
+    uint64_t frames() const { return frame_count; }
+    uint64_t frames_written() const { return written; }
+    uint64_t frames_distinct() const { return distinct.size(); }
+
+    // Compare the distinct-CRC sequence with a previous hash log. A run
+    // that stops early passes as long as its frames match the golden prefix.
+    bool check_golden(std::string const &path, std::string &error) const
+    {
+        std::ifstream golden(path);
+        if (!golden) {
+            error = "Cannot read golden frame log " + path;
+            return false;
+        }
+        std::vector<uint32_t> expected;
+        std::string line;
+        while (std::getline(golden, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream fields(line);
+            uint64_t index, cpu_cycle;
+            std::string crc;
+            int is_new = 0;
+            if (!(fields >> index >> cpu_cycle >> crc >> is_new))
+                continue;
+            if (is_new)
+                expected.push_back(std::stoul(crc, nullptr, 16));
+        }
+        if (distinct.empty() && !expected.empty()) {
+            error = "No frames captured";
+            return false;
+        }
+        for (size_t i = 0; i < distinct.size(); i++) {
+            if (i >= expected.size()) {
+                error = "More distinct frames than " + path;
+                return false;
+            }
+            if (distinct[i] != expected[i]) {
+                char msg[80];
+                snprintf(msg, sizeof(msg),
+                         "Distinct frame %zu: crc %08x, golden %08x", i,
+                         distinct[i], expected[i]);
+                error = msg;
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,449 @@
+// SPDX-License-Identifier: MIT
+// GDB remote serial protocol stub (--gdb PORT)
+//
+// The core stops only at retirement boundaries. The harness calls retire()
+// on every falling edge with an instruction on the commit port, before the
+// rising edge that commits it. A stop there shows GDB that instruction's PC
+// with everything older retired. The stub checks for a stop with one flag
+// and one bit of a PC bitmap (a bit per halfword for RV32C), so while the
+// program continues, the loop runs as fast as it does without breakpoints.
+// `s` steps one retired instruction; Ctrl-C from GDB is picked up by
+// poll_interrupt(), which the loop calls every few thousand cycles.
+//
+// Registers are read through the cpu_debug_read/cpu_csr_debug_read ports
+// (x0-x31 are GDB registers 0-31, pc is 32, CSR n is 65 + n). That port
+// forwards the write of the instruction in WB, which has not retired at a
+// stop, so that one register comes from a copy the stub keeps of every
+// retired write. Memory is the harness RAM, read and written directly, so
+// lines held dirty in a D-cache are not seen and code written from GDB
+// misses any copy already in the I-cache. Register writes, watchpoints and
+// MMIO addresses are not supported.
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class GdbStub
+{
+    static constexpr unsigned NUM_REGS = 32;
+    static constexpr unsigned PC_REG = 32;
+    static constexpr unsigned CSR_BASE = 65;
+    static constexpr unsigned CSR_COUNT = 4096;
+
+    int fd = -1;
+    bool attached = false;
+    bool no_ack = false;
+
+    // One bit per halfword of RAM
+    std::vector<uint64_t> bitmap;
+    size_t breakpoints = 0;
+
+    bool stop_pending = true;  // the first instruction stops for the attach
+    bool interrupted = false;
+    bool running = false;  // resumed by GDB, which waits for a stop reply
+    uint64_t steps = 0;  // retirements left before a `s` stops
+
+    std::array<uint32_t, NUM_REGS> regs{};  // copy of every retired write
+    uint64_t retired = 0;
+
+    std::string input;
+
+    static int hex_digit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    static uint32_t parse_hex(std::string const &s, size_t &pos)
+    {
+        uint32_t value = 0;
+        int digit;
+        while (pos < s.size() && (digit = hex_digit(s[pos])) >= 0) {
+            value = value << 4 | digit;
+            pos++;
+        }
+        return value;
+    }
+
+    static void append_byte(std::string &out, uint8_t b)
+    {
+        static const char digits[] = "0123456789abcdef";
+        out += digits[b >> 4];
+        out += digits[b & 0xF];
+    }
+
+    // Registers go over the wire in target (little-endian) byte order
+    static void append_word(std::string &out, uint32_t w)
+    {
+        for (int i = 0; i < 4; i++)
+            append_byte(out, w >> (8 * i));
+    }
+
+    bool hit(uint32_t pc) const
+    {
+        size_t bit = pc >> 1;
+        return bit / 64 < bitmap.size() && (bitmap[bit / 64] >> (bit % 64) & 1);
+    }
+
+    bool set_breakpoint(uint32_t pc, bool on)
+    {
+        size_t bit = pc >> 1;
+        if (bit / 64 >= bitmap.size())
+            return false;
+        uint64_t mask = uint64_t(1) << (bit % 64);
+        bool was = bitmap[bit / 64] & mask;
+        if (on && !was) {
+            bitmap[bit / 64] |= mask;
+            breakpoints++;
+        } else if (!on && was) {
+            bitmap[bit / 64] &= ~mask;
+            breakpoints--;
+        }
+        return true;
+    }
+
+    void send_raw(std::string const &s)
+    {
+        for (size_t sent = 0; sent < s.size();) {
+            ssize_t n = send(fd, s.data() + sent, s.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0) {
+                detach();
+                return;
+            }
+            sent += n;
+        }
+    }
+
+    void send_packet(std::string const &payload)
+    {
+        uint8_t sum = 0;
+        for (char c : payload)
+            sum += static_cast<uint8_t>(c);
+        std::string packet = "$" + payload + "#";
+        append_byte(packet, sum);
+        send_raw(packet);
+    }
+
+    // Next packet payload; false once GDB has gone
+    bool receive_packet(std::string &payload)
+    {
+        for (;;) {
+            auto start = input.find('$');
+            if (start != std::string::npos) {
+                auto end = input.find('#', start);
+                if (end != std::string::npos && end + 2 < input.size()) {
+                    payload = input.substr(start + 1, end - start - 1);
+                    input.erase(0, end + 3);
+                    if (!no_ack)
+                        send_raw("+");
+                    return attached;
+                }
+            } else {
+                input.clear();  // acks and Ctrl-C while stopped
+            }
+            char buffer[4096];
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0) {
+                detach();
+                return false;
+            }
+            input.append(buffer, n);
+        }
+    }
+
+    void detach()
+    {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+        attached = false;
+        stop_pending = false;
+        breakpoints = 0;
+    }
+
+    template <typename Model>
+    uint32_t read_register(Model &top, unsigned n)
+    {
+        if (n == 0)
+            return 0;
+        if (top.io_cpu_retire_write_enable && top.io_cpu_retire_rd == n)
+            return regs[n];
+        top.io_cpu_debug_read_address = n;
+        top.eval();
+        return top.io_cpu_debug_read_data;
+    }
+
+    template <typename Model>
+    uint32_t read_csr(Model &top, unsigned n)
+    {
+        top.io_cpu_csr_debug_read_address = n;
+        top.eval();
+        return top.io_cpu_csr_debug_read_data;
+    }
+
+    // Handles one packet while stopped; true when it resumes the core
+    template <typename Model, typename Ram>
+    bool handle(std::string const &packet, Model &top, Ram &ram, bool &kill)
+    {
+        uint32_t pc = top.io_cpu_retire_pc;
+        size_t pos = 1;
+        switch (packet.empty() ? 0 : packet[0]) {
+        case '?':
+            send_packet(interrupted ? "S02" : "S05");
+            return false;
+        case 'g': {
+            std::string out;
+            for (unsigned i = 0; i < NUM_REGS; i++)
+                append_word(out, read_register(top, i));
+            append_word(out, pc);
+            send_packet(out);
+            return false;
+        }
+        case 'p': {
+            unsigned n = parse_hex(packet, pos);
+            std::string out;
+            if (n < NUM_REGS)
+                append_word(out, read_register(top, n));
+            else if (n == PC_REG)
+                append_word(out, pc);
+            else if (n >= CSR_BASE && n < CSR_BASE + CSR_COUNT)
+                append_word(out, read_csr(top, n - CSR_BASE));
+            else
+                out = "xxxxxxxx";
+            send_packet(out);
+            return false;
+        }
+        case 'm': {
+            uint32_t addr = parse_hex(packet, pos);
+            pos++;
+            uint32_t len = parse_hex(packet, pos);
+            if (uint64_t(addr) + len > ram.bytes()) {
+                send_packet("E01");
+                return false;
+            }
+            std::string out;
+            for (uint32_t a = addr; a < addr + len; a++)
+                append_byte(out, ram.read(a & ~3u) >> (8 * (a & 3)));
+            send_packet(out);
+            return false;
+        }
+        case 'M': {
+            uint32_t addr = parse_hex(packet, pos);
+            pos++;
+            uint32_t len = parse_hex(packet, pos);
+            pos++;
+            if (uint64_t(addr) + len > ram.bytes() ||
+                packet.size() < pos + 2 * size_t(len)) {
+                send_packet("E01");
+                return false;
+            }
+            for (uint32_t i = 0; i < len; i++, pos += 2) {
+                uint32_t a = addr + i;
+                uint32_t b = hex_digit(packet[pos]) << 4 | hex_digit(packet[pos + 1]);
+                ram.write(a & ~3u, b << (8 * (a & 3)), 1u << (a & 3));
+            }
+            send_packet("OK");
+            return false;
+        }
+        case 'Z':
+        case 'z':
+            // Software and hardware breakpoints both go to the bitmap
+            if (packet.size() > 2 && (packet[1] == '0' || packet[1] == '1')) {
+                pos = 3;
+                uint32_t addr = parse_hex(packet, pos);
+                send_packet(set_breakpoint(addr, packet[0] == 'Z') ? "OK"
+                                                                    : "E01");
+            } else {
+                send_packet("");
+            }
+            return false;
+        case 'c':
+            running = true;
+            return true;
+        case 's':
+            steps = 1;
+            running = true;
+            return true;
+        case 'D':
+            send_packet("OK");
+            detach();
+            return true;
+        case 'k':
+            kill = true;
+            detach();
+            return true;
+        case 'H':
+        case 'T':
+            send_packet("OK");
+            return false;
+        case 'q':
+            if (packet.compare(0, 10, "qSupported") == 0)
+                send_packet("PacketSize=4000;QStartNoAckMode+");
+            else if (packet == "qAttached")
+                send_packet("1");
+            else if (packet == "qC")
+                send_packet("QC1");
+            else if (packet == "qfThreadInfo")
+                send_packet("m1");
+            else if (packet == "qsThreadInfo")
+                send_packet("l");
+            else
+                send_packet("");
+            return false;
+        case 'Q':
+            if (packet == "QStartNoAckMode") {
+                send_packet("OK");
+                no_ack = true;
+            } else {
+                send_packet("");
+            }
+            return false;
+        default:
+            // Register writes (G, P), X, v packets: GDB falls back or
+            // reports them as unsupported
+            send_packet("");
+            return false;
+        }
+    }
+
+    // Stopped at the instruction on the commit port; false when GDB killed
+    // the simulation
+    template <typename Model, typename Ram>
+    bool serve(Model &top, Ram &ram)
+    {
+        if (running)
+            send_packet(interrupted ? "S02" : "S05");
+        running = false;
+        std::string packet;
+        bool kill = false;
+        while (attached && receive_packet(packet)) {
+            if (handle(packet, top, ram, kill))
+                break;
+        }
+        top.io_cpu_debug_read_address = 0;
+        top.io_cpu_csr_debug_read_address = 0;
+        top.eval();
+        stop_pending = false;
+        interrupted = false;
+        return !kill;
+    }
+
+public:
+    // Listens on localhost:port and waits for GDB to connect
+    GdbStub(unsigned port, size_t ram_bytes) : bitmap((ram_bytes / 2 + 63) / 64)
+    {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0)
+            throw std::runtime_error("gdb: socket() failed");
+        int one = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ||
+            listen(listener, 1)) {
+            close(listener);
+            throw std::runtime_error("gdb: cannot listen on port " +
+                                     std::to_string(port));
+        }
+        std::fprintf(stderr, "GDB: waiting for a connection on port %u\n", port);
+        fd = accept(listener, nullptr, nullptr);
+        close(listener);
+        if (fd < 0)
+            throw std::runtime_error("gdb: accept() failed");
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        attached = true;
+    }
+
+    ~GdbStub() { detach(); }
+
+    uint64_t instructions() const { return retired; }
+
+    // The register file at the start of the loop (reset or --restore), the
+    // base of the copy that answers for a register written in WB
+    template <typename Model>
+    void sync(Model &top)
+    {
+        for (unsigned i = 1; i < NUM_REGS; i++) {
+            top.io_cpu_debug_read_address = i;
+            top.eval();
+            regs[i] = top.io_cpu_debug_read_data;
+        }
+        top.io_cpu_debug_read_address = 0;
+        top.eval();
+    }
+
+    // Called with the commit port valid on a falling edge; false when GDB
+    // killed the simulation
+    template <typename Model, typename Ram>
+    bool retire(Model &top, Ram &ram)
+    {
+        if ((stop_pending || (breakpoints && hit(top.io_cpu_retire_pc))) &&
+            attached && !serve(top, ram))
+            return false;
+        if (top.io_cpu_retire_write_enable && top.io_cpu_retire_rd != 0)
+            regs[top.io_cpu_retire_rd] = top.io_cpu_retire_data;
+        retired++;
+        if (steps && --steps == 0)
+            stop_pending = true;
+        return true;
+    }
+
+    // Ctrl-C (0x03) from GDB while the core runs; a cheap poll()
+    void poll_interrupt()
+    {
+        if (!attached)
+            return;
+        pollfd p{fd, POLLIN, 0};
+        if (poll(&p, 1, 0) <= 0)
+            return;
+        char buffer[256];
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            detach();
+            return;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            if (buffer[i] == 0x03) {
+                stop_pending = true;
+                interrupted = true;
+            } else {
+                input += buffer[i];
+            }
+        }
+    }
+
+    // The simulation ended on its own
+    void exited(int status)
+    {
+        if (!attached)
+            return;
+        char packet[8];
+        std::snprintf(packet, sizeof(packet), "W%02x", status & 0xFF);
+        send_packet(packet);
+        detach();
+    }
+};
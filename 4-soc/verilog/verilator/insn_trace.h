@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: MIT
+// Binary retired-instruction trace (--trace-insn)
+//
+// One fixed-size record per instruction retiring from WB, read from the
+// cpu_retire_* commit port of Top. The simulation thread appends records to
+// a single-producer/single-consumer ring without locking; a writer thread
+// drains it to the file. Names ending in .zst or .lz4 are piped through the
+// zstd / lz4 command line tools, the way FrameCapture hands video to
+// ffmpeg. A full ring makes the simulation wait, so traces are never lossy.
+// trace_decode (make trace-decode) disassembles and symbolizes a trace.
+//
+// File layout: InsnTraceHeader, then InsnTraceRecord until end of file.
+// Canonical NOPs do not appear, the commit port cannot tell them from
+// pipeline bubbles.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct InsnTraceRecord {
+    uint32_t pc;
+    uint32_t insn;
+    uint32_t rd_value;      // value written to rd, 0 when there is none
+    uint32_t mem_address;   // load/store address, 0 for other instructions
+    uint32_t delta_cycles;  // CPU cycles since the previous record
+};
+static_assert(sizeof(InsnTraceRecord) == 20, "records are written raw");
+
+struct InsnTraceHeader {
+    static constexpr char MAGIC[8] = {'M', 'Y', 'C', 'P', 'U', 'I', 'N', 'S'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t start_cycle;  // first record is at start_cycle + its delta
+};
+
+// Plain file, or a pipe through zstd / lz4 chosen by the extension
+class InsnTraceStream
+{
+    FILE *file = nullptr;
+    bool is_pipe = false;
+
+    static std::string extension(std::string const &path)
+    {
+        auto dot = path.rfind('.');
+        return dot == std::string::npos ? "" : path.substr(dot);
+    }
+
+public:
+    InsnTraceStream(std::string const &path, bool write)
+    {
+        std::string ext = extension(path);
+        std::string tool = ext == ".zst" ? "zstd" : ext == ".lz4" ? "lz4" : "";
+        if (tool.empty()) {
+            file = fopen(path.c_str(), write ? "wb" : "rb");
+        } else {
+            // zstd names its output with -o, lz4 takes it positionally
+            std::string dest = (tool == "zstd" ? "-o '" : "'") + path + "'";
+            std::string cmd = write ? tool + " -q -f - " + dest
+                                    : tool + " -q -d -c '" + path + "'";
+            file = popen(cmd.c_str(), write ? "w" : "r");
+            is_pipe = true;
+        }
+        if (!file)
+            throw std::runtime_error("Cannot open instruction trace " + path);
+    }
+
+    ~InsnTraceStream() { close(); }
+
+    InsnTraceStream(InsnTraceStream const &) = delete;
+    InsnTraceStream &operator=(InsnTraceStream const &) = delete;
+
+    FILE *get() const { return file; }
+
+    void close()
+    {
+        if (!file)
+            return;
+        if (is_pipe)
+            pclose(file);
+        else
+            fclose(file);
+        file = nullptr;
+    }
+};
+
+// --trace-insn-start / --trace-insn-stop: CPU cycle N, or pc:ADDR for the
+// first retirement of the instruction at ADDR
+class InsnTraceTrigger
+{
+    std::optional<uint64_t> at_cycle;
+    std::optional<uint32_t> at_pc;
+
+public:
+    void parse(std::string const &spec)
+    {
+        if (spec.compare(0, 3, "pc:") == 0)
+            at_pc = std::stoul(spec.substr(3), nullptr, 0);
+        else
+            at_cycle = std::stoull(spec, nullptr, 0);
+    }
+
+    bool set() const { return at_cycle || at_pc; }
+
+    bool hit(uint64_t cpu_cycle, uint32_t pc) const
+    {
+        return (at_cycle && cpu_cycle >= *at_cycle) || (at_pc && pc == *at_pc);
+    }
+};
+
+class InsnTracer
+{
+public:
+    static constexpr size_t RING_RECORDS = 1 << 16;  // 1.25 MiB
+
+    InsnTraceTrigger start, stop;
+
+private:
+    enum class State { Off, Waiting, Tracing, Done };
+
+    std::unique_ptr<InsnTraceStream> out;
+    std::vector<InsnTraceRecord> ring;
+    std::atomic<uint64_t> head{0}, tail{0};
+    std::atomic<bool> closing{false};
+    std::thread writer;
+    State state = State::Off;
+    bool header_written = false;
+    uint64_t last_cycle = 0;
+    uint64_t full_waits = 0;
+
+    // Consumer: copies whole contiguous spans of the ring per fwrite
+    void write_loop()
+    {
+        FILE *f = out->get();
+        while (true) {
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            uint64_t h = head.load(std::memory_order_acquire);
+            if (t == h) {
+                if (closing.load(std::memory_order_acquire) &&
+                    head.load(std::memory_order_acquire) == t)
+                    return;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            size_t index = t & (RING_RECORDS - 1);
+            size_t n = std::min<uint64_t>(h - t, RING_RECORDS - index);
+            fwrite(&ring[index], sizeof(InsnTraceRecord), n, f);
+            tail.store(t + n, std::memory_order_release);
+        }
+    }
+
+    // Written by the simulation thread before the first record is
+    // published, so it always precedes the writer's output
+    void write_header(uint64_t cpu_cycle)
+    {
+        InsnTraceHeader header{};
+        memcpy(header.magic, InsnTraceHeader::MAGIC, sizeof(header.magic));
+        header.version = InsnTraceHeader::VERSION;
+        header.record_size = sizeof(InsnTraceRecord);
+        header.start_cycle = cpu_cycle;
+        fwrite(&header, sizeof(header), 1, out->get());
+        header_written = true;
+    }
+
+    void push(InsnTraceRecord const &record)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= RING_RECORDS) {
+            full_waits++;
+            while (h - tail.load(std::memory_order_acquire) >= RING_RECORDS)
+                std::this_thread::yield();
+        }
+        ring[h & (RING_RECORDS - 1)] = record;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+public:
+    ~InsnTracer() { close(); }
+
+    void open(std::string const &path)
+    {
+        out = std::make_unique<InsnTraceStream>(path, true);
+        ring.resize(RING_RECORDS);
+        state = start.set() ? State::Waiting : State::Tracing;
+        writer = std::thread(&InsnTracer::write_loop, this);
+    }
+
+    bool active() const
+    {
+        return state == State::Waiting || state == State::Tracing;
+    }
+
+    uint64_t records() const { return head.load(std::memory_order_relaxed); }
+    uint64_t ring_full_waits() const { return full_waits; }
+
+    // Called for every retired instruction while active()
+    void retire(uint64_t cpu_cycle, uint32_t pc, uint32_t insn,
+                uint32_t rd_value, uint32_t mem_address)
+    {
+        if (state == State::Waiting) {
+            if (!start.hit(cpu_cycle, pc))
+                return;
+            state = State::Tracing;
+        }
+        if (stop.hit(cpu_cycle, pc)) {
+            state = State::Done;
+            return;
+        }
+        if (!header_written) {
+            write_header(cpu_cycle);
+            last_cycle = cpu_cycle;
+        }
+        uint64_t delta = std::min<uint64_t>(cpu_cycle - last_cycle, UINT32_MAX);
+        last_cycle = cpu_cycle;
+        push({pc, insn, rd_value, mem_address, uint32_t(delta)});
+    }
+
+    void close()
+    {
+        if (!writer.joinable())
+            return;
+        closing.store(true, std::memory_order_release);
+        writer.join();
+        if (!header_written)
+            write_header(last_cycle);
+        out->close();
+        state = State::Off;
+    }
+};
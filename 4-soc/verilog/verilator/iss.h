@@ -0,0 +1,972 @@
+// SPDX-License-Identifier: MIT
+// Functional RV32IMC + Zicsr model of the 4-soc core (--lockstep, --iss-ff)
+//
+// Instructions are decoded once into a direct-mapped micro-op cache keyed by
+// PC. Decoding itself is a lookup in a compile-time table indexed by
+// opcode[6:2], funct3 and bit 30 (funct7[5]), with RV32M (funct7 = 1)
+// patched in by iss_decode(); stores drop any cached line
+// they overwrite, so self-modifying code stays correct. Compressed
+// instructions are expanded by iss_expand() before decoding, exactly like
+// CompressedExpander.scala, so retired insn values match the RTL commit port. The model follows
+// the RTL where it deviates from the privileged spec: ecall/ebreak save the
+// address of the next instruction in mepc, misaligned halfword accesses
+// touch bytes 2-3. Interrupts are not modelled: the UART, DMA, MTIMECMP and
+// MSIP raise them in the RTL at times the ISS cannot know, so --lockstep
+// stops checking and --iss-ff hands over to the RTL once the guest sets
+// mstatus.MIE with any of mie.MSIE/MTIE/MEIE (interrupts_enabled()).
+// Counter CSRs read the retired-instruction count, which keeps delay loops
+// finite but is only an approximation of the RTL values.
+//
+// iss_decode() and iss_disassemble() are shared with trace_decode.
+//
+// Bus is a word-addressed memory: read(addr), write(addr, value, strobe)
+// and is_ram(addr). Loads outside RAM are flagged as unpredictable so the
+// lockstep checker takes their value from the RTL.
+
+#pragma once
+
+#include <array>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+enum class IssOp : uint8_t {
+    ILLEGAL,
+    LUI, AUIPC, JAL, JALR,
+    BEQ, BNE, BLT, BGE, BLTU, BGEU,
+    LB, LH, LW, LBU, LHU,
+    SB, SH, SW,
+    ADDI, SLTI, SLTIU, XORI, ORI, ANDI, SLLI, SRLI, SRAI,
+    ADD, SUB, SLL, SLT, SLTU, XOR, SRL, SRA, OR, AND,
+    MUL, MULH, MULHSU, MULHU, DIV, DIVU, REM, REMU,  // funct3 order
+    FENCE,
+    PRIV,  // ecall, ebreak, mret, wfi: resolved from the full word
+    CSRRW, CSRRS, CSRRC, CSRRWI, CSRRSI, CSRRCI,
+};
+
+// Index: opcode[6:2] << 4 | funct3 << 1 | instruction bit 30
+static constexpr std::array<IssOp, 512> make_iss_decode_table()
+{
+    std::array<IssOp, 512> table{};
+    // bit30 < 0: either value of bit 30
+    auto set = [&table](unsigned opcode, unsigned funct3, int bit30,
+                        IssOp op) {
+        for (unsigned b = 0; b < 2; b++)
+            if (bit30 < 0 || unsigned(bit30) == b)
+                table[(opcode >> 2) << 4 | funct3 << 1 | b] = op;
+    };
+    auto set_all = [&set](unsigned opcode, IssOp op) {
+        for (unsigned f3 = 0; f3 < 8; f3++)
+            set(opcode, f3, -1, op);
+    };
+    set_all(0x37, IssOp::LUI);
+    set_all(0x17, IssOp::AUIPC);
+    set_all(0x6F, IssOp::JAL);
+    set(0x67, 0, -1, IssOp::JALR);
+
+    set(0x63, 0, -1, IssOp::BEQ);
+    set(0x63, 1, -1, IssOp::BNE);
+    set(0x63, 4, -1, IssOp::BLT);
+    set(0x63, 5, -1, IssOp::BGE);
+    set(0x63, 6, -1, IssOp::BLTU);
+    set(0x63, 7, -1, IssOp::BGEU);
+
+    set(0x03, 0, -1, IssOp::LB);
+    set(0x03, 1, -1, IssOp::LH);
+    set(0x03, 2, -1, IssOp::LW);
+    set(0x03, 4, -1, IssOp::LBU);
+    set(0x03, 5, -1, IssOp::LHU);
+    set(0x23, 0, -1, IssOp::SB);
+    set(0x23, 1, -1, IssOp::SH);
+    set(0x23, 2, -1, IssOp::SW);
+
+    set(0x13, 0, -1, IssOp::ADDI);
+    set(0x13, 2, -1, IssOp::SLTI);
+    set(0x13, 3, -1, IssOp::SLTIU);
+    set(0x13, 4, -1, IssOp::XORI);
+    set(0x13, 6, -1, IssOp::ORI);
+    set(0x13, 7, -1, IssOp::ANDI);
+    set(0x13, 1, 0, IssOp::SLLI);
+    set(0x13, 5, 0, IssOp::SRLI);
+    set(0x13, 5, 1, IssOp::SRAI);
+
+    set(0x33, 0, 0, IssOp::ADD);
+    set(0x33, 0, 1, IssOp::SUB);
+    set(0x33, 1, 0, IssOp::SLL);
+    set(0x33, 2, 0, IssOp::SLT);
+    set(0x33, 3, 0, IssOp::SLTU);
+    set(0x33, 4, 0, IssOp::XOR);
+    set(0x33, 5, 0, IssOp::SRL);
+    set(0x33, 5, 1, IssOp::SRA);
+    set(0x33, 6, 0, IssOp::OR);
+    set(0x33, 7, 0, IssOp::AND);
+
+    set(0x0F, 0, -1, IssOp::FENCE);
+    set(0x0F, 1, -1, IssOp::FENCE);  // fence.i: stores already invalidate
+
+    set(0x73, 0, -1, IssOp::PRIV);
+    set(0x73, 1, -1, IssOp::CSRRW);
+    set(0x73, 2, -1, IssOp::CSRRS);
+    set(0x73, 3, -1, IssOp::CSRRC);
+    set(0x73, 5, -1, IssOp::CSRRWI);
+    set(0x73, 6, -1, IssOp::CSRRSI);
+    set(0x73, 7, -1, IssOp::CSRRCI);
+    return table;
+}
+
+// Architectural state, also what --iss-ff hands to the RTL
+struct IssState {
+    uint32_t pc = 0x1000;
+    std::array<uint32_t, 32> x{};
+    uint32_t mstatus = 0, mie = 0, mtvec = 0, mscratch = 0;
+    uint32_t mepc = 0, mcause = 0, mcountinhibit = 0;
+};
+
+// What one instruction did, for the lockstep checker
+struct IssRetire {
+    uint32_t pc = 0, insn = 0;
+    uint8_t rd = 0;
+    bool writes_rd = false;     // rd != x0 was written
+    bool unpredictable = false; // MMIO load or counter CSR read
+    uint32_t value = 0;
+    bool ram_store = false;
+    uint32_t store_address = 0, store_data = 0;
+    uint8_t store_strobe = 0;
+};
+
+static constexpr std::array<IssOp, 512> ISS_DECODE = make_iss_decode_table();
+
+// One decoded instruction; imm is sign-extended for its format, the CSR
+// address for SYSTEM instructions
+struct IssDecoded {
+    uint32_t pc = 1;  // never a fetch address: empty cache line
+    uint32_t insn = 0;
+    IssOp op = IssOp::ILLEGAL;
+    uint8_t rd = 0, rs1 = 0, rs2 = 0;
+    uint8_t length = 4;  // 2 for an expanded compressed instruction
+    int32_t imm = 0;
+};
+
+// RV32C (no F/D) to the equivalent 32-bit instruction; 0 for illegal and
+// reserved encodings. Same cases as CompressedExpander.scala.
+static inline uint32_t iss_expand(uint16_t c)
+{
+    auto bit = [c](int hi, int lo) -> uint32_t {
+        return (c >> lo) & ((1u << (hi - lo + 1)) - 1);
+    };
+    auto i_type = [](uint32_t imm, uint32_t rs1, uint32_t funct3,
+                     uint32_t rd, uint32_t opcode) {
+        return (imm & 0xFFF) << 20 | rs1 << 15 | funct3 << 12 | rd << 7 |
+               opcode;
+    };
+    auto s_type = [](uint32_t imm, uint32_t rs2, uint32_t rs1,
+                     uint32_t funct3) {
+        return (imm >> 5 & 0x7F) << 25 | rs2 << 20 | rs1 << 15 |
+               funct3 << 12 | (imm & 0x1F) << 7 | 0x23;
+    };
+    auto b_type = [](uint32_t imm, uint32_t rs1, uint32_t funct3) {
+        return (imm >> 12 & 1) << 31 | (imm >> 5 & 0x3F) << 25 | rs1 << 15 |
+               funct3 << 12 | (imm >> 1 & 0xF) << 8 | (imm >> 11 & 1) << 7 |
+               0x63;
+    };
+    auto j_type = [](uint32_t imm, uint32_t rd) {
+        return (imm >> 20 & 1) << 31 | (imm >> 1 & 0x3FF) << 21 |
+               (imm >> 11 & 1) << 20 | (imm >> 12 & 0xFF) << 12 | rd << 7 |
+               0x6F;
+    };
+    auto r_type = [](uint32_t funct7, uint32_t rs2, uint32_t rs1,
+                     uint32_t funct3, uint32_t rd) {
+        return funct7 << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 | rd << 7 |
+               0x33;
+    };
+    auto sext = [](uint32_t value, int bits) {
+        return uint32_t(int32_t(value << (32 - bits)) >> (32 - bits));
+    };
+
+    uint32_t rd = bit(11, 7), rs2 = bit(6, 2);
+    uint32_t rdp = 8 + bit(4, 2), rs1p = 8 + bit(9, 7);
+    uint32_t ci_imm = sext(bit(12, 12) << 5 | bit(6, 2), 6);
+    uint32_t cj_imm = sext(bit(12, 12) << 11 | bit(8, 8) << 10 |
+                               bit(10, 9) << 8 | bit(6, 6) << 7 |
+                               bit(7, 7) << 6 | bit(2, 2) << 5 |
+                               bit(11, 11) << 4 | bit(5, 3) << 1,
+                           12);
+    uint32_t cb_imm = sext(bit(12, 12) << 8 | bit(6, 5) << 6 |
+                               bit(2, 2) << 5 | bit(11, 10) << 3 |
+                               bit(4, 3) << 1,
+                           9);
+    uint32_t lw_imm = bit(5, 5) << 6 | bit(12, 10) << 3 | bit(6, 6) << 2;
+    bool ci_zero = bit(12, 12) == 0 && bit(6, 2) == 0;
+
+    switch (bit(1, 0) << 3 | bit(15, 13)) {
+    case 0x00: {  // c.addi4spn
+        uint32_t imm = bit(10, 7) << 6 | bit(12, 11) << 4 | bit(5, 5) << 3 |
+                       bit(6, 6) << 2;
+        return imm ? i_type(imm, 2, 0, rdp, 0x13) : 0;
+    }
+    case 0x02: return i_type(lw_imm, rs1p, 2, rdp, 0x03);  // c.lw
+    case 0x06: return s_type(lw_imm, rdp, rs1p, 2);        // c.sw
+
+    case 0x08: return i_type(ci_imm, rd, 0, rd, 0x13);  // c.addi
+    case 0x09: return j_type(cj_imm, 1);                // c.jal
+    case 0x0A: return i_type(ci_imm, 0, 0, rd, 0x13);   // c.li
+    case 0x0B:
+        if (ci_zero)
+            return 0;
+        if (rd == 2) {  // c.addi16sp
+            uint32_t imm = sext(bit(12, 12) << 9 | bit(4, 3) << 7 |
+                                    bit(5, 5) << 6 | bit(2, 2) << 5 |
+                                    bit(6, 6) << 4,
+                                10);
+            return i_type(imm, 2, 0, 2, 0x13);
+        }
+        return (ci_imm & 0xFFFFF) << 12 | rd << 7 | 0x37;  // c.lui
+    case 0x0C:
+        switch (bit(11, 10)) {
+        case 0:  // c.srli
+            return bit(12, 12) ? 0 : i_type(rs2, rs1p, 5, rs1p, 0x13);
+        case 1:  // c.srai
+            return bit(12, 12) ? 0
+                               : i_type(0x400 | rs2, rs1p, 5, rs1p, 0x13);
+        case 2: return i_type(ci_imm, rs1p, 7, rs1p, 0x13);  // c.andi
+        default: {  // c.sub, c.xor, c.or, c.and
+            static constexpr uint8_t FUNCT3[4] = {0, 4, 6, 7};
+            if (bit(12, 12))
+                return 0;
+            return r_type(bit(6, 5) ? 0 : 0x20, rdp, rs1p, FUNCT3[bit(6, 5)],
+                          rs1p);
+        }
+        }
+    case 0x0D: return j_type(cj_imm, 0);          // c.j
+    case 0x0E: return b_type(cb_imm, rs1p, 0);    // c.beqz
+    case 0x0F: return b_type(cb_imm, rs1p, 1);    // c.bnez
+
+    case 0x10:  // c.slli
+        return bit(12, 12) ? 0 : i_type(rs2, rd, 1, rd, 0x13);
+    case 0x12: {  // c.lwsp
+        uint32_t imm = bit(3, 2) << 6 | bit(12, 12) << 5 | bit(6, 4) << 2;
+        return rd ? i_type(imm, 2, 2, rd, 0x03) : 0;
+    }
+    case 0x14:
+        if (!bit(12, 12)) {
+            if (rs2)
+                return r_type(0, rs2, 0, 0, rd);         // c.mv
+            return rd ? i_type(0, rd, 0, 0, 0x67) : 0;  // c.jr
+        }
+        if (rs2)
+            return r_type(0, rs2, rd, 0, rd);  // c.add
+        return rd ? i_type(0, rd, 0, 1, 0x67)  // c.jalr
+                  : 0x00100073;                // c.ebreak
+    case 0x16:  // c.swsp
+        return s_type(bit(8, 7) << 6 | bit(12, 9) << 2, rs2, 2, 2);
+    }
+    return 0;  // FP loads/stores, reserved funct3 and quadrant 3
+}
+
+static inline IssDecoded iss_decode(uint32_t pc, uint32_t insn)
+{
+    IssDecoded d;
+    d.pc = pc;
+    d.insn = insn;
+    d.rd = (insn >> 7) & 0x1F;
+    d.rs1 = (insn >> 15) & 0x1F;
+    d.rs2 = (insn >> 20) & 0x1F;
+    uint32_t opcode = insn & 0x7F;
+    if ((insn & 3) != 3)
+        return d;
+    d.op = ISS_DECODE[(insn >> 2 & 0x1F) << 4 | (insn >> 12 & 7) << 1 |
+                      (insn >> 30 & 1)];
+    int32_t sinsn = int32_t(insn);
+    switch (opcode) {
+    case 0x37:
+    case 0x17:
+        d.imm = int32_t(insn & 0xFFFFF000);
+        break;
+    case 0x6F:
+        d.imm = (sinsn >> 31 << 20) | (insn & 0xFF000) |
+                (insn >> 20 & 1) << 11 | (insn >> 21 & 0x3FF) << 1;
+        break;
+    case 0x63:
+        d.imm = (sinsn >> 31 << 12) | (insn >> 7 & 1) << 11 |
+                (insn >> 25 & 0x3F) << 5 | (insn >> 8 & 0xF) << 1;
+        break;
+    case 0x23:
+        d.imm = (sinsn >> 25 << 5) | (insn >> 7 & 0x1F);
+        break;
+    case 0x33:
+        // funct7 0x00 / 0x20 are RV32I, 0x01 is RV32M
+        if ((insn >> 25) == 1)
+            d.op = IssOp(unsigned(IssOp::MUL) + (insn >> 12 & 7));
+        else if (insn >> 25 & ~0x20u)
+            d.op = IssOp::ILLEGAL;
+        break;
+    case 0x13:
+        if ((d.op == IssOp::SLLI || d.op == IssOp::SRLI ||
+             d.op == IssOp::SRAI) &&
+            (insn >> 25 & ~0x20u))
+            d.op = IssOp::ILLEGAL;
+        d.imm = sinsn >> 20;
+        break;
+    case 0x73:
+        d.imm = insn >> 20;  // CSR address, uimm is in rs1
+        break;
+    default:
+        d.imm = sinsn >> 20;
+        break;
+    }
+    return d;
+}
+
+// Assembler mnemonic with ABI register names; branch and jump targets are
+// absolute
+static inline std::string iss_disassemble(uint32_t pc, uint32_t insn)
+{
+    static char const *const REG[32] = {
+        "zero", "ra", "sp", "gp", "tp",  "t0",  "t1", "t2", "s0", "s1", "a0",
+        "a1",   "a2", "a3", "a4", "a5",  "a6",  "a7", "s2", "s3", "s4", "s5",
+        "s6",   "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+    static char const *const NAME[] = {
+        "illegal", "lui",  "auipc", "jal",   "jalr",   "beq",    "bne",
+        "blt",     "bge",  "bltu",  "bgeu",  "lb",     "lh",     "lw",
+        "lbu",     "lhu",  "sb",    "sh",    "sw",     "addi",   "slti",
+        "sltiu",   "xori", "ori",   "andi",  "slli",   "srli",   "srai",
+        "add",     "sub",  "sll",   "slt",   "sltu",   "xor",    "srl",
+        "sra",     "or",   "and",   "mul",   "mulh",   "mulhsu", "mulhu",
+        "div",     "divu", "rem",   "remu",  "fence",  "system", "csrrw",
+        "csrrs",   "csrrc", "csrrwi", "csrrsi", "csrrci"};
+    static_assert(sizeof(NAME) / sizeof(NAME[0]) == size_t(IssOp::CSRRCI) + 1,
+                  "one name per IssOp");
+    IssDecoded d = iss_decode(pc, insn);
+    char const *name = NAME[size_t(d.op)];
+    char const *rd = REG[d.rd], *rs1 = REG[d.rs1], *rs2 = REG[d.rs2];
+    char text[64];
+    switch (d.op) {
+    case IssOp::ILLEGAL:
+        snprintf(text, sizeof(text), ".word 0x%08x", insn);
+        break;
+    case IssOp::LUI:
+    case IssOp::AUIPC:
+        snprintf(text, sizeof(text), "%s %s, 0x%x", name, rd,
+                 uint32_t(d.imm) >> 12);
+        break;
+    case IssOp::JAL:
+        snprintf(text, sizeof(text), "jal %s, 0x%x", rd, pc + d.imm);
+        break;
+    case IssOp::JALR:
+    case IssOp::LB:
+    case IssOp::LH:
+    case IssOp::LW:
+    case IssOp::LBU:
+    case IssOp::LHU:
+        snprintf(text, sizeof(text), "%s %s, %d(%s)", name, rd, d.imm, rs1);
+        break;
+    case IssOp::BEQ:
+    case IssOp::BNE:
+    case IssOp::BLT:
+    case IssOp::BGE:
+    case IssOp::BLTU:
+    case IssOp::BGEU:
+        snprintf(text, sizeof(text), "%s %s, %s, 0x%x", name, rs1, rs2,
+                 pc + d.imm);
+        break;
+    case IssOp::SB:
+    case IssOp::SH:
+    case IssOp::SW:
+        snprintf(text, sizeof(text), "%s %s, %d(%s)", name, rs2, d.imm, rs1);
+        break;
+    case IssOp::SLLI:
+    case IssOp::SRLI:
+    case IssOp::SRAI:
+        snprintf(text, sizeof(text), "%s %s, %s, %d", name, rd, rs1,
+                 d.imm & 31);
+        break;
+    case IssOp::FENCE:
+        snprintf(text, sizeof(text), "%s", (insn >> 12 & 7) ? "fence.i"
+                                                            : "fence");
+        break;
+    case IssOp::PRIV:
+        snprintf(text, sizeof(text), "%s",
+                 insn == 0x00000073   ? "ecall"
+                 : insn == 0x00100073 ? "ebreak"
+                 : insn == 0x30200073 ? "mret"
+                 : insn == 0x10500073 ? "wfi"
+                                      : "system");
+        break;
+    case IssOp::CSRRW:
+    case IssOp::CSRRS:
+    case IssOp::CSRRC:
+        snprintf(text, sizeof(text), "%s %s, 0x%03x, %s", name, rd,
+                 uint32_t(d.imm), rs1);
+        break;
+    case IssOp::CSRRWI:
+    case IssOp::CSRRSI:
+    case IssOp::CSRRCI:
+        snprintf(text, sizeof(text), "%s %s, 0x%03x, %u", name, rd,
+                 uint32_t(d.imm), unsigned(d.rs1));
+        break;
+    default:
+        if (d.op >= IssOp::ADD)
+            snprintf(text, sizeof(text), "%s %s, %s, %s", name, rd, rs1, rs2);
+        else
+            snprintf(text, sizeof(text), "%s %s, %s, %d", name, rd, rs1,
+                     d.imm);
+        break;
+    }
+    return text;
+}
+
+template <typename Bus>
+class RV32Iss
+{
+    static constexpr size_t CACHE_LINES = 1 << 16;
+
+    Bus &bus;
+    IssState s;
+    uint64_t retired = 0;
+    IssRetire last;
+    std::vector<IssDecoded> cache;
+    std::string fault_message;
+
+    // PCs are 2-byte aligned; a 32-bit instruction at PC[1] = 1 takes its
+    // upper half from the next word
+    IssDecoded const &fetch(uint32_t pc)
+    {
+        IssDecoded &line = cache[(pc >> 1) & (CACHE_LINES - 1)];
+        if (line.pc == pc)
+            return line;
+        uint32_t word = bus.read(pc);
+        uint16_t half = (pc & 2) ? word >> 16 : word;
+        if ((half & 3) != 3) {
+            line = iss_decode(pc, iss_expand(half));
+            line.length = 2;
+        } else {
+            line = iss_decode(pc, (pc & 2) ? half | bus.read(pc + 2) << 16
+                                           : word);
+        }
+        return line;
+    }
+
+    uint32_t load(uint32_t address)
+    {
+        if (!bus.is_ram(address))
+            last.unpredictable = true;
+        return bus.read(address);
+    }
+
+    void store(uint32_t address, uint32_t data, uint8_t strobe)
+    {
+        bus.write(address, data, strobe);
+        // Instructions starting 2 bytes before the word, or in either of its
+        // halves, may overlap it
+        uint32_t word = address & ~3u;
+        for (uint32_t pc = word - 2; pc != word + 4; pc += 2) {
+            IssDecoded &line = cache[(pc >> 1) & (CACHE_LINES - 1)];
+            if (line.pc == pc)
+                line.pc = 1;
+        }
+        if (bus.is_ram(address)) {
+            last.ram_store = true;
+            last.store_address = address & ~3u;
+            last.store_data = data;
+            last.store_strobe = strobe;
+        }
+    }
+
+    static bool counter_csr(uint16_t csr)
+    {
+        uint16_t low = csr & ~0x80;  // high halves at +0x80
+        return (low >= 0xB00 && low <= 0xB0D) || low == 0xC00 || low == 0xC02;
+    }
+
+    // CSR.scala implements the trap registers, mcountinhibit and counters;
+    // everything else reads as zero and ignores writes
+    uint32_t csr_read(uint16_t csr)
+    {
+        switch (csr) {
+        case 0x300: return s.mstatus;
+        case 0x304: return s.mie;
+        case 0x305: return s.mtvec;
+        case 0x320: return s.mcountinhibit;
+        case 0x340: return s.mscratch;
+        case 0x341: return s.mepc;
+        case 0x342: return s.mcause;
+        }
+        if (!counter_csr(csr))
+            return 0;
+        last.unpredictable = true;
+        uint16_t low = csr & ~0x80;
+        uint64_t value = (low == 0xB00 || low == 0xB02 || low == 0xC00 ||
+                          low == 0xC02)
+                             ? retired
+                             : 0;
+        return (csr & 0x80) ? uint32_t(value >> 32) : uint32_t(value);
+    }
+
+    void csr_write(uint16_t csr, uint32_t value)
+    {
+        switch (csr) {
+        case 0x300: s.mstatus = value; break;
+        case 0x304: s.mie = value; break;
+        case 0x305: s.mtvec = value; break;
+        case 0x320: s.mcountinhibit = value & 0x3FFD; break;  // CSR.scala mask
+        case 0x340: s.mscratch = value; break;
+        case 0x341: s.mepc = value; break;
+        case 0x342: s.mcause = value; break;
+        }
+    }
+
+    // Same bit shuffles as CLINT.scala (MIE is bit 3, MPIE bit 7)
+    void trap(uint32_t cause, uint32_t next)
+    {
+        s.mepc = next;
+        s.mcause = cause;
+        s.mstatus = (s.mstatus & ~0x88u) | (s.mstatus & 0x8) << 4;
+        s.pc = s.mtvec;
+    }
+
+public:
+    explicit RV32Iss(Bus &b) : bus(b), cache(CACHE_LINES) {}
+
+    IssState const &state() const { return s; }
+    uint64_t instructions() const { return retired; }
+    bool faulted() const { return !fault_message.empty(); }
+    std::string const &fault() const { return fault_message; }
+
+    // From here on the RTL may take an interrupt the model never sees
+    bool interrupts_enabled() const
+    {
+        return (s.mstatus & 0x8) && (s.mie & 0x888);
+    }
+
+    // Lockstep adopts RTL values the model cannot predict
+    void set_reg(uint8_t rd, uint32_t value)
+    {
+        if (rd)
+            s.x[rd] = value;
+    }
+
+    // Execute one instruction. On an illegal instruction nothing changes
+    // and faulted() becomes true.
+    IssRetire const &step()
+    {
+        IssDecoded const &d = fetch(s.pc);
+        last = IssRetire{};
+        last.pc = s.pc;
+        last.insn = d.insn;
+        uint32_t a = s.x[d.rs1], b = s.x[d.rs2];
+        uint32_t imm = uint32_t(d.imm);
+        uint32_t next = s.pc + d.length;
+        uint32_t value = 0;
+        bool writes = true;
+
+        switch (d.op) {
+        case IssOp::LUI: value = imm; break;
+        case IssOp::AUIPC: value = s.pc + imm; break;
+        case IssOp::JAL: value = next; next = s.pc + imm; break;
+        case IssOp::JALR: value = next; next = (a + imm) & ~1u; break;
+
+        case IssOp::BEQ: writes = false; if (a == b) next = s.pc + imm; break;
+        case IssOp::BNE: writes = false; if (a != b) next = s.pc + imm; break;
+        case IssOp::BLT: writes = false; if (int32_t(a) < int32_t(b)) next = s.pc + imm; break;
+        case IssOp::BGE: writes = false; if (int32_t(a) >= int32_t(b)) next = s.pc + imm; break;
+        case IssOp::BLTU: writes = false; if (a < b) next = s.pc + imm; break;
+        case IssOp::BGEU: writes = false; if (a >= b) next = s.pc + imm; break;
+
+        case IssOp::LB:
+        case IssOp::LBU: {
+            uint32_t addr = a + imm;
+            uint8_t byte = load(addr) >> ((addr & 3) * 8);
+            value = d.op == IssOp::LB ? uint32_t(int8_t(byte)) : byte;
+            break;
+        }
+        case IssOp::LH:
+        case IssOp::LHU: {
+            uint32_t addr = a + imm;
+            uint32_t offset = (addr & 3) == 3 ? 2 : addr & 3;
+            uint16_t half = load(addr) >> (offset * 8);
+            value = d.op == IssOp::LH ? uint32_t(int16_t(half)) : half;
+            break;
+        }
+        case IssOp::LW: value = load(a + imm); break;
+
+        case IssOp::SB: {
+            uint32_t addr = a + imm;
+            writes = false;
+            store(addr, (b & 0xFF) << ((addr & 3) * 8), 1 << (addr & 3));
+            break;
+        }
+        case IssOp::SH: {
+            uint32_t addr = a + imm;
+            uint32_t offset = (addr & 3) == 3 ? 2 : addr & 3;
+            writes = false;
+            store(addr, (b & 0xFFFF) << (offset * 8), 3 << offset);
+            break;
+        }
+        case IssOp::SW: writes = false; store(a + imm, b, 0xF); break;
+
+        case IssOp::ADDI: value = a + imm; break;
+        case IssOp::SLTI: value = int32_t(a) < d.imm; break;
+        case IssOp::SLTIU: value = a < imm; break;
+        case IssOp::XORI: value = a ^ imm; break;
+        case IssOp::ORI: value = a | imm; break;
+        case IssOp::ANDI: value = a & imm; break;
+        case IssOp::SLLI: value = a << (imm & 31); break;
+        case IssOp::SRLI: value = a >> (imm & 31); break;
+        case IssOp::SRAI: value = int32_t(a) >> (imm & 31); break;
+
+        case IssOp::ADD: value = a + b; break;
+        case IssOp::SUB: value = a - b; break;
+        case IssOp::SLL: value = a << (b & 31); break;
+        case IssOp::SLT: value = int32_t(a) < int32_t(b); break;
+        case IssOp::SLTU: value = a < b; break;
+        case IssOp::XOR: value = a ^ b; break;
+        case IssOp::SRL: value = a >> (b & 31); break;
+        case IssOp::SRA: value = int32_t(a) >> (b & 31); break;
+        case IssOp::OR: value = a | b; break;
+        case IssOp::AND: value = a & b; break;
+
+        case IssOp::MUL: value = a * b; break;
+        case IssOp::MULH:
+            value = uint32_t(uint64_t(int64_t(int32_t(a)) * int32_t(b)) >> 32);
+            break;
+        case IssOp::MULHSU:
+            value = uint32_t(uint64_t(int64_t(int32_t(a)) * int64_t(b)) >> 32);
+            break;
+        case IssOp::MULHU: value = uint32_t(uint64_t(a) * b >> 32); break;
+        case IssOp::DIV:
+            value = b == 0                          ? ~0u
+                    : a == 0x80000000u && b == ~0u ? a
+                                                   : uint32_t(int32_t(a) / int32_t(b));
+            break;
+        case IssOp::DIVU: value = b == 0 ? ~0u : a / b; break;
+        case IssOp::REM:
+            value = b == 0                          ? a
+                    : a == 0x80000000u && b == ~0u ? 0
+                                                   : uint32_t(int32_t(a) % int32_t(b));
+            break;
+        case IssOp::REMU: value = b == 0 ? a : a % b; break;
+
+        case IssOp::FENCE: writes = false; break;
+
+        case IssOp::PRIV:
+            if (d.insn == 0x00000073 || d.insn == 0x00100073) {
+                trap(d.insn == 0x00000073 ? 11 : 3, next);
+                retired++;
+                return last;
+            }
+            if (d.insn == 0x30200073) {
+                s.mstatus = (s.mstatus & ~0x88u) | 0x80 | (s.mstatus >> 4 & 0x8);
+                s.pc = s.mepc;
+                retired++;
+                return last;
+            }
+            if (d.insn != 0x10500073) {  // wfi is a nop
+                fault_message = "illegal system instruction";
+                return last;
+            }
+            writes = false;
+            break;
+
+        case IssOp::CSRRW:
+        case IssOp::CSRRS:
+        case IssOp::CSRRC:
+        case IssOp::CSRRWI:
+        case IssOp::CSRRSI:
+        case IssOp::CSRRCI: {
+            uint16_t csr = d.imm;
+            uint32_t src = d.op >= IssOp::CSRRWI ? d.rs1 : a;
+            value = csr_read(csr);
+            switch (d.op) {
+            case IssOp::CSRRW:
+            case IssOp::CSRRWI: csr_write(csr, src); break;
+            case IssOp::CSRRS:
+            case IssOp::CSRRSI: csr_write(csr, value | src); break;
+            default: csr_write(csr, value & ~src); break;
+            }
+            break;
+        }
+
+        case IssOp::ILLEGAL:
+            fault_message = "illegal instruction";
+            return last;
+        }
+
+        if (writes && d.rd) {
+            s.x[d.rd] = value;
+            last.rd = d.rd;
+            last.value = value;
+            last.writes_rd = true;
+        }
+        s.pc = next;
+        retired++;
+        return last;
+    }
+
+    // Run up to count instructions, stopping early when the PC reaches
+    // stop_pc (not executed), on a fault, or after the instruction that
+    // enables interrupts. Returns instructions executed.
+    uint64_t run(uint64_t count, uint32_t stop_pc = 1)
+    {
+        uint64_t start = retired;
+        while (retired - start < count && s.pc != stop_pc) {
+            step();
+            if (faulted() || interrupts_enabled())
+                break;
+        }
+        return retired - start;
+    }
+};
+
+// --lockstep: the ISS runs on a private copy of memory and is stepped each
+// time the RTL retires a register write to rd != x0. Instructions without a
+// register write (branches, stores, fence) are executed on the way, and RAM
+// stores are compared in order against the RTL's bus writes. MMIO is
+// decoded inside the RTL and never reaches the harness, so MMIO stores are
+// not compared and MMIO loads take the RTL value. Checking ends for good at
+// the instruction that enables interrupts (see interrupts_enabled()).
+template <typename Bus>
+class Lockstep
+{
+public:
+    static constexpr size_t MAX_STORE_LAG = 64;
+    static constexpr uint64_t MAX_STEPS_PER_WRITE = 1 << 20;
+    static constexpr size_t HISTORY = 8;
+
+private:
+    struct Store {
+        uint32_t address, data;
+        uint8_t strobe;
+    };
+
+    RV32Iss<Bus> iss;
+    std::deque<Store> rtl_stores, iss_stores;
+    std::array<IssRetire, HISTORY> history{};
+    uint64_t steps = 0;
+    uint64_t matched = 0, stores_matched = 0;
+    std::string message;
+    bool ended = false;
+    uint32_t end_pc = 0;
+
+    // True (and checking over) once the instruction r enabled interrupts
+    bool end_at(IssRetire const &r)
+    {
+        if (!iss.interrupts_enabled())
+            return false;
+        ended = true;
+        end_pc = r.pc;
+        rtl_stores.clear();
+        iss_stores.clear();
+        return true;
+    }
+
+    static uint32_t mask(uint8_t strobe)
+    {
+        return ((strobe & 1) ? 0x000000FF : 0) | ((strobe & 2) ? 0x0000FF00 : 0) |
+               ((strobe & 4) ? 0x00FF0000 : 0) | ((strobe & 8) ? 0xFF000000 : 0);
+    }
+
+    bool fail(char const *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char line[256];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        message = line;
+        return false;
+    }
+
+    bool match_stores()
+    {
+        for (; !rtl_stores.empty() && !iss_stores.empty();
+             rtl_stores.pop_front(), iss_stores.pop_front()) {
+            Store const &r = rtl_stores.front(), &e = iss_stores.front();
+            uint32_t m = mask(e.strobe);
+            if ((r.address >> 2) != (e.address >> 2) || r.strobe != e.strobe ||
+                (r.data & m) != (e.data & m))
+                return fail("store %llu: RTL [0x%08x] = 0x%08x strobe %x, "
+                            "ISS [0x%08x] = 0x%08x strobe %x",
+                            (unsigned long long) stores_matched, r.address,
+                            r.data, r.strobe, e.address, e.data, e.strobe);
+            stores_matched++;
+        }
+        if (rtl_stores.size() > MAX_STORE_LAG)
+            return fail("RTL made %zu RAM stores the ISS did not, first "
+                        "[0x%08x] = 0x%08x",
+                        rtl_stores.size(), rtl_stores.front().address,
+                        rtl_stores.front().data);
+        if (iss_stores.size() > MAX_STORE_LAG)
+            return fail("ISS made %zu RAM stores the RTL did not, first "
+                        "[0x%08x] = 0x%08x",
+                        iss_stores.size(), iss_stores.front().address,
+                        iss_stores.front().data);
+        return true;
+    }
+
+public:
+    explicit Lockstep(Bus &bus) : iss(bus) {}
+
+    RV32Iss<Bus> const &model() const { return iss; }
+    uint64_t writes_matched() const { return matched; }
+    uint64_t stores_compared() const { return stores_matched; }
+    std::string const &divergence() const { return message; }
+    // Checking ended where the guest enabled interrupts, at end_address()
+    bool checking() const { return !ended; }
+    uint32_t end_address() const { return end_pc; }
+
+    // Most recent ISS instructions, oldest first
+    std::vector<IssRetire> recent() const
+    {
+        std::vector<IssRetire> out;
+        for (uint64_t i = steps > HISTORY ? steps - HISTORY : 0; i < steps; i++)
+            out.push_back(history[i % HISTORY]);
+        return out;
+    }
+
+    // RTL register write committing this cycle; false on divergence
+    bool on_retire(uint32_t pc, uint8_t rd, uint32_t data)
+    {
+        if (ended || !rd)
+            return true;
+        for (uint64_t n = 0;; n++) {
+            if (n == MAX_STEPS_PER_WRITE)
+                return fail("ISS ran %llu instructions without a register "
+                            "write, RTL wrote x%u at 0x%08x",
+                            (unsigned long long) n, rd, pc);
+            IssRetire const &r = iss.step();
+            if (iss.faulted())
+                return fail("ISS %s 0x%08x at 0x%08x", iss.fault().c_str(),
+                            r.insn, r.pc);
+            history[steps++ % HISTORY] = r;
+            if (r.ram_store) {
+                iss_stores.push_back(
+                    {r.store_address, r.store_data, r.store_strobe});
+                if (!match_stores())
+                    return false;
+            }
+            if (!r.writes_rd) {
+                if (end_at(r))
+                    return true;
+                continue;
+            }
+            if (r.pc != pc || r.rd != rd)
+                return fail("RTL wrote x%u at pc 0x%08x, ISS wrote x%u at pc "
+                            "0x%08x (insn 0x%08x)",
+                            rd, pc, r.rd, r.pc, r.insn);
+            if (r.unpredictable)
+                iss.set_reg(rd, data);
+            else if (r.value != data)
+                return fail("pc 0x%08x (insn 0x%08x): RTL x%u = 0x%08x, ISS "
+                            "x%u = 0x%08x",
+                            pc, r.insn, rd, data, rd, r.value);
+            matched++;
+            end_at(r);
+            return true;
+        }
+    }
+
+    // RTL write to RAM seen on the harness bus; false on divergence
+    bool on_store(uint32_t address, uint32_t data, uint8_t strobe)
+    {
+        if (ended)
+            return true;
+        rtl_stores.push_back({address, data, strobe});
+        return match_stores();
+    }
+};
+
+// --iss-ff state transfer: instructions fed to the RTL at its reset vector
+// in place of RAM, which set the CSRs (through x1), then x1..x31, and jump
+// to the ISS PC. mstatus.MIE is set only after the registers, so no
+// interrupt sees a half-loaded state. The jal keeps every register intact
+// but limits the target to +-1 MiB of the stub.
+class IssBootStub
+{
+    std::vector<uint32_t> words;
+    uint32_t base = 0, target = 0;
+    bool jumped = false, active = false;
+
+    static uint32_t lui(unsigned rd, uint32_t upper)
+    {
+        return (upper << 12) | rd << 7 | 0x37;
+    }
+    static uint32_t addi(unsigned rd, unsigned rs1, uint32_t imm)
+    {
+        return (imm & 0xFFF) << 20 | rs1 << 15 | rd << 7 | 0x13;
+    }
+    static uint32_t csrw(uint16_t csr, unsigned rs1)
+    {
+        return uint32_t(csr) << 20 | rs1 << 15 | 1 << 12 | 0x73;
+    }
+    static uint32_t csrsi(uint16_t csr, unsigned uimm)
+    {
+        return uint32_t(csr) << 20 | uimm << 15 | 6 << 12 | 0x73;
+    }
+    static uint32_t jal(int32_t offset)
+    {
+        uint32_t o = uint32_t(offset);
+        return (o >> 20 & 1) << 31 | (o >> 1 & 0x3FF) << 21 |
+               (o >> 11 & 1) << 20 | (o & 0xFF000) | 0x6F;
+    }
+
+    void li(unsigned rd, uint32_t value)
+    {
+        words.push_back(lui(rd, (value + 0x800) >> 12));
+        words.push_back(addi(rd, rd, value));
+    }
+
+public:
+    void build(IssState const &s, uint32_t reset_pc)
+    {
+        base = reset_pc;
+        target = s.pc;
+        words.clear();
+        std::pair<uint16_t, uint32_t> const csrs[] = {
+            {0x305, s.mtvec},    {0x340, s.mscratch}, {0x341, s.mepc},
+            {0x342, s.mcause},   {0x304, s.mie},      {0x320, s.mcountinhibit},
+            {0x300, s.mstatus & ~0x8u},
+        };
+        for (auto const &csr : csrs) {
+            li(1, csr.second);
+            words.push_back(csrw(csr.first, 1));
+        }
+        for (unsigned r = 1; r < 32; r++)
+            li(r, s.x[r]);
+        if (s.mstatus & 0x8)
+            words.push_back(csrsi(0x300, 0x8));
+        int64_t offset =
+            int64_t(target) - (int64_t(base) + int64_t(words.size()) * 4);
+        if (offset < -(1 << 20) || offset >= (1 << 20) || (offset & 1))
+            throw std::runtime_error(
+                "--iss-ff target is out of jal range of the reset vector");
+        words.push_back(jal(int32_t(offset)));
+        jumped = false;
+        active = true;
+    }
+
+    // Instruction to feed for fetch address pc; false once the core has
+    // fetched the jal and arrived at the target, and for addresses outside
+    // the stub
+    bool feed(uint32_t pc, uint32_t &insn)
+    {
+        if (!active)
+            return false;
+        if (jumped && pc == target) {
+            active = false;
+            return false;
+        }
+        if (pc < base || (pc - base) / 4 >= words.size())
+            return false;
+        size_t index = (pc - base) / 4;
+        jumped |= index + 1 == words.size();
+        insn = words[index];
+        return true;
+    }
+
+    bool feeding() const { return active; }
+    uint32_t jump_target() const { return target; }
+};
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+// Timing model for the harness RAM behind Top's AXI4-Lite memory slave
+//
+// The slave holds io_mem_slave_read until the harness raises read_valid, so
+// a read can be answered any number of cycles after it is issued. The
+// harness asks ready() for the CPU cycle a new access completes and keeps
+// read_valid low until then. Latencies count extra wait cycles: 0 is the
+// original same-edge answer.
+//
+//   ideal   every access completes at once (default)
+//   fixed   every access takes --mem-latency cycles
+//   banked  --mem-banks word-interleaved banks, each busy for --mem-latency
+//           cycles per access; an access to a busy bank queues behind it
+//   dram    banks with one open row each: --mem-row-hit cycles when the row
+//           is open, --mem-row-miss when it has to be (re)opened
+//
+// Beats after the first of an AXI burst (io_mem_slave_burst) stream from the
+// open page and take --mem-beat cycles instead, unless a dram burst crosses
+// into another row.
+//
+// --mem-interval N caps bandwidth for every model: a new transfer starts at
+// most once every N cycles. Writes are posted (the slave has no write
+// handshake), so the CPU never waits for them, but they occupy their bank
+// and the channel and so delay later reads.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class MemoryTiming
+{
+public:
+    enum class Model { Ideal, Fixed, Banked, Dram };
+
+    struct Stats {
+        uint64_t reads = 0, writes = 0;
+        uint64_t latency = 0;      // issue to completion, all accesses
+        uint64_t queue_delay = 0;  // issue to start, waiting on bank/channel
+        uint64_t max_queue_delay = 0;
+        uint64_t bank_conflicts = 0;  // accesses that waited on their bank
+        uint64_t row_hits = 0, row_misses = 0;
+        uint64_t burst_beats = 0;
+    };
+
+private:
+    Model model = Model::Ideal;
+    uint64_t latency = 0;
+    uint64_t row_hit = 2, row_miss = 8;
+    uint64_t beat = 1;
+    uint32_t banks = 4;
+    uint32_t row_bytes = 2048;
+    uint64_t interval = 0;
+
+    uint64_t channel_free = 0;
+    std::vector<uint64_t> bank_free;
+    std::vector<int64_t> open_row;  // -1: bank precharged
+    Stats stats;
+
+    static Model parse_model(std::string const &name)
+    {
+        if (name == "ideal")
+            return Model::Ideal;
+        if (name == "fixed")
+            return Model::Fixed;
+        if (name == "banked")
+            return Model::Banked;
+        if (name == "dram")
+            return Model::Dram;
+        throw std::invalid_argument("Unknown --mem-model " + name +
+                                    " (ideal, fixed, banked, dram)");
+    }
+
+    // Word-interleaved for banked, row-interleaved (one row per bank, then
+    // the next bank) for dram, so sequential code streams through a row
+    uint32_t bank_of(uint32_t address) const
+    {
+        uint32_t unit = model == Model::Dram ? address / row_bytes : address >> 2;
+        return unit & (banks - 1);
+    }
+
+public:
+    bool parse_option(std::string const &flag, std::string const &value)
+    {
+        auto number = [&] { return std::stoull(value, nullptr, 0); };
+        if (flag == "--mem-model")
+            model = parse_model(value);
+        else if (flag == "--mem-latency")
+            latency = number();
+        else if (flag == "--mem-banks")
+            banks = uint32_t(number());
+        else if (flag == "--mem-row-hit")
+            row_hit = number();
+        else if (flag == "--mem-row-miss")
+            row_miss = number();
+        else if (flag == "--mem-row-bytes")
+            row_bytes = uint32_t(number());
+        else if (flag == "--mem-interval")
+            interval = number();
+        else if (flag == "--mem-beat")
+            beat = number();
+        else
+            return false;
+        return true;
+    }
+
+    // Check the options once parsing is done
+    void configure()
+    {
+        if (!banks || (banks & (banks - 1)))
+            throw std::invalid_argument("--mem-banks must be a power of two");
+        if (!row_bytes || (row_bytes & (row_bytes - 1)) || row_bytes < 4)
+            throw std::invalid_argument(
+                "--mem-row-bytes must be a power of two of at least 4");
+        bank_free.assign(banks, 0);
+        open_row.assign(banks, -1);
+    }
+
+    // Ideal with no bandwidth cap answers on the issuing edge, exactly as
+    // the harness did without a model
+    bool enabled() const { return model != Model::Ideal || interval; }
+
+    char const *name() const
+    {
+        static char const *const NAMES[] = {"ideal", "fixed", "banked", "dram"};
+        return NAMES[int(model)];
+    }
+
+    // CPU cycle at which an access issued at `now` completes; `burst` marks
+    // a beat continuing a burst at the previous address + 4
+    uint64_t ready(uint32_t address, bool write, uint64_t now,
+                   bool burst = false)
+    {
+        uint64_t start = std::max(now, channel_free);
+        uint64_t busy = 0;
+        uint32_t bank = 0;
+        if (model == Model::Banked || model == Model::Dram) {
+            bank = bank_of(address);
+            if (bank_free[bank] > start) {
+                stats.bank_conflicts++;
+                start = bank_free[bank];
+            }
+        }
+        switch (model) {
+        case Model::Ideal:
+            break;
+        case Model::Fixed:
+        case Model::Banked:
+            busy = burst ? beat : latency;
+            break;
+        case Model::Dram: {
+            int64_t row = address / row_bytes / banks;
+            if (burst && open_row[bank] == row) {
+                stats.row_hits++;
+                busy = beat;
+            } else if (open_row[bank] == row) {
+                stats.row_hits++;
+                busy = row_hit;
+            } else {
+                stats.row_misses++;
+                busy = row_miss;
+                open_row[bank] = row;
+            }
+            break;
+        }
+        }
+        uint64_t done = start + busy;
+        channel_free = start + interval;
+        if (model == Model::Banked || model == Model::Dram)
+            bank_free[bank] = done;
+
+        (write ? stats.writes : stats.reads)++;
+        stats.burst_beats += burst;
+        stats.latency += done - now;
+        stats.queue_delay += start - now;
+        stats.max_queue_delay = std::max(stats.max_queue_delay, start - now);
+        return done;
+    }
+
+    Stats const &statistics() const { return stats; }
+
+    void print_summary(FILE *f) const
+    {
+        uint64_t accesses = stats.reads + stats.writes;
+        auto average = [&](uint64_t total) {
+            return accesses ? double(total) / accesses : 0.0;
+        };
+        fprintf(f,
+                "\nMemory model (%s): %llu reads, %llu writes\n"
+                "  Average latency: %.2f cycles\n"
+                "  Average queueing delay: %.2f cycles (max %llu)\n",
+                name(), (unsigned long long) stats.reads,
+                (unsigned long long) stats.writes, average(stats.latency),
+                average(stats.queue_delay),
+                (unsigned long long) stats.max_queue_delay);
+        if (stats.burst_beats)
+            fprintf(f, "  Burst continuation beats: %llu\n",
+                    (unsigned long long) stats.burst_beats);
+        if (model == Model::Banked || model == Model::Dram)
+            fprintf(f, "  Bank conflicts: %llu\n",
+                    (unsigned long long) stats.bank_conflicts);
+        if (model == Model::Dram)
+            fprintf(f, "  Row buffer: %llu hits, %llu misses (%.1f%% hit)\n",
+                    (unsigned long long) stats.row_hits,
+                    (unsigned long long) stats.row_misses,
+                    accesses ? 100.0 * stats.row_hits / accesses : 0.0);
+    }
+};
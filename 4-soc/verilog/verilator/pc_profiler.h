@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: MIT
+// Exact per-PC cycle and stall profile (--profile, --profile-collapsed)
+//
+// Fed every CPU cycle from the commit port and the cpu_perf_* event port of
+// Top. Cycles are charged to the instruction that retires next, so the gap
+// left by a stall or a flush lands on the instruction that waited for it;
+// mispredictions, flushes and hazard stalls are counted on the instruction in
+// ID, memory stalls on the one in MEM. Counters live in a flat array indexed
+// by PC / 2, so the two compressed instructions of one word (RV32C) get rows
+// of their own, grown to the highest RAM PC seen.
+//
+// A shadow call stack follows the RAS convention of the core: JAL/JALR with
+// rd = ra/t0 calls, JALR x0 through ra/t0 returns. Each distinct stack is a
+// node of a call tree carrying its own cycle count, written out as
+// flamegraph.pl collapsed stacks. Trap entry and mret do not change it.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../../common/verilator/elf_loader.h"
+#include "iss.h"
+
+class PcProfiler
+{
+public:
+    enum Event : uint8_t {
+        MISPREDICT = 1 << 0,
+        HAZARD_STALL = 1 << 1,
+        MEMORY_STALL = 1 << 2,
+        CONTROL_FLUSH = 1 << 3,
+    };
+
+    struct Row {
+        uint64_t cycles = 0, retired = 0;
+        uint64_t hazard = 0, memory = 0, flushes = 0, mispredicts = 0;
+        uint32_t insn = 0;  // last instruction word retired here
+
+        void add(Row const &r)
+        {
+            cycles += r.cycles;
+            retired += r.retired;
+            hazard += r.hazard;
+            memory += r.memory;
+            flushes += r.flushes;
+            mispredicts += r.mispredicts;
+        }
+    };
+
+private:
+    static constexpr size_t MAX_DEPTH = 256;
+
+    struct Node {
+        uint32_t parent;
+        uint32_t target;  // callee entry PC, the first PC retired for root
+        uint64_t cycles = 0;
+    };
+
+    uint32_t limit;  // PCs at or above this are folded into `outside`
+    std::vector<Row> rows;
+    Row outside;
+    uint64_t pending = 0;  // cycles since the last retirement
+    uint64_t total_cycles = 0, total_retired = 0;
+
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, uint32_t> children;  // parent << 32 | target
+    uint32_t current = 0;
+    size_t depth = 0;
+    bool call_pending = false;
+
+    Row &row(uint32_t pc)
+    {
+        if (pc >= limit)
+            return outside;
+        size_t index = pc >> 1;
+        if (index >= rows.size())
+            rows.resize(std::max(index + 1, rows.size() * 2));
+        return rows[index];
+    }
+
+    void enter(uint32_t target)
+    {
+        if (depth >= MAX_DEPTH)
+            return;
+        uint64_t key = uint64_t(current) << 32 | target;
+        auto [it, inserted] = children.emplace(key, uint32_t(nodes.size()));
+        if (inserted)
+            nodes.push_back({current, target});
+        current = it->second;
+        depth++;
+    }
+
+    static std::string hex(uint32_t pc)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "0x%08x", pc);
+        return name;
+    }
+
+    // Function name for an entry PC or a PC inside a function
+    static std::string name(ElfImage const *elf, uint32_t pc)
+    {
+        long index = elf ? elf->code_symbol_at(pc) : -1;
+        return index < 0 ? hex(pc) : elf->code_symbols()[index].second;
+    }
+
+public:
+    explicit PcProfiler(uint32_t ram_bytes) : limit(ram_bytes)
+    {
+        nodes.push_back({0, 0});
+    }
+
+    // Once per CPU cycle, before retire() for that cycle
+    void cycle(uint8_t events, uint32_t id_pc, uint32_t mem_pc)
+    {
+        pending++;
+        total_cycles++;
+        if (!events)
+            return;
+        if (events & MEMORY_STALL)
+            row(mem_pc).memory++;
+        if (events & (MISPREDICT | HAZARD_STALL | CONTROL_FLUSH)) {
+            Row &r = row(id_pc);
+            r.mispredicts += (events & MISPREDICT) != 0;
+            r.hazard += (events & HAZARD_STALL) != 0;
+            r.flushes += (events & CONTROL_FLUSH) != 0;
+        }
+    }
+
+    void retire(uint32_t pc, uint32_t insn)
+    {
+        Row &r = row(pc);
+        r.cycles += pending;
+        r.retired++;
+        r.insn = insn;
+        total_retired++;
+
+        if (call_pending) {
+            // The instruction after a call is the callee entry
+            call_pending = false;
+            enter(pc);
+        } else if (total_retired == 1) {
+            nodes[0].target = pc;
+        }
+        nodes[current].cycles += pending;
+        pending = 0;
+
+        uint32_t opcode = insn & 0x7F;
+        uint32_t rd = (insn >> 7) & 0x1F, rs1 = (insn >> 15) & 0x1F;
+        bool link = rd == 1 || rd == 5;
+        if ((opcode == 0x6F || opcode == 0x67) && link) {
+            call_pending = true;
+        } else if (opcode == 0x67 && rd == 0 && (rs1 == 1 || rs1 == 5) &&
+                   current != 0) {
+            current = nodes[current].parent;
+            depth--;
+        }
+    }
+
+    uint64_t cycles() const { return total_cycles; }
+    uint64_t retired() const { return total_retired; }
+
+    // perf-report style text: a per-function table, then the hottest PCs
+    // with their disassembly
+    void write_report(std::string const &path, ElfImage const *elf,
+                      size_t top_pcs = 50) const
+    {
+        FILE *f = fopen(path.c_str(), "w");
+        if (!f)
+            throw std::runtime_error("Cannot write profile " + path);
+
+        struct Function {
+            std::string name;
+            Row total;
+        };
+        std::unordered_map<long, Function> functions;
+        std::vector<uint32_t> hot;
+        for (size_t i = 0; i < rows.size(); i++) {
+            Row const &r = rows[i];
+            if (!r.cycles && !r.retired && !r.hazard && !r.memory &&
+                !r.flushes && !r.mispredicts)
+                continue;
+            uint32_t pc = uint32_t(i << 1);
+            // Without symbols each 4 KiB page stands in for a function
+            long key = elf ? elf->code_symbol_at(pc) : long(pc >> 12) << 12;
+            auto &fn = functions[key];
+            if (fn.name.empty())
+                fn.name = !elf       ? "[page " + hex(uint32_t(key)) + "]"
+                          : key >= 0 ? elf->code_symbols()[key].second
+                                     : "[unknown]";
+            fn.total.add(r);
+            hot.push_back(pc);
+        }
+        if (outside.cycles || outside.retired)
+            functions[-2] = {"[outside RAM]", outside};
+
+        std::vector<Function const *> order;
+        for (auto const &[key, fn] : functions)
+            order.push_back(&fn);
+        std::sort(order.begin(), order.end(), [](auto a, auto b) {
+            return a->total.cycles > b->total.cycles;
+        });
+
+        double total = total_cycles ? double(total_cycles) : 1.0;
+        fprintf(f, "# %llu cycles, %llu instructions retired\n",
+                (unsigned long long) total_cycles,
+                (unsigned long long) total_retired);
+        fprintf(f, "# %8s %12s %12s %6s %10s %10s %10s %10s  %s\n", "Overhead",
+                "Cycles", "Retired", "CPI", "Hazard", "Memory", "Flushes",
+                "Mispred", "Symbol");
+        for (auto fn : order) {
+            Row const &t = fn->total;
+            fprintf(f, "  %7.2f%% %12llu %12llu %6.2f %10llu %10llu %10llu "
+                       "%10llu  %s\n",
+                    100.0 * t.cycles / total, (unsigned long long) t.cycles,
+                    (unsigned long long) t.retired,
+                    t.retired ? double(t.cycles) / t.retired : 0.0,
+                    (unsigned long long) t.hazard,
+                    (unsigned long long) t.memory,
+                    (unsigned long long) t.flushes,
+                    (unsigned long long) t.mispredicts, fn->name.c_str());
+        }
+
+        std::sort(hot.begin(), hot.end(), [this](uint32_t a, uint32_t b) {
+            return rows[a >> 1].cycles > rows[b >> 1].cycles;
+        });
+        hot.resize(std::min(hot.size(), top_pcs));
+        fprintf(f, "\n# Hottest PCs\n");
+        fprintf(f, "# %8s %12s %12s %10s %10s  %-8s %s\n", "Overhead", "Cycles",
+                "Retired", "Hazard", "Memory", "PC", "Instruction");
+        for (uint32_t pc : hot) {
+            Row const &r = rows[pc >> 1];
+            fprintf(f, "  %7.2f%% %12llu %12llu %10llu %10llu  %08x %-28s %s\n",
+                    100.0 * r.cycles / total, (unsigned long long) r.cycles,
+                    (unsigned long long) r.retired,
+                    (unsigned long long) r.hazard,
+                    (unsigned long long) r.memory, pc,
+                    iss_disassemble(pc, r.insn).c_str(),
+                    elf ? name(elf, pc).c_str() : "");
+        }
+        fclose(f);
+    }
+
+    // One "outer;inner cycles" line per call stack, for flamegraph.pl
+    void write_collapsed(std::string const &path, ElfImage const *elf) const
+    {
+        FILE *f = fopen(path.c_str(), "w");
+        if (!f)
+            throw std::runtime_error("Cannot write profile " + path);
+        std::vector<std::string> stacks(nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++) {
+            // Parents are always created before their children
+            std::string frame = name(elf, nodes[i].target);
+            stacks[i] = i ? stacks[nodes[i].parent] + ";" + frame : frame;
+            if (nodes[i].cycles)
+                fprintf(f, "%s %llu\n", stacks[i].c_str(),
+                        (unsigned long long) nodes[i].cycles);
+        }
+        fclose(f);
+    }
+};
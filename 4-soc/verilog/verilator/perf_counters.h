@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: MIT
+// Hardware performance counter snapshots for --stats-json
+//
+// Counters are read through the CSR debug port, which returns the low 32
+// bits (the high-word CSRs are shadows latched only by software reads).
+// Every read accumulates the 32-bit delta into a 64-bit total, so taking a
+// sample at least once per 2^32 cycles gives full-width values.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class PerfCounters
+{
+public:
+    struct Counter {
+        char const *name;
+        uint16_t csr;
+    };
+
+    // Every counter implemented in CSR.scala, in mhpmcounter order
+    static constexpr std::array<Counter, 13> COUNTERS = {{
+        {"mcycle", 0xB00},
+        {"minstret", 0xB02},
+        {"branch_mispredictions", 0xB03},  // BTB, RAS and IndirectBTB
+        {"hazard_stall_cycles", 0xB04},
+        {"memory_stall_cycles", 0xB05},  // AXI4-Lite bus wait states
+        {"control_flushes", 0xB06},
+        {"btb_miss_penalties", 0xB07},
+        {"branches_resolved", 0xB08},
+        {"btb_predictions", 0xB09},
+        {"icache_hits", 0xB0A},  // zero unless Top has an I-cache
+        {"icache_misses", 0xB0B},  // line refills
+        {"dcache_misses", 0xB0C},  // zero unless Top has a D-cache
+        {"dcache_writebacks", 0xB0D},  // dirty lines written back
+    }};
+    enum Index {
+        MCYCLE,
+        MINSTRET,
+        MISPREDICTIONS,
+        HAZARD_STALLS,
+        MEMORY_STALLS,
+        CONTROL_FLUSHES,
+        BTB_MISSES,
+        BRANCHES,
+        BTB_PREDICTIONS,
+        ICACHE_HITS,
+        ICACHE_MISSES,
+        DCACHE_MISSES,
+        DCACHE_WRITEBACKS,
+    };
+    static constexpr size_t COUNT = COUNTERS.size();
+    using Values = std::array<uint64_t, COUNT>;
+
+    // Longest safe gap between reads before a 32-bit counter can wrap twice
+    static constexpr uint64_t MAX_READ_INTERVAL = 1ull << 31;
+
+private:
+    Values totals{};
+    std::array<uint32_t, COUNT> last_low{};
+
+    struct Sample {
+        uint64_t cycle;
+        Values values;
+    };
+    std::vector<Sample> samples;
+
+    static void write_values(FILE *f, Values const &values, char const *indent)
+    {
+        for (size_t i = 0; i < COUNT; i++)
+            fprintf(f, "%s\"%s\": %llu%s\n", indent, COUNTERS[i].name,
+                    (unsigned long long) values[i], i + 1 < COUNT ? "," : "");
+    }
+
+    static double ratio(uint64_t num, uint64_t den)
+    {
+        return den ? double(num) / double(den) : 0.0;
+    }
+
+public:
+    // Read every counter; only combinational evals, so call it while the
+    // model inputs still match the last clock edge.
+    template <typename Model>
+    Values const &read(Model &top)
+    {
+        uint16_t saved = top.io_cpu_csr_debug_read_address;
+        for (size_t i = 0; i < COUNT; i++) {
+            top.io_cpu_csr_debug_read_address = COUNTERS[i].csr;
+            top.eval();
+            uint32_t low = top.io_cpu_csr_debug_read_data;
+            totals[i] += uint32_t(low - last_low[i]);
+            last_low[i] = low;
+        }
+        top.io_cpu_csr_debug_read_address = saved;
+        top.eval();
+        return totals;
+    }
+
+    template <typename Model>
+    void sample(Model &top, uint64_t cpu_cycle)
+    {
+        samples.push_back({cpu_cycle, read(top)});
+    }
+
+    uint64_t get(size_t index) const { return totals[index]; }
+
+    // { "program", "cpu_cycles", "counters", "derived", "bus", "samples" }
+    void write_json(std::string const &path, std::string const &program,
+                    uint64_t cpu_cycles, uint64_t bus_reads,
+                    uint64_t bus_writes) const
+    {
+        FILE *f = fopen(path.c_str(), "w");
+        if (!f)
+            throw std::runtime_error("Cannot write " + path);
+        std::string escaped;
+        for (char c : program) {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        auto &v = totals;
+        fprintf(f, "{\n  \"program\": \"%s\",\n", escaped.c_str());
+        fprintf(f, "  \"cpu_cycles\": %llu,\n",
+                (unsigned long long) cpu_cycles);
+        fprintf(f, "  \"counters\": {\n");
+        write_values(f, v, "    ");
+        fprintf(f, "  },\n  \"derived\": {\n");
+        fprintf(f, "    \"ipc\": %.6f,\n", ratio(v[MINSTRET], v[MCYCLE]));
+        fprintf(f, "    \"cpi\": %.6f,\n", ratio(v[MCYCLE], v[MINSTRET]));
+        fprintf(f, "    \"branch_accuracy\": %.6f,\n",
+                v[BRANCHES] ? 1.0 - ratio(v[MISPREDICTIONS], v[BRANCHES])
+                            : 0.0);
+        fprintf(f, "    \"btb_coverage\": %.6f,\n",
+                ratio(v[BTB_PREDICTIONS], v[BRANCHES]));
+        fprintf(f, "    \"btb_cold_miss_rate\": %.6f,\n",
+                ratio(v[BTB_MISSES], v[BRANCHES]));
+        fprintf(f, "    \"hazard_stall_fraction\": %.6f,\n",
+                ratio(v[HAZARD_STALLS], v[MCYCLE]));
+        fprintf(f, "    \"memory_stall_fraction\": %.6f,\n",
+                ratio(v[MEMORY_STALLS], v[MCYCLE]));
+        fprintf(f, "    \"icache_hit_rate\": %.6f,\n",
+                ratio(v[ICACHE_HITS], v[ICACHE_HITS] + v[ICACHE_MISSES]));
+        fprintf(f, "    \"dcache_writeback_ratio\": %.6f\n",
+                ratio(v[DCACHE_WRITEBACKS], v[DCACHE_MISSES]));
+        fprintf(f, "  },\n  \"bus\": {\n");
+        fprintf(f, "    \"reads\": %llu,\n    \"writes\": %llu\n  },\n",
+                (unsigned long long) bus_reads,
+                (unsigned long long) bus_writes);
+        fprintf(f, "  \"samples\": [");
+        for (size_t s = 0; s < samples.size(); s++) {
+            fprintf(f, "%s\n    {\n      \"cpu_cycle\": %llu,\n",
+                    s ? "," : "", (unsigned long long) samples[s].cycle);
+            write_values(f, samples[s].values, "      ");
+            fprintf(f, "    }");
+        }
+        fprintf(f, "%s]\n}\n", samples.empty() ? "" : "\n  ");
+        fclose(f);
+    }
+};
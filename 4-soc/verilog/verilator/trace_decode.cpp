@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: MIT
+// Offline decoder for sim.cpp --trace-insn files
+//
+// Prints one line per retired instruction: absolute CPU cycle, PC, the
+// enclosing ELF symbol, the instruction word and its disassembly, then the
+// value written to rd and the load/store address where there is one.
+// .zst and .lz4 traces are read through the zstd / lz4 tools.
+//
+// Usage: trace_decode TRACE [-e program.elf] [-n N]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../../common/verilator/elf_loader.h"
+#include "insn_trace.h"
+#include "iss.h"
+
+static std::string symbolize(ElfImage const &elf, uint32_t pc)
+{
+    long index = elf.code_symbol_at(pc);
+    if (index < 0)
+        return "";
+    auto const &[address, name] = elf.code_symbols()[index];
+    char offset[16];
+    snprintf(offset, sizeof(offset), "+0x%x", pc - address);
+    return name + (pc == address ? "" : offset);
+}
+
+static bool writes_rd(IssDecoded const &d)
+{
+    switch (d.op) {
+    case IssOp::ILLEGAL:
+    case IssOp::BEQ:
+    case IssOp::BNE:
+    case IssOp::BLT:
+    case IssOp::BGE:
+    case IssOp::BLTU:
+    case IssOp::BGEU:
+    case IssOp::SB:
+    case IssOp::SH:
+    case IssOp::SW:
+    case IssOp::FENCE:
+    case IssOp::PRIV:
+        return false;
+    default:
+        return d.rd != 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *trace = nullptr;
+    const char *elf = nullptr;
+    uint64_t limit = UINT64_MAX;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-e") && i + 1 < argc)
+            elf = argv[++i];
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            limit = std::stoull(argv[++i], nullptr, 0);
+        else
+            trace = argv[i];
+    }
+    if (!trace) {
+        std::cerr << "Usage: " << argv[0] << " TRACE [-e program.elf] [-n N]\n"
+                  << "  TRACE: sim --trace-insn output (.zst and .lz4 are"
+                  << " decompressed)\n"
+                  << "  -e F: Symbolize PCs with the ELF symbol table\n"
+                  << "  -n N: Stop after N records\n";
+        return 1;
+    }
+
+    try {
+        std::unique_ptr<ElfImage> symbols;
+        if (elf)
+            symbols = std::make_unique<ElfImage>(elf);
+
+        InsnTraceStream in(trace, false);
+        InsnTraceHeader header;
+        if (fread(&header, sizeof(header), 1, in.get()) != 1 ||
+            memcmp(header.magic, InsnTraceHeader::MAGIC, sizeof(header.magic)))
+            throw std::runtime_error(std::string(trace) +
+                                     " is not an instruction trace");
+        if (header.version != InsnTraceHeader::VERSION ||
+            header.record_size != sizeof(InsnTraceRecord))
+            throw std::runtime_error(std::string(trace) + ": trace version " +
+                                     std::to_string(header.version) +
+                                     " is not supported");
+
+        uint64_t cycle = header.start_cycle;
+        uint64_t count = 0;
+        std::vector<InsnTraceRecord> records(4096);
+        size_t n;
+        while (count < limit &&
+               (n = fread(records.data(), sizeof(InsnTraceRecord),
+                          records.size(), in.get())) > 0) {
+            for (size_t i = 0; i < n && count < limit; i++, count++) {
+                auto const &r = records[i];
+                cycle += r.delta_cycles;
+                IssDecoded d = iss_decode(r.pc, r.insn);
+                std::string sym = symbols ? symbolize(*symbols, r.pc) : "";
+                printf("%12llu  %08x %-24s %08x  %-32s",
+                       (unsigned long long) cycle, r.pc, sym.c_str(), r.insn,
+                       iss_disassemble(r.pc, r.insn).c_str());
+                if (writes_rd(d))
+                    printf(" x%u=0x%08x", d.rd, r.rd_value);
+                if (d.op >= IssOp::LB && d.op <= IssOp::SW)
+                    printf(" [0x%08x]", r.mem_address);
+                printf("\n");
+            }
+        }
+        fprintf(stderr, "%llu records\n", (unsigned long long) count);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,11 +1,39 @@
 // SPDX-License-Identifier: MIT
 // VGA Display - SDL2-based renderer for VGA peripheral output
+//
+// The simulation loop only stores 6-bit RRGGBB indices into a capture buffer.
+// Completed frames are handed to a convert thread through a triple buffer
+// (capture / ready / converting); the convert thread expands them through a
+// 64-entry palette into an ARGB buffer and hands that back. The window,
+// renderer, texture and event pump all stay on the thread that calls init(),
+// which uploads and presents the newest converted frame from poll_events().
+// When the display falls behind, the unread ready frame is replaced and
+// counted as dropped, so a slow display never holds up the CPU model.
 
 #pragma once
 
 #include <SDL.h>
+#include <algorithm>
+#include <array>
+#include <condition_variable>
 #include <cstdint>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 6-bit RRGGBB -> 32-bit ARGB, each 2-bit channel scaled 0-3 -> 0-255
+static constexpr std::array<uint32_t, 64> make_vga_palette()
+{
+    std::array<uint32_t, 64> palette{};
+    for (uint32_t i = 0; i < 64; i++) {
+        uint32_t r = ((i >> 4) & 0x3) * 0x55;
+        uint32_t g = ((i >> 2) & 0x3) * 0x55;
+        uint32_t b = (i & 0x3) * 0x55;
+        palette[i] = 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+    return palette;
+}
 
 class VGADisplay
 {
@@ -17,19 +45,79 @@ class VGADisplay
     static constexpr int VGA_HEIGHT = 480;
     static constexpr int WINDOW_SCALE = 1;
 
-    uint32_t framebuffer[VGA_HEIGHT][VGA_WIDTH];
+    static constexpr std::array<uint32_t, 64> PALETTE = make_vga_palette();
+
+    // Indexed frames; capture_frame is owned by the simulation thread,
+    // convert_frame by the convert thread, ready_frame is swapped under lock.
+    std::array<std::vector<uint8_t>, 3> frames;
+    uint8_t *capture;
+    int capture_frame = 0, ready_frame = 1, convert_frame = 2;
+    bool frame_ready = false;
+
+    // Converted frames; converting is owned by the convert thread, showing by
+    // the display thread, converted is swapped under lock.
+    std::array<std::vector<uint32_t>, 3> argb;
+    int converting = 0, converted = 1, showing = 2;
+    bool argb_ready = false;
+
+    bool stopping = false;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::thread convert_thread;
+    uint64_t submitted = 0, dropped = 0;
+
     bool enabled;
 
+    // Palette expansion only; no SDL calls on this thread
+    void convert_loop()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            changed.wait(guard, [this] { return stopping || frame_ready; });
+            if (stopping)
+                break;
+            std::swap(convert_frame, ready_frame);
+            frame_ready = false;
+            guard.unlock();
+
+            uint8_t const *pixels = frames[convert_frame].data();
+            uint32_t *out = argb[converting].data();
+            for (size_t i = 0; i < argb[converting].size(); i++)
+                out[i] = PALETTE[pixels[i]];
+
+            guard.lock();
+            std::swap(converting, converted);
+            argb_ready = true;
+        }
+    }
+
+    // Upload and show the newest converted frame, if there is one
+    void present()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!argb_ready)
+                return;
+            std::swap(showing, converted);
+            argb_ready = false;
+        }
+        SDL_UpdateTexture(texture, nullptr, argb[showing].data(),
+                          VGA_WIDTH * sizeof(uint32_t));
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+        SDL_RenderPresent(renderer);
+    }
+
 public:
     VGADisplay()
         : window(nullptr), renderer(nullptr), texture(nullptr), enabled(false)
     {
-        // Initialize framebuffer to black
-        for (int y = 0; y < VGA_HEIGHT; y++) {
-            for (int x = 0; x < VGA_WIDTH; x++) {
-                framebuffer[y][x] = 0xFF000000;  // ARGB: opaque black
-            }
-        }
+        // Initialize every frame to black
+        for (auto &frame : frames)
+            frame.assign(VGA_WIDTH * VGA_HEIGHT, 0);
+        for (auto &frame : argb)
+            frame.assign(VGA_WIDTH * VGA_HEIGHT, PALETTE[0]);
+        capture = frames[capture_frame].data();
     }
 
     ~VGADisplay() { cleanup(); }
@@ -68,11 +156,13 @@ public:
             return false;
         }
 
-        renderer = SDL_CreateRenderer(
-            window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        // No PRESENTVSYNC: presenting runs on the simulation thread and must
+        // not wait for the display
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
         if (!renderer) {
             fprintf(stderr, "SDL_CreateRenderer Error: %s\n", SDL_GetError());
             SDL_DestroyWindow(window);
+            window = nullptr;
             SDL_Quit();
             return false;
         }
@@ -84,11 +174,16 @@ public:
         if (!texture) {
             fprintf(stderr, "SDL_CreateTexture Error: %s\n", SDL_GetError());
             SDL_DestroyRenderer(renderer);
+            renderer = nullptr;
             SDL_DestroyWindow(window);
+            window = nullptr;
             SDL_Quit();
             return false;
         }
 
+        stopping = false;
+        convert_thread = std::thread(&VGADisplay::convert_loop, this);
+
         enabled = true;
         printf("SDL2 VGA Display initialized (%dx%d)\n", VGA_WIDTH, VGA_HEIGHT);
         return true;
@@ -96,6 +191,14 @@ public:
 
     void cleanup()
     {
+        if (convert_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            changed.notify_all();
+            convert_thread.join();
+        }
         if (texture) {
             SDL_DestroyTexture(texture);
             texture = nullptr;
@@ -117,50 +220,58 @@ public:
     // Convert 6-bit RRGGBB to 32-bit ARGB
     static uint32_t rrggbb_to_argb(uint8_t rrggbb)
     {
-        uint8_t rr = (rrggbb >> 4) & 0x3;
-        uint8_t gg = (rrggbb >> 2) & 0x3;
-        uint8_t bb = rrggbb & 0x3;
-
-        // Scale 2-bit to 8-bit (0-3 -> 0-255)
-        uint8_t r = (rr * 255) / 3;
-        uint8_t g = (gg * 255) / 3;
-        uint8_t b = (bb * 255) / 3;
-
-        return 0xFF000000 | (r << 16) | (g << 8) | b;
+        return PALETTE[rrggbb & 0x3F];
     }
 
-    // Update pixel at current position
+    // Update pixel at current position (called once per pixel clock)
     void update_pixel(uint16_t x, uint16_t y, uint8_t rrggbb, bool active)
     {
         if (!enabled || !active)
             return;
 
         if (x < VGA_WIDTH && y < VGA_HEIGHT)
-            framebuffer[y][x] = rrggbb_to_argb(rrggbb);
+            capture[y * VGA_WIDTH + x] = rrggbb & 0x3F;
     }
 
-    // Render framebuffer to screen
+    // Hand the captured frame to the convert thread and start a new one.
+    // Never blocks on SDL: an unconverted ready frame is simply replaced.
     void render()
     {
         if (!enabled)
             return;
 
-        // Update texture with framebuffer
-        SDL_UpdateTexture(texture, nullptr, framebuffer,
-                          VGA_WIDTH * sizeof(uint32_t));
-
-        // Clear and render
-        SDL_RenderClear(renderer);
-        SDL_RenderCopy(renderer, texture, nullptr, nullptr);
-        SDL_RenderPresent(renderer);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (frame_ready)
+                dropped++;
+            std::swap(capture_frame, ready_frame);
+            frame_ready = true;
+        }
+        changed.notify_one();
+        submitted++;
+
+        // Start from the frame just completed, so pixels the next frame does
+        // not touch keep their last value as with a single framebuffer
+        uint8_t *next = frames[capture_frame].data();
+        std::copy(capture, capture + VGA_WIDTH * VGA_HEIGHT, next);
+        capture = next;
     }
 
-    // Process SDL events (returns false if user closes window)
+    // Indexed frame being captured, for checkpoints
+    uint8_t *pixels() { return capture; }
+
+    uint64_t frames_submitted() const { return submitted; }
+    uint64_t frames_dropped() const { return dropped; }
+
+    // Show the newest converted frame and process SDL events (returns false
+    // if user closes window); call from the thread that called init()
     bool poll_events()
     {
         if (!enabled)
             return true;
 
+        present();
+
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT)
@@ -175,14 +286,18 @@ public:
 
     bool is_enabled() const { return enabled; }
 
-    // Save current framebuffer as BMP file
+    // Save the frame being captured as BMP file
     bool save_frame(const char *filename)
     {
         if (!enabled)
             return false;
 
+        std::vector<uint32_t> argb(VGA_WIDTH * VGA_HEIGHT);
+        for (size_t i = 0; i < argb.size(); i++)
+            argb[i] = PALETTE[capture[i]];
+
         SDL_Surface *surface = SDL_CreateRGBSurfaceFrom(
-            framebuffer, VGA_WIDTH, VGA_HEIGHT, 32, VGA_WIDTH * 4,
+            argb.data(), VGA_WIDTH, VGA_HEIGHT, 32, VGA_WIDTH * 4,
             0x00FF0000,  // R mask
             0x0000FF00,  // G mask
             0x000000FF,  // B mask
@@ -119,3 +119,24 @@ check-verilator:
 check-deps: check-toolchain check-verilator check-riscof
 	@echo "All dependencies validated successfully"
 	@echo ""
+
+# Optional Verilator model flavors used by the stage Makefiles:
+#   verilator-mt:   --threads $(VERILATOR_THREADS) plus optimization, keeps --trace
+#   verilator-fast: same as verilator-mt without --trace (no -vcd support)
+# Each flavor builds into its own --Mdir so the default traced obj_dir used by
+# sim/compliance targets is never clobbered. Override on the command line,
+# e.g. make verilator-fast VERILATOR_THREADS=8
+VERILATOR_THREADS ?= 4
+VERILATOR_OPT_FLAGS = --threads $(VERILATOR_THREADS) -O3 --x-assign fast --x-initial fast
+VERILATOR_OPT_MAKEFLAGS = OPT_FAST=-O3
+VERILATOR_MT_MDIR ?= obj_dir_mt
+VERILATOR_FAST_MDIR ?= obj_dir_fast
+
+# Waveform format of the traced models (verilator, verilator-mt). TRACE_FST=1
+# verilates with FST output, compressed on a separate writer thread; the -vcd
+# option then writes FST. Run make clean when switching formats.
+ifeq ($(TRACE_FST),1)
+VERILATOR_TRACE = --trace-fst --trace-threads 1
+else
+VERILATOR_TRACE = --trace
+endif
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MIT
+// Statically dispatched MMIO bus shared by the stage Verilator harnesses
+//
+// The top SelectBits of a bus address pick a device, as the RTL's
+// deviceSelect does. The select -> device table is built at compile time from
+// the BusSlot list, and dispatch is a switch over the slots rather than a
+// virtual call or an if/else chain over address ranges. Devices provide
+//   uint32_t read(uint32_t offset)
+//   void write(uint32_t offset, uint32_t value, bool write_strobe[4])
+// where offset is the address with the select bits cleared. Unmapped selects
+// read as 0 and ignore writes.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+template <uint32_t Select, typename Device>
+struct BusSlot {
+    static constexpr uint32_t select = Select;
+    Device *device;
+};
+
+template <unsigned SelectBits, typename... Slots>
+class DeviceBus
+{
+public:
+    static constexpr unsigned SHIFT = 32 - SelectBits;
+    static constexpr uint32_t OFFSET_MASK = (1u << SHIFT) - 1u;
+
+private:
+    static constexpr size_t SELECTS = size_t(1) << SelectBits;
+    static constexpr uint8_t UNMAPPED = sizeof...(Slots);
+    static_assert(sizeof...(Slots) < 255, "too many bus slots");
+
+    static constexpr std::array<uint8_t, SELECTS> TABLE = [] {
+        std::array<uint8_t, SELECTS> table{};
+        for (auto &entry : table)
+            entry = UNMAPPED;
+        uint8_t index = 0;
+        ((table[Slots::select] = index++), ...);
+        return table;
+    }();
+
+    std::tuple<Slots...> slots;
+
+    template <size_t... I>
+    uint32_t read(uint8_t slot, uint32_t offset, std::index_sequence<I...>)
+    {
+        uint32_t data = 0;
+        ((slot == I && (data = std::get<I>(slots).device->read(offset), true)) ||
+         ...);
+        return data;
+    }
+
+    template <size_t... I>
+    void write(uint8_t slot,
+               uint32_t offset,
+               uint32_t value,
+               bool write_strobe[4],
+               std::index_sequence<I...>)
+    {
+        ((slot == I &&
+          (std::get<I>(slots).device->write(offset, value, write_strobe),
+           true)) ||
+         ...);
+    }
+
+public:
+    explicit DeviceBus(Slots... devices) : slots(devices...) {}
+
+    static constexpr bool mapped(uint32_t address)
+    {
+        return TABLE[address >> SHIFT] != UNMAPPED;
+    }
+
+    uint32_t read(uint32_t address)
+    {
+        return read(TABLE[address >> SHIFT], address & OFFSET_MASK,
+                    std::index_sequence_for<Slots...>{});
+    }
+
+    void write(uint32_t address, uint32_t value, bool write_strobe[4])
+    {
+        write(TABLE[address >> SHIFT], address & OFFSET_MASK, value,
+              write_strobe, std::index_sequence_for<Slots...>{});
+    }
+};
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: MIT
+// Guest RAM and ELF program loader shared by the stage Verilator harnesses
+//
+// GuestRAM backs simulated memory with an anonymous mapping, so pages are
+// only faulted in (and zeroed by the kernel) when the program touches them.
+// ElfImage maps an ELF file read-only, copies its PT_LOAD segments straight
+// into guest RAM and exposes the symbol table (tohost, begin_signature, ...)
+// so callers need neither objcopy nor addresses on the command line. Code
+// symbols are also kept sorted by address to name PCs in traces and profiles.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class GuestRAM
+{
+    uint32_t *words = nullptr;
+    size_t count = 0;
+
+    static uint32_t *map(size_t bytes, void *at = nullptr)
+    {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+        flags |= MAP_NORESERVE;
+#endif
+        if (at)
+            flags |= MAP_FIXED;
+        void *p = mmap(at, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::runtime_error("Cannot map " + std::to_string(bytes) +
+                                     " bytes of guest memory");
+        return static_cast<uint32_t *>(p);
+    }
+
+public:
+    explicit GuestRAM(size_t words_count) : count(words_count)
+    {
+        if (count)
+            words = map(bytes());
+    }
+
+    ~GuestRAM()
+    {
+        if (words)
+            munmap(words, bytes());
+    }
+
+    GuestRAM(GuestRAM const &) = delete;
+    GuestRAM &operator=(GuestRAM const &) = delete;
+
+    size_t size() const { return count; }
+    size_t bytes() const { return count * sizeof(uint32_t); }
+
+    uint32_t &operator[](size_t index) { return words[index]; }
+    uint32_t operator[](size_t index) const { return words[index]; }
+
+    uint8_t *data() { return reinterpret_cast<uint8_t *>(words); }
+
+    // Drop every touched page; the replacement mapping reads as zero and is
+    // faulted in again on demand, so clearing costs nothing per untouched page.
+    void clear()
+    {
+        if (words)
+            map(bytes(), words);
+    }
+};
+
+class ElfImage
+{
+    // ELF32 little-endian layouts (<elf.h> is not available everywhere)
+    struct Header {
+        uint8_t ident[16];
+        uint16_t type, machine;
+        uint32_t version, entry, phoff, shoff, flags;
+        uint16_t ehsize, phentsize, phnum, shentsize, shnum, shstrndx;
+    };
+    struct ProgramHeader {
+        uint32_t type, offset, vaddr, paddr, filesz, memsz, flags, align;
+    };
+    struct SectionHeader {
+        uint32_t name, type, flags, addr, offset, size, link, info, addralign,
+            entsize;
+    };
+    struct Symbol {
+        uint32_t name, value, size;
+        uint8_t info, other;
+        uint16_t shndx;
+    };
+
+    static constexpr char ELF_MAGIC[4] = {0x7f, 'E', 'L', 'F'};
+    static constexpr uint16_t EM_RISCV = 243;
+    static constexpr uint32_t PT_LOAD = 1;
+    static constexpr uint32_t SHT_SYMTAB = 2;
+    static constexpr uint8_t STB_GLOBAL = 1;
+    static constexpr uint8_t STT_NOTYPE = 0, STT_FUNC = 2;
+
+    std::string filename;
+    uint8_t const *image = nullptr;
+    size_t image_size = 0;
+    std::unordered_map<std::string, uint32_t> symbol_table;
+    std::vector<std::pair<uint32_t, std::string>> code_symbol_table;
+
+    template <typename T>
+    T const *at(size_t offset, size_t count = 1) const
+    {
+        if (offset > image_size || count * sizeof(T) > image_size - offset)
+            throw std::runtime_error("Truncated ELF file " + filename);
+        return reinterpret_cast<T const *>(image + offset);
+    }
+
+    Header const &header() const { return *at<Header>(0); }
+
+    void read_symbols()
+    {
+        auto &ehdr = header();
+        auto sections = at<SectionHeader>(ehdr.shoff, ehdr.shnum);
+        for (int i = 0; i < ehdr.shnum; i++) {
+            if (sections[i].type != SHT_SYMTAB ||
+                sections[i].link >= ehdr.shnum)
+                continue;
+            auto &strtab = sections[sections[i].link];
+            size_t n = sections[i].size / sizeof(Symbol);
+            auto symbols = at<Symbol>(sections[i].offset, n);
+            auto names = at<char>(strtab.offset, strtab.size);
+            for (size_t s = 0; s < n; s++) {
+                if (!symbols[s].shndx || symbols[s].name >= strtab.size)
+                    continue;
+                std::string name(names + symbols[s].name,
+                                 strnlen(names + symbols[s].name,
+                                         strtab.size - symbols[s].name));
+                // Globals win over same-named locals from other objects
+                if ((symbols[s].info >> 4) == STB_GLOBAL)
+                    symbol_table[name] = symbols[s].value;
+                else
+                    symbol_table.emplace(name, symbols[s].value);
+                // Functions and assembler labels, without .L locals and the
+                // $x / $d mapping symbols
+                uint8_t type = symbols[s].info & 0xF;
+                if ((type == STT_FUNC || type == STT_NOTYPE) && !name.empty() &&
+                    name[0] != '$' && name.compare(0, 2, ".L"))
+                    code_symbol_table.emplace_back(symbols[s].value, name);
+            }
+        }
+        std::sort(code_symbol_table.begin(), code_symbol_table.end());
+        code_symbol_table.erase(
+            std::unique(code_symbol_table.begin(), code_symbol_table.end(),
+                        [](auto const &a, auto const &b) {
+                            return a.first == b.first;
+                        }),
+            code_symbol_table.end());
+    }
+
+public:
+    // Cheap check on the first four bytes, used to tell ELF from .asmbin
+    static bool is_elf(std::string const &filename)
+    {
+        char magic[4] = {0};
+        std::ifstream file(filename, std::ios::binary);
+        file.read(magic, sizeof(magic));
+        return file && !memcmp(magic, ELF_MAGIC, sizeof(ELF_MAGIC));
+    }
+
+    explicit ElfImage(std::string const &path) : filename(path)
+    {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Could not open file " + filename);
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(Header)) {
+            close(fd);
+            throw std::runtime_error("Not an ELF file: " + filename);
+        }
+        image_size = st.st_size;
+        void *p = mmap(nullptr, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED)
+            throw std::runtime_error("Could not map file " + filename);
+        image = static_cast<uint8_t const *>(p);
+
+        auto &ehdr = header();
+        if (memcmp(ehdr.ident, ELF_MAGIC, sizeof(ELF_MAGIC)) ||
+            ehdr.ident[4] != 1 || ehdr.ident[5] != 1 ||
+            ehdr.machine != EM_RISCV) {
+            munmap(const_cast<uint8_t *>(image), image_size);
+            throw std::runtime_error("Not a 32-bit little-endian RISC-V ELF: " +
+                                     filename);
+        }
+        // The destructor does not run for a constructor that throws
+        try {
+            read_symbols();
+        } catch (...) {
+            munmap(const_cast<uint8_t *>(image), image_size);
+            throw;
+        }
+    }
+
+    ~ElfImage() { munmap(const_cast<uint8_t *>(image), image_size); }
+
+    ElfImage(ElfImage const &) = delete;
+    ElfImage &operator=(ElfImage const &) = delete;
+
+    uint32_t entry() const { return header().entry; }
+
+    std::unordered_map<std::string, uint32_t> const &symbols() const
+    {
+        return symbol_table;
+    }
+
+    std::optional<uint32_t> symbol(std::string const &name) const
+    {
+        auto it = symbol_table.find(name);
+        if (it == symbol_table.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    // (address, name) of every code symbol, sorted, one per address
+    std::vector<std::pair<uint32_t, std::string>> const &code_symbols() const
+    {
+        return code_symbol_table;
+    }
+
+    // Index into code_symbols() of the nearest symbol at or below pc, or -1
+    // when pc is below the first one
+    long code_symbol_at(uint32_t pc) const
+    {
+        auto it = std::upper_bound(
+            code_symbol_table.begin(), code_symbol_table.end(), pc,
+            [](uint32_t pc, auto const &sym) { return pc < sym.first; });
+        return long(it - code_symbol_table.begin()) - 1;
+    }
+
+    // Place every PT_LOAD segment at its physical address; the part of a
+    // segment beyond its file contents (.bss) is zeroed.
+    void load(GuestRAM &ram) const
+    {
+        auto &ehdr = header();
+        auto segments = at<ProgramHeader>(ehdr.phoff, ehdr.phnum);
+        for (int i = 0; i < ehdr.phnum; i++) {
+            auto &seg = segments[i];
+            if (seg.type != PT_LOAD || !seg.memsz)
+                continue;
+            if (seg.filesz > seg.memsz ||
+                uint64_t(seg.paddr) + seg.memsz > ram.bytes())
+                throw std::runtime_error(
+                    "Segment " + std::to_string(i) + " of " + filename +
+                    " (" + std::to_string(seg.memsz) +
+                    " bytes) does not fit in guest memory");
+            memcpy(ram.data() + seg.paddr, at<uint8_t>(seg.offset, seg.filesz),
+                   seg.filesz);
+            memset(ram.data() + seg.paddr + seg.filesz, 0,
+                   seg.memsz - seg.filesz);
+        }
+    }
+};
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MIT
+// Fork-server test driver shared by the stage Verilator harnesses
+//
+// -batch with -fork builds one model, takes it through the reset cycles
+// once and then fork()s a child per manifest entry from that point. A child
+// starts with a copy-on-write image of the parent - the constructed model,
+// the reset state and the mapped but untouched guest RAM - loads its test
+// and simulates, then sends a status line and its signature back over a
+// pipe and exits without running any destructors. The parent keeps up to
+// `jobs` children running, writes the results as they arrive and reports a
+// child that died without one.
+//
+// fork() copies only the calling thread, so the model must be verilated
+// single-threaded (VERILATOR_THREADS=1); the parallelism comes from the
+// children instead.
+
+#pragma once
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class ForkServer
+{
+public:
+    // Called in the parent for every finished child
+    using Report = std::function<void(size_t test,
+                                      std::string const &status,
+                                      std::string const &signature)>;
+
+private:
+    struct Child {
+        pid_t pid;
+        int fd;  // read end of the child's result pipe
+        size_t test;
+        std::string result;
+    };
+
+    unsigned jobs;
+    int result_fd = -1;  // write end, in a child only
+
+    static std::string exit_status(int status)
+    {
+        if (WIFSIGNALED(status))
+            return "CRASHED (signal " + std::to_string(WTERMSIG(status)) + ")";
+        return "ERROR: exited with " + std::to_string(WEXITSTATUS(status)) +
+               " and no result";
+    }
+
+    // The child wrote "<status>\n<signature>"; anything else means it died
+    static void finished(Child &child, Report const &report)
+    {
+        int status = 0;
+        while (waitpid(child.pid, &status, 0) < 0 && errno == EINTR)
+            ;
+        auto newline = child.result.find('\n');
+        if (newline == std::string::npos)
+            report(child.test, exit_status(status), "");
+        else
+            report(child.test, child.result.substr(0, newline),
+                   child.result.substr(newline + 1));
+    }
+
+public:
+    explicit ForkServer(unsigned jobs) : jobs(jobs ? jobs : 1) {}
+
+    // In the parent: runs `tests` children, at most `jobs` at a time, and
+    // returns nullopt once every one has been reported. In a child: returns
+    // the index of the test it is to run, and the caller ends with finish().
+    std::optional<size_t> serve(size_t tests, Report const &report)
+    {
+        std::vector<Child> running;
+        size_t next = 0;
+        while (next < tests || !running.empty()) {
+            while (next < tests && running.size() < jobs) {
+                int fds[2];
+                if (pipe(fds) != 0)
+                    throw std::runtime_error("fork server: pipe() failed");
+                // Buffered output would otherwise be printed again by the
+                // child
+                std::cout.flush();
+                std::fflush(stdout);
+                pid_t pid = fork();
+                if (pid < 0)
+                    throw std::runtime_error("fork server: fork() failed");
+                if (pid == 0) {
+                    close(fds[0]);
+                    for (auto const &other : running)
+                        close(other.fd);
+                    result_fd = fds[1];
+                    return next;
+                }
+                close(fds[1]);
+                running.push_back({pid, fds[0], next++, {}});
+            }
+
+            std::vector<pollfd> fds;
+            for (auto const &child : running)
+                fds.push_back({child.fd, POLLIN, 0});
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error("fork server: poll() failed");
+            }
+            for (size_t i = fds.size(); i-- > 0;) {
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                    continue;
+                char buffer[4096];
+                ssize_t n = read(fds[i].fd, buffer, sizeof(buffer));
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n > 0) {
+                    running[i].result.append(buffer, n);
+                    continue;
+                }
+                close(running[i].fd);
+                finished(running[i], report);
+                running.erase(running.begin() + i);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // In a child: hand the result to the parent and exit
+    [[noreturn]] void finish(std::string const &status,
+                             std::string const &signature)
+    {
+        std::string message = status + "\n" + signature;
+        for (size_t sent = 0; sent < message.size();) {
+            ssize_t n = write(result_fd, message.data() + sent,
+                              message.size() - sent);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            sent += n;
+        }
+        close(result_fd);
+        std::cout.flush();
+        std::fflush(stdout);
+        _exit(0);
+    }
+};
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+// Wall-clock progress heartbeat shared by the stage Verilator harnesses
+//
+// tick() is meant for the innermost simulation loop: it only looks at the
+// clock every CHECK_INTERVAL time steps and prints at most one line per
+// period, with progress against the time limit and the simulated CPU clock
+// rate. Harnesses pass their own time unit and how many CPU cycles one step
+// is (0.5 when every step is one clock edge).
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+class Heartbeat
+{
+    static constexpr uint64_t CHECK_INTERVAL = 1 << 16;  // power of two
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point last_wall = Clock::now();
+    uint64_t last_time = 0;
+    double cycles_per_step;
+    double period;
+    double khz = 0;
+
+public:
+    explicit Heartbeat(double cycles_per_step, double seconds = 2.0)
+        : cycles_per_step(cycles_per_step), period(seconds)
+    {
+    }
+
+    void restart(uint64_t time = 0)
+    {
+        last_wall = Clock::now();
+        last_time = time;
+    }
+
+    // True at most once per period; rate_khz() then covers the last period
+    bool due(uint64_t time)
+    {
+        if (time & (CHECK_INTERVAL - 1))
+            return false;
+        auto now = Clock::now();
+        double elapsed = std::chrono::duration<double>(now - last_wall).count();
+        if (elapsed < period)
+            return false;
+        khz = (time - last_time) * cycles_per_step / elapsed / 1e3;
+        last_wall = now;
+        last_time = time;
+        return true;
+    }
+
+    double rate_khz() const { return khz; }
+
+    // time and limit in harness steps; limit 0 means unbounded
+    void tick(uint64_t time, uint64_t limit)
+    {
+        if (!due(time))
+            return;
+        if (limit)
+            fprintf(stderr, "Simulation progress: %llu%% (%.1f kHz)\n",
+                    (unsigned long long) (time * 100 / limit), khz);
+        else
+            fprintf(stderr, "Simulation progress: %llu cycles (%.1f kHz)\n",
+                    (unsigned long long) (time * cycles_per_step), khz);
+    }
+};
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: MIT
+// Harness throughput counters shared by the stage Verilator harnesses
+//
+// The clocking loop calls eval() through SimStats, which counts the calls
+// and the rising clock edges they evaluate, so harnesses with different
+// loop structures report the same two numbers. With -stats (--sim-stats in
+// 4-soc) the harness prints them on exit as one stderr line for
+// scripts/sim-bench.py:
+//
+//   [sim-stats] evals=N cycles=N
+//
+// Wall time and peak RSS are measured by the script around the process.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+class SimStats
+{
+    uint64_t evals = 0;
+    uint64_t cycles = 0;
+    bool last_clock = false;
+
+public:
+    template <typename Model>
+    void eval(Model &top)
+    {
+        top.eval();
+        ++evals;
+        if (top.clock && !last_clock)
+            ++cycles;
+        last_clock = top.clock;
+    }
+
+    void report() const
+    {
+        std::fprintf(stderr, "[sim-stats] evals=%llu cycles=%llu\n",
+                     static_cast<unsigned long long>(evals),
+                     static_cast<unsigned long long>(cycles));
+    }
+};
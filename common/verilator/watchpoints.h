@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+// Write-triggered watchpoints shared by the stage Verilator harnesses
+//
+// Halt detection, test-completion markers and user -watch ranges are all
+// address-range watches that Memory::write() checks after storing a word,
+// so the simulation loop no longer polls memory every half-cycle. A watch
+// either fires on any write to its range or only when the stored word
+// equals a value (0xBABECAFE, tohost = 1, 0xCAFEF00D, ...).
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+class WriteWatchpoints
+{
+public:
+    struct Hit {
+        unsigned id;
+        uint32_t address;
+        uint32_t value;  // word as stored, after byte strobes
+    };
+
+private:
+    struct Watch {
+        unsigned id;
+        uint32_t begin, end;  // [begin, end)
+        std::optional<uint32_t> value;
+    };
+
+    std::vector<Watch> watches;
+    std::vector<Hit> hits;
+    // Bounding range of every watch: the only test most writes ever see
+    uint32_t low = std::numeric_limits<uint32_t>::max();
+    uint32_t high = 0;
+
+public:
+    // Watch the bytes [begin, end); returns the id reported in hits
+    unsigned add(uint32_t begin,
+                 uint32_t end,
+                 std::optional<uint32_t> value = std::nullopt)
+    {
+        unsigned id = watches.size();
+        watches.push_back({id, begin, end, value});
+        low = std::min(low, begin);
+        high = std::max(high, end);
+        return id;
+    }
+
+    unsigned add_word(uint32_t address,
+                      std::optional<uint32_t> value = std::nullopt)
+    {
+        return add(address & ~3u, (address & ~3u) + 4, value);
+    }
+
+    void clear()
+    {
+        watches.clear();
+        hits.clear();
+        low = std::numeric_limits<uint32_t>::max();
+        high = 0;
+    }
+
+    // Called by Memory::write() with the word-aligned address it stored to
+    void on_write(uint32_t address, uint32_t stored)
+    {
+        if (address + 4 <= low || address >= high)
+            return;
+        for (auto const &watch : watches) {
+            if (address + 4 > watch.begin && address < watch.end &&
+                (!watch.value || stored == *watch.value))
+                hits.push_back({watch.id, address, stored});
+        }
+    }
+
+    bool pending() const { return !hits.empty(); }
+
+    // Hits since the last call, oldest first
+    std::vector<Hit> take()
+    {
+        std::vector<Hit> taken;
+        taken.swap(hits);
+        return taken;
+    }
+};
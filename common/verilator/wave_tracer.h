@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: MIT
+// Waveform tracing shared by the stage Verilator harnesses
+//
+// WaveTracer writes VCD, or FST when the model is verilated with
+// --trace-fst (make TRACE_FST=1). On top of Verilator's writer it adds:
+//   -trace-start T / -trace-end T  only dump inside [T, T'] (same time base as
+//                                  the -time limit of the harness)
+//   -trace-pc ADDR                 start dumping once the PC reaches ADDR
+//   -trace-addr ADDR               start dumping at the first store to ADDR
+//   -trace-chunk T                 roll over to a new file every T time units
+//   -trace-ring N                  keep only the newest N chunk files
+// VCD text is handed to a background thread for writing; FST models get the
+// same from Verilator's own --trace-threads.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#if VM_TRACE
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#if VM_TRACE_FST
+#include <verilated_fst_c.h>
+#else
+#include <verilated_vcd_c.h>
+#endif
+#endif
+
+#if VM_TRACE && !VM_TRACE_FST
+// Double-buffered VCD output: Verilator's text is collected in large buffers
+// that a writer thread flushes, so dump() never waits on the disk unless
+// MAX_PENDING buffers are already queued.
+class BackgroundTraceFile : public VerilatedVcdFile
+{
+    static constexpr size_t BUFFER_BYTES = 1 << 20;
+    static constexpr size_t MAX_PENDING = 4;
+
+    FILE *file = nullptr;
+    std::string active;
+    std::deque<std::string> pending;
+    std::mutex lock;
+    std::condition_variable changed;
+    bool closing = false;
+    std::thread writer;
+
+    void write_loop()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            changed.wait(guard, [this] { return closing || !pending.empty(); });
+            if (pending.empty())
+                return;
+            std::string buffer = std::move(pending.front());
+            pending.pop_front();
+            changed.notify_all();
+            guard.unlock();
+            fwrite(buffer.data(), 1, buffer.size(), file);
+            guard.lock();
+        }
+    }
+
+    void submit()
+    {
+        if (active.empty())
+            return;
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this] { return pending.size() < MAX_PENDING; });
+        pending.push_back(std::move(active));
+        active = std::string();
+        active.reserve(BUFFER_BYTES);
+        changed.notify_all();
+    }
+
+public:
+    ~BackgroundTraceFile() override { close(); }
+
+    bool open(std::string const &name) override
+    {
+        file = fopen(name.c_str(), "w");
+        if (!file)
+            return false;
+        closing = false;
+        active.reserve(BUFFER_BYTES);
+        writer = std::thread(&BackgroundTraceFile::write_loop, this);
+        return true;
+    }
+
+    void close() override
+    {
+        if (!file)
+            return;
+        submit();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closing = true;
+        }
+        changed.notify_all();
+        writer.join();
+        fclose(file);
+        file = nullptr;
+    }
+
+    ssize_t write(char const *bufp, ssize_t len) override
+    {
+        active.append(bufp, len);
+        if (active.size() >= BUFFER_BYTES)
+            submit();
+        return len;
+    }
+};
+#endif
+
+class WaveTracer
+{
+    static constexpr int TRACE_DEPTH = 99;
+
+    uint64_t start_time = 0;
+    uint64_t end_time = std::numeric_limits<uint64_t>::max();
+    std::optional<uint32_t> start_pc, start_store;
+    bool triggered = true;
+    uint64_t chunk_length = 0;
+    size_t ring_size = 0;
+
+#if VM_TRACE
+#if VM_TRACE_FST
+    using TraceFile = VerilatedFstC;
+#else
+    using TraceFile = VerilatedVcdC;
+    BackgroundTraceFile output;
+#endif
+    std::unique_ptr<TraceFile> tfp;
+    std::string filename;
+    bool finished = false;
+    uint64_t chunk_end = 0;
+    unsigned chunk_index = 0;
+    std::deque<std::string> chunk_files;
+
+    // trace.vcd -> trace.000003.vcd
+    std::string chunk_filename(unsigned index) const
+    {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), ".%06u", index);
+        auto dot = filename.rfind('.');
+        if (dot == std::string::npos ||
+            filename.find('/', dot) != std::string::npos)
+            return filename + suffix;
+        return filename.substr(0, dot) + suffix + filename.substr(dot);
+    }
+
+    void open_file(uint64_t time)
+    {
+        std::string name = filename;
+        if (chunk_length) {
+            name = chunk_filename(chunk_index++);
+            chunk_end = time + chunk_length;
+            chunk_files.push_back(name);
+            if (ring_size && chunk_files.size() > ring_size) {
+                std::remove(chunk_files.front().c_str());
+                chunk_files.pop_front();
+            }
+        }
+        tfp->set_time_resolution("1ps");
+        tfp->set_time_unit("1ns");
+        tfp->open(name.c_str());
+        if (!tfp->isOpen())
+            throw std::runtime_error("Failed to open trace file " + name);
+    }
+#endif
+
+public:
+    // Consume one "-flag value" pair if it is a tracing option; values are
+    // decimal or 0x-prefixed.
+    bool parse_option(std::string const &flag, std::string const &value)
+    {
+        auto number = [&] { return std::stoull(value, nullptr, 0); };
+        if (flag == "-trace-start") {
+            start_time = number();
+        } else if (flag == "-trace-end") {
+            end_time = number();
+        } else if (flag == "-trace-pc") {
+            start_pc = number();
+            triggered = false;
+        } else if (flag == "-trace-addr") {
+            start_store = number();
+            triggered = false;
+        } else if (flag == "-trace-chunk") {
+            chunk_length = number();
+        } else if (flag == "-trace-ring") {
+            ring_size = number();
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Start conditions, called by the harness once per clock cycle
+    void check_pc(uint32_t pc)
+    {
+        if (!triggered && start_pc && pc == *start_pc)
+            triggered = true;
+    }
+
+    void check_store(uint32_t address)
+    {
+        if (!triggered && start_store && address == *start_store)
+            triggered = true;
+    }
+
+#if VM_TRACE
+    template <typename Model>
+    void enable(std::string const &trace_filename, Model &top)
+    {
+        filename = trace_filename;
+        Verilated::traceEverOn(true);
+#if VM_TRACE_FST
+        tfp = std::make_unique<TraceFile>();
+#else
+        tfp = std::make_unique<TraceFile>(&output);
+#endif
+        top.trace(tfp.get(), TRACE_DEPTH);
+    }
+
+    // The file is opened lazily at the first dump inside the window, so a
+    // late -trace-start or a trigger that never fires costs no disk space.
+    void dump(uint64_t time)
+    {
+        if (!tfp || finished || !triggered || time < start_time)
+            return;
+        if (time > end_time) {
+            tfp->close();
+            finished = true;
+            return;
+        }
+        if (!tfp->isOpen()) {
+            open_file(time);
+        } else if (chunk_length && time >= chunk_end) {
+            tfp->close();
+            open_file(time);
+        }
+        tfp->dump(time);
+    }
+
+    ~WaveTracer()
+    {
+        if (tfp)
+            tfp->close();
+    }
+#else
+    // Trace-free model (verilator-fast): reject -vcd instead of ignoring it
+    template <typename Model>
+    void enable(std::string const &trace_filename, Model &top)
+    {
+        throw std::runtime_error("Cannot write " + trace_filename +
+                                 ": model was built without --trace");
+    }
+
+    void dump(uint64_t time) {}
+#endif
+};
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+CPI comparison across the 3-pipeline core variants
+
+Builds one Verilated model per hazard-handling strategy (threestage,
+fivestage_stall, fivestage_forward, fivestage_final), runs the same csrc
+workloads on each until the program reaches its final idle loop, and prints
+the core's own event counters side by side:
+
+    cycles    mcycle at the halt
+    instret   instructions leaving the last stage (bubbles excluded)
+    CPI       cycles / instret
+    stalls    cycles the PC was frozen by a data hazard (0xc04)
+    flushes   cycles fetch was flushed by a taken branch or jump (0xc06)
+
+Usage:
+    python3 scripts/pipeline-cpi.py
+    python3 scripts/pipeline-cpi.py --no-build --json
+"""
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+from pathlib import Path
+from typing import Dict, List, Optional, Union
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+STAGE_DIR = REPO_ROOT / "3-pipeline"
+
+VARIANTS = ["threestage", "fivestage_stall", "fivestage_forward",
+            "fivestage_final"]
+
+# Prebuilt images of the csrc programs (csrc `make update` refreshes them)
+WORKLOADS = [
+    ("hazard_extended", "src/main/resources/hazard_extended.asmbin"),
+    ("quicksort", "src/main/resources/quicksort.asmbin"),
+    ("fibonacci", "src/main/resources/fibonacci.asmbin"),
+]
+
+PERF_PATTERN = re.compile(r"PERF((?:\s+\w+=\d+)+)")
+FIELD_PATTERN = re.compile(r"(\w+)=(\d+)")
+
+Result = Dict[str, Union[str, int, float]]
+
+
+def build_models() -> None:
+    """Generate Verilog for every variant and build its model"""
+    cmd = ["make", "-C", str(STAGE_DIR), "verilator-variants"]
+    print(f"[build] {' '.join(cmd)}", file=sys.stderr)
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+
+
+def run_workload(vtop: Path, binary: Path, max_time: int) -> Optional[Result]:
+    """Run one workload to its idle loop and return the PERF counters"""
+    cmd = [str(vtop), "-instruction", str(binary), "-time", str(max_time),
+           "-halt-idle", "-perf"]
+    result = subprocess.run(cmd, cwd=vtop.parent, stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, text=True)
+    match = PERF_PATTERN.search(result.stdout)
+    if not match:
+        return None
+    return {key: int(value)
+            for key, value in FIELD_PATTERN.findall(match.group(1))}
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description="Compare cycles, CPI and hazard counts across the "
+                    "3-pipeline core variants")
+    parser.add_argument("--time", type=int, default=10000000,
+                        help="half-cycle limit per workload (default: 10M)")
+    parser.add_argument("--no-build", action="store_true",
+                        help="reuse the models from a previous build")
+    parser.add_argument("--json", action="store_true",
+                        help="print one JSON object per variant and workload")
+    args = parser.parse_args()
+
+    if not args.no_build:
+        build_models()
+
+    results: List[Result] = []
+    failed = False
+    for variant in VARIANTS:
+        vtop = STAGE_DIR / "verilog" / "verilator" / variant / "obj_dir" / "VTop"
+        if not vtop.exists():
+            print(f"Model not found: {vtop}", file=sys.stderr)
+            return 1
+        for name, binary in WORKLOADS:
+            perf = run_workload(vtop, (STAGE_DIR / binary).resolve(), args.time)
+            if perf is None or not perf.get("halted"):
+                print(f"[run] {variant} {name}: did not reach its idle loop",
+                      file=sys.stderr)
+                failed = True
+                continue
+            cycles, instret = perf["cycles"], perf["instret"]
+            results.append({
+                "variant": variant,
+                "workload": name,
+                "cycles": cycles,
+                "instret": instret,
+                "cpi": round(cycles / instret, 3) if instret else 0.0,
+                "stalls": perf["stalls"],
+                "flushes": perf["flushes"],
+            })
+
+    if args.json:
+        for result in results:
+            print(json.dumps(result))
+    else:
+        print(f"{'variant':<18}{'workload':<16}{'cycles':>10}{'instret':>10}"
+              f"{'CPI':>8}{'stalls':>10}{'flushes':>10}")
+        for r in results:
+            print(f"{r['variant']:<18}{r['workload']:<16}{r['cycles']:>10}"
+                  f"{r['instret']:>10}{r['cpi']:>8.3f}{r['stalls']:>10}"
+                  f"{r['flushes']:>10}")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
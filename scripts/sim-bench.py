@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Simulator-throughput benchmark for the MyCPU stage harnesses
+
+Builds each stage's trace-free, single-threaded `verilator-fast` model into
+obj_dir_bench, runs a fixed workload set on it with -stats (--sim-stats in
+4-soc) and reports one JSON object per stage and workload:
+
+    wall_s           wall-clock seconds of the VTop process (best of --repeat)
+    cycles           rising clock edges evaluated, reset included
+    cycles_per_sec   cycles / wall_s
+    evals_per_cycle  eval() calls per cycle; 2 for a plain toggle loop
+    peak_rss_kb      maximum resident set size of the process
+
+The numbers measure the harness and the verilated model, not the guest,
+so the workloads only have to be fixed. --save-baseline keeps a run;
+--compare reports the change against one and fails on a regression of more
+than --threshold percent in cycles_per_sec or peak_rss_kb, or on any rise in
+evals_per_cycle.
+
+Usage:
+    make sim-bench
+    make sim-bench SIM_BENCH_ARGS="--save-baseline bench.json"
+    python3 scripts/sim-bench.py --stages 3-pipeline 4-soc --compare bench.json
+"""
+
+import argparse
+import importlib.util
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple, Union
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+BENCH_MDIR = "obj_dir_bench"
+
+# The thread sweep's workload set, so both scripts measure the same programs
+sys.dont_write_bytecode = True
+_spec = importlib.util.spec_from_file_location(
+    "verilator_thread_sweep", REPO_ROOT / "scripts" / "verilator-thread-sweep.py")
+_sweep = importlib.util.module_from_spec(_spec)
+_spec.loader.exec_module(_sweep)
+WORKLOADS = _sweep.WORKLOADS
+ensure_binary = _sweep.ensure_binary
+
+STATS_PATTERN = re.compile(r"\[sim-stats\] evals=(\d+) cycles=(\d+)")
+
+Result = Dict[str, Union[str, int, float]]
+
+
+def build_model(stage: str) -> None:
+    cmd = ["make", "-C", str(REPO_ROOT / stage), "verilator-fast",
+           "VERILATOR_THREADS=1", f"VERILATOR_FAST_MDIR={BENCH_MDIR}"]
+    print(f"[build] {stage}", file=sys.stderr)
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+
+
+def run_once(stage: str, vtop: Path, binary: Path, extra: List[str],
+             max_time: int) -> Optional[Tuple[float, int, int, int]]:
+    """One VTop run: (wall seconds, evals, cycles, peak RSS in KiB)"""
+    if stage == "4-soc":
+        flags = ["-i", str(binary), "--sim-stats"]
+    else:
+        flags = ["-instruction", str(binary), "-stats"]
+    cmd = [str(vtop)] + flags + ["-time", str(max_time)] + extra
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, cwd=vtop.parent, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE, text=True, errors="replace")
+    stderr = proc.stderr.read()
+    # wait4 rather than wait(): RUSAGE_CHILDREN would be the maximum over
+    # every child so far, not this one's
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    proc.stderr.close()
+
+    match = STATS_PATTERN.search(stderr)
+    if not match:
+        print(f"[error] {vtop} exited with {proc.returncode} and no "
+              "[sim-stats] line", file=sys.stderr)
+        return None
+    return wall, int(match.group(1)), int(match.group(2)), usage.ru_maxrss
+
+
+def bench(stage: str, name: str, vtop: Path, binary: Path, extra: List[str],
+          max_time: int, repeat: int) -> Optional[Result]:
+    runs = [run_once(stage, vtop, binary, extra, max_time) for _ in range(repeat)]
+    if any(r is None for r in runs):
+        return None
+    wall, evals, cycles, _ = min(runs, key=lambda r: r[0])
+    result: Result = {
+        "stage": stage, "workload": name,
+        "wall_s": round(wall, 4), "cycles": cycles,
+        "cycles_per_sec": round(cycles / wall) if wall > 0 else 0,
+        "evals_per_cycle": round(evals / cycles, 3) if cycles else 0.0,
+        "peak_rss_kb": max(r[3] for r in runs),
+    }
+    print(f"[run] {stage} {name}: {cycles} cycles in {wall:.2f}s", file=sys.stderr)
+    return result
+
+
+def load_results(path: Path) -> Dict[Tuple[str, str], Result]:
+    results = {}
+    for line in path.read_text().splitlines():
+        if line.strip():
+            r = json.loads(line)
+            results[(r["stage"], r["workload"])] = r
+    return results
+
+
+def compare(results: List[Result], baseline: Dict[Tuple[str, str], Result],
+            threshold: float) -> int:
+    """Print the change against the baseline; return the regression count"""
+    regressions = 0
+    print(f"{'stage':<16}{'workload':<12}{'cycles/s':>12}{'change':>9}"
+          f"{'evals/cyc':>11}{'rss KiB':>10}{'change':>9}")
+    for r in results:
+        base = baseline.get((str(r["stage"]), str(r["workload"])))
+        if base is None:
+            print(f"{r['stage']:<16}{r['workload']:<12}  (not in baseline)")
+            continue
+        speed = (100.0 * (float(r["cycles_per_sec"]) / base["cycles_per_sec"] - 1)
+                 if base["cycles_per_sec"] else 0.0)
+        rss = (100.0 * (float(r["peak_rss_kb"]) / base["peak_rss_kb"] - 1)
+               if base["peak_rss_kb"] else 0.0)
+        notes = []
+        if speed < -threshold:
+            notes.append("slower")
+        if rss > threshold:
+            notes.append("more memory")
+        if float(r["evals_per_cycle"]) > base["evals_per_cycle"]:
+            notes.append("more evals")
+        if r["cycles"] != base["cycles"]:
+            notes.append(f"cycles {base['cycles']} -> {r['cycles']}")
+        regressions += sum(n in ("slower", "more memory", "more evals") for n in notes)
+        print(f"{r['stage']:<16}{r['workload']:<12}{r['cycles_per_sec']:>12}"
+              f"{speed:>+8.1f}%{r['evals_per_cycle']:>11}{r['peak_rss_kb']:>10}"
+              f"{rss:>+8.1f}%  {', '.join(notes)}")
+    return regressions
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description="Benchmark the trace-free VTop of every stage and report "
+                    "wall time, cycles/s, eval() calls per cycle and peak RSS")
+    parser.add_argument("--stages", nargs="+", choices=sorted(WORKLOADS),
+                        default=sorted(WORKLOADS), help="stages to benchmark")
+    parser.add_argument("--time", type=int, default=2000000,
+                        help="half-cycle limit per workload (default: 2M)")
+    parser.add_argument("--repeat", type=int, default=3,
+                        help="runs per workload; the fastest counts (default: 3)")
+    parser.add_argument("--no-build", action="store_true",
+                        help=f"reuse the {BENCH_MDIR} models of a previous run")
+    parser.add_argument("--save-baseline", type=Path, metavar="FILE",
+                        help="also write the results to FILE")
+    parser.add_argument("--compare", type=Path, metavar="FILE",
+                        help="compare against a baseline saved with --save-baseline")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="regression threshold in percent (default: 5)")
+    args = parser.parse_args()
+
+    baseline = None
+    if args.compare:
+        if not args.compare.exists():
+            print(f"Baseline not found: {args.compare}", file=sys.stderr)
+            return 1
+        baseline = load_results(args.compare)
+
+    results: List[Result] = []
+    failed = False
+    for stage in args.stages:
+        stage_dir = REPO_ROOT / stage
+        if not args.no_build:
+            build_model(stage)
+        vtop = stage_dir / "verilog" / "verilator" / BENCH_MDIR / "VTop"
+        if not vtop.exists():
+            print(f"Model not found: {vtop}", file=sys.stderr)
+            return 1
+        for name, binary, extra in WORKLOADS[stage]:
+            path = ensure_binary(stage_dir, binary)
+            if path is None:
+                print(f"[skip] {stage} {name}: {binary} not found", file=sys.stderr)
+                continue
+            result = bench(stage, name, vtop, path.resolve(), extra,
+                           args.time, max(1, args.repeat))
+            if result is None:
+                failed = True
+                continue
+            results.append(result)
+
+    lines = "".join(json.dumps(r) + "\n" for r in results)
+    if args.save_baseline:
+        args.save_baseline.write_text(lines)
+        print(f"[baseline] {len(results)} results in {args.save_baseline}",
+              file=sys.stderr)
+    if baseline is not None:
+        regressions = compare(results, baseline, args.threshold)
+        if regressions:
+            print(f"{regressions} regression(s) beyond {args.threshold}%",
+                  file=sys.stderr)
+            return 1
+    else:
+        sys.stdout.write(lines)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
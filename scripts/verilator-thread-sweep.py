@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""
+Verilator thread-count sweep for the MyCPU stage simulators
+
+Builds the trace-free `verilator-fast` model of one stage once per thread
+count, runs a fixed workload set on each model and reports simulated MHz
+(CPU cycles per wall-clock second). The result answers whether a design is
+large enough to benefit from Verilator's multithreaded scheduler.
+
+Usage:
+    python3 scripts/verilator-thread-sweep.py --stage 4-soc --threads 1,2,4,8
+    python3 scripts/verilator-thread-sweep.py --stage 3-pipeline --no-build
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+import time
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+
+# Workloads per stage: (name, binary relative to the stage, extra VTop args).
+# Binaries under csrc/ are built on demand with the stage's csrc Makefile.
+WORKLOADS: Dict[str, List[Tuple[str, str, List[str]]]] = {
+    "0-minimal": [
+        ("jit", "src/main/resources/jit.asmbin", []),
+    ],
+    "1-single-cycle": [
+        ("fibonacci", "src/main/resources/fibonacci.asmbin", []),
+        ("quicksort", "src/main/resources/quicksort.asmbin", []),
+    ],
+    "2-mmio-trap": [
+        ("fibonacci", "src/main/resources/fibonacci.asmbin", []),
+        ("quicksort", "src/main/resources/quicksort.asmbin", []),
+        ("nyancat", "src/main/resources/nyancat.asmbin", []),
+    ],
+    "3-pipeline": [
+        ("fibonacci", "src/main/resources/fibonacci.asmbin", []),
+        ("quicksort", "src/main/resources/quicksort.asmbin", []),
+    ],
+    "4-soc": [
+        ("fibonacci", "csrc/fibonacci.asmbin", ["--headless"]),
+        ("bubblesort", "csrc/bubblesort.asmbin", ["--headless"]),
+        ("nyancat", "src/main/resources/nyancat.asmbin", ["--headless"]),
+    ],
+}
+
+# 4-soc prints the number of simulated half-cycles on exit; 0-3 always run
+# for exactly -time half-cycles.
+DONE_PATTERN = re.compile(r"Done: (\d+) cycles")
+
+
+def build_model(stage_dir: Path, threads: int, mdir: str) -> None:
+    """Build the trace-free model for one thread count into its own Mdir"""
+    cmd = [
+        "make", "-C", str(stage_dir), "verilator-fast",
+        f"VERILATOR_THREADS={threads}", f"VERILATOR_FAST_MDIR={mdir}",
+    ]
+    print(f"[build] threads={threads}: {' '.join(cmd)}", file=sys.stderr)
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+
+
+def ensure_binary(stage_dir: Path, binary: str) -> Optional[Path]:
+    """Return the workload binary, building csrc programs when missing"""
+    path = stage_dir / binary
+    if not path.exists() and binary.startswith("csrc/"):
+        subprocess.run(["make", "-C", str(stage_dir / "csrc"), path.name],
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return path if path.exists() else None
+
+
+def run_workload(stage: str, vtop: Path, binary: Path, extra: List[str],
+                 max_time: int) -> Tuple[int, float]:
+    """Run one workload and return (simulated CPU cycles, wall seconds)"""
+    flag = "-i" if stage == "4-soc" else "-instruction"
+    cmd = [str(vtop), flag, str(binary), "-time", str(max_time)] + extra
+    start = time.perf_counter()
+    result = subprocess.run(cmd, cwd=vtop.parent, stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, text=True)
+    wall = time.perf_counter() - start
+
+    half_cycles = max_time
+    match = DONE_PATTERN.search(result.stdout)
+    if match:
+        half_cycles = int(match.group(1))
+    return half_cycles // 2, wall
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description="Sweep Verilator --threads and report simulated MHz")
+    parser.add_argument("--stage", default="4-soc", choices=sorted(WORKLOADS))
+    parser.add_argument("--threads", default="1,2,4",
+                        help="comma-separated thread counts (default: 1,2,4)")
+    parser.add_argument("--time", type=int, default=20000000,
+                        help="half-cycle limit per workload (default: 20M)")
+    parser.add_argument("--no-build", action="store_true",
+                        help="reuse previously built obj_dir_fast_t<N> models")
+    args = parser.parse_args()
+
+    stage_dir = REPO_ROOT / args.stage
+    thread_counts = [int(t) for t in args.threads.split(",") if t]
+
+    workloads = []
+    for name, binary, extra in WORKLOADS[args.stage]:
+        path = ensure_binary(stage_dir, binary)
+        if path is None:
+            print(f"[skip] {name}: {binary} not found", file=sys.stderr)
+            continue
+        workloads.append((name, path.resolve(), extra))
+    if not workloads:
+        print("No workloads available", file=sys.stderr)
+        return 1
+
+    # mhz[workload][threads]
+    mhz: Dict[str, Dict[int, float]] = {name: {} for name, _, _ in workloads}
+    for threads in thread_counts:
+        mdir = f"obj_dir_fast_t{threads}"
+        if not args.no_build:
+            build_model(stage_dir, threads, mdir)
+        vtop = stage_dir / "verilog" / "verilator" / mdir / "VTop"
+        if not vtop.exists():
+            print(f"Model not found: {vtop}", file=sys.stderr)
+            return 1
+        for name, binary, extra in workloads:
+            cycles, wall = run_workload(args.stage, vtop, binary, extra,
+                                        args.time)
+            mhz[name][threads] = cycles / wall / 1e6 if wall > 0 else 0.0
+            print(f"[run] {name} threads={threads}: {cycles} cycles in "
+                  f"{wall:.2f}s", file=sys.stderr)
+
+    # Table: simulated MHz per thread count, speedup relative to the first
+    base = thread_counts[0]
+    header = f"{'workload':<12}" + "".join(f"{str(t) + 'T MHz':>14}"
+                                           for t in thread_counts)
+    print(f"\n{args.stage}: simulated MHz (speedup vs {base}T)")
+    print(header)
+    for name, per_thread in mhz.items():
+        cells = []
+        for t in thread_counts:
+            speedup = per_thread[t] / per_thread[base] if per_thread[base] else 0
+            cells.append(f"{per_thread[t]:7.3f} {speedup:3.1f}x")
+        print(f"{name:<12}" + "".join(f"{c:>14}" for c in cells))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
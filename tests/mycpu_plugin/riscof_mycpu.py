@@ -26,7 +26,7 @@ class mycpu(pluginTemplate):
         self.isa_spec = os.path.abspath(config['ispec'])
         self.platform_spec = os.path.abspath(config['pspec'])
 
-        # Path to MyCPU project (can be 1-single-cycle, 2-mmio-trap, or 3-pipeline)
+        # Path to MyCPU project (1-single-cycle, 2-mmio-trap, 3-pipeline or 4-soc)
         self.mycpu_project = os.path.abspath(config['PATH'])
 
         if 'target_run' in config and config['target_run'] == '0':
@@ -34,6 +34,14 @@ class mycpu(pluginTemplate):
         else:
             self.target_run = True
 
+        # native=1 runs the tests through the Verilator harness' -batch mode
+        # instead of generating a ScalaTest suite and starting sbt
+        self.native = 'native' in config and config['native'] == '1'
+        # fork=1 (with native=1) runs each test in a fork()ed copy of one
+        # reset model instead of on reused per-thread models
+        self.fork = self.native and 'fork' in config and config['fork'] == '1'
+        self.sim_time = str(config['sim_time'] if 'sim_time' in config else 2000000)
+
     def initialise(self, suite, work_dir, archtest_env):
         self.work_dir = work_dir
         self.suite_dir = suite
@@ -135,6 +143,10 @@ class mycpu(pluginTemplate):
         if not self.target_run:
             return
 
+        if self.native:
+            self._run_native_batch(test_metadata)
+            return
+
         # Phase 2: Generate batch test file with all tests
         logger.info(f'=== Generating batch test file with {len(test_metadata)} tests ===')
         batch_test_scala = self._generate_batch_test_scala(test_metadata)
@@ -150,7 +162,8 @@ class mycpu(pluginTemplate):
         project_map = {
             '1-single-cycle': 'singleCycle',
             '2-mmio-trap': 'mmioTrap',
-            '3-pipeline': 'pipeline'
+            '3-pipeline': 'pipeline',
+            '4-soc': 'soc'
         }
         sbt_project_name = project_map.get(project_dir_name, 'singleCycle')
         parent_dir = os.path.dirname(self.mycpu_project)
@@ -231,6 +244,56 @@ class mycpu(pluginTemplate):
 
         return
 
+    def _write_empty_signatures(self, test_metadata):
+        """Create zero signatures for tests that produced none"""
+        for meta in test_metadata:
+            if not os.path.exists(meta['sig_file']):
+                logger.warning(f"Signature not created: {meta['name']}")
+                with open(meta['sig_file'], 'w') as f:
+                    for i in range(256):
+                        f.write('00000000\n')
+
+    def _run_native_batch(self, test_metadata):
+        """Run all tests in one VTop process using its -batch mode"""
+        logger.info('=== Building trace-free Verilator model ===')
+        if self.fork:
+            # fork() keeps only the calling thread: single-threaded model,
+            # built apart from the multithreaded obj_dir_fast
+            mdir = 'obj_dir_fork'
+            utils.shellCommand(f'make -C {self.mycpu_project} verilator-fast '
+                               f'VERILATOR_THREADS=1 VERILATOR_FAST_MDIR={mdir}').run()
+        else:
+            mdir = 'obj_dir_fast'
+            utils.shellCommand(f'make -C {self.mycpu_project} verilator-fast').run()
+        vtop = os.path.join(self.mycpu_project, f'verilog/verilator/{mdir}/VTop')
+        if not os.path.exists(vtop):
+            logger.error(f'Verilator model not found: {vtop}')
+            self._write_empty_signatures(test_metadata)
+            return
+
+        # Manifest: <program.elf> <signature file>. The simulator loads the
+        # ELF directly and finds begin_signature/end_signature/tohost in its
+        # symbol table.
+        manifest = os.path.join(self.work_dir, 'batch_manifest.txt')
+        with open(manifest, 'w') as f:
+            for meta in test_metadata:
+                f.write(f"{meta['elf']} {meta['sig_file']}\n")
+
+        batch_log = os.path.join(self.work_dir, 'batch_test.log')
+        cmd = [vtop, '-batch', manifest, '-jobs', self.num_jobs, '-time', self.sim_time]
+        if self.fork:
+            cmd.append('-fork')
+        logger.info(f'=== Running {len(test_metadata)} tests with {self.num_jobs} jobs ===')
+        logger.debug('Running native batch: ' + ' '.join(cmd))
+        with open(batch_log, 'w') as log_file:
+            try:
+                subprocess.run(cmd, stdout=log_file, stderr=subprocess.STDOUT, timeout=3600)
+            except subprocess.TimeoutExpired:
+                logger.error('Native batch run timed out after 3600 seconds')
+        logger.info(f'Batch test completed. Full log: {batch_log}')
+
+        self._write_empty_signatures(test_metadata)
+
     def _generate_test_scala(self, testname, elfFile, sigFile, asmbinFile):
         """Generate Scala test file for this compliance test"""
         return f'''// Auto-generated compliance test